@@ -0,0 +1,119 @@
+/**
+ * \file cdx-bench-arena.cpp
+ *
+ * \brief Compares full-file scans with get_cir, which returns a new components_t for each
+ * CIR, and with get_cir and get_cirs reading into a CIRArena that is released after
+ * each batch of CIRs.
+ *
+ * Each scan sums the delays of all components of all CIRs so that the data is actually
+ * touched.
+ */
+
+#include "../../cdx/WriteContinuousDelayFile.h"
+#include "../../cdx/ReadContinuousDelayFile.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <stdexcept>
+
+using namespace std;
+
+/**
+ * \brief Returns the time in s that has passed since start.
+ */
+static double seconds_since(chrono::steady_clock::time_point start) {
+	return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+int main(void) {
+	const string file_name = "cdx-bench-arena.cdx";
+	const string link = "link0";
+
+	const size_t nof_cirs = 20000;
+	const size_t nof_components = 100;
+	const size_t batch_size = 256;
+
+	{
+		CDX::component_types_t component_types = { { 0, "LOS" }, { 256,
+				"Scatterer" } };
+		CDX::links_to_component_types_t links_to_component_types = { { link,
+				component_types } };
+
+		CDX::WriteContinuousDelayFile cdx_out(file_name, 3e8, 1000.0, 1e9, {
+				link }, links_to_component_types);
+
+		vector<CDX::components_t> cirs(1,
+				CDX::components_t(nof_components));
+		for (CDX::cir_number_t cir_number = 0; cir_number < nof_cirs;
+				cir_number++) {
+			for (size_t c = 0; c < nof_components; c++) {
+				cirs[0][c].type = c == 0 ? 0 : 256;
+				cirs[0][c].id = c;
+				cirs[0][c].delay = 1e-6 + c * 10e-9;
+				cirs[0][c].amplitude = complex<double>(1.0, 0.0);
+			}
+			cdx_out.write_cir(cirs, vector<double>(1, 0.0), cir_number);
+		}
+	}
+
+	CDX::ReadContinuousDelayFile cdx_in(file_name);
+	const size_t link_index = cdx_in.get_link_index(link);
+
+	// warm up the HDF5 metadata cache and the page cache:
+	for (CDX::cir_number_t k = 0; k < nof_cirs; k++)
+		cdx_in.get_cir(link_index, k);
+
+	auto start = chrono::steady_clock::now();
+	double sum_default = 0.0;
+	for (CDX::cir_number_t k = 0; k < nof_cirs; k++)
+		for (const auto &component : cdx_in.get_cir(link_index, k).components)
+			sum_default += component.delay;
+	const double default_s = seconds_since(start);
+
+	CDX::CIRArena arena;
+
+	start = chrono::steady_clock::now();
+	double sum_arena = 0.0;
+	for (CDX::cir_number_t k = 0; k < nof_cirs; k++) {
+		for (const auto &component : cdx_in.get_cir(link_index, k, arena))
+			sum_arena += component.delay;
+		if ((k + 1) % batch_size == 0)
+			arena.release();
+	}
+	arena.release();
+	const double arena_s = seconds_since(start);
+
+	start = chrono::steady_clock::now();
+	double sum_batch = 0.0;
+	vector<CDX::arena_cir_t> batch;
+	for (CDX::cir_number_t first = 0; first < nof_cirs; first += batch_size) {
+		cdx_in.get_cirs(link_index, first,
+				min<size_t>(batch_size, nof_cirs - first), arena, batch);
+		for (const auto &cir : batch)
+			for (const auto &component : cir)
+				sum_batch += component.delay;
+		arena.release();
+	}
+	const double batch_s = seconds_since(start);
+
+	if (sum_arena != sum_default or sum_batch != sum_default)
+		throw runtime_error("cdx-bench-arena: scans returned different data.");
+
+	cout << "cdx-bench-arena: " << nof_cirs << " CIRs, " << nof_components
+			<< " components per CIR, arena released every " << batch_size
+			<< " CIRs\n";
+	cout << "  get_cir, new vector per CIR: " << default_s << " s, "
+			<< nof_cirs / default_s << " CIRs/s\n";
+	cout << "  get_cir, arena:              " << arena_s << " s, "
+			<< nof_cirs / arena_s << " CIRs/s\n";
+	cout << "  get_cirs, arena:             " << batch_s << " s, "
+			<< nof_cirs / batch_s << " CIRs/s\n";
+	cout << "  arena capacity:              " << arena.get_capacity() / 1024
+			<< " kB in " << arena.get_nof_blocks() << " block(s)" << endl;
+
+	remove(file_name.c_str());
+
+	return 0;
+}
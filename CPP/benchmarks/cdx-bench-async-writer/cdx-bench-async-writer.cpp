@@ -0,0 +1,106 @@
+/**
+ * \file cdx-bench-async-writer.cpp
+ *
+ * \brief Measures a simulation loop that computes CIRs and writes them with
+ * WriteContinuousDelayFile, once with synchronous writes and once with the
+ * asynchronous writer for several queue depths.
+ */
+
+#include "../../cdx/WriteContinuousDelayFile.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+
+using namespace std;
+
+/**
+ * \brief Returns the time in s that has passed since start.
+ */
+static double seconds_since(chrono::steady_clock::time_point start) {
+	return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * \brief Computes the components of a CIR, standing in for a channel simulator.
+ */
+static void simulate(CDX::cir_number_t cir_number,
+		CDX::components_t &components) {
+	for (size_t c = 0; c < components.size(); c++) {
+		double phase = 0.0;
+		for (size_t k = 0; k < 200; k++)
+			phase += sin(1e-3 * (cir_number + c + k));
+
+		components[c].type = c == 0 ? 0 : 256;
+		components[c].id = c;
+		components[c].delay = 1e-6 + c * 10e-9;
+		components[c].amplitude = polar(1.0, phase);
+	}
+}
+
+/**
+ * \brief Runs the simulation loop and returns its duration in s.
+ *
+ * \param[in] queue_depth Queue depth of the asynchronous writer, synchronous writes if zero
+ */
+static double run(const string &file_name, size_t nof_cirs,
+		size_t nof_components, size_t queue_depth) {
+	const string link = "link0";
+
+	CDX::component_types_t component_types = { { 0, "LOS" },
+			{ 256, "Scatterer" } };
+	CDX::links_to_component_types_t links_to_component_types = { { link,
+			component_types } };
+
+	const auto start = chrono::steady_clock::now();
+
+	CDX::WriteContinuousDelayFile cdx_out(file_name, 3e8, 1000.0, 1e9,
+			{ link }, links_to_component_types);
+	if (queue_depth > 0)
+		cdx_out.enable_async_writer(queue_depth);
+
+	for (CDX::cir_number_t cir_number = 0; cir_number < nof_cirs;
+			cir_number++) {
+		CDX::components_t components(nof_components);
+		simulate(cir_number, components);
+
+		cdx_out.write_cir( { { link, std::move(components) } },
+				{ { link, 0.0 } }, cir_number);
+	}
+
+	cdx_out.flush();
+	const double duration_s = seconds_since(start);
+
+	if (queue_depth > 0) {
+		const CDX::async_write_stats_t stats = cdx_out.get_async_write_stats();
+		printf(
+				"  queue depth %4zu: %7.3f s, %6llu batches, %6llu blocked calls, max. occupancy %4zu, mean latency %8.5f s, max. latency %8.5f s\n",
+				queue_depth, duration_s, (unsigned long long) stats.nof_batches,
+				(unsigned long long) stats.nof_blocked_calls,
+				stats.max_queue_occupancy, stats.mean_latency_s(),
+				stats.max_latency_s);
+	} else {
+		printf("  synchronous:      %7.3f s\n", duration_s);
+	}
+
+	return duration_s;
+}
+
+int main(void) {
+	const string file_name = "cdx-bench-async-writer.cdx";
+
+	const size_t nof_cirs = 5000;
+	const size_t nof_components = 50;
+
+	cout << "cdx-bench-async-writer: " << nof_cirs << " CIRs with "
+			<< nof_components << " components\n";
+
+	run(file_name, nof_cirs, nof_components, 0);
+	for (size_t queue_depth = 1; queue_depth <= 256; queue_depth *= 16)
+		run(file_name, nof_cirs, nof_components, queue_depth);
+
+	remove(file_name.c_str());
+
+	return 0;
+}
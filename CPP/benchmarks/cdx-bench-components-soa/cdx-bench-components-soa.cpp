@@ -0,0 +1,201 @@
+/**
+ * \file cdx-bench-components-soa.cpp
+ *
+ * \brief Compares the power and the RMS delay spread kernels on CIRs stored as components_t
+ * and as CDX::ComponentsSoA, and reading and writing CIRs in both representations.
+ *
+ * The kernels run over a set of CIRs that is larger than the last level cache, so they
+ * are bound by the memory bandwidth, and the structure of arrays only loads the fields
+ * that a kernel uses.
+ */
+
+#include "../../cdx/WriteContinuousDelayFile.h"
+#include "../../cdx/ReadContinuousDelayFile.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <stdexcept>
+
+using namespace std;
+
+/**
+ * \brief Returns the time in s that has passed since start.
+ */
+static double seconds_since(chrono::steady_clock::time_point start) {
+	return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+static double power(const CDX::components_t &components) {
+	double p = 0.0;
+	for (const auto &component : components)
+		p += component.amplitude.real() * component.amplitude.real()
+				+ component.amplitude.imag() * component.amplitude.imag();
+	return p;
+}
+
+static double power(const CDX::ComponentsSoA &components) {
+	const double *reals = components.reals.data();
+	const double *imags = components.imags.data();
+	double p = 0.0;
+	for (size_t i = 0; i < components.size(); i++)
+		p += reals[i] * reals[i] + imags[i] * imags[i];
+	return p;
+}
+
+static double delay_spread(const CDX::components_t &components) {
+	double p = 0.0, p_tau = 0.0, p_tau2 = 0.0;
+	for (const auto &component : components) {
+		const double p_i = component.amplitude.real()
+				* component.amplitude.real()
+				+ component.amplitude.imag() * component.amplitude.imag();
+		p += p_i;
+		p_tau += p_i * component.delay;
+		p_tau2 += p_i * component.delay * component.delay;
+	}
+	const double mean_delay = p_tau / p;
+	return sqrt(max(0.0, p_tau2 / p - mean_delay * mean_delay));
+}
+
+static double delay_spread(const CDX::ComponentsSoA &components) {
+	const double *delays = components.delays.data();
+	const double *reals = components.reals.data();
+	const double *imags = components.imags.data();
+	double p = 0.0, p_tau = 0.0, p_tau2 = 0.0;
+	for (size_t i = 0; i < components.size(); i++) {
+		const double p_i = reals[i] * reals[i] + imags[i] * imags[i];
+		p += p_i;
+		p_tau += p_i * delays[i];
+		p_tau2 += p_i * delays[i] * delays[i];
+	}
+	const double mean_delay = p_tau / p;
+	return sqrt(max(0.0, p_tau2 / p - mean_delay * mean_delay));
+}
+
+/**
+ * \brief Runs a kernel over all CIRs several times and returns the components per second.
+ */
+template<typename CIR, typename Kernel>
+static double run_kernel(const vector<CIR> &cirs, size_t nof_components,
+		Kernel kernel, double &result) {
+	const size_t nof_runs = 20;
+
+	auto start = chrono::steady_clock::now();
+	result = 0.0;
+	for (size_t run = 0; run < nof_runs; run++)
+		for (const auto &cir : cirs)
+			result += kernel(cir);
+	return nof_runs * cirs.size() * nof_components / seconds_since(start);
+}
+
+int main(void) {
+	const size_t nof_cirs = 20000;
+	const size_t nof_components = 256;
+
+	vector<CDX::components_t> aos_cirs(nof_cirs,
+			CDX::components_t(nof_components));
+	for (size_t k = 0; k < nof_cirs; k++)
+		for (size_t c = 0; c < nof_components; c++) {
+			aos_cirs[k][c].type = c == 0 ? 0 : 1;
+			aos_cirs[k][c].id = c;
+			aos_cirs[k][c].delay = 1e-6 + c * 10e-9 + k * 1e-12;
+			aos_cirs[k][c].amplitude = polar(exp(-0.01 * c), 0.1 * (c + k));
+		}
+
+	vector<CDX::ComponentsSoA> soa_cirs(nof_cirs);
+	for (size_t k = 0; k < nof_cirs; k++)
+		CDX::to_soa(aos_cirs[k], soa_cirs[k]);
+
+	cout << "cdx-bench-components-soa: " << nof_cirs << " CIRs, "
+			<< nof_components << " components per CIR\n";
+
+	double aos_result, soa_result;
+	double aos_rate = run_kernel(aos_cirs, nof_components,
+			[](const CDX::components_t &c) {return power(c);}, aos_result);
+	double soa_rate = run_kernel(soa_cirs, nof_components,
+			[](const CDX::ComponentsSoA &c) {return power(c);}, soa_result);
+	if (aos_result != soa_result)
+		throw runtime_error("cdx-bench-components-soa: power differs.");
+	cout << "  power, components_t:          " << aos_rate / 1e6
+			<< " M components/s\n";
+	cout << "  power, ComponentsSoA:         " << soa_rate / 1e6
+			<< " M components/s (" << soa_rate / aos_rate << "x)\n";
+
+	aos_rate = run_kernel(aos_cirs, nof_components,
+			[](const CDX::components_t &c) {return delay_spread(c);},
+			aos_result);
+	soa_rate = run_kernel(soa_cirs, nof_components,
+			[](const CDX::ComponentsSoA &c) {return delay_spread(c);},
+			soa_result);
+	if (aos_result != soa_result)
+		throw runtime_error("cdx-bench-components-soa: delay spread differs.");
+	cout << "  delay spread, components_t:   " << aos_rate / 1e6
+			<< " M components/s\n";
+	cout << "  delay spread, ComponentsSoA:  " << soa_rate / 1e6
+			<< " M components/s (" << soa_rate / aos_rate << "x)\n";
+
+	// reading and writing a part of the CIRs in both representations:
+	const string file_name = "cdx-bench-components-soa.cdx";
+	const size_t nof_file_cirs = 5000;
+	CDX::links_to_component_types_t links_to_component_types = { { "link0", {
+			{ 0, "LOS" }, { 1, "Scatterer" } } } };
+
+	for (int soa = 0; soa < 2; soa++) {
+		auto start = chrono::steady_clock::now();
+		{
+			CDX::WriteContinuousDelayFile cdx_out(file_name, 3e8, 1000.0, 1e9,
+					{ "link0" }, links_to_component_types);
+			vector<CDX::components_t> cirs(1);
+			vector<CDX::ComponentsSoA> soa_cirs_out(1);
+			const vector<double> reference_delays(1, 0.0);
+			for (CDX::cir_number_t k = 0; k < nof_file_cirs; k++)
+				if (soa) {
+					soa_cirs_out[0] = soa_cirs[k];
+					cdx_out.write_cir(soa_cirs_out, reference_delays, k);
+				} else {
+					cirs[0] = aos_cirs[k];
+					cdx_out.write_cir(cirs, reference_delays, k);
+				}
+		}
+		const double write_s = seconds_since(start);
+		cout << "  write_cir, "
+				<< (soa ? "ComponentsSoA: " : "components_t:  ")
+				<< nof_file_cirs / write_s << " CIRs/s\n";
+	}
+
+	CDX::ReadContinuousDelayFile cdx_in(file_name);
+
+	// warm up the HDF5 metadata cache and the page cache:
+	for (CDX::cir_number_t k = 0; k < nof_file_cirs; k++)
+		cdx_in.get_cir(size_t(0), k);
+
+	auto start = chrono::steady_clock::now();
+	double aos_sum = 0.0;
+	for (CDX::cir_number_t k = 0; k < nof_file_cirs; k++)
+		aos_sum += delay_spread(cdx_in.get_cir(size_t(0), k).components);
+	const double get_cir_s = seconds_since(start);
+
+	start = chrono::steady_clock::now();
+	double soa_sum = 0.0;
+	CDX::ComponentsSoA components;
+	for (CDX::cir_number_t k = 0; k < nof_file_cirs; k++) {
+		cdx_in.read_cir(0, k, components);
+		soa_sum += delay_spread(components);
+	}
+	const double read_cir_s = seconds_since(start);
+
+	if (aos_sum != soa_sum)
+		throw runtime_error(
+				"cdx-bench-components-soa: reads returned different data.");
+
+	cout << "  get_cir + delay spread:       " << nof_file_cirs / get_cir_s
+			<< " CIRs/s\n";
+	cout << "  read_cir + delay spread:      " << nof_file_cirs / read_cir_s
+			<< " CIRs/s\n";
+	cout.flush();
+
+	remove(file_name.c_str());
+
+	return 0;
+}
@@ -0,0 +1,146 @@
+/**
+ * \file cdx-bench-field-mask.cpp
+ *
+ * \brief Compares a delays-only scan, finding the minimum and maximum delay of a link, with
+ * all fields and with only the delay read through get_cir, read_cir and read_cirs.
+ *
+ * The components are stored as compound records, so HDF5 reads the same bytes from the
+ * file in both cases. The mask reduces the bytes converted and written to memory from
+ * sizeof(hdf5_impulse_t) to sizeof(double) per component.
+ */
+
+#include "../../cdx/WriteContinuousDelayFile.h"
+#include "../../cdx/ReadContinuousDelayFile.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+
+using namespace std;
+
+/**
+ * \brief Returns the time in s that has passed since start.
+ */
+static double seconds_since(chrono::steady_clock::time_point start) {
+	return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * \brief Minimum and maximum delay found by a scan.
+ */
+struct delay_range_t {
+	delay_range_t() :
+			min(numeric_limits<double>::infinity()), max(
+					-numeric_limits<double>::infinity()) {
+	}
+
+	void add(double delay) {
+		min = std::min(min, delay);
+		max = std::max(max, delay);
+	}
+
+	bool operator!=(const delay_range_t &other) const {
+		return min != other.min or max != other.max;
+	}
+
+	double min, max;
+};
+
+int main(void) {
+	const string file_name = "cdx-bench-field-mask.cdx";
+
+	const size_t nof_cirs = 10000;
+	const size_t nof_components = 200;
+
+	{
+		CDX::links_to_component_types_t links_to_component_types = { {
+				"link0", { { 0, "LOS" }, { 1, "Scatterer" } } } };
+		CDX::WriteContinuousDelayFile cdx_out(file_name, 3e8, 1000.0, 1e9, {
+				"link0" }, links_to_component_types);
+
+		vector<CDX::components_t> cirs(1,
+				CDX::components_t(nof_components));
+		for (CDX::cir_number_t cir_number = 0; cir_number < nof_cirs;
+				cir_number++) {
+			for (size_t c = 0; c < nof_components; c++) {
+				cirs[0][c].type = c == 0 ? 0 : 1;
+				cirs[0][c].id = c;
+				cirs[0][c].delay = 1e-6 + c * 10e-9 + cir_number * 1e-12;
+				cirs[0][c].amplitude = complex<double>(1.0, 0.5);
+			}
+			cdx_out.write_cir(cirs, vector<double>(1, 0.0), cir_number);
+		}
+	}
+
+	CDX::ReadContinuousDelayFile cdx_in(file_name);
+
+	// warm up the HDF5 metadata cache and the page cache:
+	for (CDX::cir_number_t k = 0; k < nof_cirs; k++)
+		cdx_in.get_cir(size_t(0), k);
+
+	cout << "cdx-bench-field-mask: " << nof_cirs << " CIRs, " << nof_components
+			<< " components per CIR, delays-only scan\n";
+	cout << "  bytes per component transferred to memory: all fields "
+			<< sizeof(CDX::hdf5_impulse_t) << ", delays only "
+			<< sizeof(double) << " ("
+			<< double(sizeof(CDX::hdf5_impulse_t)) / sizeof(double)
+			<< "x less)\n";
+
+	delay_range_t reference;
+	for (unsigned fields : { unsigned(CDX::all_component_fields),
+			unsigned(CDX::fields_delay) }) {
+		const string name =
+				fields == CDX::all_component_fields ?
+						"all fields:  " : "delays only: ";
+
+		auto start = chrono::steady_clock::now();
+		delay_range_t get_cir_range;
+		for (CDX::cir_number_t k = 0; k < nof_cirs; k++)
+			for (const auto &component : cdx_in.get_cir(size_t(0), k, fields).components)
+				get_cir_range.add(component.delay);
+		const double get_cir_s = seconds_since(start);
+
+		start = chrono::steady_clock::now();
+		delay_range_t read_cir_range;
+		CDX::ComponentsSoA components;
+		for (CDX::cir_number_t k = 0; k < nof_cirs; k++) {
+			cdx_in.read_cir(0, k, components, fields);
+			for (double delay : components.delays)
+				read_cir_range.add(delay);
+		}
+		const double read_cir_s = seconds_since(start);
+
+		start = chrono::steady_clock::now();
+		delay_range_t read_cirs_range;
+		CDX::cir_block_t block;
+		const size_t count = 256;
+		for (CDX::cir_number_t first = 0; first < nof_cirs; first += count) {
+			cdx_in.read_cirs(0, first, min<size_t>(count, nof_cirs - first),
+					block, fields);
+			for (double delay : block.delays)
+				read_cirs_range.add(delay);
+		}
+		const double read_cirs_s = seconds_since(start);
+
+		if (fields == CDX::all_component_fields)
+			reference = get_cir_range;
+		if (get_cir_range != reference or read_cir_range != reference
+				or read_cirs_range != reference)
+			throw runtime_error(
+					"cdx-bench-field-mask: scans returned different delays.");
+
+		cout << "  get_cir, " << name << nof_cirs / get_cir_s << " CIRs/s\n";
+		cout << "  read_cir, " << name << nof_cirs / read_cir_s
+				<< " CIRs/s\n";
+		cout << "  read_cirs, " << name << nof_cirs / read_cirs_s
+				<< " CIRs/s\n";
+	}
+	cout.flush();
+
+	remove(file_name.c_str());
+
+	return 0;
+}
@@ -0,0 +1,157 @@
+/**
+ * \file cdx-bench-follow.cpp
+ *
+ * \brief Measures the latency from writing a CIR in SWMR mode to reading it with
+ * CDX::FollowContinuousDelayFile in another process, for several flush cadences, and the
+ * rate of refreshes.
+ *
+ * The writer stores the time of writing each CIR, taken from the monotonic clock that
+ * both processes share, as the reference delay of the CIR.
+ */
+
+#include "../../cdx/WriteContinuousDelayFile.h"
+#include "../../cdx/FollowContinuousDelayFile.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <stdexcept>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace std;
+
+/**
+ * \brief Returns the time of the monotonic clock in s.
+ */
+static double now_s() {
+	return chrono::duration<double>(
+			chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * \brief Writes CIRs at about a given rate in SWMR mode, in the child process.
+ */
+static void write_file(const string &file_name, size_t nof_cirs,
+		double cir_rate_Hz, size_t flush_interval_cirs, int to_follower) {
+	const size_t nof_components = 20;
+
+	CDX::links_to_component_types_t component_types;
+	component_types["link0"] = { { 0, "LOS" }, { 1, "Scatterer" } };
+
+	CDX::WriteContinuousDelayFile cdx_out(file_name, 3e8, cir_rate_Hz, 1e9,
+			{ "link0" }, component_types, false, CDX::get_swmr_access_plist());
+
+	CDX::swmr_options_t options;
+	options.flush_interval_cirs = flush_interval_cirs;
+	options.flush_interval_s = 0.0;
+	cdx_out.enable_swmr_write(options);
+
+	char byte = 0;
+	if (write(to_follower, &byte, 1) != 1)
+		throw runtime_error("cdx-bench-follow: write to pipe failed.");
+
+	vector<CDX::components_t> cirs(1, CDX::components_t(nof_components));
+	const double start_s = now_s();
+	for (CDX::cir_number_t n = 0; n < nof_cirs; n++) {
+		// wait for the time of the CIR:
+		const double wait_s = start_s + n / cir_rate_Hz - now_s();
+		if (wait_s > 0.0)
+			usleep(static_cast<useconds_t>(wait_s * 1e6));
+
+		for (size_t c = 0; c < nof_components; c++) {
+			cirs[0][c].type = c == 0 ? 0 : 1;
+			cirs[0][c].id = c;
+			cirs[0][c].delay = 1e-6 + c * 10e-9;
+			cirs[0][c].amplitude = complex<double>(1.0, 0.5);
+		}
+		cdx_out.write_cir(cirs, { now_s() }, n);
+	}
+	cdx_out.sync();
+
+	// the file is closed after the follower:
+	sleep(1);
+}
+
+/**
+ * \brief Follows a file written by a child process and prints the latencies.
+ */
+static void run(size_t flush_interval_cirs, size_t nof_cirs,
+		double cir_rate_Hz) {
+	const string file_name = "cdx-bench-follow.cdx";
+
+	int to_follower[2];
+	if (pipe(to_follower) != 0)
+		throw runtime_error("cdx-bench-follow: pipe failed.");
+
+	cout.flush();
+	const pid_t pid = fork();
+	if (pid == 0) {
+		try {
+			write_file(file_name, nof_cirs, cir_rate_Hz, flush_interval_cirs,
+					to_follower[1]);
+		} catch (...) {
+			_exit(2);
+		}
+		_exit(0);
+	}
+
+	char byte;
+	if (read(to_follower[0], &byte, 1) != 1)
+		throw runtime_error("cdx-bench-follow: the writer did not start.");
+
+	double total_latency_s = 0.0, max_latency_s = 0.0;
+	size_t nof_refreshes = 0;
+	double refresh_s = 0.0;
+	{
+		CDX::FollowContinuousDelayFile cdx_in(file_name);
+
+		vector<CDX::cir_block_t> blocks;
+		while (cdx_in.get_next_cir() < nof_cirs) {
+			if (cdx_in.read_new_cirs(blocks, 10.0, CDX::fields_delay) == 0)
+				throw runtime_error("cdx-bench-follow: no new CIRs within 10 s.");
+
+			const double read_s = now_s();
+			for (double written_s : blocks[0].ref_delays) {
+				total_latency_s += read_s - written_s;
+				max_latency_s = max(max_latency_s, read_s - written_s);
+			}
+		}
+
+		// refreshes of a file without new CIRs:
+		const double start_s = now_s();
+		while (now_s() - start_s < 0.2) {
+			cdx_in.refresh();
+			nof_refreshes++;
+		}
+		refresh_s = now_s() - start_s;
+	}
+
+	int status;
+	waitpid(pid, &status, 0);
+	if (not WIFEXITED(status) or WEXITSTATUS(status) != 0)
+		throw runtime_error("cdx-bench-follow: the writer failed.");
+
+	cout << "  flush every " << flush_interval_cirs << " CIRs: latency mean "
+			<< 1e3 * total_latency_s / nof_cirs << " ms, max "
+			<< 1e3 * max_latency_s << " ms, " << nof_refreshes / refresh_s
+			<< " refreshes/s\n";
+
+	remove(file_name.c_str());
+}
+
+int main(void) {
+	const size_t nof_cirs = 2000;
+	const double cir_rate_Hz = 1000.0;
+
+	cout << "cdx-bench-follow: " << nof_cirs << " CIRs written at "
+			<< cir_rate_Hz << " CIRs/s, 20 components per CIR\n";
+
+	for (size_t flush_interval_cirs : { 1, 16, 64 })
+		run(flush_interval_cirs, nof_cirs, cir_rate_Hz);
+	cout.flush();
+
+	return 0;
+}
@@ -0,0 +1,122 @@
+/**
+ * \file cdx-bench-in-memory.cpp
+ *
+ * \brief Measures a pipeline stage that writes a continuous-delay CDX file and a next stage
+ * that reads all its CIRs back, once through a file on disk and once in memory, handing
+ * the file on as an image, see get_in_memory_access_plist.
+ *
+ * The number of CIRs is 20000 by default and can be given as the first argument.
+ */
+
+#include "../../cdx/WriteContinuousDelayFile.h"
+#include "../../cdx/ReadContinuousDelayFile.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+
+using namespace std;
+
+const size_t nof_links = 2;
+const size_t nof_components = 20;
+
+/**
+ * \brief Returns the time in s that has passed since start.
+ */
+static double seconds_since(chrono::steady_clock::time_point start) {
+	return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+static void write_cirs(CDX::WriteContinuousDelayFile &cdx_out,
+		size_t nof_cirs) {
+	vector<CDX::components_t> cirs(nof_links,
+			CDX::components_t(nof_components));
+	vector<double> reference_delays(nof_links, 1e-6);
+	for (CDX::cir_number_t n = 0; n < nof_cirs; n++) {
+		for (size_t l = 0; l < nof_links; l++)
+			for (size_t c = 0; c < nof_components; c++) {
+				cirs[l][c].type = 0;
+				cirs[l][c].id = c;
+				cirs[l][c].delay = 1e-6 + c * 10e-9;
+				cirs[l][c].amplitude = complex<double>(1.0, 0.5);
+			}
+		cdx_out.write_cir(cirs, reference_delays, n);
+	}
+}
+
+/**
+ * \brief Reads all CIRs of all links and returns the number of components.
+ */
+static size_t read_cirs(CDX::ReadContinuousDelayFile &cdx_in) {
+	size_t nof_read_components = 0;
+	for (size_t l = 0; l < cdx_in.get_nof_links(); l++)
+		nof_read_components +=
+				cdx_in.read_cirs(l, 0, cdx_in.get_nof_cirs()).offsets.back();
+	return nof_read_components;
+}
+
+static void print(const string &name, double write_s, double read_s) {
+	cout << "  " << name << ": write " << 1e3 * write_s << " ms, read "
+			<< 1e3 * read_s << " ms, total " << 1e3 * (write_s + read_s)
+			<< " ms\n";
+}
+
+int main(int argc, char *argv[]) {
+	const size_t nof_cirs = argc > 1 ? strtoul(argv[1], nullptr, 10) : 20000;
+	const string file_name = "cdx-bench-in-memory.cdx";
+
+	cout << "cdx-bench-in-memory: " << nof_cirs << " CIRs of " << nof_links
+			<< " links, " << nof_components << " components per CIR\n";
+
+	vector<string> link_names;
+	CDX::links_to_component_types_t component_types;
+	for (size_t l = 0; l < nof_links; l++) {
+		link_names.push_back("link" + to_string(l));
+		component_types[link_names.back()] = { { 0, "LOS" } };
+	}
+
+	// through a file on disk:
+	auto start = chrono::steady_clock::now();
+	{
+		CDX::WriteContinuousDelayFile cdx_out(file_name, 3e8, 1000.0, 1e9,
+				link_names, component_types);
+		write_cirs(cdx_out, nof_cirs);
+	}
+	double write_s = seconds_since(start);
+
+	start = chrono::steady_clock::now();
+	size_t nof_read_components;
+	{
+		CDX::ReadContinuousDelayFile cdx_in(file_name);
+		nof_read_components = read_cirs(cdx_in);
+	}
+	print("disk", write_s, seconds_since(start));
+	remove(file_name.c_str());
+
+	// in memory, the image is taken by the writer and copied by the reader:
+	start = chrono::steady_clock::now();
+	vector<char> image;
+	{
+		CDX::WriteContinuousDelayFile cdx_out(file_name, 3e8, 1000.0, 1e9,
+				link_names, component_types, false,
+				CDX::get_in_memory_access_plist());
+		write_cirs(cdx_out, nof_cirs);
+		image = cdx_out.get_file_image();
+	}
+	write_s = seconds_since(start);
+
+	start = chrono::steady_clock::now();
+	{
+		CDX::ReadContinuousDelayFile cdx_in(file_name,
+				CDX::get_file_image_access_plist(image));
+		if (read_cirs(cdx_in) != nof_read_components)
+			throw runtime_error("cdx-bench-in-memory: CIRs differ.");
+	}
+	print("memory", write_s, seconds_since(start));
+	cout << "  image: " << image.size() / 1e6 << " MB\n";
+	cout.flush();
+
+	return 0;
+}
@@ -0,0 +1,98 @@
+/**
+ * \file cdx-bench-lazy-open.cpp
+ *
+ * \brief Measures the time to open a continuous-delay CDX file with one dataset per CIR
+ * eagerly and lazily, the time to read the first CIR after opening, and the time of the
+ * check of the number of CIRs that lazy opening defers.
+ *
+ * The number of CIRs is 10^6 by default and can be given as the first argument.
+ */
+
+#include "../../cdx/WriteContinuousDelayFile.h"
+#include "../../cdx/ReadContinuousDelayFile.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+
+using namespace std;
+
+/**
+ * \brief Returns the time in s that has passed since start.
+ */
+static double seconds_since(chrono::steady_clock::time_point start) {
+	return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+static void write_file(const string &file_name, size_t nof_cirs) {
+	CDX::links_to_component_types_t component_types;
+	component_types["link0"] = { { 0, "LOS" }, { 1, "Scatterer" } };
+
+	CDX::WriteContinuousDelayFile cdx_out(file_name, 3e8, 1000.0, 1e9,
+			{ "link0" }, component_types);
+
+	vector<CDX::components_t> cirs(1, CDX::components_t(2));
+	for (CDX::cir_number_t n = 0; n < nof_cirs; n++) {
+		for (size_t c = 0; c < cirs[0].size(); c++) {
+			cirs[0][c].type = c;
+			cirs[0][c].id = c;
+			cirs[0][c].delay = 1e-6 + c * 10e-9;
+			cirs[0][c].amplitude = complex<double>(1.0, 0.5);
+		}
+		cdx_out.write_cir(cirs, { 1e-6 }, n);
+	}
+}
+
+/**
+ * \brief Opens the file and reads its first CIR, and prints the times.
+ */
+static void run(const string &name, const string &file_name, size_t nof_cirs,
+		bool lazy_open) {
+	const auto start = chrono::steady_clock::now();
+	CDX::ReadContinuousDelayFile cdx_in(file_name,
+			H5::FileAccPropList::DEFAULT, lazy_open);
+	const double open_s = seconds_since(start);
+
+	const auto read_start = chrono::steady_clock::now();
+	if (cdx_in.get_cir(0, 0).components.size() != 2)
+		throw runtime_error("cdx-bench-lazy-open: wrong first CIR.");
+	const double read_s = seconds_since(read_start);
+
+	if (cdx_in.get_nof_cirs() != nof_cirs)
+		throw runtime_error("cdx-bench-lazy-open: wrong number of CIRs.");
+
+	cout << "  " << name << ": open " << 1e3 * open_s << " ms, first CIR "
+			<< 1e3 * read_s << " ms";
+
+	if (lazy_open) {
+		const auto verify_start = chrono::steady_clock::now();
+		cdx_in.verify_nof_cirs();
+		cout << ", verify_nof_cirs " << 1e3 * seconds_since(verify_start)
+				<< " ms";
+	}
+	cout << "\n";
+}
+
+int main(int argc, char *argv[]) {
+	const size_t nof_cirs = argc > 1 ? strtoul(argv[1], nullptr, 10) : 1000000;
+	const string file_name = "cdx-bench-lazy-open.cdx";
+
+	cout << "cdx-bench-lazy-open: " << nof_cirs
+			<< " CIRs of 1 link, 2 components per CIR\n";
+
+	const auto start = chrono::steady_clock::now();
+	write_file(file_name, nof_cirs);
+	cout << "  writing: " << seconds_since(start) << " s\n";
+
+	// the first open reads the file into the page cache for both:
+	run("eager", file_name, nof_cirs, false);
+	run("eager", file_name, nof_cirs, false);
+	run("lazy", file_name, nof_cirs, true);
+	cout.flush();
+
+	remove(file_name.c_str());
+
+	return 0;
+}
@@ -0,0 +1,129 @@
+/**
+ * \file cdx-bench-merge.cpp
+ *
+ * \brief Compares CDX::merge with bulk copy against reading and writing every CIR, for
+ * chunk files of a simulated drive concatenated along time and for files with disjoint
+ * links.
+ *
+ * The naive merge converts each component from the file format and back and passes it
+ * through the writer. The bulk copy copies the datasets of the CIRs with H5Ocopy, or with
+ * disjoint links the whole link groups.
+ */
+
+#include "../../cdx/WriteContinuousDelayFile.h"
+#include "../../cdx/ReadContinuousDelayFile.h"
+#include "../../cdx/Merge.h"
+
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <stdexcept>
+
+using namespace std;
+
+/**
+ * \brief Returns the time in s that has passed since start.
+ */
+static double seconds_since(chrono::steady_clock::time_point start) {
+	return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * \brief Writes a chunk file of some links, the CIRs are numbered from first_cir over all chunks.
+ */
+static void write_chunk(const string &file_name,
+		const vector<string> &link_names, CDX::cir_number_t first_cir,
+		size_t nof_cirs, size_t nof_components) {
+	CDX::links_to_component_types_t links_to_component_types;
+	for (const auto &link_name : link_names)
+		links_to_component_types[link_name] = { { 0, "LOS" }, { 1,
+				"Scatterer" } };
+
+	CDX::WriteContinuousDelayFile cdx_out(file_name, 3e8, 1000.0, 1e9,
+			link_names, links_to_component_types);
+
+	vector<CDX::components_t> cirs(link_names.size(),
+			CDX::components_t(nof_components));
+	for (CDX::cir_number_t n = 0; n < nof_cirs; n++) {
+		for (auto &cir : cirs)
+			for (size_t c = 0; c < nof_components; c++) {
+				cir[c].type = c == 0 ? 0 : 1;
+				cir[c].id = c;
+				cir[c].delay = 1e-6 + c * 10e-9 + (first_cir + n) * 1e-12;
+				cir[c].amplitude = complex<double>(1.0, 0.5);
+			}
+		cdx_out.write_cir(cirs, vector<double>(link_names.size(), 0.0), n);
+	}
+}
+
+/**
+ * \brief Merges files with and without bulk copy and prints the rates.
+ */
+static void run(const string &name, const vector<string> &file_names,
+		CDX::merge_mode_t mode) {
+	const string output_file_name = "cdx-bench-merge-output.cdx";
+
+	double seconds[2] = { 0.0, 0.0 };
+	CDX::merge_stats_t stats;
+	for (bool bulk_copy : { false, true }) {
+		CDX::merge_options_t options;
+		options.mode = mode;
+		options.bulk_copy = bulk_copy;
+
+		const auto start = chrono::steady_clock::now();
+		stats = CDX::merge(file_names, output_file_name, options);
+		seconds[bulk_copy] = seconds_since(start);
+
+		CDX::ReadContinuousDelayFile cdx_in(output_file_name);
+		if (cdx_in.get_nof_cirs() != stats.nof_cirs
+				or cdx_in.get_nof_links() != stats.nof_links)
+			throw runtime_error("cdx-bench-merge: merged file is incomplete.");
+	}
+
+	const double nof_cirs = stats.nof_cirs * stats.nof_links;
+	cout << "  " << name << ", read and write: " << nof_cirs / seconds[0]
+			<< " CIRs/s\n";
+	cout << "  " << name << ", bulk copy: " << nof_cirs / seconds[1]
+			<< " CIRs/s (" << seconds[0] / seconds[1] << "x)\n";
+
+	remove(output_file_name.c_str());
+}
+
+int main(void) {
+	const size_t nof_chunks = 8;
+	const size_t nof_cirs_per_chunk = 2500;
+	const size_t nof_components = 20;
+
+	cout << "cdx-bench-merge: " << nof_chunks << " files of "
+			<< nof_cirs_per_chunk << " CIRs, " << nof_components
+			<< " components per CIR\n";
+
+	// chunks of a drive with two links:
+	vector<string> time_file_names;
+	for (size_t k = 0; k < nof_chunks; k++) {
+		time_file_names.push_back(
+				"cdx-bench-merge-time" + to_string(k) + ".cdx");
+		write_chunk(time_file_names.back(), { "link0", "link1" },
+				k * nof_cirs_per_chunk, nof_cirs_per_chunk, nof_components);
+	}
+
+	// one file per link of the same drive:
+	vector<string> links_file_names;
+	for (size_t k = 0; k < nof_chunks; k++) {
+		links_file_names.push_back(
+				"cdx-bench-merge-links" + to_string(k) + ".cdx");
+		write_chunk(links_file_names.back(), { "link" + to_string(k) }, 0,
+				nof_cirs_per_chunk, nof_components);
+	}
+
+	run("along time", time_file_names, CDX::merge_time);
+	run("disjoint links", links_file_names, CDX::merge_links);
+	cout.flush();
+
+	for (const auto &file_name : time_file_names)
+		remove(file_name.c_str());
+	for (const auto &file_name : links_file_names)
+		remove(file_name.c_str());
+
+	return 0;
+}
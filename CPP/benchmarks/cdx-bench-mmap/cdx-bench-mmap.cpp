@@ -0,0 +1,131 @@
+/**
+ * \file cdx-bench-mmap.cpp
+ *
+ * \brief Measures the scan throughput of ReadContinuousDelayFile::get_cir_view with and
+ * without memory-mapped access, and of get_cir for reference.
+ *
+ * Each scan sums the delays of all components of all CIRs so that the data is actually
+ * touched.
+ */
+
+#include "../../cdx/WriteContinuousDelayFile.h"
+#include "../../cdx/ReadContinuousDelayFile.h"
+
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <stdexcept>
+
+using namespace std;
+
+/**
+ * \brief Returns the time in s that has passed since start.
+ */
+static double seconds_since(chrono::steady_clock::time_point start) {
+	return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * \brief Scans all CIRs of a link through views and returns the sum of all delays.
+ */
+static double scan_views(CDX::ReadContinuousDelayFile &cdx_in,
+		const string &link, size_t &nof_mapped) {
+	double sum = 0.0;
+	nof_mapped = 0;
+	for (CDX::cir_number_t k = 0; k < cdx_in.get_nof_cirs(); k++) {
+		const CDX::DataView<CDX::hdf5_impulse_t> view = cdx_in.get_cir_view(
+				link, k);
+		for (const auto &component : view)
+			sum += component.delay;
+		if (view.is_mapped())
+			nof_mapped++;
+	}
+	return sum;
+}
+
+int main(void) {
+	const string file_name = "cdx-bench-mmap.cdx";
+	const string link = "link0";
+
+	const size_t nof_cirs = 20000;
+	const size_t nof_components = 100;
+
+	{
+		CDX::component_types_t component_types = { { 0, "LOS" }, { 256,
+				"Scatterer" } };
+		CDX::links_to_component_types_t links_to_component_types = { { link,
+				component_types } };
+
+		CDX::WriteContinuousDelayFile cdx_out(file_name, 3e8, 1000.0, 1e9, {
+				link }, links_to_component_types);
+
+		CDX::components_t components(nof_components);
+		for (CDX::cir_number_t cir_number = 0; cir_number < nof_cirs;
+				cir_number++) {
+			for (size_t c = 0; c < nof_components; c++) {
+				components.at(c).type = c == 0 ? 0 : 256;
+				components.at(c).id = c;
+				components.at(c).delay = 1e-6 + c * 10e-9;
+				components.at(c).amplitude = complex<double>(1.0, 0.0);
+			}
+
+			cdx_out.write_cir( { { link, components } }, { { link, 0.0 } },
+					cir_number);
+		}
+	}
+
+	CDX::ReadContinuousDelayFile cdx_in(file_name);
+
+	const double megabytes = nof_cirs * nof_components
+			* sizeof(CDX::hdf5_impulse_t) / 1024.0 / 1024.0;
+
+	size_t nof_mapped = 0;
+
+	// warm up the HDF5 metadata cache and the page cache:
+	cdx_in.set_mmap_enabled(false);
+	scan_views(cdx_in, link, nof_mapped);
+
+	cdx_in.set_mmap_enabled(false);
+	auto start = chrono::steady_clock::now();
+	const double sum_read = scan_views(cdx_in, link, nof_mapped);
+	const double read_s = seconds_since(start);
+
+	// the first scan looks up the location of each CIR in the file:
+	cdx_in.set_mmap_enabled(true);
+	start = chrono::steady_clock::now();
+	const double sum_mmap = scan_views(cdx_in, link, nof_mapped);
+	const double mmap_first_s = seconds_since(start);
+
+	// following scans use the known locations:
+	start = chrono::steady_clock::now();
+	const double sum_mmap_repeated = scan_views(cdx_in, link, nof_mapped);
+	const double mmap_repeated_s = seconds_since(start);
+
+	start = chrono::steady_clock::now();
+	double sum_get_cir = 0.0;
+	for (unsigned int k = 0; k < cdx_in.get_nof_cirs(); k++)
+		for (const auto &component : cdx_in.get_cir(link, k).components)
+			sum_get_cir += component.delay;
+	const double get_cir_s = seconds_since(start);
+
+	if (sum_mmap != sum_read or sum_mmap_repeated != sum_read
+			or sum_get_cir != sum_read)
+		throw runtime_error(
+				"cdx-bench-mmap: scans returned different data.");
+
+	cout << "cdx-bench-mmap: " << nof_cirs << " CIRs, " << megabytes
+			<< " MB of components\n";
+	cout << "  get_cir_view, H5Dread:        " << read_s << " s, "
+			<< megabytes / read_s << " MB/s\n";
+	cout << "  get_cir_view, mmap, first:    " << mmap_first_s << " s, "
+			<< megabytes / mmap_first_s << " MB/s, " << nof_mapped
+			<< " views mapped\n";
+	cout << "  get_cir_view, mmap, repeated: " << mmap_repeated_s << " s, "
+			<< megabytes / mmap_repeated_s << " MB/s\n";
+	cout << "  get_cir:                      " << get_cir_s << " s, "
+			<< megabytes / get_cir_s << " MB/s" << endl;
+
+	remove(file_name.c_str());
+
+	return 0;
+}
@@ -0,0 +1,135 @@
+/**
+ * \file cdx-bench-prefetch.cpp
+ *
+ * \brief Measures how much reading ahead with CIRPrefetcher overlaps reading and
+ * computing, compared to calling ReadContinuousDelayFile::get_cir in the loop.
+ *
+ * For each CIR, the consumer computes the channel transfer function at a number of
+ * frequencies. The file is evicted from the page cache before each run.
+ */
+
+#include "../../cdx/WriteContinuousDelayFile.h"
+#include "../../cdx/CIRPrefetcher.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <stdexcept>
+
+using namespace std;
+
+/**
+ * \brief Returns the time in s that has passed since start.
+ */
+static double seconds_since(chrono::steady_clock::time_point start) {
+	return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * \brief Removes a file from the page cache.
+ */
+static void evict_from_page_cache(const string &file_name) {
+	const int fd = open(file_name.c_str(), O_RDONLY);
+	if (fd < 0)
+		throw runtime_error("cdx-bench-prefetch: could not open file.");
+	fdatasync(fd);
+	posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+	close(fd);
+}
+
+/**
+ * \brief Returns the sum of the magnitudes of the transfer function of a CIR at a number of frequencies.
+ */
+static double process(const CDX::cir_t &cir) {
+	const size_t nof_frequencies = 64;
+
+	double sum = 0.0;
+	for (size_t f = 0; f < nof_frequencies; f++) {
+		const double omega = 2.0 * M_PI * (f * 1e6);
+		complex<double> H(0.0, 0.0);
+		for (const auto &component : cir.components)
+			H += component.amplitude
+					* polar(1.0, -omega * (cir.ref_delay + component.delay));
+		sum += abs(H);
+	}
+	return sum;
+}
+
+int main(void) {
+	const string file_name = "cdx-bench-prefetch.cdx";
+	const string link = "link0";
+
+	const size_t nof_cirs = 5000;
+	const size_t nof_components = 100;
+
+	{
+		CDX::component_types_t component_types = { { 0, "LOS" }, { 256,
+				"Scatterer" } };
+		CDX::links_to_component_types_t links_to_component_types = { { link,
+				component_types } };
+
+		CDX::WriteContinuousDelayFile cdx_out(file_name, 3e8, 1000.0, 1e9, {
+				link }, links_to_component_types);
+
+		CDX::components_t components(nof_components);
+		for (CDX::cir_number_t cir_number = 0; cir_number < nof_cirs;
+				cir_number++) {
+			for (size_t c = 0; c < nof_components; c++) {
+				components.at(c).type = c == 0 ? 0 : 256;
+				components.at(c).id = c;
+				components.at(c).delay = 1e-6 + c * 10e-9 + cir_number * 1e-12;
+				components.at(c).amplitude = complex<double>(1.0, 0.1 * c);
+			}
+
+			cdx_out.write_cir( { { link, components } }, { { link, 0.0 } },
+					cir_number);
+		}
+	}
+
+	cout << "cdx-bench-prefetch: " << nof_cirs << " CIRs with "
+			<< nof_components << " components, cold page cache\n";
+
+	evict_from_page_cache(file_name);
+	double reference_sum = 0.0;
+	auto start = chrono::steady_clock::now();
+	{
+		CDX::ReadContinuousDelayFile cdx_in(file_name);
+		for (unsigned int k = 0; k < nof_cirs; k++)
+			reference_sum += process(cdx_in.get_cir(link, k));
+	}
+	const double get_cir_s = seconds_since(start);
+	printf("  get_cir:          %8.3f s\n", get_cir_s);
+
+	for (size_t depth = 1; depth <= 64; depth *= 4) {
+		evict_from_page_cache(file_name);
+		double sum = 0.0;
+		CDX::prefetch_stats_t stats;
+
+		start = chrono::steady_clock::now();
+		{
+			CDX::SharedReadContinuousDelayFile cdx_in(file_name);
+			CDX::CIRPrefetcher prefetcher(cdx_in, link, depth);
+			for (CDX::cir_number_t k = 0; k < nof_cirs; k++)
+				sum += process(prefetcher.get_cir(k));
+			stats = prefetcher.get_stats();
+		}
+		const double prefetch_s = seconds_since(start);
+
+		if (sum != reference_sum)
+			throw runtime_error(
+					"cdx-bench-prefetch: prefetcher returned different data.");
+
+		printf(
+				"  depth %2zu:         %8.3f s, speedup %5.2f, %6llu hits, %6llu misses\n",
+				depth, prefetch_s, get_cir_s / prefetch_s,
+				(unsigned long long) stats.hits,
+				(unsigned long long) stats.misses);
+	}
+
+	remove(file_name.c_str());
+
+	return 0;
+}
@@ -0,0 +1,104 @@
+/**
+ * \file cdx-bench-query.cpp
+ *
+ * \brief Compares ReadContinuousDelayFile::query with a full scan of all CIRs using get_cir.
+ *
+ * A continuous-delay file is written whose component delays grow slowly over time, as it
+ * happens for a receiver moving away from the transmitter. A query for a narrow delay
+ * window then only touches a few blocks of CIRs while the full scan has to read every CIR
+ * in the time window.
+ */
+
+#include "../../cdx/WriteContinuousDelayFile.h"
+#include "../../cdx/ReadContinuousDelayFile.h"
+
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <stdexcept>
+
+using namespace std;
+
+/**
+ * \brief Returns the time in s that has passed since start.
+ */
+static double seconds_since(chrono::steady_clock::time_point start) {
+	return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+int main(void) {
+	const string file_name = "cdx-bench-query.cdx";
+	const string link = "link0";
+
+	const double cir_rate_Hz = 1000.0;
+	const size_t nof_cirs = 20000;
+	const size_t nof_components = 20;
+
+	{
+		CDX::component_types_t component_types = { { 0, "LOS" }, { 256,
+				"Scatterer" } };
+		CDX::links_to_component_types_t links_to_component_types = { { link,
+				component_types } };
+
+		CDX::WriteContinuousDelayFile cdx_out(file_name, 3e8, cir_rate_Hz, 1e9,
+				{ link }, links_to_component_types);
+
+		for (CDX::cir_number_t cir_number = 0; cir_number < nof_cirs;
+				cir_number++) {
+			CDX::components_t components(nof_components);
+
+			// delays grow by 1 ns per CIR, components are spaced by 10 ns:
+			for (size_t c = 0; c < nof_components; c++) {
+				components.at(c).type = c == 0 ? 0 : 256;
+				components.at(c).id = c;
+				components.at(c).delay = 1e-6 + cir_number * 1e-9 + c * 10e-9;
+				components.at(c).amplitude = complex<double>(1.0 / (c + 1), 0.0);
+			}
+
+			cdx_out.write_cir( { { link, components } }, { { link, 0.0 } },
+					cir_number);
+		}
+	}
+
+	CDX::ReadContinuousDelayFile cdx_in(file_name);
+
+	CDX::query_t query;
+	query.start_time_s = 0.0;
+	query.end_time_s = (nof_cirs - 1) / cir_rate_Hz;
+	query.min_delay_s = 5e-6;
+	query.max_delay_s = 5.5e-6;
+	query.types = { 256 };
+
+	// query using the delay bounds:
+	auto start = chrono::steady_clock::now();
+	const CDX::query_result_t result = cdx_in.query(link, query);
+	const double query_s = seconds_since(start);
+
+	// full scan:
+	start = chrono::steady_clock::now();
+	size_t nof_matches = 0;
+	for (unsigned int k = 0; k < cdx_in.get_nof_cirs(); k++) {
+		const CDX::cir_t cir = cdx_in.get_cir(link, k);
+		for (const auto &component : cir.components)
+			if (component.delay >= query.min_delay_s
+					and component.delay <= query.max_delay_s
+					and component.type == 256)
+				nof_matches++;
+	}
+	const double scan_s = seconds_since(start);
+
+	if (nof_matches != result.size())
+		throw runtime_error(
+				"cdx-bench-query: query and full scan selected a different number of components.");
+
+	cout << "cdx-bench-query: " << nof_cirs << " CIRs, " << result.size()
+			<< " matching components\n";
+	cout << "  query:     " << query_s << " s, " << result.nof_cirs_read
+			<< " CIRs read, " << result.nof_cirs_skipped << " CIRs skipped\n";
+	cout << "  full scan: " << scan_s << " s\n";
+	cout << "  speedup:   " << scan_s / query_s << endl;
+
+	remove(file_name.c_str());
+
+	return 0;
+}
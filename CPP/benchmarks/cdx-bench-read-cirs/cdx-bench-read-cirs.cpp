@@ -0,0 +1,106 @@
+/**
+ * \file cdx-bench-read-cirs.cpp
+ *
+ * \brief Compares reading all CIRs of a link with get_cir, one CIR per call, and with
+ * read_cirs in blocks of different sizes.
+ *
+ * Each scan sums the delays and the power of all components so that the data is actually
+ * touched.
+ */
+
+#include "../../cdx/WriteContinuousDelayFile.h"
+#include "../../cdx/ReadContinuousDelayFile.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <stdexcept>
+
+using namespace std;
+
+/**
+ * \brief Returns the time in s that has passed since start.
+ */
+static double seconds_since(chrono::steady_clock::time_point start) {
+	return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+int main(void) {
+	const string file_name = "cdx-bench-read-cirs.cdx";
+	const string link = "link0";
+
+	const size_t nof_cirs = 20000;
+	const size_t nof_components = 100;
+
+	{
+		CDX::component_types_t component_types = { { 0, "LOS" }, { 256,
+				"Scatterer" } };
+		CDX::links_to_component_types_t links_to_component_types = { { link,
+				component_types } };
+
+		CDX::WriteContinuousDelayFile cdx_out(file_name, 3e8, 1000.0, 1e9, {
+				link }, links_to_component_types);
+
+		vector<CDX::components_t> cirs(1,
+				CDX::components_t(nof_components));
+		for (CDX::cir_number_t cir_number = 0; cir_number < nof_cirs;
+				cir_number++) {
+			for (size_t c = 0; c < nof_components; c++) {
+				cirs[0][c].type = c == 0 ? 0 : 256;
+				cirs[0][c].id = c;
+				cirs[0][c].delay = 1e-6 + c * 10e-9;
+				cirs[0][c].amplitude = complex<double>(1.0, 0.5);
+			}
+			cdx_out.write_cir(cirs, vector<double>(1, 0.0), cir_number);
+		}
+	}
+
+	CDX::ReadContinuousDelayFile cdx_in(file_name);
+	const size_t link_index = cdx_in.get_link_index(link);
+
+	// warm up the HDF5 metadata cache and the page cache:
+	for (CDX::cir_number_t k = 0; k < nof_cirs; k++)
+		cdx_in.get_cir(link_index, k);
+
+	auto start = chrono::steady_clock::now();
+	double sum_get_cir = 0.0;
+	for (CDX::cir_number_t k = 0; k < nof_cirs; k++)
+		for (const auto &component : cdx_in.get_cir(link_index, k).components)
+			sum_get_cir += component.delay + norm(component.amplitude);
+	const double get_cir_s = seconds_since(start);
+
+	cout << "cdx-bench-read-cirs: " << nof_cirs << " CIRs, " << nof_components
+			<< " components per CIR\n";
+	cout << "  get_cir:                 " << get_cir_s << " s, "
+			<< nof_cirs / get_cir_s << " CIRs/s\n";
+
+	CDX::cir_block_t block;
+	for (size_t count : { 1, 16, 256, 4096 }) {
+		start = chrono::steady_clock::now();
+		double sum_read_cirs = 0.0;
+		for (CDX::cir_number_t first = 0; first < nof_cirs; first += count) {
+			cdx_in.read_cirs(link_index, first,
+					min<size_t>(count, nof_cirs - first), block);
+			for (size_t i = 0; i < block.size(); i++)
+				sum_read_cirs += block.delays[i]
+						+ block.reals[i] * block.reals[i]
+						+ block.imags[i] * block.imags[i];
+		}
+		const double read_cirs_s = seconds_since(start);
+
+		if (fabs(sum_read_cirs - sum_get_cir) > 1e-9 * fabs(sum_get_cir))
+			throw runtime_error(
+					"cdx-bench-read-cirs: scans returned different data.");
+
+		cout << "  read_cirs, " << count << " CIRs per block: "
+				<< read_cirs_s << " s, " << nof_cirs / read_cirs_s
+				<< " CIRs/s\n";
+	}
+	cout.flush();
+
+	remove(file_name.c_str());
+
+	return 0;
+}
@@ -0,0 +1,156 @@
+/**
+ * \file cdx-bench-reader-options.cpp
+ *
+ * \brief Measures windowed reads of a wide discrete-delay CDX file with different
+ * settings of get_reader_access_plist.
+ *
+ * The CIRs are read in blocks of consecutive CIRs. A window of delay samples slides over
+ * each block, so every chunk of the block, one CIR each, is read once per window unless
+ * the chunk cache holds the whole block. The file is evicted from the page cache before
+ * each run.
+ *
+ * The number of CIRs and of delay samples are 4096 and 1024 by default and can be given
+ * as the first and second argument.
+ */
+
+#include "../../cdx/WriteDiscreteDelayFile.h"
+#include "../../cdx/ReadDiscreteDelayFile.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+
+using namespace std;
+
+const size_t nof_cirs_per_block = 256;
+const size_t nof_delay_samples_per_window = 64;
+
+/**
+ * \brief Returns the time in s that has passed since start.
+ */
+static double seconds_since(chrono::steady_clock::time_point start) {
+	return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * \brief Removes a file from the page cache.
+ */
+static void evict_from_page_cache(const string &file_name) {
+	const int fd = open(file_name.c_str(), O_RDONLY);
+	if (fd < 0)
+		throw runtime_error("cdx-bench-reader-options: could not open file.");
+	fdatasync(fd);
+	posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+	close(fd);
+}
+
+static void write_file(const string &file_name, size_t nof_cirs,
+		size_t nof_delay_samples) {
+	CDX::WriteDiscreteDelayFile cdx_out(file_name, 3e8, 1000.0, 1e9,
+			{ "link0" }, 100e6);
+	cdx_out.setup_link(0, nof_delay_samples, 0.0);
+
+	vector<complex<double> > cir(nof_delay_samples);
+	for (size_t k = 0; k < nof_cirs; k++) {
+		for (size_t n = 0; n < cir.size(); n++)
+			cir[n] = complex<double>(k, n);
+		cdx_out.append_cir_snapshot(0, cir, 1e-6);
+	}
+}
+
+/**
+ * \brief Reads all windows of all blocks of CIRs and prints the time.
+ */
+static void run(const string &name, const string &file_name,
+		const CDX::reader_options_t &options) {
+	evict_from_page_cache(file_name);
+
+	const auto start = chrono::steady_clock::now();
+	CDX::ReadDiscreteDelayFile cdx_in(file_name,
+			CDX::get_reader_access_plist(options));
+	const double open_s = seconds_since(start);
+
+	const size_t nof_cirs = cdx_in.get_nof_cirs(0);
+	const size_t nof_delay_samples = cdx_in.get_nof_delay_samples(0);
+
+	double sum = 0.0;
+	for (size_t first_cir = 0; first_cir + nof_cirs_per_block <= nof_cirs;
+			first_cir += nof_cirs_per_block)
+		for (size_t first_sample = 0;
+				first_sample + nof_delay_samples_per_window <= nof_delay_samples;
+				first_sample += nof_delay_samples_per_window) {
+			const auto cirs = cdx_in.get_cirs(0, first_cir, nof_cirs_per_block,
+					first_sample, nof_delay_samples_per_window);
+			sum += cirs.back().back().real();
+		}
+
+	const double total_s = seconds_since(start);
+	if (sum <= 0.0)
+		throw runtime_error("cdx-bench-reader-options: wrong CIRs.");
+
+	cout << "  " << name << ": open " << 1e3 * open_s << " ms, total "
+			<< 1e3 * total_s << " ms\n";
+}
+
+int main(int argc, char *argv[]) {
+	const size_t nof_cirs = argc > 1 ? strtoul(argv[1], nullptr, 10) : 4096;
+	const size_t nof_delay_samples =
+			argc > 2 ? strtoul(argv[2], nullptr, 10) : 1024;
+	const string file_name = "cdx-bench-reader-options.cdx";
+
+	cout << "cdx-bench-reader-options: " << nof_cirs << " CIRs of "
+			<< nof_delay_samples << " delay samples, windows of "
+			<< nof_cirs_per_block << " CIRs and "
+			<< nof_delay_samples_per_window << " delay samples\n";
+
+	write_file(file_name, nof_cirs, nof_delay_samples);
+
+	// a block of CIRs of one of the two datasets:
+	const size_t block_size = nof_cirs_per_block * nof_delay_samples
+			* sizeof(double);
+
+	CDX::reader_options_t options;
+	run("HDF5 defaults, 1 MB chunk cache", file_name, options);
+
+	options.chunk_cache_size = 2 * block_size;
+	run("chunk cache of 2 blocks, 521 slots", file_name, options);
+
+	options.chunk_cache_slots = 100003;
+	run("chunk cache of 2 blocks, 100003 slots", file_name, options);
+
+	options.chunk_cache_w0 = 0.0;
+	run("chunk cache of 2 blocks, 100003 slots, w0 0", file_name, options);
+
+	options.chunk_cache_w0 = -1.0;
+	options.metadata_cache_size = 1 << 20;
+	run("chunk cache of 2 blocks, 100003 slots, 1 MB metadata cache",
+			file_name, options);
+
+	options.metadata_cache_size = 0;
+	options.driver = CDX::core_driver;
+	run("chunk cache of 2 blocks, 100003 slots, core driver", file_name,
+			options);
+
+	options.chunk_cache_size = 0;
+	options.chunk_cache_slots = 0;
+	run("HDF5 defaults, core driver", file_name, options);
+
+#ifdef H5_HAVE_DIRECT
+	options.chunk_cache_size = 2 * block_size;
+	options.chunk_cache_slots = 100003;
+	options.driver = CDX::direct_driver;
+	run("chunk cache of 2 blocks, 100003 slots, direct driver", file_name,
+			options);
+#endif
+
+	cout.flush();
+
+	remove(file_name.c_str());
+
+	return 0;
+}
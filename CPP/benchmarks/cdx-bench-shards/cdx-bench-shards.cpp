@@ -0,0 +1,196 @@
+/**
+ * \file cdx-bench-shards.cpp
+ *
+ * \brief Measures how simulating and writing CIRs scales with the number of worker threads,
+ * writing to a single file against writing shards with CDX::ShardedWriteContinuousDelayFile,
+ * and compares reading the master file with reading the single file.
+ *
+ * Each worker thread computes the components of a CIR with some arithmetic that stands in
+ * for a channel simulation. With a single file, the workers compute chunks of CIRs and hand
+ * them to one WriteContinuousDelayFile with asynchronous writer in order. With shards, each
+ * worker computes a contiguous range of CIRs and writes it to its own shard.
+ */
+
+#include "../../cdx/Shards.h"
+#include "../../cdx/ReadContinuousDelayFile.h"
+
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdio>
+#include <iostream>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+using namespace std;
+
+const size_t nof_cirs = 8192;
+const size_t nof_components = 20;
+const size_t cirs_per_chunk = 64;
+
+/**
+ * \brief Returns the time in s that has passed since start.
+ */
+static double seconds_since(chrono::steady_clock::time_point start) {
+	return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * \brief Computes the components of a CIR of a moving receiver.
+ */
+static CDX::components_t simulate(CDX::cir_number_t cir_number) {
+	CDX::components_t components(nof_components);
+	for (size_t c = 0; c < nof_components; c++) {
+		// sum of the contributions of the facets of a scatterer:
+		double phase = 0.0;
+		for (size_t k = 1; k <= 100; k++)
+			phase += sin(1e-3 * cir_number * k + c) / k;
+
+		components[c].type = c == 0 ? 0 : 1;
+		components[c].id = c;
+		components[c].delay = 1e-6 + c * 10e-9 + cir_number * 1e-12;
+		components[c].amplitude = polar(1.0 / (1.0 + c), phase);
+	}
+	return components;
+}
+
+/**
+ * \brief Simulates all CIRs in chunks and writes them to one file in order.
+ */
+static void write_single_file(const string &file_name, size_t nof_threads,
+		CDX::links_to_component_types_t &component_types) {
+	CDX::WriteContinuousDelayFile cdx_out(file_name, 3e8, 1000.0, 1e9, {
+			"link0" }, component_types);
+	cdx_out.enable_async_writer(cirs_per_chunk);
+
+	mutex m;
+	condition_variable turn;
+	size_t next_chunk = 0; // the next chunk a worker computes
+	size_t next_written_chunk = 0; // the next chunk that is written
+
+	auto worker = [&]() {
+		for (;;) {
+			size_t chunk;
+			{
+				lock_guard<mutex> lock(m);
+				chunk = next_chunk++;
+			}
+
+			const CDX::cir_number_t first_cir = chunk * cirs_per_chunk;
+			if (first_cir >= nof_cirs)
+				return;
+
+			vector<CDX::components_t> cirs;
+			for (CDX::cir_number_t n = first_cir;
+					n < first_cir + cirs_per_chunk; n++)
+				cirs.push_back(simulate(n));
+
+			unique_lock<mutex> lock(m);
+			turn.wait(lock, [&]() {return next_written_chunk == chunk;});
+			for (size_t k = 0; k < cirs.size(); k++)
+				cdx_out.write_cir( { std::move(cirs[k]) }, { 0.0 },
+						first_cir + k);
+			next_written_chunk++;
+			turn.notify_all();
+		}
+	};
+
+	vector<thread> threads;
+	for (size_t t = 0; t < nof_threads; t++)
+		threads.emplace_back(worker);
+	for (auto &t : threads)
+		t.join();
+
+	cdx_out.flush();
+}
+
+/**
+ * \brief Simulates the CIRs of each shard in a worker thread of its own.
+ */
+static void write_shards(const string &file_name, size_t nof_threads,
+		CDX::links_to_component_types_t &component_types) {
+	CDX::ShardedWriteContinuousDelayFile cdx_out(file_name, 3e8, 1000.0, 1e9,
+			{ "link0" }, component_types, nof_cirs, nof_threads,
+			cirs_per_chunk);
+
+	auto worker = [&](size_t shard) {
+		const CDX::shard_range_t range = cdx_out.get_shard_range(shard);
+		for (CDX::cir_number_t n = range.first_cir;
+				n < range.first_cir + range.nof_cirs; n++)
+			cdx_out.write_cir( { simulate(n) }, { 0.0 }, n);
+	};
+
+	vector<thread> threads;
+	for (size_t t = 0; t < nof_threads; t++)
+		threads.emplace_back(worker, t);
+	for (auto &t : threads)
+		t.join();
+
+	cdx_out.finalize();
+}
+
+/**
+ * \brief Reads all CIRs of a file and returns the rate in CIRs/s.
+ */
+static double read_rate(const string &file_name) {
+	const auto start = chrono::steady_clock::now();
+
+	CDX::ReadContinuousDelayFile cdx_in(file_name);
+	size_t nof_read_components = 0;
+	for (CDX::cir_number_t n = 0; n < cdx_in.get_nof_cirs(); n++)
+		nof_read_components += cdx_in.get_cir(0, n).components.size();
+
+	if (nof_read_components != nof_cirs * nof_components)
+		throw runtime_error("cdx-bench-shards: file is incomplete.");
+
+	return nof_cirs / seconds_since(start);
+}
+
+int main(void) {
+	cout << "cdx-bench-shards: " << nof_cirs << " CIRs, " << nof_components
+			<< " components per CIR, " << thread::hardware_concurrency()
+			<< " hardware threads\n";
+
+	CDX::links_to_component_types_t component_types;
+	component_types["link0"] = { { 0, "LOS" }, { 1, "Scatterer" } };
+
+	const string single_file_name = "cdx-bench-shards-single.cdx";
+	const string master_file_name = "cdx-bench-shards-master.cdx";
+
+	const vector<size_t> nof_threads_list = { 1, 2, 4, 8 };
+	for (size_t nof_threads : nof_threads_list) {
+		auto start = chrono::steady_clock::now();
+		write_single_file(single_file_name, nof_threads, component_types);
+		const double single_seconds = seconds_since(start);
+
+		start = chrono::steady_clock::now();
+		write_shards(master_file_name, nof_threads, component_types);
+		const double shards_seconds = seconds_since(start);
+
+		cout << "  " << nof_threads << " threads: single file "
+				<< nof_cirs / single_seconds << " CIRs/s, shards "
+				<< nof_cirs / shards_seconds << " CIRs/s ("
+				<< single_seconds / shards_seconds << "x)\n";
+		cout.flush();
+
+		// the master file of the most shards is read below:
+		if (nof_threads != nof_threads_list.back())
+			for (size_t k = 0; k < nof_threads; k++)
+				remove(CDX::get_shard_file_name(master_file_name, k).c_str());
+	}
+
+	const double single_read_rate = read_rate(single_file_name);
+	const double master_read_rate = read_rate(master_file_name);
+	cout << "  reading single file: " << single_read_rate << " CIRs/s\n";
+	cout << "  reading master file of " << nof_threads_list.back()
+			<< " shards: " << master_read_rate << " CIRs/s ("
+			<< master_read_rate / single_read_rate << "x)\n";
+
+	remove(single_file_name.c_str());
+	remove(master_file_name.c_str());
+	for (size_t k = 0; k < nof_threads_list.back(); k++)
+		remove(CDX::get_shard_file_name(master_file_name, k).c_str());
+
+	return 0;
+}
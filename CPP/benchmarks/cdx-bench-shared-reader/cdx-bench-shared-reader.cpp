@@ -0,0 +1,119 @@
+/**
+ * \file cdx-bench-shared-reader.cpp
+ *
+ * \brief Measures the aggregate get_cir throughput of SharedReadContinuousDelayFile for
+ * 1 to 32 client threads, with the HDF5 mutex taken by each client and with a
+ * dedicated I/O thread.
+ *
+ * The CIRs of the file are distributed round-robin over the client threads, so
+ * concurrent requests are for adjacent CIRs.
+ */
+
+#include "../../cdx/WriteContinuousDelayFile.h"
+#include "../../cdx/SharedReadContinuousDelayFile.h"
+
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <stdexcept>
+#include <thread>
+
+using namespace std;
+
+/**
+ * \brief Returns the time in s that has passed since start.
+ */
+static double seconds_since(chrono::steady_clock::time_point start) {
+	return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * \brief Reads all CIRs of a link with a number of client threads and returns the sum of all delays.
+ */
+static double read_all(CDX::SharedReadContinuousDelayFile &cdx_in,
+		const string &link, size_t nof_threads) {
+	vector<double> sums(nof_threads, 0.0);
+	vector<thread> clients;
+
+	for (size_t t = 0; t < nof_threads; t++)
+		clients.push_back(thread([&cdx_in, &link, &sums, t, nof_threads] {
+			for (CDX::cir_number_t k = t; k < cdx_in.get_nof_cirs(); k += nof_threads)
+			for (const auto &component : cdx_in.get_cir(link, k).components)
+			sums[t] += component.delay;
+		}));
+
+	for (auto &client : clients)
+		client.join();
+
+	double sum = 0.0;
+	for (auto s : sums)
+		sum += s;
+	return sum;
+}
+
+int main(void) {
+	const string file_name = "cdx-bench-shared-reader.cdx";
+	const string link = "link0";
+
+	const size_t nof_cirs = 20000;
+	const size_t nof_components = 50;
+
+	{
+		CDX::component_types_t component_types = { { 0, "LOS" }, { 256,
+				"Scatterer" } };
+		CDX::links_to_component_types_t links_to_component_types = { { link,
+				component_types } };
+
+		CDX::WriteContinuousDelayFile cdx_out(file_name, 3e8, 1000.0, 1e9, {
+				link }, links_to_component_types);
+
+		CDX::components_t components(nof_components);
+		for (CDX::cir_number_t cir_number = 0; cir_number < nof_cirs;
+				cir_number++) {
+			for (size_t c = 0; c < nof_components; c++) {
+				components.at(c).type = c == 0 ? 0 : 256;
+				components.at(c).id = c;
+				components.at(c).delay = 1e-6 + c * 10e-9;
+				components.at(c).amplitude = complex<double>(1.0, 0.0);
+			}
+
+			cdx_out.write_cir( { { link, components } }, { { link, 0.0 } },
+					cir_number);
+		}
+	}
+
+	cout << "cdx-bench-shared-reader: " << nof_cirs << " CIRs with "
+			<< nof_components << " components, aggregate get_cir throughput\n";
+	cout << "  threads   HDF5 mutex [CIRs/s]   I/O thread [CIRs/s]\n";
+
+	double reference_sum = -1.0;
+
+	for (size_t nof_threads = 1; nof_threads <= 32; nof_threads *= 2) {
+		double cirs_per_s[2];
+
+		for (int use_io_thread = 0; use_io_thread < 2; use_io_thread++) {
+			CDX::SharedReadContinuousDelayFile cdx_in(file_name,
+					use_io_thread == 1);
+
+			// warm up the HDF5 metadata cache and the page cache:
+			read_all(cdx_in, link, 1);
+
+			const auto start = chrono::steady_clock::now();
+			const double sum = read_all(cdx_in, link, nof_threads);
+			cirs_per_s[use_io_thread] = nof_cirs / seconds_since(start);
+
+			if (reference_sum < 0.0)
+				reference_sum = sum;
+			else if (abs(sum - reference_sum) > 1e-9 * reference_sum)
+				throw runtime_error(
+						"cdx-bench-shared-reader: threads returned different data.");
+		}
+
+		printf("  %7zu   %19.0f   %19.0f\n", nof_threads, cirs_per_s[0],
+				cirs_per_s[1]);
+	}
+
+	remove(file_name.c_str());
+
+	return 0;
+}
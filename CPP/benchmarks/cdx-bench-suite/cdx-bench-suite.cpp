@@ -0,0 +1,504 @@
+/**
+ * \file cdx-bench-suite.cpp
+ *
+ * \brief Runs parameterized benchmarks of writing, reading and converting CDX files and
+ * reports the results on the console and as JSON, to track the performance of the library
+ * across releases.
+ *
+ * Each benchmark runs over the grid of the parameters it depends on: links, CIRs per link,
+ * components per CIR and delay samples per CIR:
+ *
+ * - write_cir writes a continuous-delay file,
+ * - get_cir_sequential reads all CIRs of a continuous-delay file in order,
+ * - get_cir_random reads as many CIRs at random positions,
+ * - append_cir_snapshot writes a discrete-delay file,
+ * - convert converts a continuous-delay file into a discrete-delay file with
+ *   CDX::sample_components, the interpolation of the tool cdx-convert-continuous-to-discrete,
+ *   without its optional filter. The tool is built separately in tools/ with Armadillo and
+ *   Boost.
+ *
+ * Input files are written before the time is taken. The options follow those of Google
+ * Benchmark, so results can be compared with its tools:
+ *
+ * - --benchmark_filter=<regex> runs only the benchmarks whose names match,
+ * - --benchmark_repetitions=<n> repeats each benchmark n times (3 by default) and adds the
+ *   mean, median and standard deviation of the repetitions,
+ * - --benchmark_out=<file> writes the results as JSON to a file,
+ * - --benchmark_list_tests lists the names of the benchmarks without running them.
+ *
+ * Times are in ms. The CPU time is the time of the process, including the threads of the
+ * library.
+ */
+
+#include "../../cdx/Convert.h"
+#include "../../cdx/WriteContinuousDelayFile.h"
+#include "../../cdx/ReadContinuousDelayFile.h"
+#include "../../cdx/WriteDiscreteDelayFile.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <regex>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+using namespace std;
+
+const double cir_rate_Hz = 1000.0;
+const double delay_sampling_frequency_Hz = 100e6;
+
+/**
+ * \brief A point of the parameter grid, parameters a benchmark does not depend on are 0.
+ */
+struct parameters_t {
+	size_t nof_links;
+	size_t nof_cirs; ///< CIRs per link
+	size_t nof_components; ///< components per CIR
+	size_t nof_delay_samples; ///< delay samples per CIR of a discrete-delay file
+};
+
+/**
+ * \brief The values of each parameter in the grid.
+ */
+const vector<size_t> nof_links_values = { 1, 4 };
+const vector<size_t> nof_cirs_values = { 500, 2000 };
+const vector<size_t> nof_components_values = { 8, 64 };
+const vector<size_t> nof_delay_samples_values = { 64, 512 };
+
+/**
+ * \brief Measures the time of the code between start and stop, like benchmark::State.
+ */
+class run_timer_t {
+public:
+	void start() {
+		start_time = chrono::steady_clock::now();
+		start_clock = clock();
+	}
+
+	void stop() {
+		real_s = chrono::duration<double>(
+				chrono::steady_clock::now() - start_time).count();
+		cpu_s = double(clock() - start_clock) / CLOCKS_PER_SEC;
+	}
+
+	double real_s = 0.0;
+	double cpu_s = 0.0;
+	size_t nof_items = 0; ///< number of CIRs processed, for items_per_second
+
+private:
+	chrono::steady_clock::time_point start_time;
+	clock_t start_clock;
+};
+
+typedef void (*benchmark_function_t)(const parameters_t&, run_timer_t&);
+
+struct benchmark_t {
+	string name;
+	benchmark_function_t function;
+	bool uses_components; ///< the grid includes components per CIR
+	bool uses_delay_samples; ///< the grid includes delay samples per CIR
+};
+
+const string continuous_file_name = "cdx-bench-suite-continuous.cdx";
+const string discrete_file_name = "cdx-bench-suite-discrete.cdx";
+
+static vector<string> get_link_names(size_t nof_links) {
+	vector<string> link_names;
+	for (size_t l = 0; l < nof_links; l++)
+		link_names.push_back("link" + to_string(l));
+	return link_names;
+}
+
+/**
+ * \brief Returns the components of a CIR, a LOS component and scatterers.
+ */
+static CDX::components_t get_components(size_t nof_components,
+		CDX::cir_number_t cir_number) {
+	CDX::components_t components(nof_components);
+	for (size_t c = 0; c < nof_components; c++) {
+		components[c].type = c == 0 ? 0 : 256;
+		components[c].id = c;
+		components[c].delay = 1e-6 + c * 10e-9 + cir_number * 1e-12;
+		components[c].amplitude = polar(1.0 / (c + 1), 0.1 * c);
+	}
+	return components;
+}
+
+static void write_continuous_file(const parameters_t &parameters) {
+	const vector<string> link_names = get_link_names(parameters.nof_links);
+	CDX::links_to_component_types_t component_types;
+	for (const auto &link_name : link_names)
+		component_types[link_name] = { { 0, "LOS" }, { 256, "Scatterer" } };
+
+	CDX::WriteContinuousDelayFile cdx_out(continuous_file_name, 3e8,
+			cir_rate_Hz, 1e9, link_names, component_types);
+
+	vector<CDX::components_t> cirs(parameters.nof_links);
+	const vector<double> reference_delays(parameters.nof_links, 1e-6);
+	for (CDX::cir_number_t n = 0; n < parameters.nof_cirs; n++) {
+		for (auto &cir : cirs)
+			cir = get_components(parameters.nof_components, n);
+		cdx_out.write_cir(cirs, reference_delays, n);
+	}
+}
+
+/**
+ * \brief Sums the power of the components so that the data is actually touched.
+ */
+static double get_power(const CDX::components_t &components) {
+	double power = 0.0;
+	for (const auto &component : components)
+		power += norm(component.amplitude);
+	return power;
+}
+
+static void bm_write_cir(const parameters_t &parameters, run_timer_t &timer) {
+	timer.start();
+	write_continuous_file(parameters);
+	timer.stop();
+	timer.nof_items = parameters.nof_links * parameters.nof_cirs;
+}
+
+static void bm_get_cir_sequential(const parameters_t &parameters,
+		run_timer_t &timer) {
+	write_continuous_file(parameters);
+
+	timer.start();
+	CDX::ReadContinuousDelayFile cdx_in(continuous_file_name);
+	double power = 0.0;
+	for (size_t l = 0; l < parameters.nof_links; l++)
+		for (CDX::cir_number_t n = 0; n < parameters.nof_cirs; n++)
+			power += get_power(cdx_in.get_cir(l, n).components);
+	timer.stop();
+	timer.nof_items = parameters.nof_links * parameters.nof_cirs;
+
+	if (power <= 0.0)
+		throw runtime_error("cdx-bench-suite: CIRs without power.");
+}
+
+static void bm_get_cir_random(const parameters_t &parameters,
+		run_timer_t &timer) {
+	write_continuous_file(parameters);
+
+	// the same positions in each repetition:
+	mt19937 generator(1);
+	uniform_int_distribution<size_t> link_distribution(0,
+			parameters.nof_links - 1);
+	uniform_int_distribution<CDX::cir_number_t> cir_distribution(0,
+			parameters.nof_cirs - 1);
+
+	timer.start();
+	CDX::ReadContinuousDelayFile cdx_in(continuous_file_name);
+	double power = 0.0;
+	for (size_t k = 0; k < parameters.nof_links * parameters.nof_cirs; k++) {
+		const size_t l = link_distribution(generator);
+		power += get_power(
+				cdx_in.get_cir(l, cir_distribution(generator)).components);
+	}
+	timer.stop();
+	timer.nof_items = parameters.nof_links * parameters.nof_cirs;
+
+	if (power <= 0.0)
+		throw runtime_error("cdx-bench-suite: CIRs without power.");
+}
+
+static void bm_append_cir_snapshot(const parameters_t &parameters,
+		run_timer_t &timer) {
+	vector<complex<double> > cir(parameters.nof_delay_samples);
+	for (size_t k = 0; k < cir.size(); k++)
+		cir[k] = polar(1.0 / (k + 1), 0.1 * k);
+
+	timer.start();
+	{
+		CDX::WriteDiscreteDelayFile cdx_out(discrete_file_name, 3e8,
+				cir_rate_Hz, 1e9, get_link_names(parameters.nof_links),
+				delay_sampling_frequency_Hz);
+		for (size_t l = 0; l < parameters.nof_links; l++)
+			cdx_out.setup_link(l, parameters.nof_delay_samples, 0.0);
+
+		for (size_t n = 0; n < parameters.nof_cirs; n++)
+			for (size_t l = 0; l < parameters.nof_links; l++)
+				cdx_out.append_cir_snapshot(l, cir, 1e-6);
+	}
+	timer.stop();
+	timer.nof_items = parameters.nof_links * parameters.nof_cirs;
+}
+
+static void bm_convert(const parameters_t &parameters, run_timer_t &timer) {
+	write_continuous_file(parameters);
+
+	timer.start();
+	{
+		CDX::ReadContinuousDelayFile cdx_in(continuous_file_name);
+		CDX::WriteDiscreteDelayFile cdx_out(discrete_file_name, 3e8,
+				cir_rate_Hz, 1e9, get_link_names(parameters.nof_links),
+				delay_sampling_frequency_Hz);
+
+		const double min_delay = 1e-6;
+		for (size_t l = 0; l < parameters.nof_links; l++)
+			cdx_out.setup_link(l, parameters.nof_delay_samples, min_delay);
+
+		vector<complex<double> > samples(parameters.nof_delay_samples);
+		for (CDX::cir_number_t n = 0; n < parameters.nof_cirs; n++)
+			for (size_t l = 0; l < parameters.nof_links; l++) {
+				const CDX::cir_t cir = cdx_in.get_cir(l, n);
+				CDX::sample_components(cir.components, min_delay,
+						delay_sampling_frequency_Hz, samples);
+				cdx_out.append_cir_snapshot(l, samples, cir.ref_delay);
+			}
+	}
+	timer.stop();
+	timer.nof_items = parameters.nof_links * parameters.nof_cirs;
+}
+
+const vector<benchmark_t> benchmarks = {
+		{ "write_cir", bm_write_cir, true, false },
+		{ "get_cir_sequential", bm_get_cir_sequential, true, false },
+		{ "get_cir_random", bm_get_cir_random, true, false },
+		{ "append_cir_snapshot", bm_append_cir_snapshot, false, true },
+		{ "convert", bm_convert, true, true } };
+
+/**
+ * \brief Returns the points of the parameter grid of a benchmark.
+ */
+static vector<parameters_t> get_grid(const benchmark_t &benchmark) {
+	const vector<size_t> unused = { 0 };
+	vector<parameters_t> grid;
+	for (size_t nof_links : nof_links_values)
+		for (size_t nof_cirs : nof_cirs_values)
+			for (size_t nof_components : benchmark.uses_components ?
+					nof_components_values : unused)
+				for (size_t nof_delay_samples : benchmark.uses_delay_samples ?
+						nof_delay_samples_values : unused)
+					grid.push_back( { nof_links, nof_cirs, nof_components,
+							nof_delay_samples });
+	return grid;
+}
+
+/**
+ * \brief Returns the name of a run, e.g. write_cir/links:1/cirs:1000/components:8.
+ */
+static string get_run_name(const benchmark_t &benchmark,
+		const parameters_t &parameters) {
+	string name = benchmark.name + "/links:" + to_string(parameters.nof_links)
+			+ "/cirs:" + to_string(parameters.nof_cirs);
+	if (benchmark.uses_components)
+		name += "/components:" + to_string(parameters.nof_components);
+	if (benchmark.uses_delay_samples)
+		name += "/delay_samples:" + to_string(parameters.nof_delay_samples);
+	return name;
+}
+
+/**
+ * \brief Returns a string with quotes and backslashes escaped for JSON.
+ */
+static string json_string(const string &s) {
+	string escaped = "\"";
+	for (char c : s) {
+		if (c == '"' or c == '\\')
+			escaped += '\\';
+		escaped += c;
+	}
+	return escaped + "\"";
+}
+
+/**
+ * \brief Collects the runs and their aggregates as JSON objects in the format of Google Benchmark.
+ */
+class json_report_t {
+public:
+	void add_run(const string &run_name, const parameters_t &parameters,
+			size_t repetitions, size_t repetition_index,
+			const run_timer_t &timer) {
+		ostringstream run;
+		run << "{\n      \"name\": " << json_string(run_name)
+				<< ",\n      \"run_name\": " << json_string(run_name)
+				<< ",\n      \"run_type\": \"iteration\""
+				<< ",\n      \"repetitions\": " << repetitions
+				<< ",\n      \"repetition_index\": " << repetition_index
+				<< ",\n      \"threads\": 1,\n      \"iterations\": 1"
+				<< get_times(timer.real_s, timer.cpu_s, timer.nof_items)
+				<< get_parameters(parameters) << "\n    }";
+		runs.push_back(run.str());
+	}
+
+	void add_aggregate(const string &run_name, const parameters_t &parameters,
+			size_t repetitions, const string &aggregate_name, double real_s,
+			double cpu_s, size_t nof_items) {
+		ostringstream run;
+		run << "{\n      \"name\": " << json_string(run_name + "_" + aggregate_name)
+				<< ",\n      \"run_name\": " << json_string(run_name)
+				<< ",\n      \"run_type\": \"aggregate\""
+				<< ",\n      \"repetitions\": " << repetitions
+				<< ",\n      \"threads\": 1"
+				<< ",\n      \"aggregate_name\": " << json_string(aggregate_name)
+				<< ",\n      \"iterations\": " << repetitions
+				<< get_times(real_s, cpu_s, nof_items)
+				<< get_parameters(parameters) << "\n    }";
+		runs.push_back(run.str());
+	}
+
+	void write(const string &file_name, const string &executable) const {
+		ofstream out(file_name);
+		if (not out)
+			throw runtime_error(
+					"cdx-bench-suite: could not open " + file_name + ".");
+
+		const time_t now = time(nullptr);
+		char date[32];
+		strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S%z", localtime(&now));
+
+		unsigned majnum, minnum, relnum;
+		H5get_libversion(&majnum, &minnum, &relnum);
+
+		out << "{\n  \"context\": {\n    \"date\": " << json_string(date)
+				<< ",\n    \"executable\": " << json_string(executable)
+				<< ",\n    \"num_cpus\": " << thread::hardware_concurrency()
+				<< ",\n    \"hdf5_version\": \"" << majnum << "." << minnum
+				<< "." << relnum << "\"\n  },\n  \"benchmarks\": [\n";
+		for (size_t k = 0; k < runs.size(); k++)
+			out << "    " << runs[k] << (k + 1 < runs.size() ? ",\n" : "\n");
+		out << "  ]\n}\n";
+	}
+
+private:
+	static string get_times(double real_s, double cpu_s, size_t nof_items) {
+		ostringstream times;
+		times << setprecision(10) << ",\n      \"real_time\": " << 1e3 * real_s
+				<< ",\n      \"cpu_time\": " << 1e3 * cpu_s
+				<< ",\n      \"time_unit\": \"ms\"";
+		if (real_s > 0.0 and nof_items > 0)
+			times << ",\n      \"items_per_second\": " << nof_items / real_s;
+		return times.str();
+	}
+
+	static string get_parameters(const parameters_t &parameters) {
+		ostringstream out;
+		out << ",\n      \"links\": " << parameters.nof_links
+				<< ",\n      \"cirs\": " << parameters.nof_cirs;
+		if (parameters.nof_components > 0)
+			out << ",\n      \"components\": " << parameters.nof_components;
+		if (parameters.nof_delay_samples > 0)
+			out << ",\n      \"delay_samples\": "
+					<< parameters.nof_delay_samples;
+		return out.str();
+	}
+
+	vector<string> runs;
+};
+
+static void print_run(const string &name, double real_s, double cpu_s,
+		size_t nof_items) {
+	cout << left << setw(64) << name << right << fixed << setprecision(1)
+			<< setw(12) << 1e3 * real_s << " ms" << setw(12) << 1e3 * cpu_s
+			<< " ms" << setw(14) << setprecision(0)
+			<< (real_s > 0.0 ? nof_items / real_s : 0.0) << " CIRs/s\n"
+			<< defaultfloat << flush;
+}
+
+/**
+ * \brief Returns the value of an option --<name>=<value> or nullptr if the argument is another option.
+ */
+static const char* get_option(const char *argument, const string &name) {
+	const string prefix = "--" + name + "=";
+	return string(argument).compare(0, prefix.size(), prefix) == 0 ?
+			argument + prefix.size() : nullptr;
+}
+
+int main(int argc, char *argv[]) {
+	regex filter(".*");
+	size_t repetitions = 3;
+	string out_file_name;
+	bool list_tests = false;
+
+	for (int k = 1; k < argc; k++) {
+		const char *value;
+		if ((value = get_option(argv[k], "benchmark_filter")))
+			filter = regex(value);
+		else if ((value = get_option(argv[k], "benchmark_repetitions")))
+			repetitions = max(1ul, strtoul(value, nullptr, 10));
+		else if ((value = get_option(argv[k], "benchmark_out")))
+			out_file_name = value;
+		else if (string(argv[k]) == "--benchmark_list_tests")
+			list_tests = true;
+		else {
+			cerr << "usage: " << argv[0]
+					<< " [--benchmark_filter=<regex>] [--benchmark_repetitions=<n>]"
+					<< " [--benchmark_out=<file>] [--benchmark_list_tests]\n";
+			return 1;
+		}
+	}
+
+	json_report_t report;
+	for (const auto &benchmark : benchmarks)
+		for (const auto &parameters : get_grid(benchmark)) {
+			const string run_name = get_run_name(benchmark, parameters);
+			if (not regex_search(run_name, filter))
+				continue;
+			if (list_tests) {
+				cout << run_name << "\n";
+				continue;
+			}
+
+			vector<double> real_s, cpu_s;
+			size_t nof_items = 0;
+			for (size_t r = 0; r < repetitions; r++) {
+				run_timer_t timer;
+				benchmark.function(parameters, timer);
+				print_run(run_name, timer.real_s, timer.cpu_s, timer.nof_items);
+				report.add_run(run_name, parameters, repetitions, r, timer);
+
+				real_s.push_back(timer.real_s);
+				cpu_s.push_back(timer.cpu_s);
+				nof_items = timer.nof_items;
+			}
+			if (repetitions < 2)
+				continue;
+
+			const auto mean = [](const vector<double> &v) {
+				double sum = 0.0;
+				for (double x : v)
+					sum += x;
+				return sum / v.size();
+			};
+			const auto median = [](vector<double> v) {
+				sort(v.begin(), v.end());
+				return v.size() % 2 ?
+						v[v.size() / 2] :
+						(v[v.size() / 2 - 1] + v[v.size() / 2]) / 2.0;
+			};
+			const auto stddev = [&](const vector<double> &v) {
+				const double m = mean(v);
+				double sum = 0.0;
+				for (double x : v)
+					sum += (x - m) * (x - m);
+				return sqrt(sum / (v.size() - 1));
+			};
+
+			print_run(run_name + "_mean", mean(real_s), mean(cpu_s), nof_items);
+			print_run(run_name + "_median", median(real_s), median(cpu_s),
+					nof_items);
+			report.add_aggregate(run_name, parameters, repetitions, "mean",
+					mean(real_s), mean(cpu_s), nof_items);
+			report.add_aggregate(run_name, parameters, repetitions, "median",
+					median(real_s), median(cpu_s), nof_items);
+			report.add_aggregate(run_name, parameters, repetitions, "stddev",
+					stddev(real_s), stddev(cpu_s), 0);
+		}
+
+	remove(continuous_file_name.c_str());
+	remove(discrete_file_name.c_str());
+
+	if (not out_file_name.empty() and not list_tests)
+		report.write(out_file_name, argv[0]);
+
+	return 0;
+}
@@ -0,0 +1,110 @@
+/**
+ * \file cdx-bench-swmr.cpp
+ *
+ * \brief Measures the cost of writing continuous-delay CDX files in SWMR mode with several
+ * flush cadences, compared to the normal writer.
+ *
+ * In SWMR mode the components are appended to one dataset per link and flushed every few
+ * CIRs, and CDX::compact_continuous_delay_file stores the CIRs as datasets of their own
+ * after the file has been closed. The rate of writing, the time of closing and the time
+ * of compacting are given separately.
+ */
+
+#include "../../cdx/WriteContinuousDelayFile.h"
+#include "../../cdx/ReadContinuousDelayFile.h"
+
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+
+using namespace std;
+
+/**
+ * \brief Returns the time in s that has passed since start.
+ */
+static double seconds_since(chrono::steady_clock::time_point start) {
+	return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * \brief Writes a file, in SWMR mode if flush_interval_cirs is not zero, and prints the rates.
+ */
+static void run(const string &name, size_t flush_interval_cirs,
+		size_t nof_cirs, size_t nof_components) {
+	const string file_name = "cdx-bench-swmr.cdx";
+	const vector<string> link_names = { "link0", "link1" };
+
+	CDX::links_to_component_types_t links_to_component_types;
+	for (const auto &link_name : link_names)
+		links_to_component_types[link_name] = { { 0, "LOS" },
+				{ 1, "Scatterer" } };
+
+	vector<CDX::components_t> cirs(link_names.size(),
+			CDX::components_t(nof_components));
+	const vector<double> reference_delays(link_names.size(), 0.0);
+
+	const auto start = chrono::steady_clock::now();
+
+	unique_ptr<CDX::WriteContinuousDelayFile> cdx_out(
+			new CDX::WriteContinuousDelayFile(file_name, 3e8, 1000.0, 1e9,
+					link_names, links_to_component_types, false,
+					flush_interval_cirs > 0 ?
+							CDX::get_swmr_access_plist() :
+							H5::FileAccPropList::DEFAULT));
+
+	if (flush_interval_cirs > 0) {
+		CDX::swmr_options_t options;
+		options.flush_interval_cirs = flush_interval_cirs;
+		options.flush_interval_s = 0.0;
+		cdx_out->enable_swmr_write(options);
+	}
+
+	for (CDX::cir_number_t n = 0; n < nof_cirs; n++) {
+		for (auto &cir : cirs)
+			for (size_t c = 0; c < nof_components; c++) {
+				cir[c].type = c == 0 ? 0 : 1;
+				cir[c].id = c;
+				cir[c].delay = 1e-6 + c * 10e-9 + n * 1e-12;
+				cir[c].amplitude = complex<double>(1.0, 0.5);
+			}
+		cdx_out->write_cir(cirs, reference_delays, n);
+	}
+	cdx_out->sync();
+
+	const double write_s = seconds_since(start);
+	const auto close_start = chrono::steady_clock::now();
+	cdx_out.reset();
+	const double close_s = seconds_since(close_start);
+
+	const auto compact_start = chrono::steady_clock::now();
+	if (flush_interval_cirs > 0)
+		CDX::compact_continuous_delay_file(file_name);
+	const double compact_s = seconds_since(compact_start);
+
+	if (CDX::ReadContinuousDelayFile(file_name).get_nof_cirs() != nof_cirs)
+		throw runtime_error("cdx-bench-swmr: file is incomplete.");
+
+	cout << "  " << name << ": " << nof_cirs / write_s << " CIRs/s, closing "
+			<< close_s << " s, compacting " << compact_s << " s, total "
+			<< nof_cirs / (write_s + close_s + compact_s) << " CIRs/s\n";
+
+	remove(file_name.c_str());
+}
+
+int main(void) {
+	const size_t nof_cirs = 20000;
+	const size_t nof_components = 20;
+
+	cout << "cdx-bench-swmr: " << nof_cirs << " CIRs of 2 links, "
+			<< nof_components << " components per CIR\n";
+
+	run("normal writer", 0, nof_cirs, nof_components);
+	for (size_t flush_interval_cirs : { 16, 64, 1024 })
+		run("SWMR, flush every " + to_string(flush_interval_cirs) + " CIRs",
+				flush_interval_cirs, nof_cirs, nof_components);
+	cout.flush();
+
+	return 0;
+}
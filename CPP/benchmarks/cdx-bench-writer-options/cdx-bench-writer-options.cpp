@@ -0,0 +1,155 @@
+/**
+ * \file cdx-bench-writer-options.cpp
+ *
+ * \brief Measures the write time, the file size and the time to read all CIRs of a
+ * continuous-delay CDX file written with different settings of writer_options_t.
+ *
+ * The file is evicted from the page cache before it is read. Files written with paged
+ * aggregation are read a second time with a page buffer, see reader_options_t.
+ *
+ * The number of CIRs is 20000 by default and can be given as the first argument.
+ */
+
+#include "../../cdx/WriteContinuousDelayFile.h"
+#include "../../cdx/ReadContinuousDelayFile.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+
+using namespace std;
+
+const size_t nof_links = 2;
+const size_t nof_components = 10;
+
+/**
+ * \brief Returns the time in s that has passed since start.
+ */
+static double seconds_since(chrono::steady_clock::time_point start) {
+	return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * \brief Removes a file from the page cache.
+ */
+static void evict_from_page_cache(const string &file_name) {
+	const int fd = open(file_name.c_str(), O_RDONLY);
+	if (fd < 0)
+		throw runtime_error("cdx-bench-writer-options: could not open file.");
+	fdatasync(fd);
+	posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+	close(fd);
+}
+
+static void write_file(const string &file_name, size_t nof_cirs,
+		const CDX::writer_options_t &options) {
+	vector<string> link_names;
+	CDX::links_to_component_types_t component_types;
+	for (size_t l = 0; l < nof_links; l++) {
+		link_names.push_back("link" + to_string(l));
+		component_types[link_names.back()] = { { 0, "LOS" } };
+	}
+
+	CDX::WriteContinuousDelayFile cdx_out(file_name, 3e8, 1000.0, 1e9,
+			link_names, component_types, false, H5::FileAccPropList::DEFAULT,
+			options);
+
+	vector<CDX::components_t> cirs(nof_links,
+			CDX::components_t(nof_components));
+	const vector<double> reference_delays(nof_links, 1e-6);
+	for (CDX::cir_number_t n = 0; n < nof_cirs; n++) {
+		for (size_t l = 0; l < nof_links; l++)
+			for (size_t c = 0; c < nof_components; c++) {
+				cirs[l][c].type = 0;
+				cirs[l][c].id = c;
+				cirs[l][c].delay = 1e-6 + c * 10e-9;
+				cirs[l][c].amplitude = complex<double>(n, c);
+			}
+		cdx_out.write_cir(cirs, reference_delays, n);
+	}
+}
+
+/**
+ * \brief Reads all CIRs of the file from disk and returns the time in s.
+ */
+static double read_file(const string &file_name,
+		const CDX::reader_options_t &options) {
+	evict_from_page_cache(file_name);
+
+	const auto start = chrono::steady_clock::now();
+	CDX::ReadContinuousDelayFile cdx_in(file_name,
+			CDX::get_reader_access_plist(options));
+
+	for (size_t l = 0; l < cdx_in.get_nof_links(); l++)
+		if (cdx_in.read_cirs(l, 0, cdx_in.get_nof_cirs()).offsets.back()
+				!= cdx_in.get_nof_cirs() * nof_components)
+			throw runtime_error("cdx-bench-writer-options: wrong CIRs.");
+
+	return seconds_since(start);
+}
+
+static void run(const string &name, const string &file_name, size_t nof_cirs,
+		const CDX::writer_options_t &options) {
+	auto start = chrono::steady_clock::now();
+	write_file(file_name, nof_cirs, options);
+	const double write_s = seconds_since(start);
+
+	struct stat file_stat;
+	stat(file_name.c_str(), &file_stat);
+
+	cout << "  " << name << ": write " << 1e3 * write_s << " ms, size "
+			<< file_stat.st_size / 1e6 << " MB, cold read "
+			<< 1e3 * read_file(file_name, CDX::reader_options_t()) << " ms";
+
+	if (options.paged_aggregation) {
+		CDX::reader_options_t reader_options;
+		reader_options.page_buffer_size = 16 << 20;
+		cout << ", with page buffer "
+				<< 1e3 * read_file(file_name, reader_options) << " ms";
+	}
+	cout << "\n";
+
+	remove(file_name.c_str());
+}
+
+int main(int argc, char *argv[]) {
+	const size_t nof_cirs = argc > 1 ? strtoul(argv[1], nullptr, 10) : 20000;
+	const string file_name = "cdx-bench-writer-options.cdx";
+
+	cout << "cdx-bench-writer-options: " << nof_cirs << " CIRs of " << nof_links
+			<< " links, " << nof_components << " components per CIR\n";
+
+	CDX::writer_options_t options;
+	run("HDF5 defaults", file_name, nof_cirs, options);
+
+	options.meta_block_size = 1 << 16;
+	options.small_data_block_size = 1 << 16;
+	run("64 KB aggregation blocks", file_name, nof_cirs, options);
+
+	options = CDX::writer_options_t();
+	options.paged_aggregation = true;
+	options.page_size = 1 << 16;
+	run("paged aggregation, 64 KB pages", file_name, nof_cirs, options);
+
+	options = CDX::writer_options_t();
+	options.new_style_groups = true;
+	run("dense groups", file_name, nof_cirs, options);
+
+	options.track_times = false;
+	run("dense groups, no times", file_name, nof_cirs, options);
+
+	options.paged_aggregation = true;
+	options.page_size = 1 << 16;
+	run("dense groups, no times, paged aggregation, 64 KB pages", file_name,
+			nof_cirs, options);
+
+	cout.flush();
+
+	return 0;
+}
@@ -0,0 +1,74 @@
+/**
+ * \file	CIRArena.cpp
+ *
+ * \brief	Monotonic memory arena for decoded CIR components.
+ */
+
+#include "CIRArena.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace CDX {
+
+CIRArena::CIRArena(size_t _block_size) :
+		block_size(std::max<size_t>(_block_size, 64)), used(0), bytes_allocated(
+				0), capacity(0) {
+}
+
+CIRArena::~CIRArena() {
+	for (auto &block : blocks)
+		delete[] block.data;
+}
+
+void *CIRArena::allocate(size_t nof_bytes, size_t alignment) {
+	if (alignment == 0 or (alignment & (alignment - 1)) != 0
+			or alignment > alignof(std::max_align_t))
+		throw std::logic_error("CIRArena::allocate: unsupported alignment.");
+
+	if (not blocks.empty()) {
+		const size_t offset = (used + alignment - 1) & ~(alignment - 1);
+		if (offset <= blocks.back().size
+				and nof_bytes <= blocks.back().size - offset) {
+			used = offset + nof_bytes;
+			bytes_allocated += nof_bytes;
+			return blocks.back().data + offset;
+		}
+	}
+
+	// blocks start at the alignment of std::max_align_t:
+	add_block(nof_bytes);
+	used = nof_bytes;
+	bytes_allocated += nof_bytes;
+	return blocks.back().data;
+}
+
+void CIRArena::release() {
+	if (blocks.size() > 1) {
+		// replace the blocks by one that holds all of them:
+		const size_t total_size = capacity;
+		for (auto &block : blocks)
+			delete[] block.data;
+		blocks.clear();
+		capacity = 0;
+		block_size = total_size;
+		add_block(total_size);
+	}
+
+	used = 0;
+	bytes_allocated = 0;
+}
+
+void CIRArena::add_block(size_t min_size) {
+	const size_t size = std::max(block_size, min_size);
+
+	block_t block;
+	block.data = new char[size];
+	block.size = size;
+	blocks.push_back(block);
+
+	capacity += size;
+	block_size = size;
+}
+
+} // end of namespace CDX
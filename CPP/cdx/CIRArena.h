@@ -0,0 +1,132 @@
+/**
+ * \file	CIRArena.h
+ *
+ * \brief	Monotonic memory arena for decoded CIR components.
+ */
+
+#ifndef CDX_CIRARENA_H_
+#define CDX_CIRARENA_H_
+
+#include <cstddef>
+#include <vector>
+
+#include "File.h"
+
+namespace CDX {
+
+/**
+ * \brief Memory arena that hands out memory for decoded CIRs and releases it all at once.
+ *
+ * Allocations are taken one after another from large blocks and are never freed
+ * individually. release() frees all allocations at once. If the allocations since the
+ * last release needed more than one block, the blocks are replaced by a single block of
+ * their total size, so a scan that reads batches of similar size does not allocate
+ * memory once the first batch has been read.
+ *
+ * Only trivially destructible types may be allocated, no destructors are called.
+ */
+class CIRArena {
+public:
+	/**
+	 * \brief Creates an empty arena.
+	 *
+	 * \param[in] _block_size Size of the first block in bytes. Further blocks are at least
+	 * as large as the blocks before.
+	 */
+	explicit CIRArena(size_t _block_size = 1 << 20);
+
+	virtual ~CIRArena();
+
+	/**
+	 * \brief Returns memory of a given size and alignment.
+	 *
+	 * \param[in] nof_bytes Size in bytes
+	 * \param[in] alignment Alignment in bytes, a power of two not greater than that of std::max_align_t
+	 * \return Memory valid until the next call of release or the destruction of the arena
+	 */
+	void *allocate(size_t nof_bytes, size_t alignment);
+
+	/**
+	 * \brief Returns uninitialized memory for \c count objects of type T.
+	 */
+	template<typename T>
+	T *allocate(size_t count) {
+		return static_cast<T *>(allocate(count * sizeof(T), alignof(T)));
+	}
+
+	/**
+	 * \brief Releases all allocations at once.
+	 */
+	void release();
+
+	/** returns the number of bytes allocated since the last release */
+	size_t get_bytes_allocated() const {
+		return bytes_allocated;
+	}
+
+	/** returns the total size of the blocks in bytes */
+	size_t get_capacity() const {
+		return capacity;
+	}
+
+	/** returns the number of blocks */
+	size_t get_nof_blocks() const {
+		return blocks.size();
+	}
+
+private:
+	CIRArena(const CIRArena &);
+	CIRArena &operator=(const CIRArena &);
+
+	/**
+	 * \brief Appends a block of at least the given size.
+	 */
+	void add_block(size_t min_size);
+
+	/**
+	 * \brief A block of memory.
+	 */
+	struct block_t {
+		char *data; ///< first byte
+		size_t size; ///< size in bytes
+	};
+
+	std::vector<block_t> blocks; ///< all blocks, allocations are taken from the last one
+	size_t block_size; ///< size of the next block in bytes
+	size_t used; ///< bytes used in the last block
+	size_t bytes_allocated; ///< bytes handed out since the last release
+	size_t capacity; ///< total size of the blocks in bytes
+};
+
+/**
+ * \brief CIR whose components are stored in a CIRArena.
+ *
+ * Returned by the reading functions that take an arena. The components are valid until
+ * the arena is released.
+ */
+struct arena_cir_t {
+	/** returns the number of components */
+	size_t size() const {
+		return nof_components;
+	}
+
+	const impulse_t &operator[](size_t k) const {
+		return components[k];
+	}
+
+	const impulse_t *begin() const {
+		return components;
+	}
+
+	const impulse_t *end() const {
+		return components + nof_components;
+	}
+
+	double ref_delay; ///< the reference delay in s
+	impulse_t *components; ///< the multipath components, owned by the arena
+	size_t nof_components; ///< the number of components
+};
+
+} // end of namespace CDX
+
+#endif /* CDX_CIRARENA_H_ */
@@ -0,0 +1,121 @@
+/**
+ * \file CIRPrefetcher.cpp
+ */
+
+#include "CIRPrefetcher.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+using namespace std;
+
+namespace CDX {
+
+CIRPrefetcher::CIRPrefetcher(SharedReadContinuousDelayFile &_reader,
+		string _link, size_t _depth, unsigned _fields) :
+		reader(_reader), link_index(reader.get_link_index(_link)), nof_cirs(
+				reader.get_nof_cirs()), fields(_fields), window_start(0), next_cir(
+				0), generation(0), stop(false) {
+	if (_depth == 0) {
+		throw logic_error("CIRPrefetcher::CIRPrefetcher: depth must be at least 1.");
+	}
+
+	check_component_fields(fields, "CIRPrefetcher::CIRPrefetcher");
+
+	slots.resize(_depth + 1);
+
+	readahead_thread = thread(&CIRPrefetcher::read_ahead, this);
+}
+
+CIRPrefetcher::~CIRPrefetcher() {
+	{
+		lock_guard<mutex> lock(state_mutex);
+		stop = true;
+	}
+	window_moved.notify_one();
+	readahead_thread.join();
+}
+
+const cir_t &CIRPrefetcher::get_cir(cir_number_t cir_num) {
+	if (cir_num >= nof_cirs) {
+		throw logic_error(
+				"CIRPrefetcher::get_cir: parameter cir_num is greater than number of cirs in file.");
+	}
+
+	slot_t &slot = slots[cir_num % slots.size()];
+
+	unique_lock<mutex> lock(state_mutex);
+
+	if (cir_num < window_start or cir_num >= window_start + slots.size()) {
+		// start a new window, the background thread discards the CIR it is reading:
+		for (auto &s : slots)
+			s.ready = false;
+		next_cir = cir_num;
+		generation++;
+		stats.repositions++;
+	}
+	window_start = cir_num;
+	window_moved.notify_one();
+
+	if (slot.ready and slot.cir_num == cir_num) {
+		stats.hits++;
+	} else {
+		stats.misses++;
+		cir_ready.wait(lock,
+				[&slot, cir_num] {return slot.ready and slot.cir_num == cir_num;});
+	}
+
+	if (slot.error)
+		rethrow_exception(slot.error);
+
+	return slot.cir;
+}
+
+void CIRPrefetcher::read_ahead() {
+	vector<hdf5_impulse_t> raw_components;
+
+	while (true) {
+		cir_number_t cir_num;
+		uint64_t read_generation;
+
+		{
+			unique_lock<mutex> lock(state_mutex);
+			window_moved.wait(lock,
+					[this] {return stop or (max(next_cir, window_start) < window_start + slots.size() and max(next_cir, window_start) < nof_cirs);});
+
+			if (stop)
+				return;
+
+			// CIRs the consumer has skipped are not read:
+			next_cir = max(next_cir, window_start);
+
+			cir_num = next_cir++;
+			read_generation = generation;
+			slots[cir_num % slots.size()].ready = false;
+		}
+
+		// the slot is not used by the consumer until it is marked as ready:
+		slot_t &slot = slots[cir_num % slots.size()];
+		slot.error = exception_ptr();
+		try {
+			slot.cir.ref_delay = reader.get_raw_cir(link_index, cir_num,
+					raw_components, fields);
+			ReadContinuousDelayFile::convert_components(raw_components,
+					slot.cir.components);
+		} catch (...) {
+			slot.error = current_exception();
+		}
+
+		{
+			lock_guard<mutex> lock(state_mutex);
+			if (read_generation != generation)
+				continue; // the window has moved away from this CIR
+
+			slot.cir_num = cir_num;
+			slot.ready = true;
+		}
+		cir_ready.notify_one();
+	}
+}
+
+} /* namespace CDX */
@@ -0,0 +1,126 @@
+/**
+ * \file CIRPrefetcher.h
+ *
+ * \brief Readahead of CIRs on a background thread.
+ */
+
+#ifndef CDX_CIRPREFETCHER_H_
+#define CDX_CIRPREFETCHER_H_
+
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "SharedReadContinuousDelayFile.h"
+
+namespace CDX {
+
+/**
+ * \brief Counters of a CIRPrefetcher.
+ */
+struct prefetch_stats_t {
+	prefetch_stats_t() :
+			hits(0), misses(0), repositions(0) {
+	}
+
+	uint64_t hits; ///< requested CIRs that had already been read
+	uint64_t misses; ///< requested CIRs the caller had to wait for
+	uint64_t repositions; ///< requested CIRs outside of the readahead window, included in misses
+};
+
+/**
+ * \brief Reads the CIRs of a link ahead of the consumer on a background thread.
+ *
+ * The prefetcher keeps a window of the CIR requested last and the \c depth CIRs after it.
+ * A background thread reads and converts the CIRs of the window in ascending order into
+ * buffers that are reused, so a consumer that processes the CIRs in order finds the next
+ * CIR already read while it was busy with the previous one. Requesting a CIR outside of
+ * the window moves the window to it.
+ *
+ * The background thread reads through a SharedReadContinuousDelayFile, so the reader can
+ * still be used by other threads. A prefetcher itself must be used by a single consumer.
+ */
+class CIRPrefetcher {
+public:
+	/**
+	 * \brief Starts reading ahead from CIR 0.
+	 *
+	 * \param[in] _reader Reader of the file, has to exist as long as the prefetcher
+	 * \param[in] _link Link name
+	 * \param[in] _depth Number of CIRs to read ahead, at least 1
+	 * \param[in] _fields Mask of the fields to read, see ReadContinuousDelayFile::get_cir
+	 */
+	CIRPrefetcher(SharedReadContinuousDelayFile &_reader, std::string _link,
+			size_t _depth = 16, unsigned _fields = all_component_fields);
+
+	/**
+	 * \brief Stops the background thread.
+	 */
+	virtual ~CIRPrefetcher();
+
+	/**
+	 * \brief Returns the CIR with a given number.
+	 *
+	 * \param[in] cir_num CIR number
+	 * \return The CIR, valid until the next call
+	 */
+	const cir_t &get_cir(cir_number_t cir_num);
+
+	/** returns the number of CIRs read ahead */
+	size_t get_depth() const {
+		return slots.size() - 1;
+	}
+
+	/** returns the hit and miss counters */
+	prefetch_stats_t get_stats() const {
+		return stats;
+	}
+
+	/** resets the hit and miss counters */
+	void reset_stats() {
+		stats = prefetch_stats_t();
+	}
+
+protected:
+	/**
+	 * \brief Buffer for one CIR of the readahead window.
+	 */
+	struct slot_t {
+		slot_t() :
+				cir_num(0), ready(false) {
+		}
+
+		cir_number_t cir_num; ///< number of the CIR in the buffer
+		bool ready; ///< true if cir holds CIR cir_num
+		cir_t cir; ///< the CIR
+		std::exception_ptr error; ///< exception thrown while reading the CIR
+	};
+
+	/**
+	 * \brief Main loop of the background thread.
+	 */
+	void read_ahead();
+
+	SharedReadContinuousDelayFile &reader; ///< the reader of the file
+	const size_t link_index; ///< index of the link to read
+	const cir_number_t nof_cirs; ///< the number of CIRs of the link
+	const unsigned fields; ///< mask of the fields to read
+
+	std::vector<slot_t> slots; ///< the buffers of the window, CIR n is stored in slot n % (depth + 1)
+	prefetch_stats_t stats; ///< the hit and miss counters
+
+	std::mutex state_mutex; ///< protects the members below and the ready flags of the slots
+	std::condition_variable window_moved; ///< signaled when the window has moved or the thread has to stop
+	std::condition_variable cir_ready; ///< signaled when a CIR has been read
+	cir_number_t window_start; ///< first CIR of the window
+	cir_number_t next_cir; ///< next CIR the background thread reads
+	uint64_t generation; ///< incremented when the window is moved to a CIR outside of it
+	bool stop; ///< tells the background thread to stop
+	std::thread readahead_thread; ///< the background thread
+};
+
+} /* namespace CDX */
+
+#endif /* CDX_CIRPREFETCHER_H_ */
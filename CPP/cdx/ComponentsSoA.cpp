@@ -0,0 +1,138 @@
+/**
+ * \file	ComponentsSoA.cpp
+ *
+ * \brief	Structure-of-arrays representation of the multipath components of a CIR.
+ */
+
+#include "ComponentsSoA.h"
+
+#include <sstream>
+#include <stdexcept>
+
+namespace CDX {
+
+const char *get_component_field_name(size_t field) {
+	static const char *const names[nof_component_fields] = { "type", "id",
+			"delay", "real", "imag" };
+
+	if (field >= nof_component_fields)
+		throw std::logic_error("get_component_field_name: invalid field.");
+
+	return names[field];
+}
+
+void check_component_fields(unsigned fields, const char *function) {
+	if (fields == 0 or (fields & ~unsigned(all_component_fields)) != 0) {
+		std::stringstream ss;
+		ss << function << ": invalid mask of component fields (" << fields
+				<< ").";
+		throw std::logic_error(ss.str());
+	}
+}
+
+H5::CompType get_component_field_type(size_t field) {
+	// same member types as the compound type of the readers and writers:
+	switch (field) {
+	case component_type: {
+		H5::CompType type(sizeof(uint16_t));
+		type.insertMember("type", 0, H5::PredType::NATIVE_INT16);
+		return type;
+	}
+	case component_id: {
+		H5::CompType type(sizeof(uint64_t));
+		type.insertMember("id", 0, H5::PredType::NATIVE_UINT64);
+		return type;
+	}
+	case component_delay:
+	case component_real:
+	case component_imag: {
+		H5::CompType type(sizeof(double));
+		type.insertMember(get_component_field_name(field), 0,
+				H5::PredType::NATIVE_DOUBLE);
+		return type;
+	}
+	default:
+		throw std::logic_error("get_component_field_type: invalid field.");
+	}
+}
+
+void set_conversion_buffer(H5::DSetMemXferPropList &xfer,
+		size_t nof_components) {
+	xfer.setBuffer(nof_components * sizeof(hdf5_impulse_t), NULL, NULL);
+}
+
+void ComponentsSoA::resize(size_t n) {
+	types.resize(n);
+	ids.resize(n);
+	delays.resize(n);
+	reals.resize(n);
+	imags.resize(n);
+}
+
+void ComponentsSoA::reserve(size_t n) {
+	types.reserve(n);
+	ids.reserve(n);
+	delays.reserve(n);
+	reals.reserve(n);
+	imags.reserve(n);
+}
+
+void ComponentsSoA::push_back(const impulse_t &component) {
+	types.push_back(component.type);
+	ids.push_back(component.id);
+	delays.push_back(component.delay);
+	reals.push_back(component.amplitude.real());
+	imags.push_back(component.amplitude.imag());
+}
+
+impulse_t ComponentsSoA::get(size_t k) const {
+	impulse_t component;
+	component.type = types[k];
+	component.id = ids[k];
+	component.delay = delays[k];
+	component.amplitude = std::complex<double>(reals[k], imags[k]);
+	return component;
+}
+
+void *ComponentsSoA::get_field_data(size_t field) {
+	return const_cast<void *>(static_cast<const ComponentsSoA *>(this)->get_field_data(
+			field));
+}
+
+const void *ComponentsSoA::get_field_data(size_t field) const {
+	switch (field) {
+	case component_type:
+		return types.data();
+	case component_id:
+		return ids.data();
+	case component_delay:
+		return delays.data();
+	case component_real:
+		return reals.data();
+	case component_imag:
+		return imags.data();
+	default:
+		throw std::logic_error("ComponentsSoA::get_field_data: invalid field.");
+	}
+}
+
+void to_soa(const components_t &components, ComponentsSoA &soa) {
+	soa.resize(components.size());
+
+	for (size_t k = 0; k < components.size(); k++) {
+		soa.types[k] = components[k].type;
+		soa.ids[k] = components[k].id;
+		soa.delays[k] = components[k].delay;
+		soa.reals[k] = components[k].amplitude.real();
+		soa.imags[k] = components[k].amplitude.imag();
+	}
+}
+
+void to_components(const ComponentsSoA &soa, components_t &components) {
+	components.resize(soa.size());
+
+	for (size_t k = 0; k < soa.size(); k++)
+		components[k] = soa.get(k);
+}
+
+} // end of namespace CDX
@@ -0,0 +1,189 @@
+/**
+ * \file	ComponentsSoA.h
+ *
+ * \brief	Structure-of-arrays representation of the multipath components of a CIR.
+ */
+
+#ifndef CDX_COMPONENTSSOA_H_
+#define CDX_COMPONENTSSOA_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <vector>
+
+#include "File.h"
+
+namespace CDX {
+
+/**
+ * \brief Allocator that aligns memory to \c Alignment bytes, e.g. for SIMD loads.
+ */
+template<typename T, size_t Alignment = 64>
+struct aligned_allocator {
+	typedef T value_type;
+
+	template<typename U>
+	struct rebind {
+		typedef aligned_allocator<U, Alignment> other;
+	};
+
+	aligned_allocator() {
+	}
+
+	template<typename U>
+	aligned_allocator(const aligned_allocator<U, Alignment> &) {
+	}
+
+	T *allocate(size_t n) {
+		// the address returned by operator new is stored in front of the aligned memory:
+		char *raw = static_cast<char *>(::operator new(
+				n * sizeof(T) + Alignment + sizeof(void *)));
+		const uintptr_t address = reinterpret_cast<uintptr_t>(raw)
+				+ sizeof(void *);
+		char *aligned = raw + sizeof(void *)
+				+ ((Alignment - address % Alignment) % Alignment);
+		reinterpret_cast<void **>(aligned)[-1] = raw;
+		return reinterpret_cast<T *>(aligned);
+	}
+
+	void deallocate(T *p, size_t) {
+		::operator delete(reinterpret_cast<void **>(p)[-1]);
+	}
+};
+
+template<typename T, typename U, size_t Alignment>
+bool operator==(const aligned_allocator<T, Alignment> &,
+		const aligned_allocator<U, Alignment> &) {
+	return true;
+}
+
+template<typename T, typename U, size_t Alignment>
+bool operator!=(const aligned_allocator<T, Alignment> &,
+		const aligned_allocator<U, Alignment> &) {
+	return false;
+}
+
+/**
+ * \brief Number of members of the compound type in which components are stored in the file.
+ */
+const size_t nof_component_fields = 5;
+
+/**
+ * \brief Index of each member of the compound type in which components are stored in the file.
+ */
+enum component_field_t {
+	component_type = 0, ///< the member \c type
+	component_id = 1, ///< the member \c id
+	component_delay = 2, ///< the member \c delay
+	component_real = 3, ///< the member \c real
+	component_imag = 4 ///< the member \c imag
+};
+
+/**
+ * \brief Bits of a mask of members of the stored components, see e.g. ReadContinuousDelayFile::get_cir.
+ *
+ * Bit \c k selects member \c k of component_field_t. Masks are combined with |.
+ */
+enum component_fields_t {
+	fields_type = 1 << component_type, ///< the member \c type
+	fields_id = 1 << component_id, ///< the member \c id
+	fields_delay = 1 << component_delay, ///< the member \c delay
+	fields_real = 1 << component_real, ///< the member \c real
+	fields_imag = 1 << component_imag, ///< the member \c imag
+	fields_amplitude = fields_real | fields_imag, ///< the members \c real and \c imag
+	all_component_fields = (1 << nof_component_fields) - 1 ///< all members
+};
+
+/**
+ * \brief Throws a std::logic_error if a mask of members is empty or has unknown bits set.
+ */
+void check_component_fields(unsigned fields, const char *function);
+
+/**
+ * \brief Returns the name of a member of the compound type in which components are stored.
+ */
+const char *get_component_field_name(size_t field);
+
+/**
+ * \brief Returns a compound type with a single member of the stored components.
+ *
+ * Reading or writing a dataset of components with this type transfers only this member,
+ * from or to an array of the member's native type.
+ */
+H5::CompType get_component_field_type(size_t field);
+
+/**
+ * \brief Sizes the conversion buffer of transfers of some members for a number of components.
+ *
+ * HDF5 converts the members in a buffer of 1 MB by default, which is allocated for each
+ * read or write and dominates the time for CIRs of typical size.
+ */
+void set_conversion_buffer(H5::DSetMemXferPropList &xfer, size_t nof_components);
+
+/**
+ * \brief Multipath components of a CIR stored as structure of arrays.
+ *
+ * Element \c k of each vector belongs to component \c k. Each vector is aligned to 64
+ * bytes, so kernels that only need a few fields, e.g. power sums over reals and imags,
+ * touch only these and can use aligned SIMD loads.
+ */
+struct ComponentsSoA {
+	typedef std::vector<uint16_t, aligned_allocator<uint16_t> > uint16_vector;
+	typedef std::vector<uint64_t, aligned_allocator<uint64_t> > uint64_vector;
+	typedef std::vector<double, aligned_allocator<double> > double_vector;
+
+	/** returns the number of components */
+	size_t size() const {
+		return delays.size();
+	}
+
+	/** sets the number of components */
+	void resize(size_t n);
+
+	/** reserves memory for n components */
+	void reserve(size_t n);
+
+	/** removes all components */
+	void clear() {
+		resize(0);
+	}
+
+	/** appends a component */
+	void push_back(const impulse_t &component);
+
+	/** returns component k */
+	impulse_t get(size_t k) const;
+
+	/** returns the first element of the vector of a member, see component_field_t */
+	void *get_field_data(size_t field);
+
+	/** returns the first element of the vector of a member, see component_field_t */
+	const void *get_field_data(size_t field) const;
+
+	uint16_vector types; ///< the component's type
+	uint64_vector ids; ///< the component's identifier
+	double_vector delays; ///< the component's delay in s
+	double_vector reals; ///< real part of the component's amplitude
+	double_vector imags; ///< imaginary part of the component's amplitude
+};
+
+/**
+ * \brief Converts components to structure of arrays.
+ *
+ * \param[in] components The components
+ * \param[out] soa Is resized and filled
+ */
+void to_soa(const components_t &components, ComponentsSoA &soa);
+
+/**
+ * \brief Converts components from structure of arrays.
+ *
+ * \param[in] soa The components
+ * \param[out] components Is resized and filled
+ */
+void to_components(const ComponentsSoA &soa, components_t &components);
+
+} // end of namespace CDX
+
+#endif /* CDX_COMPONENTSSOA_H_ */
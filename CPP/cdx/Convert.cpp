@@ -0,0 +1,38 @@
+/**
+ * \file	Convert.cpp
+ *
+ * \brief	Sampling of continuous-delay CIRs on a discrete delay axis.
+ */
+
+#include "Convert.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+namespace CDX {
+
+void sample_components(const components_t &components, double first_delay,
+		double sampling_frequency_Hz, vector<complex<double> > &samples) {
+	fill(samples.begin(), samples.end(), complex<double>(0.0, 0.0));
+
+	// sin(pi (k - x)) is -(-1)^k sin(pi x) for integer k, so a component takes a single
+	// sine instead of one per sample. Next to the component, where the sine is small, it
+	// is computed directly, as the identity would lose its precision there:
+	for (const auto &component : components) {
+		const double position = (component.delay - first_delay)
+				* sampling_frequency_Hz;
+		const double sin_position = sin(M_PI * position);
+		for (size_t k = 0; k < samples.size(); k++) {
+			const double x = M_PI * (k - position);
+			if (fabs(x) >= M_PI)
+				samples[k] += component.amplitude
+						* ((k % 2 ? sin_position : -sin_position) / x);
+			else
+				samples[k] += component.amplitude * (x == 0.0 ? 1.0 : sin(x) / x);
+		}
+	}
+}
+
+} // end of namespace CDX
@@ -0,0 +1,33 @@
+/**
+ * \file	Convert.h
+ *
+ * \brief	Sampling of continuous-delay CIRs on a discrete delay axis.
+ */
+
+#ifndef CDX_CONVERT_H_
+#define CDX_CONVERT_H_
+
+#include "File.h"
+
+namespace CDX {
+
+/**
+ * \brief Samples the components of a CIR with a sinc pulse on a discrete delay axis.
+ *
+ * This is the interpolation of cdx-convert-continuous-to-discrete. Sample \c k is at the
+ * delay <tt>first_delay + k / sampling_frequency_Hz</tt>, and each component adds its
+ * amplitude times <tt>sinc(pi sampling_frequency_Hz (t_k - delay))</tt>, i.e. the response
+ * of an ideal low-pass filter of bandwidth <tt>sampling_frequency_Hz / 2</tt>.
+ *
+ * \param[in] components Components of the CIR, their delays in s
+ * \param[in] first_delay Delay of the first sample in s
+ * \param[in] sampling_frequency_Hz Sampling frequency of the delay axis in Hz
+ * \param[out] samples Is overwritten, its size is the number of delay samples
+ */
+void sample_components(const components_t &components, double first_delay,
+		double sampling_frequency_Hz,
+		std::vector<std::complex<double> > &samples);
+
+} // end of namespace CDX
+
+#endif /* CDX_CONVERT_H_ */
@@ -7,6 +7,7 @@
 
 #include "File.h"
 
+#include <sstream>
 #include <stdexcept>
 
 using namespace std;
@@ -18,8 +19,65 @@ using namespace std;
 
 namespace CDX {
 
-File::File(std::string _file_name) :
-		file_name(_file_name), h5file(file_name.c_str(), H5F_ACC_RDONLY), c0_m_s(
+std::mutex &get_hdf5_mutex() {
+	static std::mutex hdf5_mutex;
+	return hdf5_mutex;
+}
+
+H5::FileAccPropList get_in_memory_access_plist(bool backing_store,
+		size_t increment) {
+	H5::FileAccPropList access_plist;
+	access_plist.setCore(increment, backing_store);
+	return access_plist;
+}
+
+H5::FileAccPropList get_file_image_access_plist(
+		const std::vector<char> &image) {
+	if (image.empty())
+		throw logic_error("get_file_image_access_plist: the image is empty.");
+
+	H5::FileAccPropList access_plist;
+	access_plist.setCore(1 << 20, false);
+
+	// HDF5 copies the image into the property list:
+	if (H5Pset_file_image(access_plist.getId(), (void *) image.data(),
+			image.size()) < 0)
+		throw runtime_error(
+				"get_file_image_access_plist: setting the file image failed.");
+
+	return access_plist;
+}
+
+/// number of files reached through external links that are kept open, see
+/// with_external_link_cache
+static const unsigned external_link_cache_size = 64;
+
+/**
+ * \brief Returns a copy of a file access property list with enabled external link file cache.
+ *
+ * Without the cache, HDF5 opens and closes the target file of an external link each time
+ * the link is traversed, for example for every CIR of a master file of shards.
+ */
+static H5::FileAccPropList with_external_link_cache(
+		const H5::FileAccPropList &access_plist) {
+	H5::FileAccPropList plist;
+	if (access_plist.getId() != H5P_DEFAULT)
+		plist.copy(access_plist);
+
+	unsigned cache_size = 0;
+	H5Pget_elink_file_cache_size(plist.getId(), &cache_size);
+	if (cache_size == 0)
+		H5Pset_elink_file_cache_size(plist.getId(), external_link_cache_size);
+
+	return plist;
+}
+
+File::File(std::string _file_name,
+		const H5::FileAccPropList &_access_plist, unsigned int _flags,
+		bool _lazy_open) :
+		file_name(_file_name), h5file(file_name.c_str(), _flags,
+				H5::FileCreatPropList::DEFAULT,
+				with_external_link_cache(_access_plist)), c0_m_s(
 				read_double_h5(h5file, "/parameters/c0_m_s")), cir_rate_Hz(
 				read_double_h5(h5file, "/parameters/cir_rate_Hz")), transmitter_frequency_Hz(
 				read_double_h5(h5file, "/parameters/transmitter_frequency_Hz")), delay_type(
@@ -30,29 +88,110 @@ File::File(std::string _file_name) :
 	for (size_t k = 0; k < nof_links; k++) {
 		std::string link_name = links_group.getObjnameByIdx(k);
 		link_names.push_back(link_name);
-		link_groups[link_name] = new H5::Group(
-				links_group.openGroup(link_name));
+		link_groups.push_back(
+				_lazy_open ?
+						nullptr : new H5::Group(links_group.openGroup(link_name)));
 	}
 
+	index_link_names();
 }
 
 File::File(std::string _file_name, double _c0_m_s, double _cir_rate_Hz,
 		double _transmitter_frequency_Hz,
-		const std::vector<std::string> &_link_names) :
-		file_name(_file_name), h5file(file_name.c_str(), H5F_ACC_TRUNC), c0_m_s(
+		const std::vector<std::string> &_link_names,
+		const H5::FileAccPropList &_access_plist,
+		const H5::FileCreatPropList &_create_plist) :
+		file_name(_file_name), h5file(file_name.c_str(), H5F_ACC_TRUNC,
+				_create_plist, _access_plist), c0_m_s(
 				_c0_m_s), cir_rate_Hz(_cir_rate_Hz), transmitter_frequency_Hz(
 				_transmitter_frequency_Hz), link_names(_link_names), links_group(
-				h5file.createGroup("/links")), nof_links(link_names.size()) {
-
+				h5file.createGroup("/links")), nof_links(link_names.size()), link_groups(
+				nof_links, nullptr) {
+	index_link_names();
 }
 
 File::~File() {
 	// close link groups which were openend in constructor:
-	for (size_t k = 0; k < link_names.size(); k++) {
-		delete link_groups[link_names.at(k)];
+	for (size_t k = 0; k < link_groups.size(); k++) {
+		delete link_groups[k];
 	}
 }
 
+std::vector<char> File::get_file_image() {
+	const ssize_t size = H5Fget_file_image(h5file.getId(), nullptr, 0);
+	if (size < 0)
+		throw runtime_error(
+				"File::get_file_image: getting the size of the image of "
+						+ file_name + " failed.");
+
+	std::vector<char> image(size);
+	if (H5Fget_file_image(h5file.getId(), image.data(), image.size()) != size)
+		throw runtime_error(
+				"File::get_file_image: getting the image of " + file_name
+						+ " failed.");
+
+	return image;
+}
+
+H5::Group &File::get_link_group(size_t link_index) {
+	if (link_groups[link_index] == nullptr)
+		link_groups[link_index] = new H5::Group(
+				links_group.openGroup(link_names[link_index]));
+
+	return *link_groups[link_index];
+}
+
+size_t File::get_link_index(const std::string &link_name) const {
+	const auto it = link_indices.find(link_name);
+	if (it != link_indices.end())
+		return it->second;
+
+	std::stringstream ss;
+	ss << "File::get_link_index: did not find link " << link_name
+			<< " in file.";
+	throw std::logic_error(ss.str());
+}
+
+const std::string &File::get_link_name(size_t link_index) const {
+	check_link_index(link_index, "File::get_link_name");
+	return link_names[link_index];
+}
+
+void File::copy_object(const std::string &path,
+		const H5::H5Location &destination,
+		const std::string &destination_name) const {
+	if (H5Ocopy(h5file.getId(), path.c_str(), destination.getId(),
+			destination_name.c_str(), H5P_DEFAULT, H5P_DEFAULT) < 0)
+		throw runtime_error(
+				"File::copy_object: copying " + path + " of " + file_name
+						+ " failed.");
+}
+
+void File::check_same_parameters(const File &other,
+		const char *function) const {
+	if (other.c0_m_s != c0_m_s or other.cir_rate_Hz != cir_rate_Hz
+			or other.transmitter_frequency_Hz != transmitter_frequency_Hz)
+		throw runtime_error(
+				std::string(function) + ": " + other.file_name
+						+ " has another speed of light, CIR rate or transmitter frequency than "
+						+ file_name + ".");
+}
+
+void File::index_link_names() {
+	for (size_t k = 0; k < link_names.size(); k++)
+		link_indices[link_names[k]] = k;
+}
+
+void File::check_link_index(size_t link_index, const char *function) const {
+	if (link_index < nof_links)
+		return;
+
+	std::stringstream ss;
+	ss << function << ": link index " << link_index
+			<< " is out of range, the file has " << nof_links << " links.";
+	throw std::logic_error(ss.str());
+}
+
 double File::read_double_h5(H5::H5File file, std::string dataset_name) {
 
 	H5::DataSet dataset = file.openDataSet(dataset_name);
@@ -81,12 +220,11 @@ std::string File::read_string_h5(H5::H5File file, std::string path) {
 	int delay_type_len = delay_type_type.getSize();
 	H5::DataSpace delay_type_space = H5::DataSpace(delay_type_set.getSpace());
 
-	char delay_type[delay_type_len + 1];
-	delay_type_set.read(delay_type, delay_type_type, delay_type_space);
-
-	delay_type[delay_type_len] = 0;
+	// heap buffer, the string can be of any length:
+	std::vector<char> delay_type(delay_type_len + 1, 0);
+	delay_type_set.read(delay_type.data(), delay_type_type, delay_type_space);
 
-	const std::string out = delay_type;
+	const std::string out = delay_type.data();
 	return out;
 }
 
@@ -17,6 +17,8 @@
 #include <vector>
 #include <complex>
 #include <map>
+#include <mutex>
+#include <unordered_map>
 
 #include "H5Cpp.h"
 
@@ -60,6 +62,11 @@ struct hdf5_impulse_t {
 	double imag;
 };
 
+/**
+ * \brief Number of a CIR within a link, counting from zero.
+ */
+typedef uint64_t cir_number_t;
+
 /**
  * \brief Struct used as return value for function ReadContinuousDelayCDXFile::get_cir.
  */
@@ -68,6 +75,42 @@ struct cir_t {
 	components_t components; ///< the multipath components
 };
 
+/**
+ * \brief Returns the mutex that serializes calls into the HDF5 library.
+ *
+ * HDF5 is usually built without thread-safety, so no two threads may be inside the library
+ * at the same time, not even for different files. The thread-safe classes of this library,
+ * e.g. SharedReadContinuousDelayFile, hold this mutex while calling HDF5. Applications that
+ * call HDF5 from several threads themselves should lock it as well.
+ */
+std::mutex &get_hdf5_mutex();
+
+/**
+ * \brief Returns file access properties that keep a file in memory with the HDF5 core driver.
+ *
+ * A writer created with these properties does not touch the disk, unless \c backing_store
+ * is set. Then the memory image is written to the file on each flush and on closing. The
+ * image of the open file can be handed to the next stage of a pipeline with
+ * File::get_file_image and get_file_image_access_plist, without a file on disk.
+ *
+ * \param[in] backing_store Write the image to the file on flushing and closing
+ * \param[in] increment Number of bytes by which the memory image grows
+ */
+H5::FileAccPropList get_in_memory_access_plist(bool backing_store = false,
+		size_t increment = 1 << 20);
+
+/**
+ * \brief Returns file access properties that open a file from an image in memory.
+ *
+ * The image is copied, so it can be released after the file has been opened. The file
+ * name given to the reader or writer is only used as a label. Nothing is read from or
+ * written to the disk. The changes of a writer opened this way are lost on closing
+ * unless a new image is taken with File::get_file_image.
+ *
+ * \param[in] image Image of a CDX file, e.g. from File::get_file_image
+ */
+H5::FileAccPropList get_file_image_access_plist(const std::vector<char> &image);
+
 /**
  * \brief Base class for the processing of Channel Data Exchange (CDX) files.
  *
@@ -98,8 +141,14 @@ public:
 	 * \brief Construction from a file name.
 	 *
 	 * \param[in] _file_name File name
+	 * \param[in] _access_plist File access properties the file is opened with
+	 * \param[in] _flags H5F_ACC_RDONLY, or H5F_ACC_RDWR for writers that append to the file
+	 * \param[in] _lazy_open If true, the group of each link is opened on first use by
+	 * get_link_group instead of here
 	 */
-	File(std::string _file_name);
+	File(std::string _file_name, const H5::FileAccPropList &_access_plist =
+			H5::FileAccPropList::DEFAULT, unsigned int _flags = H5F_ACC_RDONLY,
+			bool _lazy_open = false);
 
 	/**
 	 * \brief Construction from file name and parameters.
@@ -109,10 +158,16 @@ public:
 	 * \param[in] _cir_rate_Hz CIR rate in Hz
 	 * \param[in] _transmitter_frequency_Hz Transmitter Frequency in Hz
 	 * \param[in] _link_names Vector of strings for the link names
+	 * \param[in] _access_plist File access properties the file is created with
+	 * \param[in] _create_plist File creation properties, e.g. the file space strategy
 	 */
 	File(std::string _file_name, double _c0_m_s, double _cir_rate_Hz,
 			double _transmitter_frequency_Hz,
-			const std::vector<std::string> &_link_names);
+			const std::vector<std::string> &_link_names,
+			const H5::FileAccPropList &_access_plist =
+					H5::FileAccPropList::DEFAULT,
+			const H5::FileCreatPropList &_create_plist =
+					H5::FileCreatPropList::DEFAULT);
 
 	/**
 	 * \brief Destructor.
@@ -146,6 +201,17 @@ public:
 		return h5file;
 	}
 
+	/**
+	 * \brief Returns an image of the file in memory.
+	 *
+	 * The image is a complete HDF5 file that can be written to disk as it is, or opened
+	 * with get_file_image_access_plist. Writers first write their pending data, see
+	 * WriteFile::get_file_image.
+	 *
+	 * \return The bytes of the file
+	 */
+	virtual std::vector<char> get_file_image();
+
 	/**
 	 * \brief Returns number of links.
 	 *
@@ -191,6 +257,47 @@ public:
 		return link_names;
 	}
 
+	/**
+	 * \brief Returns the index of a link in the vector returned by get_link_names.
+	 *
+	 * The reading and writing methods have overloads that take the link index instead of
+	 * the link name. They access the state of the link directly, without looking up the
+	 * name, so resolve the name once with this function on hot paths.
+	 *
+	 * \param[in] link_name Link name
+	 * \return Index of the link
+	 */
+	size_t get_link_index(const std::string &link_name) const;
+
+	/**
+	 * \brief Returns the name of the link with a given index.
+	 *
+	 * \param[in] link_index Link index
+	 * \return Link name
+	 */
+	const std::string &get_link_name(size_t link_index) const;
+
+	/**
+	 * \brief Copies an object of this file into another HDF5 file with H5Ocopy.
+	 *
+	 * \param[in] path Path of the object in this file, e.g. /parameters
+	 * \param[in] destination File or group the copy is created in
+	 * \param[in] destination_name Name of the copy relative to \c destination
+	 */
+	void copy_object(const std::string &path,
+			const H5::H5Location &destination,
+			const std::string &destination_name) const;
+
+	/**
+	 * \brief Throws a std::runtime_error if another file has other parameters than this one.
+	 *
+	 * The speed of light, the CIR rate and the transmitter frequency are compared.
+	 *
+	 * \param[in] other File to compare with
+	 * \param[in] function Name of the calling function for the error message
+	 */
+	void check_same_parameters(const File &other, const char *function) const;
+
 protected:
 	const std::string file_name; ///< the CDX file's name
 	H5::H5File h5file; ///< the handle to the HDF5 file
@@ -203,7 +310,26 @@ protected:
 	std::vector<std::string> link_names; ///< vector of the link names
 	H5::Group links_group; ///< handle to the group in the HDF5 file that stores the links
 	const size_t nof_links; ///< the number of the links
-	std::map<std::string, H5::Group *> link_groups; ///< vector of pointers to HDF5 groups which contain data for each link in file
+	std::vector<H5::Group *> link_groups; ///< vector of pointers to HDF5 groups which contain data for each link in file, indexed by link index, nullptr until opened by get_link_group
+	std::unordered_map<std::string, size_t> link_indices; ///< the index of each link name
+
+	/**
+	 * \brief Fills link_indices from link_names.
+	 */
+	void index_link_names();
+
+	/**
+	 * \brief Returns the group of the link with a given index, opening it on first use.
+	 */
+	H5::Group &get_link_group(size_t link_index);
+
+	/**
+	 * \brief Throws a std::logic_error if a link index is out of range.
+	 *
+	 * \param[in] link_index Link index
+	 * \param[in] function Name of the calling function for the error message
+	 */
+	void check_link_index(size_t link_index, const char *function) const;
 };
 
 } // end of namespace CDX
@@ -0,0 +1,74 @@
+/**
+ * \file	FollowContinuousDelayFile.cpp
+ *
+ * \brief	Reading the CIRs of a continuous-delay CDX file while it is written in SWMR mode.
+ */
+
+#include "FollowContinuousDelayFile.h"
+
+#include <chrono>
+#include <thread>
+
+using namespace std;
+
+namespace CDX {
+
+/**
+ * \brief Returns a copy of file access properties with the latest file format, which SWMR reads need.
+ */
+static H5::FileAccPropList with_latest_format(
+		const H5::FileAccPropList &access_plist) {
+	H5::FileAccPropList plist;
+	if (access_plist.getId() != H5P_DEFAULT)
+		plist.copy(access_plist);
+
+	plist.setLibverBounds(H5F_LIBVER_LATEST, H5F_LIBVER_LATEST);
+	return plist;
+}
+
+FollowContinuousDelayFile::FollowContinuousDelayFile(std::string _file_name,
+		const H5::FileAccPropList &_access_plist) :
+		ReadContinuousDelayFile(_file_name, with_latest_format(_access_plist),
+				false, H5F_ACC_RDONLY | H5F_ACC_SWMR_READ), next_cir(0), poll_interval_s(
+				0.001) {
+	refresh();
+}
+
+FollowContinuousDelayFile::~FollowContinuousDelayFile() {
+}
+
+cir_number_t FollowContinuousDelayFile::refresh() {
+	refresh_appended_cirs();
+	return nof_cirs;
+}
+
+cir_number_t FollowContinuousDelayFile::wait_for_cirs(cir_number_t min_nof_cirs,
+		double timeout_s) {
+	const auto deadline = chrono::steady_clock::now()
+			+ chrono::duration_cast<chrono::steady_clock::duration>(
+					chrono::duration<double>(timeout_s));
+
+	while (refresh() < min_nof_cirs and chrono::steady_clock::now() < deadline)
+		this_thread::sleep_for(chrono::duration<double>(poll_interval_s));
+
+	return nof_cirs;
+}
+
+size_t FollowContinuousDelayFile::read_new_cirs(
+		std::vector<cir_block_t> &blocks, double timeout_s, unsigned fields) {
+	check_component_fields(fields, "FollowContinuousDelayFile::read_new_cirs");
+
+	if (wait_for_cirs(next_cir + 1, timeout_s) <= next_cir)
+		return 0;
+
+	const size_t count = nof_cirs - next_cir;
+
+	blocks.resize(nof_links);
+	for (size_t k = 0; k < nof_links; k++)
+		read_cirs(k, next_cir, count, blocks[k], fields);
+
+	next_cir = nof_cirs;
+	return count;
+}
+
+} // end of namespace CDX
@@ -0,0 +1,100 @@
+/**
+ * \file	FollowContinuousDelayFile.h
+ *
+ * \brief	Reading the CIRs of a continuous-delay CDX file while it is written in SWMR mode.
+ */
+
+#ifndef CDX_FOLLOWCONTINUOUSDELAYFILE_H_
+#define CDX_FOLLOWCONTINUOUSDELAYFILE_H_
+
+#include "ReadContinuousDelayFile.h"
+
+namespace CDX {
+
+/**
+ * \brief Follows a continuous-delay CDX file that is being written, like <tt>tail -f</tt>.
+ *
+ * The file is opened once with H5F_ACC_SWMR_READ. refresh updates the extents of the
+ * datasets the writer appends to, without reopening the file, so the number of CIRs
+ * grows with each flush of the writer, see WriteFile::enable_swmr_write. The number of
+ * reference delays is taken as the number of complete CIRs, as the writer appends them
+ * after the CIRs have been flushed.
+ *
+ * The CIRs are read by ReadContinuousDelayFile, which reads the CIRs appended in SWMR mode
+ * from the datasets \c appended_cirs and \c appended_cir_ends of each link, see
+ * WriteContinuousDelayFile::prepare_swmr_write. Files that are not written any more are
+ * followed as well, their CIRs are all available at once.
+ *
+ * The writer leaves the appended CIRs where they are when it closes the file, so
+ * followers may keep the file open. compact_continuous_delay_file restructures the file,
+ * it must not be called while the file is followed.
+ */
+class FollowContinuousDelayFile: public ReadContinuousDelayFile {
+public:
+	/**
+	 * \brief Opens a continuous-delay file for following.
+	 *
+	 * The file must be written in SWMR mode or not be open for writing at all.
+	 *
+	 * \param[in] _file_name File name
+	 * \param[in] _access_plist File access properties, the latest file format is set on a copy
+	 */
+	FollowContinuousDelayFile(std::string _file_name,
+			const H5::FileAccPropList &_access_plist =
+					H5::FileAccPropList::DEFAULT);
+
+	virtual ~FollowContinuousDelayFile();
+
+	/**
+	 * \brief Refreshes the extents of the datasets the writer appends to.
+	 *
+	 * \return The number of CIRs that can be read, see get_nof_cirs
+	 */
+	cir_number_t refresh();
+
+	/**
+	 * \brief Refreshes until at least \c min_nof_cirs CIRs can be read or the timeout has passed.
+	 *
+	 * \param[in] min_nof_cirs Number of CIRs to wait for
+	 * \param[in] timeout_s Time to wait at most in s, zero to refresh only once
+	 * \return The number of CIRs that can be read, which is less than \c min_nof_cirs on timeout
+	 */
+	cir_number_t wait_for_cirs(cir_number_t min_nof_cirs, double timeout_s);
+
+	/**
+	 * \brief Reads the CIRs that have become available since the last call.
+	 *
+	 * Waits up to \c timeout_s for new CIRs, see wait_for_cirs, and reads all new CIRs of
+	 * each link. The first call returns the CIRs from CIR 0 on.
+	 *
+	 * \param[out] blocks Is resized to the number of links and filled by read_cirs for each link index
+	 * \param[in] timeout_s Time to wait at most for new CIRs in s
+	 * \param[in] fields Mask of the fields to fill, see read_cirs
+	 * \return The number of new CIRs, zero on timeout
+	 */
+	size_t read_new_cirs(std::vector<cir_block_t> &blocks, double timeout_s,
+			unsigned fields = all_component_fields);
+
+	/** returns the number of the first CIR that the next call of read_new_cirs returns */
+	cir_number_t get_next_cir() const {
+		return next_cir;
+	}
+
+	/** sets the time between two refreshes while waiting for CIRs in s, 1 ms by default */
+	void set_poll_interval_s(double _poll_interval_s) {
+		poll_interval_s = _poll_interval_s;
+	}
+
+	/** returns the time between two refreshes while waiting for CIRs in s */
+	double get_poll_interval_s() const {
+		return poll_interval_s;
+	}
+
+private:
+	cir_number_t next_cir; ///< first CIR returned by the next call of read_new_cirs
+	double poll_interval_s; ///< time between refreshes while waiting in s
+};
+
+} // end of namespace CDX
+
+#endif /* CDX_FOLLOWCONTINUOUSDELAYFILE_H_ */
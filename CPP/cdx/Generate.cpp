@@ -0,0 +1,503 @@
+/**
+ * \file	Generate.cpp
+ *
+ * \brief	Synthetic CDX files from a geometric channel model, for benchmarks and soak tests.
+ */
+
+#include "Generate.h"
+#include "Convert.h"
+#include "Shards.h"
+#include "WriteContinuousDelayFile.h"
+#include "WriteDiscreteDelayFile.h"
+
+#include <algorithm>
+#include <cmath>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <stdexcept>
+#include <thread>
+
+using namespace std;
+
+namespace CDX {
+
+/// number of consecutive CIRs computed by a thread at a time
+static const cir_number_t cirs_per_block = 256;
+
+/// component types of the LOS component and of the scatterers
+static const uint16_t los_type = 0;
+static const uint16_t scatterer_type = 256;
+
+/// the lifetime of a scatterer is cut at this multiple of its mean
+static const double max_lifetime_factor = 10.0;
+
+/// largest height of a scatterer above the ground in m
+static const double max_scatterer_height_m = 20.0;
+
+/// number of delay samples before the reference delay in discrete-delay files
+static const size_t delay_samples_before_reference = 4;
+
+/// the identifier of a scatterer is its index in the block of its birth plus the block shifted by this
+static const unsigned id_block_shift = 24;
+
+struct vector3_t {
+	double x;
+	double y;
+	double z;
+};
+
+static double dot(const vector3_t &a, const vector3_t &b) {
+	return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+static double distance(const vector3_t &a, const vector3_t &b) {
+	return sqrt(
+			(a.x - b.x) * (a.x - b.x) + (a.y - b.y) * (a.y - b.y)
+					+ (a.z - b.z) * (a.z - b.z));
+}
+
+/**
+ * \brief A satellite, seen from the receiver.
+ */
+struct satellite_t {
+	vector3_t direction; ///< unit vector from the receiver towards the satellite
+	double range_rate_m_s; ///< change of the distance to the receiver at time 0
+};
+
+/**
+ * \brief A point scatterer that is alive from its birth until its death.
+ */
+struct scatterer_t {
+	uint64_t id;
+	double birth_s;
+	double death_s;
+	vector3_t position;
+	double amplitude;
+};
+
+/**
+ * \brief Returns a random number generator seeded by the seed of the model and two numbers.
+ */
+static mt19937_64 get_generator(uint64_t seed, uint64_t a, uint64_t b) {
+	seed_seq seq = { uint32_t(seed), uint32_t(seed >> 32), uint32_t(a), uint32_t(
+			a >> 32), uint32_t(b), uint32_t(b >> 32) };
+	return mt19937_64(seq);
+}
+
+/**
+ * \brief The model of one link, shared read-only by all threads.
+ */
+class link_model_t {
+public:
+	link_model_t(const generate_options_t &_options, size_t _link_index) :
+			options(_options), link_index(_link_index), block_duration_s(
+					cirs_per_block / options.cir_rate_Hz), nof_lookback_blocks(
+					ceil(
+							max_lifetime_factor * options.mean_scatterer_lifetime_s
+									/ block_duration_s)) {
+		mt19937_64 generator = get_generator(options.seed, 2 * link_index + 1,
+				0);
+		const double azimuth = uniform_real_distribution<double>(0.0,
+				2.0 * M_PI)(generator);
+		const double elevation = uniform_real_distribution<double>(
+				15.0 * M_PI / 180.0, 75.0 * M_PI / 180.0)(generator);
+		satellite.direction = { cos(elevation) * cos(azimuth), cos(elevation)
+				* sin(azimuth), sin(elevation) };
+		satellite.range_rate_m_s = uniform_real_distribution<double>(
+				-options.max_range_rate_m_s, options.max_range_rate_m_s)(
+				generator);
+	}
+
+	/**
+	 * \brief Returns the scatterers that can be alive during the CIRs of a block.
+	 *
+	 * These are the scatterers born during the block and the blocks before it that are
+	 * not longer ago than the longest lifetime, drawn again for each block.
+	 */
+	vector<scatterer_t> get_scatterers(int64_t block) const {
+		vector<scatterer_t> scatterers;
+		for (int64_t birth_block = block - nof_lookback_blocks;
+				birth_block <= block; birth_block++)
+			add_born_scatterers(birth_block, scatterers);
+		return scatterers;
+	}
+
+	/**
+	 * \brief Returns the position of the receiver at a time.
+	 */
+	vector3_t get_receiver_position(double time_s) const {
+		return {options.receiver_speed_m_s * time_s, 0.0, 0.0};
+	}
+
+	/**
+	 * \brief Returns the delay of the LOS component at a time, the reference delay.
+	 */
+	double get_los_delay(double time_s, const vector3_t &receiver) const {
+		return (get_satellite_distance(time_s) - dot(satellite.direction, receiver))
+				/ options.c0_m_s;
+	}
+
+	/**
+	 * \brief Returns the delay of the path from the satellite over a scatterer to the receiver.
+	 */
+	double get_scatterer_delay(double time_s, const vector3_t &receiver,
+			const scatterer_t &scatterer) const {
+		return (get_satellite_distance(time_s)
+				- dot(satellite.direction, scatterer.position)
+				+ distance(scatterer.position, receiver)) / options.c0_m_s;
+	}
+
+	/**
+	 * \brief Returns a component of a given delay and amplitude with the phase of the carrier.
+	 */
+	impulse_t get_component(uint16_t type, uint64_t id, double delay,
+			double amplitude) const {
+		return {type, id, delay, polar(amplitude,
+					-2.0 * M_PI * fmod(options.transmitter_frequency_Hz * delay, 1.0))};
+	}
+
+private:
+	double get_satellite_distance(double time_s) const {
+		return options.satellite_distance_m + satellite.range_rate_m_s * time_s;
+	}
+
+	void add_born_scatterers(int64_t birth_block,
+			vector<scatterer_t> &scatterers) const {
+		if (options.mean_nof_scatterers <= 0.0)
+			return;
+
+		mt19937_64 generator = get_generator(options.seed, 2 * link_index,
+				birth_block);
+		const double mean_nof_births = options.mean_nof_scatterers
+				/ options.mean_scatterer_lifetime_s * block_duration_s;
+		const uint64_t nof_births = poisson_distribution<uint64_t>(
+				mean_nof_births)(generator);
+		if (nof_births >= (uint64_t(1) << id_block_shift))
+			throw logic_error(
+					"generate: too many scatterers born during a block of CIRs.");
+
+		uniform_real_distribution<double> unit(0.0, 1.0);
+		exponential_distribution<double> lifetime(
+				1.0 / options.mean_scatterer_lifetime_s);
+		uniform_real_distribution<double> offset(
+				-options.max_scatterer_distance_m,
+				options.max_scatterer_distance_m);
+		uniform_real_distribution<double> height(0.0, max_scatterer_height_m);
+		normal_distribution<double> power_dB(options.mean_scatterer_power_dB,
+				options.scatterer_power_spread_dB);
+
+		for (uint64_t k = 0; k < nof_births; k++) {
+			scatterer_t scatterer;
+			scatterer.id = (uint64_t(birth_block + nof_lookback_blocks)
+					<< id_block_shift) + k + 1;
+			scatterer.birth_s = (birth_block + unit(generator))
+					* block_duration_s;
+			scatterer.death_s = scatterer.birth_s
+					+ min(lifetime(generator),
+							max_lifetime_factor
+									* options.mean_scatterer_lifetime_s);
+
+			// near the receiver at its birth:
+			const vector3_t receiver = get_receiver_position(scatterer.birth_s);
+			scatterer.position.x = receiver.x + offset(generator);
+			scatterer.position.y = offset(generator);
+			scatterer.position.z = height(generator);
+			scatterer.amplitude = pow(10.0, power_dB(generator) / 20.0);
+
+			scatterers.push_back(scatterer);
+		}
+	}
+
+	const generate_options_t &options;
+	const size_t link_index;
+	const double block_duration_s; ///< time of the CIRs of a block
+	const int64_t nof_lookback_blocks; ///< number of blocks a scatterer can live after the block of its birth
+	satellite_t satellite;
+};
+
+/**
+ * \brief The CIRs of a block of all links, indexed by CIR within the block and link.
+ */
+struct block_t {
+	vector<vector<components_t> > cirs; ///< continuous-delay files only
+	vector<vector<vector<complex<double> > > > samples; ///< discrete-delay files only
+	vector<vector<double> > reference_delays;
+	uint64_t nof_components = 0;
+	uint64_t nof_scatterers = 0;
+};
+
+static block_t compute_block(const generate_options_t &options,
+		const vector<unique_ptr<link_model_t> > &models, int64_t block_index) {
+	const cir_number_t first_cir = block_index * cirs_per_block;
+	const size_t nof_cirs = min(cirs_per_block, options.nof_cirs - first_cir);
+	const size_t nof_links = models.size();
+
+	block_t block;
+	if (options.discrete_delay)
+		block.samples.assign(nof_cirs,
+				vector<vector<complex<double> > >(nof_links,
+						vector<complex<double> >(options.nof_delay_samples)));
+	else
+		block.cirs.assign(nof_cirs, vector<components_t>(nof_links));
+	block.reference_delays.assign(nof_cirs, vector<double>(nof_links));
+
+	components_t components;
+	for (size_t l = 0; l < nof_links; l++) {
+		const link_model_t &model = *models[l];
+		const vector<scatterer_t> scatterers = model.get_scatterers(
+				block_index);
+		vector<bool> alive_in_block(scatterers.size(), false);
+
+		for (size_t n = 0; n < nof_cirs; n++) {
+			const double time_s = (first_cir + n) / options.cir_rate_Hz;
+			const vector3_t receiver = model.get_receiver_position(time_s);
+			const double los_delay = model.get_los_delay(time_s, receiver);
+
+			components.clear();
+			components.push_back(
+					model.get_component(los_type, 0, los_delay, 1.0));
+			for (size_t s = 0; s < scatterers.size(); s++)
+				if (scatterers[s].birth_s <= time_s
+						and time_s < scatterers[s].death_s) {
+					components.push_back(
+							model.get_component(scatterer_type,
+									scatterers[s].id,
+									model.get_scatterer_delay(time_s, receiver,
+											scatterers[s]),
+									scatterers[s].amplitude));
+					alive_in_block[s] = true;
+				}
+
+			block.reference_delays[n][l] = los_delay;
+			block.nof_components += components.size();
+			if (options.discrete_delay)
+				sample_components(components,
+						los_delay
+								- delay_samples_before_reference
+										/ options.delay_sampling_frequency_Hz,
+						options.delay_sampling_frequency_Hz,
+						block.samples[n][l]);
+			else
+				block.cirs[n][l] = components;
+		}
+
+		// scatterers alive at the last CIR of the block before were counted with it:
+		const double time_before_s = (double(first_cir) - 1.0)
+				/ options.cir_rate_Hz;
+		for (size_t s = 0; s < scatterers.size(); s++)
+			if (alive_in_block[s]
+					and (first_cir == 0 or scatterers[s].birth_s > time_before_s))
+				block.nof_scatterers++;
+	}
+
+	return block;
+}
+
+/**
+ * \brief Computes blocks on several threads and passes them to a function in order.
+ *
+ * At most two blocks per thread are computed ahead of the block that is written, so the
+ * memory does not depend on the number of blocks. Rethrows the first error of a thread or
+ * of the function.
+ */
+static void compute_blocks_in_order(uint64_t nof_blocks, size_t nof_threads,
+		const function<block_t(uint64_t)> &compute,
+		const function<void(block_t&)> &consume) {
+	const uint64_t max_blocks_ahead = 2 * nof_threads;
+
+	mutex blocks_mutex;
+	condition_variable blocks_changed;
+	map<uint64_t, block_t> computed_blocks;
+	uint64_t next_block = 0;
+	uint64_t next_consumed_block = 0;
+	bool stop = false;
+	exception_ptr error;
+
+	auto worker = [&]() {
+		unique_lock<mutex> lock(blocks_mutex);
+		while (true) {
+			blocks_changed.wait(lock,
+					[&]() {
+						return stop or next_block >= nof_blocks
+								or next_block < next_consumed_block + max_blocks_ahead;
+					});
+			if (stop or next_block >= nof_blocks)
+				return;
+
+			const uint64_t block_index = next_block++;
+			lock.unlock();
+			try {
+				block_t block = compute(block_index);
+				lock.lock();
+				computed_blocks[block_index] = move(block);
+			} catch (...) {
+				lock.lock();
+				if (not error)
+					error = current_exception();
+				stop = true;
+			}
+			blocks_changed.notify_all();
+		}
+	};
+
+	vector<thread> threads;
+	for (size_t k = 0; k < nof_threads; k++)
+		threads.emplace_back(worker);
+
+	for (uint64_t block_index = 0; block_index < nof_blocks; block_index++) {
+		block_t block;
+		{
+			unique_lock<mutex> lock(blocks_mutex);
+			blocks_changed.wait(lock, [&]() {
+				return stop or computed_blocks.count(block_index) > 0;
+			});
+			if (stop)
+				break;
+
+			block = move(computed_blocks[block_index]);
+			computed_blocks.erase(block_index);
+			next_consumed_block = block_index + 1;
+		}
+		blocks_changed.notify_all();
+
+		try {
+			consume(block);
+		} catch (...) {
+			lock_guard<mutex> lock(blocks_mutex);
+			error = current_exception();
+			stop = true;
+			break;
+		}
+	}
+
+	{
+		lock_guard<mutex> lock(blocks_mutex);
+		stop = true;
+	}
+	blocks_changed.notify_all();
+	for (auto &thread : threads)
+		thread.join();
+
+	if (error)
+		rethrow_exception(error);
+}
+
+generate_stats_t generate(const std::string &file_name,
+		const generate_options_t &options,
+		const H5::FileAccPropList &access_plist) {
+	if (options.nof_satellites == 0)
+		throw logic_error("generate: nof_satellites must be at least 1.");
+
+	if (options.cir_rate_Hz <= 0.0)
+		throw logic_error("generate: cir_rate_Hz must be positive.");
+
+	if (options.mean_nof_scatterers > 0.0
+			and options.mean_scatterer_lifetime_s <= 0.0)
+		throw logic_error("generate: mean_scatterer_lifetime_s must be positive.");
+
+	if (options.discrete_delay
+			and (options.delay_sampling_frequency_Hz <= 0.0
+					or options.nof_delay_samples == 0))
+		throw logic_error(
+				"generate: a discrete-delay file needs a positive sampling frequency and delay samples.");
+
+	if (options.nof_shards > 0
+			and (options.discrete_delay or options.write_track_index))
+		throw logic_error(
+				"generate: shards are only written for continuous-delay files without track index.");
+
+	const size_t nof_links = options.nof_satellites;
+	vector<string> link_names;
+	vector<unique_ptr<link_model_t> > models;
+	for (size_t l = 0; l < nof_links; l++) {
+		link_names.push_back("satellite" + to_string(l));
+		models.emplace_back(new link_model_t(options, l));
+	}
+
+	const size_t nof_threads =
+			options.nof_threads > 0 ?
+					options.nof_threads :
+					max(1u, thread::hardware_concurrency());
+	const uint64_t nof_blocks = (options.nof_cirs + cirs_per_block - 1)
+			/ cirs_per_block;
+	const auto compute = [&](uint64_t block_index) {
+		return compute_block(options, models, block_index);
+	};
+
+	generate_stats_t stats;
+	stats.nof_cirs = options.nof_cirs;
+	cir_number_t cir_number = 0;
+
+	if (options.discrete_delay) {
+		WriteDiscreteDelayFile cdx_out(file_name, options.c0_m_s,
+				options.cir_rate_Hz, options.transmitter_frequency_Hz,
+				link_names, options.delay_sampling_frequency_Hz, access_plist,
+				options.writer_options);
+		for (size_t l = 0; l < nof_links; l++)
+			cdx_out.setup_link(l, options.nof_delay_samples,
+					-(double(delay_samples_before_reference)
+							/ options.delay_sampling_frequency_Hz));
+
+		compute_blocks_in_order(nof_blocks, nof_threads, compute,
+				[&](block_t &block) {
+					for (size_t n = 0; n < block.samples.size(); n++)
+						for (size_t l = 0; l < nof_links; l++)
+							cdx_out.append_cir_snapshot(l, block.samples[n][l],
+									block.reference_delays[n][l]);
+					stats.nof_components += block.nof_components;
+					stats.nof_scatterers += block.nof_scatterers;
+				});
+		cdx_out.close();
+		return stats;
+	}
+
+	links_to_component_types_t component_types;
+	for (const auto &link_name : link_names)
+		component_types[link_name] = { { los_type, "LOS" }, { scatterer_type,
+				"Scatterer" } };
+
+	if (options.nof_shards > 0) {
+		ShardedWriteContinuousDelayFile cdx_out(file_name, options.c0_m_s,
+				options.cir_rate_Hz, options.transmitter_frequency_Hz,
+				link_names, component_types, options.nof_cirs,
+				options.nof_shards);
+
+		compute_blocks_in_order(nof_blocks, nof_threads, compute,
+				[&](block_t &block) {
+					for (size_t n = 0; n < block.cirs.size(); n++)
+						cdx_out.write_cir(move(block.cirs[n]),
+								move(block.reference_delays[n]), cir_number++);
+					stats.nof_components += block.nof_components;
+					stats.nof_scatterers += block.nof_scatterers;
+				});
+		cdx_out.finalize();
+		return stats;
+	}
+
+	WriteContinuousDelayFile cdx_out(file_name, options.c0_m_s,
+			options.cir_rate_Hz, options.transmitter_frequency_Hz, link_names,
+			component_types, options.write_track_index, access_plist,
+			options.writer_options);
+
+	// the components are converted and written while the next CIRs are computed:
+	cdx_out.enable_async_writer();
+
+	compute_blocks_in_order(nof_blocks, nof_threads, compute,
+			[&](block_t &block) {
+				for (size_t n = 0; n < block.cirs.size(); n++)
+					cdx_out.write_cir(move(block.cirs[n]),
+							move(block.reference_delays[n]), cir_number++);
+				stats.nof_components += block.nof_components;
+				stats.nof_scatterers += block.nof_scatterers;
+			});
+	cdx_out.close();
+
+	return stats;
+}
+
+} // end of namespace CDX
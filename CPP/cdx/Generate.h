@@ -0,0 +1,102 @@
+/**
+ * \file	Generate.h
+ *
+ * \brief	Synthetic CDX files from a geometric channel model, for benchmarks and soak tests.
+ */
+
+#ifndef CDX_GENERATE_H_
+#define CDX_GENERATE_H_
+
+#include "WriteFile.h"
+
+namespace CDX {
+
+/**
+ * \brief Parameters of the geometric model and the output of generate.
+ */
+struct generate_options_t {
+	generate_options_t() :
+			nof_satellites(4), nof_cirs(10000), cir_rate_Hz(100.0), c0_m_s(
+					3e8), transmitter_frequency_Hz(1.57542e9), satellite_distance_m(
+					20200e3), max_range_rate_m_s(800.0), receiver_speed_m_s(
+					10.0), mean_nof_scatterers(100.0), mean_scatterer_lifetime_s(
+					2.0), max_scatterer_distance_m(300.0), mean_scatterer_power_dB(
+					-20.0), scatterer_power_spread_dB(6.0), seed(1), nof_threads(
+					0), discrete_delay(false), delay_sampling_frequency_Hz(
+					100e6), nof_delay_samples(256), write_track_index(false), nof_shards(
+					0) {
+	}
+
+	size_t nof_satellites; ///< number of satellites, one link each, named satellite0, satellite1, ...
+	cir_number_t nof_cirs; ///< number of CIRs of each link
+	double cir_rate_Hz; ///< CIR rate, CIR n is at time n / cir_rate_Hz
+	double c0_m_s; ///< speed of light
+	double transmitter_frequency_Hz; ///< carrier frequency, sets the phase of the components
+	double satellite_distance_m; ///< distance of all satellites from the receiver at time 0
+	double max_range_rate_m_s; ///< the range rate of each satellite is uniform in [-max, max]
+	double receiver_speed_m_s; ///< speed of the receiver, which moves along the x axis
+	double mean_nof_scatterers; ///< mean number of scatterers of each link alive at a time
+	double mean_scatterer_lifetime_s; ///< mean of the exponentially distributed lifetime of a scatterer
+	double max_scatterer_distance_m; ///< largest distance of a scatterer from the receiver at its birth in x and y
+	double mean_scatterer_power_dB; ///< mean power of a scatterer relative to the LOS component
+	double scatterer_power_spread_dB; ///< standard deviation of the power of the scatterers
+	uint64_t seed; ///< seed of the model, the same seed gives the same file for any nof_threads
+	size_t nof_threads; ///< number of threads that compute CIRs, all hardware threads if 0
+	bool discrete_delay; ///< write a discrete-delay file instead of a continuous-delay file
+	double delay_sampling_frequency_Hz; ///< sampling frequency of the delay axis of a discrete-delay file
+	size_t nof_delay_samples; ///< delay samples of each CIR of a discrete-delay file
+	bool write_track_index; ///< write a track index to a continuous-delay file
+	size_t nof_shards; ///< write a continuous-delay file as shards and a master file, see ShardedWriteContinuousDelayFile, if not 0
+	writer_options_t writer_options; ///< file space and group storage settings, not used for shards
+};
+
+/**
+ * \brief Numbers of CIRs and components written by generate.
+ */
+struct generate_stats_t {
+	generate_stats_t() :
+			nof_cirs(0), nof_components(0), nof_scatterers(0) {
+	}
+
+	uint64_t nof_cirs; ///< CIRs written to each link
+	uint64_t nof_components; ///< components of all CIRs of all links
+	uint64_t nof_scatterers; ///< scatterers alive during at least one CIR, of all links
+};
+
+/**
+ * \brief Writes a CDX file with CIRs of a moving receiver and several satellites.
+ *
+ * The receiver starts at the origin and moves along the x axis. Each satellite is far
+ * away in a direction of random azimuth and an elevation between 15 and 75 degrees, and
+ * its distance changes at a constant range rate. The CIR of each link has
+ *
+ *  - a LOS component of type 0, identifier 0 and power 1, and
+ *  - the components of type 256 of point scatterers on the ground near the route of the
+ *    receiver, reached by a plane wave from the satellite.
+ *
+ * Scatterers are born as a Poisson process and die after an exponentially distributed
+ * lifetime, cut at ten times its mean, so mean_nof_scatterers are alive on average from
+ * the first CIR on. Their identifiers are unique within a link. The delay of a component
+ * is the travel time of its path and its phase that of the carrier after this time. The
+ * reference delay is the delay of the LOS component.
+ *
+ * A discrete-delay file samples the components of each CIR with sample_components, as
+ * cdx-convert-continuous-to-discrete does. Sample \c k of a CIR is at the delay
+ * <tt>(k - 4) / delay_sampling_frequency_Hz</tt> after its reference delay.
+ *
+ * The CIRs are computed in blocks by nof_threads threads and written in order. All random
+ * numbers of a block are drawn from generators seeded by the seed, the link and the
+ * block, so the file does not depend on the number of threads.
+ *
+ * \param[in] file_name File to create, an existing file is overwritten
+ * \param[in] options Parameters of the model and the output
+ * \param[in] access_plist File access properties of the file, not used for shards
+ * \return Numbers of CIRs and components written
+ */
+generate_stats_t generate(const std::string &file_name,
+		const generate_options_t &options,
+		const H5::FileAccPropList &access_plist = H5::FileAccPropList::DEFAULT);
+
+} // end of namespace CDX
+
+#endif /* CDX_GENERATE_H_ */
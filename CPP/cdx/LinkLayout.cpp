@@ -0,0 +1,173 @@
+/**
+ * \file	LinkLayout.cpp
+ *
+ * \brief	Attributes with the number and size of the CIRs of each link.
+ */
+
+#include "LinkLayout.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include <boost/lexical_cast.hpp>
+
+using namespace std;
+
+namespace CDX {
+
+/**
+ * \brief Opens an attribute of a group, creating it anew if it does not exist with the given type and size.
+ */
+static H5::Attribute open_attribute(H5::Group &group, const char *name,
+		const H5::DataType &type, const H5::DataSpace &space) {
+	if (group.attrExists(name)) {
+		H5::Attribute attribute = group.openAttribute(name);
+		if (attribute.getDataType() == type
+				and attribute.getSpace().getSimpleExtentNpoints()
+						== space.getSimpleExtentNpoints())
+			return attribute;
+
+		attribute.close();
+		group.removeAttr(name);
+	}
+
+	return group.createAttribute(name, type, space);
+}
+
+static void write_uint64(H5::Group &group, const char *name, uint64_t value) {
+	open_attribute(group, name, H5::PredType::NATIVE_UINT64, H5::DataSpace()).write(
+			H5::PredType::NATIVE_UINT64, &value);
+}
+
+static uint64_t read_uint64(const H5::Group &group, const char *name) {
+	uint64_t value;
+	group.openAttribute(name).read(H5::PredType::NATIVE_UINT64, &value);
+	return value;
+}
+
+void write_link_layout(H5::Group &link_group, const link_layout_t &layout) {
+	const uint32_t version = link_layout_version;
+	open_attribute(link_group, "layout_version", H5::PredType::NATIVE_UINT32,
+			H5::DataSpace()).write(H5::PredType::NATIVE_UINT32, &version);
+
+	write_uint64(link_group, "nof_cirs", layout.nof_cirs);
+	write_uint64(link_group, "max_nof_components", layout.max_nof_components);
+
+	const H5::StrType str_type(H5::PredType::C_S1,
+			max<size_t>(layout.sample_type.size(), 1));
+	open_attribute(link_group, "sample_type", str_type, H5::DataSpace()).write(
+			str_type, layout.sample_type);
+
+	if (layout.chunk_dims.empty()) {
+		if (link_group.attrExists("chunk_dims"))
+			link_group.removeAttr("chunk_dims");
+	} else {
+		vector<uint64_t> chunk_dims(layout.chunk_dims.begin(),
+				layout.chunk_dims.end());
+		const hsize_t dims[1] = { chunk_dims.size() };
+		open_attribute(link_group, "chunk_dims", H5::PredType::NATIVE_UINT64,
+				H5::DataSpace(1, dims)).write(H5::PredType::NATIVE_UINT64,
+				chunk_dims.data());
+	}
+}
+
+link_layout_t read_link_layout(const H5::Group &link_group) {
+	link_layout_t layout;
+
+	if (not link_group.attrExists("layout_version"))
+		return layout;
+
+	link_group.openAttribute("layout_version").read(H5::PredType::NATIVE_UINT32,
+			&layout.version);
+
+	// later versions may store the CIRs differently:
+	if (layout.version > link_layout_version)
+		return layout;
+
+	layout.nof_cirs = read_uint64(link_group, "nof_cirs");
+	layout.max_nof_components = read_uint64(link_group, "max_nof_components");
+
+	H5::Attribute sample_type = link_group.openAttribute("sample_type");
+	sample_type.read(sample_type.getStrType(), layout.sample_type);
+
+	if (link_group.attrExists("chunk_dims")) {
+		H5::Attribute attribute = link_group.openAttribute("chunk_dims");
+		vector<uint64_t> chunk_dims(attribute.getSpace().getSimpleExtentNpoints());
+		if (not chunk_dims.empty())
+			attribute.read(H5::PredType::NATIVE_UINT64, chunk_dims.data());
+		layout.chunk_dims.assign(chunk_dims.begin(), chunk_dims.end());
+	}
+
+	layout.available = true;
+	return layout;
+}
+
+/**
+ * \brief Returns the chunk dimensions of a dataset, empty if it is not chunked.
+ */
+static vector<hsize_t> get_chunk_dims(const H5::DataSet &dataset) {
+	const H5::DSetCreatPropList plist = dataset.getCreatePlist();
+	if (plist.getLayout() != H5D_CHUNKED)
+		return vector<hsize_t>();
+
+	vector<hsize_t> chunk_dims(dataset.getSpace().getSimpleExtentNdims());
+	plist.getChunk(chunk_dims.size(), chunk_dims.data());
+	return chunk_dims;
+}
+
+void build_link_layout(const std::string &file_name) {
+	H5::H5File h5file(file_name.c_str(), H5F_ACC_RDWR);
+
+	const string delay_type = File::read_string_h5(h5file,
+			"/parameters/delay_type");
+	if (delay_type != "continuous-delay" and delay_type != "discrete-delay")
+		throw logic_error(
+				"build_link_layout: " + file_name
+						+ " has an unknown delay type.");
+
+	H5::Group links_group = h5file.openGroup("/links");
+
+	for (hsize_t l = 0; l < links_group.getNumObjs(); l++) {
+		H5::Group link_group = links_group.openGroup(
+				links_group.getObjnameByIdx(l));
+
+		// one reference delay is appended after each complete CIR:
+		hsize_t nof_reference_delays = 0;
+		link_group.openDataSet("reference_delays").getSpace().getSimpleExtentDims(
+				&nof_reference_delays);
+
+		link_layout_t layout;
+
+		if (delay_type == "continuous-delay") {
+			H5::Group cirs_group = link_group.openGroup("cirs");
+			layout.sample_type = "impulse";
+			layout.nof_cirs = min<hsize_t>(nof_reference_delays,
+					cirs_group.getNumObjs());
+
+			for (cir_number_t n = 0; n < layout.nof_cirs; n++) {
+				H5::DataSet dataset = cirs_group.openDataSet(
+						boost::lexical_cast<string>(n));
+				layout.max_nof_components = max<uint64_t>(
+						layout.max_nof_components,
+						dataset.getSpace().getSimpleExtentNpoints());
+			}
+		} else {
+			layout.sample_type = "double";
+
+			// links that have not been set up have no CIRs:
+			if (H5Lexists(link_group.getId(), "cirs_real", H5P_DEFAULT) > 0) {
+				H5::DataSet dataset = link_group.openDataSet("cirs_real");
+				hsize_t dims[2];
+				dataset.getSpace().getSimpleExtentDims(dims);
+
+				layout.nof_cirs = min(nof_reference_delays, dims[1]);
+				layout.max_nof_components = dims[0];
+				layout.chunk_dims = get_chunk_dims(dataset);
+			}
+		}
+
+		write_link_layout(link_group, layout);
+	}
+}
+
+} // end of namespace CDX
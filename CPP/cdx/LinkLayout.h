@@ -0,0 +1,76 @@
+/**
+ * \file	LinkLayout.h
+ *
+ * \brief	Number and size of the CIRs of a link, stored as attributes of the link's group.
+ */
+
+#ifndef CDX_LINKLAYOUT_H_
+#define CDX_LINKLAYOUT_H_
+
+#include "File.h"
+
+namespace CDX {
+
+/**
+ * \brief Version of the link layout written by this library, see link_layout_t.
+ */
+const uint32_t link_layout_version = 1;
+
+/**
+ * \brief Number and size of the CIRs of a link.
+ *
+ * The writers store the layout as the attributes \c layout_version, \c nof_cirs,
+ * \c max_nof_components, \c sample_type and \c chunk_dims of each link group and update
+ * them when the file is flushed or closed, so readers need not count datasets to find
+ * them. \c nof_cirs only counts CIRs stored in their final layout, i.e. not the CIRs
+ * appended in SWMR mode to a continuous-delay file that has not been closed yet.
+ *
+ * Files written by older versions of the library do not have the attributes, see
+ * build_link_layout.
+ */
+struct link_layout_t {
+	link_layout_t() :
+			available(false), version(0), nof_cirs(0), max_nof_components(0) {
+	}
+
+	bool available; ///< false if the link has no layout attributes or a newer layout version
+	uint32_t version; ///< the layout version, see link_layout_version
+	uint64_t nof_cirs; ///< number of CIRs
+	uint64_t max_nof_components; ///< the largest number of components of a CIR, the number of delay samples for discrete-delay links
+	std::string sample_type; ///< "impulse" for components stored as hdf5_impulse_t, "double" for the real and imaginary parts of discrete-delay samples
+	std::vector<hsize_t> chunk_dims; ///< chunk dimensions of the datasets of the CIRs, empty if they are not chunked
+};
+
+/**
+ * \brief Writes the layout of a link as attributes of its group.
+ *
+ * Existing attributes are overwritten in place, so the layout can be updated in SWMR mode
+ * as long as \c sample_type and the size of \c chunk_dims stay the same.
+ *
+ * \param[in] link_group Group of the link
+ * \param[in] layout The layout, \c available and \c version are ignored
+ */
+void write_link_layout(H5::Group &link_group, const link_layout_t &layout);
+
+/**
+ * \brief Reads the layout of a link.
+ *
+ * \param[in] link_group Group of the link
+ * \return The layout, not available for files without layout attributes or with a newer
+ * layout version
+ */
+link_layout_t read_link_layout(const H5::Group &link_group);
+
+/**
+ * \brief Writes the layout attributes of all links of an existing CDX file.
+ *
+ * Counts the CIRs of each link and their components, as readers do for files without the
+ * attributes. The file is opened for writing.
+ *
+ * \param[in] file_name File name
+ */
+void build_link_layout(const std::string &file_name);
+
+} // end of namespace CDX
+
+#endif /* CDX_LINKLAYOUT_H_ */
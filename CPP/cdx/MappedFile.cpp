@@ -0,0 +1,48 @@
+/**
+ * \file	MappedFile.cpp
+ *
+ * \brief	Read-only memory mapping of a whole file.
+ */
+
+#include "MappedFile.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define CDX_HAVE_MMAP
+#endif
+
+namespace CDX {
+
+MappedFile::MappedFile(const std::string &file_name) :
+		address(nullptr), size(0) {
+#ifdef CDX_HAVE_MMAP
+	const int fd = open(file_name.c_str(), O_RDONLY);
+	if (fd < 0)
+		return;
+
+	struct stat file_stat;
+	if (fstat(fd, &file_stat) == 0 and file_stat.st_size > 0) {
+		void *mapping = mmap(nullptr, file_stat.st_size, PROT_READ, MAP_SHARED,
+				fd, 0);
+		if (mapping != MAP_FAILED) {
+			address = static_cast<const char *>(mapping);
+			size = file_stat.st_size;
+		}
+	}
+
+	// the mapping stays valid after closing the file descriptor:
+	close(fd);
+#endif
+}
+
+MappedFile::~MappedFile() {
+#ifdef CDX_HAVE_MMAP
+	if (address != nullptr)
+		munmap(const_cast<char *>(address), size);
+#endif
+}
+
+} // end of namespace CDX
@@ -0,0 +1,60 @@
+/**
+ * \file	MappedFile.h
+ *
+ * \brief	Read-only memory mapping of a whole file.
+ */
+
+#ifndef CDX_MAPPEDFILE_H_
+#define CDX_MAPPEDFILE_H_
+
+#include <string>
+#include <cstddef>
+
+namespace CDX {
+
+/**
+ * \brief Maps a file read-only into memory.
+ *
+ * The mapping is released in the destructor. On platforms without \c mmap,
+ * is_mapped() always returns false.
+ */
+class MappedFile {
+public:
+	/**
+	 * \brief Maps the file. If mapping fails, is_mapped() returns false.
+	 *
+	 * \param[in] file_name File name
+	 */
+	MappedFile(const std::string &file_name);
+
+	virtual ~MappedFile();
+
+	/** returns true if the file is mapped */
+	bool is_mapped() const {
+		return address != nullptr;
+	}
+
+	/**
+	 * \brief Returns a pointer to a region of the file.
+	 *
+	 * \param[in] offset Offset of the region from the beginning of the file in bytes
+	 * \param[in] length Length of the region in bytes
+	 * \return Address of the region or nullptr if the region is not inside the mapping
+	 */
+	const char *get_region(size_t offset, size_t length) const {
+		if (address == nullptr or offset > size or length > size - offset)
+			return nullptr;
+		return address + offset;
+	}
+
+private:
+	MappedFile(const MappedFile &);
+	MappedFile &operator=(const MappedFile &);
+
+	const char *address; ///< start of the mapping
+	size_t size; ///< length of the mapping in bytes
+};
+
+} // end of namespace CDX
+
+#endif /* CDX_MAPPEDFILE_H_ */
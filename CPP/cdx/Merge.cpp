@@ -0,0 +1,279 @@
+/**
+ * \file	Merge.cpp
+ *
+ * \brief	Concatenation and merging of continuous-delay CDX files.
+ */
+
+#include "Merge.h"
+#include "ReadContinuousDelayFile.h"
+#include "WriteContinuousDelayFile.h"
+#include "TrackIndex.h"
+
+#include <algorithm>
+#include <memory>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+
+using namespace std;
+
+namespace CDX {
+
+/// size of the HDF5 metadata cache of each input file in bytes
+static const size_t metadata_cache_size = 4 * 1024 * 1024;
+
+/**
+ * \brief Adds component types to the types of a link, throwing if a type has two names.
+ */
+static void add_component_types(component_types_t &types,
+		const component_types_t &new_types, const string &link_name) {
+	for (const auto &new_type : new_types) {
+		const auto it = types.find(new_type.first);
+		if (it == types.end())
+			types.insert(new_type);
+		else if (it->second != new_type.second) {
+			stringstream msg;
+			msg << "merge: component type " << new_type.first << " of link "
+					<< link_name << " is named " << it->second << " and "
+					<< new_type.second << " in different input files.";
+			throw runtime_error(msg.str());
+		}
+	}
+}
+
+/**
+ * \brief Reads consecutive CIRs and writes them, each output link from a link of an input file.
+ *
+ * The reads hold get_hdf5_mutex(), because the asynchronous writer of cdx_out calls HDF5
+ * at the same time.
+ *
+ * \param[in] inputs Input file of each output link
+ * \param[in] input_link_indices Index of the link of its input file for each output link
+ */
+static void copy_decoded(const vector<ReadContinuousDelayFile *> &inputs,
+		const vector<size_t> &input_link_indices, cir_number_t first_cir,
+		cir_number_t count, size_t batch_size,
+		WriteContinuousDelayFile &cdx_out, merge_stats_t &stats) {
+	const size_t nof_links = inputs.size();
+	const cir_number_t end_cir = first_cir + count;
+
+	cir_block_t block;
+	for (cir_number_t batch_first = first_cir; batch_first < end_cir;
+			batch_first += batch_size) {
+		const size_t batch_count = min<cir_number_t>(batch_size,
+				end_cir - batch_first);
+
+		// the CIRs are moved into the queue of the writer, so the batch is allocated anew:
+		vector<vector<components_t> > cirs(batch_count,
+				vector<components_t>(nof_links));
+		vector<vector<double> > reference_delays(batch_count,
+				vector<double>(nof_links));
+
+		for (size_t l = 0; l < nof_links; l++) {
+			{
+				lock_guard<mutex> hdf5_lock(get_hdf5_mutex());
+				inputs[l]->read_cirs(input_link_indices[l], batch_first,
+						batch_count, block);
+			}
+
+			for (size_t k = 0; k < batch_count; k++) {
+				reference_delays[k][l] = block.ref_delays[k];
+
+				components_t &components = cirs[k][l];
+				components.resize(block.offsets[k + 1] - block.offsets[k]);
+				for (size_t i = block.offsets[k], c = 0;
+						i < block.offsets[k + 1]; i++, c++) {
+					components[c].type = block.types[i];
+					components[c].id = block.ids[i];
+					components[c].delay = block.delays[i];
+					components[c].amplitude = complex<double>(block.reals[i],
+							block.imags[i]);
+				}
+			}
+		}
+
+		for (size_t k = 0; k < batch_count; k++)
+			cdx_out.write_cir(std::move(cirs[k]),
+					std::move(reference_delays[k]), stats.nof_cirs++);
+
+		stats.nof_decoded_cirs += batch_count * nof_links;
+	}
+}
+
+/**
+ * \brief Appends the input files one after the other, see merge.
+ */
+static merge_stats_t concatenate(const vector<string> &input_file_names,
+		const string &output_file_name, const merge_options_t &options,
+		const H5::FileAccPropList &access_plist) {
+	// apart from the first file, the files are opened one at a time, so the number of open
+	// files does not grow with the number of input files:
+	ReadContinuousDelayFile first(input_file_names[0], access_plist);
+	const vector<string> link_names = first.get_link_names();
+
+	vector<string> sorted_link_names = link_names;
+	sort(sorted_link_names.begin(), sorted_link_names.end());
+
+	links_to_component_types_t component_types;
+	for (size_t i = 0; i < input_file_names.size(); i++) {
+		ReadContinuousDelayFile cdx_in(input_file_names[i], access_plist);
+		first.check_same_parameters(cdx_in, "merge");
+
+		vector<string> names = cdx_in.get_link_names();
+		sort(names.begin(), names.end());
+		if (names != sorted_link_names)
+			throw runtime_error(
+					"merge: " + input_file_names[i]
+							+ " has other links than the first input file.");
+
+		for (const auto &link_name : link_names)
+			add_component_types(component_types[link_name],
+					cdx_in.get_component_types(
+							cdx_in.get_link_index(link_name)), link_name);
+	}
+
+	const size_t nof_links = link_names.size();
+
+	merge_stats_t stats;
+	stats.nof_links = nof_links;
+
+	WriteContinuousDelayFile cdx_out(output_file_name, first.get_c0_m_s(),
+			first.get_cir_rate_Hz(), first.get_transmitter_frequency_Hz(),
+			link_names, component_types, options.write_track_index);
+	if (not options.bulk_copy)
+		cdx_out.enable_async_writer(options.batch_size);
+
+	for (const auto &input_file_name : input_file_names) {
+		ReadContinuousDelayFile cdx_in(input_file_name, access_plist);
+		const cir_number_t nof_cirs = cdx_in.get_nof_cirs();
+
+		vector<size_t> input_link_indices;
+		for (const auto &link_name : link_names)
+			input_link_indices.push_back(cdx_in.get_link_index(link_name));
+
+		if (options.bulk_copy) {
+			cdx_out.copy_cirs(cdx_in, input_link_indices, 0, nof_cirs);
+			stats.nof_cirs += nof_cirs;
+			stats.nof_copied_cirs += nof_cirs * nof_links;
+		} else {
+			copy_decoded(
+					vector<ReadContinuousDelayFile *>(nof_links, &cdx_in),
+					input_link_indices, 0, nof_cirs, options.batch_size,
+					cdx_out, stats);
+
+			// the writer thread must be idle while the input file is closed and the next one
+			// is opened, which calls HDF5 without holding get_hdf5_mutex():
+			cdx_out.flush();
+		}
+	}
+
+	cdx_out.close();
+
+	return stats;
+}
+
+/**
+ * \brief Combines the links of the input files, see merge.
+ */
+static merge_stats_t combine_links(const vector<string> &input_file_names,
+		const string &output_file_name, const merge_options_t &options,
+		const H5::FileAccPropList &access_plist) {
+	vector<unique_ptr<ReadContinuousDelayFile> > inputs;
+	for (const auto &input_file_name : input_file_names)
+		inputs.emplace_back(
+				new ReadContinuousDelayFile(input_file_name, access_plist));
+
+	vector<string> link_names;
+	vector<ReadContinuousDelayFile *> link_inputs;
+	vector<size_t> input_link_indices;
+	set<string> unique_link_names;
+	for (size_t i = 0; i < inputs.size(); i++) {
+		inputs[0]->check_same_parameters(*inputs[i], "merge");
+
+		if (inputs[i]->get_nof_cirs() != inputs[0]->get_nof_cirs()) {
+			stringstream msg;
+			msg << "merge: " << input_file_names[i] << " has "
+					<< inputs[i]->get_nof_cirs() << " CIRs, the first input file "
+					<< inputs[0]->get_nof_cirs() << ".";
+			throw runtime_error(msg.str());
+		}
+
+		for (size_t l = 0; l < inputs[i]->get_nof_links(); l++) {
+			const string &link_name = inputs[i]->get_link_name(l);
+			if (not unique_link_names.insert(link_name).second)
+				throw runtime_error(
+						"merge: link " + link_name
+								+ " is contained in more than one input file.");
+
+			link_names.push_back(link_name);
+			link_inputs.push_back(inputs[i].get());
+			input_link_indices.push_back(l);
+		}
+	}
+
+	const size_t nof_links = link_names.size();
+	const cir_number_t nof_cirs = inputs[0]->get_nof_cirs();
+
+	merge_stats_t stats;
+	stats.nof_links = nof_links;
+
+	if (options.bulk_copy) {
+		{
+			H5::H5File h5file(output_file_name, H5F_ACC_TRUNC);
+			inputs[0]->copy_object("/parameters", h5file, "/parameters");
+
+			H5::Group links_group = h5file.createGroup("/links");
+			for (size_t l = 0; l < nof_links; l++)
+				link_inputs[l]->copy_object("/links/" + link_names[l],
+						links_group, link_names[l]);
+		}
+
+		stats.nof_cirs = nof_cirs;
+		stats.nof_copied_cirs = nof_cirs * nof_links;
+
+		if (options.write_track_index)
+			build_track_index(output_file_name);
+
+		return stats;
+	}
+
+	links_to_component_types_t component_types;
+	for (size_t l = 0; l < nof_links; l++)
+		component_types[link_names[l]] = link_inputs[l]->get_component_types(
+				input_link_indices[l]);
+
+	WriteContinuousDelayFile cdx_out(output_file_name,
+			inputs[0]->get_c0_m_s(), inputs[0]->get_cir_rate_Hz(),
+			inputs[0]->get_transmitter_frequency_Hz(), link_names,
+			component_types, options.write_track_index);
+	cdx_out.enable_async_writer(options.batch_size);
+
+	copy_decoded(link_inputs, input_link_indices, 0, nof_cirs,
+			options.batch_size, cdx_out, stats);
+
+	cdx_out.close();
+
+	return stats;
+}
+
+merge_stats_t merge(const std::vector<std::string> &input_file_names,
+		const std::string &output_file_name, const merge_options_t &options) {
+	if (input_file_names.empty())
+		throw logic_error("merge: no input files given.");
+
+	if (options.batch_size == 0)
+		throw logic_error("merge: batch_size must be at least 1.");
+
+	// every CIR is read once, so the metadata cache is limited as in resample:
+	const H5::FileAccPropList access_plist = get_limited_cache_access_plist(
+			metadata_cache_size);
+
+	if (options.mode == merge_links)
+		return combine_links(input_file_names, output_file_name, options,
+				access_plist);
+
+	return concatenate(input_file_names, output_file_name, options,
+			access_plist);
+}
+
+} // end of namespace CDX
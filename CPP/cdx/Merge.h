@@ -0,0 +1,79 @@
+/**
+ * \file	Merge.h
+ *
+ * \brief	Concatenation and merging of continuous-delay CDX files.
+ */
+
+#ifndef CDX_MERGE_H_
+#define CDX_MERGE_H_
+
+#include "File.h"
+
+namespace CDX {
+
+/**
+ * \brief How merge combines its input files.
+ */
+enum merge_mode_t {
+	merge_time, ///< appends the CIRs of files with the same links one file after the other
+	merge_links ///< combines the links of files with disjoint links and the same number of CIRs
+};
+
+/**
+ * \brief Options of merge.
+ */
+struct merge_options_t {
+	merge_options_t() :
+			mode(merge_time), bulk_copy(true), batch_size(256), write_track_index(
+					false) {
+	}
+
+	merge_mode_t mode; ///< how the input files are combined
+	bool bulk_copy; ///< copy the datasets of the CIRs without decoding them, otherwise each CIR is read and written
+	size_t batch_size; ///< number of CIRs of a link read in one batch if bulk_copy is false, at least 1
+	bool write_track_index; ///< write a track index to the output file
+};
+
+/**
+ * \brief Numbers of links and CIRs of the file written by merge.
+ */
+struct merge_stats_t {
+	merge_stats_t() :
+			nof_links(0), nof_cirs(0), nof_copied_cirs(0), nof_decoded_cirs(0) {
+	}
+
+	size_t nof_links; ///< links of the output file
+	uint64_t nof_cirs; ///< CIRs of each link of the output file
+	uint64_t nof_copied_cirs; ///< CIRs of all links copied without decoding
+	uint64_t nof_decoded_cirs; ///< CIRs of all links read and written
+};
+
+/**
+ * \brief Combines continuous-delay CDX files into a new file.
+ *
+ * All input files must have the same speed of light, CIR rate and transmitter frequency.
+ *
+ * With merge_time, all input files must have the same links. CIR \c n of input file \c i
+ * becomes CIR <tt>n + N</tt> of the output file, where \c N is the number of CIRs of the
+ * input files before \c i. The component types of each link are the union of the types of
+ * the input files, a type with different names in two files is an error.
+ *
+ * With merge_links, the input files must have disjoint links and the same number of CIRs.
+ * The output file contains the links of all input files.
+ *
+ * With bulk_copy, the datasets are copied with H5Ocopy, see
+ * WriteContinuousDelayFile::copy_cirs. With merge_links, each link group is copied as a
+ * whole, including its delay bounds and track index. Otherwise, the CIRs are read in
+ * batches with ReadContinuousDelayFile::read_cirs and written by the asynchronous writer.
+ *
+ * \param[in] input_file_names Continuous-delay CDX files to combine, in order of time for merge_time
+ * \param[in] output_file_name File to create, an existing file is overwritten
+ * \param[in] options How the files are combined
+ * \return Numbers of links and CIRs of the output file
+ */
+merge_stats_t merge(const std::vector<std::string> &input_file_names,
+		const std::string &output_file_name, const merge_options_t &options);
+
+} // end of namespace CDX
+
+#endif /* CDX_MERGE_H_ */
@@ -12,17 +12,34 @@
 
 #include "ReadContinuousDelayFile.h"
 
-#include <boost/lexical_cast.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
 #include <iostream>
 
 using namespace std;
 
 namespace CDX {
 
+/// number of components the buffer of read_cirs is sized for in advance and keeps between calls, 1M components are 40 MB
+static const size_t raw_buffer_budget = 1 << 20;
+
 const bool sdebug = false;
 
-ReadContinuousDelayFile::ReadContinuousDelayFile(string _file_name) :
-		ReadFile(_file_name) {
+/**
+ * \brief Refreshes the metadata of a dataset that a writer in SWMR mode appends to.
+ */
+static void refresh_dataset(H5::DataSet &dataset) {
+	if (H5Drefresh(dataset.getId()) < 0)
+		throw runtime_error(
+				"ReadContinuousDelayFile: refreshing a dataset failed.");
+}
+
+ReadContinuousDelayFile::ReadContinuousDelayFile(string _file_name,
+		const H5::FileAccPropList &_access_plist, bool _lazy_open,
+		unsigned int _flags) :
+		ReadFile(_file_name, _access_plist, _lazy_open, _flags), lazy_open(
+				_lazy_open) {
 
 	// delay-type has to be continuous-delay:
 	if (delay_type != "continuous-delay") {
@@ -32,25 +49,27 @@ ReadContinuousDelayFile::ReadContinuousDelayFile(string _file_name) :
 		throw logic_error(err_msg.str());
 	}
 
-	// open group for cirs for each link:
-	for (size_t k = 0; k < link_names.size(); k++) {
-		cir_groups[link_names.at(k)] = new H5::Group(
-				link_groups[link_names.at(k)]->openGroup("cirs"));
-	}
-
-	// read number of cirs
-	// for link 0:
-	nof_cirs = cir_groups[link_names.at(0)]->getNumObjs();
+	cir_groups.resize(nof_links, nullptr);
+	cir_locations.resize(nof_links);
+	delay_bounds.resize(nof_links);
+	track_indices.resize(nof_links);
+	appended_cirs.resize(nof_links);
 
-	for (size_t k = 0; k < link_names.size(); k++) {
-		const size_t nof_cirs_in_link = cir_groups[link_names.at(k)]->getNumObjs();
+	if (lazy_open) {
+		// one reference delay is written per CIR, its number is read without counting:
+		nof_cirs = nof_links > 0 ? get_nof_complete_cirs(0) : 0;
+	} else {
+		// open group for cirs for each link:
+		for (size_t k = 0; k < nof_links; k++)
+			get_cir_group(k);
 
-		if (nof_cirs != nof_cirs_in_link) {
-			stringstream err_msg;
-			err_msg << "snReadCIRFile: number of cirs for link 0 (" << nof_cirs
-					<< ") differs from number of cirs for link("
-					<< nof_cirs_in_link << ")!";
-			throw logic_error(err_msg.str());
+		// the destructor is not called, the groups would keep the file open:
+		try {
+			read_nof_cirs();
+		} catch (...) {
+			for (auto cir_group : cir_groups)
+				delete cir_group;
+			throw;
 		}
 	}
 
@@ -66,52 +85,919 @@ ReadContinuousDelayFile::ReadContinuousDelayFile(string _file_name) :
 			H5::PredType::NATIVE_DOUBLE);
 	cp_echo->insertMember("imag", HOFFSET(hdf5_impulse_t, imag),
 			H5::PredType::NATIVE_DOUBLE);
+
+	for (size_t field = 0; field < nof_component_fields; field++)
+		cp_fields.push_back(get_component_field_type(field));
+	cp_subsets.resize(all_component_fields + 1, NULL);
 }
 
 cir_t ReadContinuousDelayFile::get_cir(std::string link,
-		unsigned int cir_num) {
+		unsigned int cir_num, unsigned fields) {
+	return get_cir(get_link_index(link), cir_num, fields);
+}
+
+cir_t ReadContinuousDelayFile::get_cir(size_t link_index,
+		cir_number_t cir_num, unsigned fields) {
 	cir_t result_cir;
 
-	if (cir_groups.count(link) < 1) {
-		throw logic_error(
-				"ReadContinuousDelayCDXFile::get_cir: did not find link in file.");
+	vector<hdf5_impulse_t> echoes;
+	result_cir.ref_delay = get_raw_cir(link_index, cir_num, echoes, fields);
+
+	convert_components(echoes, result_cir.components);
+
+	return result_cir;
+}
+
+double ReadContinuousDelayFile::get_raw_cir(const std::string &link,
+		cir_number_t cir_num, std::vector<hdf5_impulse_t> &components,
+		unsigned fields) {
+	return get_raw_cir(get_link_index(link), cir_num, components, fields);
+}
+
+double ReadContinuousDelayFile::get_raw_cir(size_t link_index,
+		cir_number_t cir_num, std::vector<hdf5_impulse_t> &components,
+		unsigned fields) {
+	check_cir(link_index, cir_num, "ReadContinuousDelayCDXFile::get_cir");
+
+	read_components(link_index, cir_num, components, fields);
+
+	return get_reference_delay(link_index, cir_num);
+}
+
+arena_cir_t ReadContinuousDelayFile::get_cir(size_t link_index,
+		cir_number_t cir_num, CIRArena &arena, unsigned fields) {
+	arena_cir_t cir;
+	cir.ref_delay = get_raw_cir(link_index, cir_num, raw_buffer, fields);
+	cir.nof_components = raw_buffer.size();
+	cir.components = arena.allocate<impulse_t>(raw_buffer.size());
+
+	convert_components(raw_buffer.data(), raw_buffer.size(), cir.components);
+
+	return cir;
+}
+
+double ReadContinuousDelayFile::read_cir(size_t link_index,
+		cir_number_t cir_num, ComponentsSoA &components, unsigned fields) {
+	check_cir(link_index, cir_num, "ReadContinuousDelayFile::read_cir");
+	check_component_fields(fields, "ReadContinuousDelayFile::read_cir");
+
+	H5::DataSpace space;
+	H5::DataSet dataset = open_cir_dataset(link_index, cir_num, space);
+
+	components.resize(space.getSelectNpoints());
+
+	if (components.size() > 0) {
+		set_conversion_buffer(field_xfer, components.size());
+
+		const hsize_t count = components.size();
+		H5::DataSpace memspace(1, &count);
+		for (size_t field = 0; field < nof_component_fields; field++)
+			if (fields & (1 << field))
+				dataset.read(components.get_field_data(field),
+						cp_fields[field], memspace, space, field_xfer);
 	}
 
-	if (cir_num > nof_cirs - 1) {
-		throw logic_error(
-				"ReadContinuousDelayCDXFile::get_cir: parameter cir_num is greater than number of cirs in file.");
+	return get_reference_delay(link_index, cir_num);
+}
+
+void ReadContinuousDelayFile::get_cirs(size_t link_index,
+		cir_number_t first_cir, size_t count, CIRArena &arena,
+		std::vector<arena_cir_t> &cirs, unsigned fields) {
+	check_cirs(link_index, first_cir, count,
+			"ReadContinuousDelayFile::get_cirs");
+
+	cirs.resize(count);
+
+	// the buffer holds the largest CIR, so it is allocated once:
+	raw_buffer.reserve(get_link_layout(link_index).max_nof_components);
+
+	for (size_t k = 0; k < count; k++) {
+		read_components(link_index, first_cir + k, raw_buffer, fields);
+
+		cirs[k].nof_components = raw_buffer.size();
+		cirs[k].components = arena.allocate<impulse_t>(raw_buffer.size());
+		convert_components(raw_buffer.data(), raw_buffer.size(),
+				cirs[k].components);
 	}
 
-	H5::DataSet dataset = H5::DataSet(
-			cir_groups[link]->openDataSet("/links/" + link + "/cirs/" + boost::lexical_cast<string>(cir_num)));
+	// the reference delays are read at once into memory of the arena:
+	double *reference_delays = arena.allocate<double>(count);
+	get_reference_delays(link_index, first_cir, count, reference_delays);
+	for (size_t k = 0; k < count; k++)
+		cirs[k].ref_delay = reference_delays[k];
+}
+
+void ReadContinuousDelayFile::read_cirs(size_t link_index,
+		cir_number_t first_cir, size_t count, cir_block_t &block,
+		unsigned fields) {
+	check_cirs(link_index, first_cir, count,
+			"ReadContinuousDelayFile::read_cirs");
+	check_component_fields(fields, "ReadContinuousDelayFile::read_cirs");
+
+	block.first_cir = first_cir;
+	block.offsets.resize(count + 1);
+	block.ref_delays.resize(count);
 
-	H5::DataSpace dataspace = H5::DataSpace(dataset.getSpace());
+	// the buffer is sized for CIRs of the largest size, so it is usually allocated once,
+	// but not beyond a budget, as a single long CIR would inflate the bound of a block.
+	// Beyond the budget, it grows with the components actually read:
+	const size_t max_nof_components = min<uint64_t>(
+			count * get_link_layout(link_index).max_nof_components,
+			raw_buffer_budget);
+	if (raw_buffer.size() < max_nof_components)
+		raw_buffer.resize(max_nof_components);
 
-	int echoes_amount = dataspace.getSimpleExtentNpoints();
+	// read the components of the CIRs stored as datasets of their own one after another:
+	const cir_number_t end_cir = first_cir + count;
+	const cir_number_t end_stored_cir = max(first_cir,
+			min(end_cir, get_nof_stored_cirs(link_index)));
 
-	hdf5_impulse_t echoes[echoes_amount];
-	dataset.read(echoes, *cp_echo);
+	size_t nof_components = 0;
+	for (cir_number_t n = first_cir; n < end_stored_cir; n++) {
+		block.offsets[n - first_cir] = nof_components;
 
-	result_cir.components.resize(echoes_amount);
+		H5::DataSpace space;
+		H5::DataSet dataset = open_cir_dataset(link_index, n, space);
+		const size_t nof_cir_components = space.getSelectNpoints();
 
-	for (int i = 0; i < echoes_amount; i++) {
-		result_cir.components.at(i).type = echoes[i].type;
-		result_cir.components.at(i).id = echoes[i].id;
-		result_cir.components.at(i).delay = echoes[i].delay;
-		result_cir.components.at(i).amplitude = complex<double>(echoes[i].real,
-				echoes[i].imag);
+		if (raw_buffer.size() < nof_components + nof_cir_components)
+			raw_buffer.resize(
+					max(nof_components + nof_cir_components,
+							2 * raw_buffer.size()));
+
+		if (nof_cir_components > 0)
+			read_fields(dataset, space, raw_buffer.data() + nof_components,
+					nof_cir_components, fields);
+
+		nof_components += nof_cir_components;
 	}
 
-	result_cir.ref_delay = get_reference_delay(link, cir_num);
+	// the components of CIRs appended in SWMR mode are adjacent, they are read at once:
+	if (end_stored_cir < end_cir) {
+		const appended_cirs_t &appended = get_appended_cirs(link_index);
 
-	return result_cir;
+		const size_t first = end_stored_cir - appended.first_cir;
+		const hsize_t begin = first > 0 ? appended.ends[first - 1] : 0;
+		for (cir_number_t n = end_stored_cir; n < end_cir; n++) {
+			const size_t i = n - appended.first_cir;
+			block.offsets[n - first_cir] = nof_components
+					+ (i > 0 ? appended.ends[i - 1] : 0) - begin;
+		}
+
+		const hsize_t nof_appended_components = appended.ends[end_cir
+				- appended.first_cir - 1] - begin;
+
+		if (raw_buffer.size() < nof_components + nof_appended_components)
+			raw_buffer.resize(
+					max<size_t>(nof_components + nof_appended_components,
+							2 * raw_buffer.size()));
+
+		if (nof_appended_components > 0) {
+			H5::DataSpace space = appended.components.getSpace();
+			space.selectHyperslab(H5S_SELECT_SET, &nof_appended_components,
+					&begin);
+			read_fields(appended.components, space,
+					raw_buffer.data() + nof_components,
+					nof_appended_components, fields);
+		}
+
+		nof_components += nof_appended_components;
+	}
+	block.offsets[count] = nof_components;
+
+	// split the requested fields into the arrays:
+	block.types.resize(fields & fields_type ? nof_components : 0);
+	block.ids.resize(fields & fields_id ? nof_components : 0);
+	block.delays.resize(fields & fields_delay ? nof_components : 0);
+	block.reals.resize(fields & fields_real ? nof_components : 0);
+	block.imags.resize(fields & fields_imag ? nof_components : 0);
+
+	for (size_t i = 0; i < block.types.size(); i++)
+		block.types[i] = raw_buffer[i].type;
+	for (size_t i = 0; i < block.ids.size(); i++)
+		block.ids[i] = raw_buffer[i].id;
+	for (size_t i = 0; i < block.delays.size(); i++)
+		block.delays[i] = raw_buffer[i].delay;
+	for (size_t i = 0; i < block.reals.size(); i++)
+		block.reals[i] = raw_buffer[i].real;
+	for (size_t i = 0; i < block.imags.size(); i++)
+		block.imags[i] = raw_buffer[i].imag;
+
+	// memory of an exceptionally large block is not kept:
+	if (raw_buffer.size() > raw_buffer_budget) {
+		raw_buffer.resize(raw_buffer_budget);
+		raw_buffer.shrink_to_fit();
+	}
+
+	get_reference_delays(link_index, first_cir, count,
+			block.ref_delays.data());
+}
+
+cir_block_t ReadContinuousDelayFile::read_cirs(size_t link_index,
+		cir_number_t first_cir, size_t count) {
+	cir_block_t block;
+	read_cirs(link_index, first_cir, count, block);
+	return block;
+}
+
+cir_block_t ReadContinuousDelayFile::read_cirs(std::string link,
+		cir_number_t first_cir, size_t count) {
+	return read_cirs(get_link_index(link), first_cir, count);
+}
+
+component_types_t ReadContinuousDelayFile::get_component_types(
+		size_t link_index) {
+	check_link_index(link_index,
+			"ReadContinuousDelayFile::get_component_types");
+
+	// same compound type as written by WriteFile:
+	struct component_type_t {
+		uint16_t id;
+		char *name;
+	};
+
+	H5::StrType str_type(H5::PredType::C_S1, H5T_VARIABLE);
+	H5::CompType comp_t(sizeof(component_type_t));
+	comp_t.insertMember("id", HOFFSET(component_type_t, id),
+			H5::PredType::NATIVE_UINT16);
+	comp_t.insertMember("name", HOFFSET(component_type_t, name), str_type);
+
+	H5::DataSet dataset = get_link_group(link_index).openDataSet(
+			"component_types");
+	H5::DataSpace dataspace = dataset.getSpace();
+
+	vector<component_type_t> data(dataspace.getSimpleExtentNpoints());
+
+	component_types_t component_types;
+	if (data.empty())
+		return component_types;
+
+	dataset.read(data.data(), comp_t);
+
+	for (const auto &component_type : data)
+		component_types[component_type.id] = component_type.name;
+
+	// free the strings allocated by HDF5:
+	H5::DataSet::vlenReclaim(data.data(), comp_t, dataspace);
+
+	return component_types;
+}
+
+void ReadContinuousDelayFile::convert_components(
+		const std::vector<hdf5_impulse_t> &raw_components,
+		components_t &components) {
+	components.resize(raw_components.size());
+
+	convert_components(raw_components.data(), raw_components.size(),
+			components.data());
+}
+
+void ReadContinuousDelayFile::convert_components(
+		const hdf5_impulse_t *raw_components, size_t count,
+		impulse_t *components) {
+	for (size_t i = 0; i < count; i++) {
+		components[i].type = raw_components[i].type;
+		components[i].id = raw_components[i].id;
+		components[i].delay = raw_components[i].delay;
+		components[i].amplitude = complex<double>(raw_components[i].real,
+				raw_components[i].imag);
+	}
+}
+
+DataView<hdf5_impulse_t> ReadContinuousDelayFile::get_cir_view(
+		std::string link, cir_number_t cir_num) {
+	return get_cir_view(get_link_index(link), cir_num);
+}
+
+DataView<hdf5_impulse_t> ReadContinuousDelayFile::get_cir_view(
+		size_t link_index, cir_number_t cir_num) {
+	check_cir(link_index, cir_num, "ReadContinuousDelayFile::get_cir_view");
+
+	// CIRs appended in SWMR mode share a chunked dataset, which cannot be mapped:
+	if (cir_num >= get_nof_stored_cirs(link_index)) {
+		vector<hdf5_impulse_t> components;
+		read_components(link_index, cir_num, components);
+		return DataView<hdf5_impulse_t>(std::move(components));
+	}
+
+	H5::DataSpace space;
+	if (not mmap_enabled)
+		return read_view<hdf5_impulse_t>(
+				open_cir_dataset(link_index, cir_num, space), *cp_echo);
+
+	vector<cir_location_t> &locations = cir_locations[link_index];
+	if (locations.size() != nof_cirs) {
+		const cir_location_t unknown = { HADDR_UNDEF, 0 };
+		locations.assign(nof_cirs, unknown);
+	}
+
+	cir_location_t &location = locations[cir_num];
+
+	if (location.offset == HADDR_UNDEF) {
+		H5::DataSet dataset = open_cir_dataset(link_index, cir_num, space);
+
+		const size_t nof_components = dataset.getSpace().getSimpleExtentNpoints();
+		const haddr_t offset = get_mapped_offset(dataset, *cp_echo,
+				nof_components * sizeof(hdf5_impulse_t));
+
+		if (offset == HADDR_UNDEF or nof_components == 0
+				or get_mapped_region(offset,
+						nof_components * sizeof(hdf5_impulse_t)) == nullptr)
+			return read_view<hdf5_impulse_t>(dataset, *cp_echo);
+
+		location.offset = offset;
+		location.nof_components = nof_components;
+	}
+
+	return DataView<hdf5_impulse_t>(
+			static_cast<const hdf5_impulse_t *>(get_mapped_region(
+					location.offset,
+					location.nof_components * sizeof(hdf5_impulse_t))),
+			location.nof_components);
+}
+
+query_result_t ReadContinuousDelayFile::query(std::string link,
+		const query_t &query) {
+	return this->query(get_link_index(link), query);
+}
+
+query_result_t ReadContinuousDelayFile::query(size_t link_index,
+		const query_t &query) {
+	check_link_index(link_index, "ReadContinuousDelayFile::query");
+
+	query_result_t result;
+
+	// CIR numbers inside the time window:
+	const double first = max(0.0, ceil(query.start_time_s * cir_rate_Hz));
+	const double last = min(static_cast<double>(nof_cirs) - 1.0,
+			floor(query.end_time_s * cir_rate_Hz));
+
+	if (nof_cirs == 0 or first > last or query.min_delay_s > query.max_delay_s)
+		return result;
+
+	const cir_number_t first_cir = static_cast<cir_number_t>(first);
+	const cir_number_t last_cir = static_cast<cir_number_t>(last);
+
+	const delay_bounds_t &bounds = get_delay_bounds(link_index);
+	const size_t nof_blocks = bounds.bounds.size() / 2;
+
+	vector<hdf5_impulse_t> echoes;
+
+	cir_number_t cir_num = first_cir;
+	while (cir_num <= last_cir) {
+		// last CIR in the time window which belongs to the same block as cir_num:
+		cir_number_t block_end = last_cir;
+
+		if (bounds.cirs_per_block > 0) {
+			const size_t block = cir_num / bounds.cirs_per_block;
+			block_end = min(last_cir,
+					static_cast<cir_number_t>((block + 1) * bounds.cirs_per_block
+							- 1));
+
+			if (block < nof_blocks
+					and (bounds.bounds[2 * block + 1] < query.min_delay_s
+							or bounds.bounds[2 * block] > query.max_delay_s)) {
+				// no component in this block lies inside the delay window:
+				result.nof_cirs_skipped += block_end - cir_num + 1;
+				cir_num = block_end + 1;
+				continue;
+			}
+		}
+
+		for (; cir_num <= block_end; cir_num++) {
+			read_components(link_index, cir_num, echoes);
+			result.nof_cirs_read++;
+
+			for (const auto &echo : echoes) {
+				if (echo.delay < query.min_delay_s
+						or echo.delay > query.max_delay_s)
+					continue;
+
+				if (query.types.size() > 0
+						and find(query.types.begin(), query.types.end(),
+								echo.type) == query.types.end())
+					continue;
+
+				result.cir_numbers.push_back(cir_num);
+				result.types.push_back(echo.type);
+				result.ids.push_back(echo.id);
+				result.delays.push_back(echo.delay);
+				result.reals.push_back(echo.real);
+				result.imags.push_back(echo.imag);
+			}
+		}
+	}
+
+	return result;
+}
+
+track_t ReadContinuousDelayFile::get_track(std::string link, uint64_t id) {
+	return get_track(get_link_index(link), id);
+}
+
+track_t ReadContinuousDelayFile::get_track(size_t link_index, uint64_t id) {
+	check_link_index(link_index, "ReadContinuousDelayFile::get_track");
+
+	track_t track;
+
+	const track_index_t &index = get_track_index(link_index);
+
+	if (not index.available) {
+		// no index, scan all CIRs:
+		vector<hdf5_impulse_t> echoes;
+		for (cir_number_t cir_num = 0; cir_num < nof_cirs; cir_num++) {
+			read_components(link_index, cir_num, echoes);
+			for (const auto &echo : echoes) {
+				if (echo.id != id)
+					continue;
+				track.cir_numbers.push_back(cir_num);
+				track.types.push_back(echo.type);
+				track.delays.push_back(echo.delay);
+				track.reals.push_back(echo.real);
+				track.imags.push_back(echo.imag);
+			}
+		}
+		return track;
+	}
+
+	const auto it = lower_bound(index.ids.begin(), index.ids.end(), id);
+	if (it == index.ids.end() or *it != id)
+		return track;
+
+	const size_t k = it - index.ids.begin();
+	const hsize_t first_entry = index.offsets.at(k);
+	const hsize_t nof_entries = index.offsets.at(k + 1) - first_entry;
+
+	// read positions of the component:
+	const int RANK = 1;
+	hsize_t offset[RANK] = { first_entry };
+	hsize_t count[RANK] = { nof_entries };
+	H5::DataSpace memspace(RANK, count);
+
+	H5::Group index_group = get_link_group(link_index).openGroup("track_index");
+
+	track.cir_numbers.resize(nof_entries);
+	H5::DataSet cir_numbers_dataset = index_group.openDataSet("cir_numbers");
+	H5::DataSpace cir_numbers_space = cir_numbers_dataset.getSpace();
+	cir_numbers_space.selectHyperslab(H5S_SELECT_SET, count, offset);
+	cir_numbers_dataset.read(track.cir_numbers.data(),
+			H5::PredType::NATIVE_UINT64, memspace, cir_numbers_space);
+
+	vector<uint32_t> components(nof_entries);
+	H5::DataSet components_dataset = index_group.openDataSet("components");
+	H5::DataSpace components_space = components_dataset.getSpace();
+	components_space.selectHyperslab(H5S_SELECT_SET, count, offset);
+	components_dataset.read(components.data(), H5::PredType::NATIVE_UINT32,
+			memspace, components_space);
+
+	track.types.resize(nof_entries);
+	track.delays.resize(nof_entries);
+	track.reals.resize(nof_entries);
+	track.imags.resize(nof_entries);
+
+	// read the single component from each CIR:
+	hsize_t one[RANK] = { 1 };
+	H5::DataSpace element_memspace(RANK, one);
+
+	for (size_t n = 0; n < nof_entries; n++) {
+		H5::DataSpace dataspace;
+		H5::DataSet dataset = open_cir_dataset(link_index,
+				track.cir_numbers[n], dataspace);
+
+		// the components of the CIR start at the first selected one:
+		hsize_t start[RANK], end[RANK];
+		dataspace.getSelectBounds(start, end);
+		const hsize_t coord[RANK] = { start[0] + components[n] };
+		dataspace.selectElements(H5S_SELECT_SET, 1, coord);
+
+		hdf5_impulse_t echo;
+		dataset.read(&echo, *cp_echo, element_memspace, dataspace);
+
+		track.types[n] = echo.type;
+		track.delays[n] = echo.delay;
+		track.reals[n] = echo.real;
+		track.imags[n] = echo.imag;
+	}
+
+	return track;
+}
+
+void ReadContinuousDelayFile::read_components(size_t link_index,
+		cir_number_t cir_num, std::vector<hdf5_impulse_t> &components,
+		unsigned fields) {
+	check_component_fields(fields, "ReadContinuousDelayFile::read_components");
+
+	H5::DataSpace space;
+	H5::DataSet dataset = open_cir_dataset(link_index, cir_num, space);
+
+	components.resize(space.getSelectNpoints());
+
+	// the fields that are not read are set to zero:
+	if (fields != all_component_fields)
+		fill(components.begin(), components.end(), hdf5_impulse_t());
+
+	if (components.size() > 0)
+		read_fields(dataset, space, components.data(), components.size(),
+				fields);
+}
+
+void ReadContinuousDelayFile::read_fields(const H5::DataSet &dataset,
+		const H5::DataSpace &space, hdf5_impulse_t *components,
+		size_t nof_components, unsigned fields) {
+	const hsize_t count = nof_components;
+	H5::DataSpace memspace(1, &count);
+
+	if (fields == all_component_fields) {
+		dataset.read(components, *cp_echo, memspace, space);
+		return;
+	}
+
+	set_conversion_buffer(field_xfer, nof_components);
+
+	dataset.read(components, get_fields_type(fields), memspace, space,
+			field_xfer);
+}
+
+const H5::CompType &ReadContinuousDelayFile::get_fields_type(
+		unsigned fields) {
+	check_component_fields(fields, "ReadContinuousDelayFile::get_fields_type");
+
+	if (cp_subsets[fields] == NULL) {
+		const size_t offsets[nof_component_fields] = { HOFFSET(hdf5_impulse_t,
+				type), HOFFSET(hdf5_impulse_t, id), HOFFSET(hdf5_impulse_t,
+				delay), HOFFSET(hdf5_impulse_t, real), HOFFSET(hdf5_impulse_t,
+				imag) };
+
+		H5::CompType *type = new H5::CompType(sizeof(hdf5_impulse_t));
+		for (size_t field = 0; field < nof_component_fields; field++)
+			if (fields & (1 << field))
+				type->insertMember(get_component_field_name(field),
+						offsets[field],
+						cp_fields[field].getMemberDataType(0));
+		cp_subsets[fields] = type;
+	}
+
+	return *cp_subsets[fields];
+}
+
+H5::DataSet ReadContinuousDelayFile::open_cir_dataset(size_t link_index,
+		cir_number_t cir_num, H5::DataSpace &space) {
+	H5::Group &cir_group = get_cir_group(link_index);
+
+	const appended_cirs_t &appended = get_appended_cirs(link_index);
+	if (appended.available and cir_num >= appended.first_cir) {
+		const size_t i = cir_num - appended.first_cir;
+		const hsize_t begin = i > 0 ? appended.ends[i - 1] : 0;
+		const hsize_t count = appended.ends[i] - begin;
+
+		space = appended.components.getSpace();
+		if (count > 0)
+			space.selectHyperslab(H5S_SELECT_SET, &count, &begin);
+		else
+			space.selectNone();
+		return appended.components;
+	}
+
+	snprintf(name_buffer, sizeof(name_buffer), "%llu",
+			static_cast<unsigned long long>(cir_num));
+
+	H5::DataSet dataset = cir_group.openDataSet(name_buffer);
+	space = dataset.getSpace();
+	return dataset;
+}
+
+H5::Group &ReadContinuousDelayFile::get_cir_group(size_t link_index) {
+	if (cir_groups[link_index] != nullptr)
+		return *cir_groups[link_index];
+
+	if (lazy_open) {
+		const cir_number_t nof_link_cirs = get_nof_complete_cirs(link_index);
+
+		// a writer in SWMR mode that crashed may have flushed some links only, see
+		// read_nof_cirs:
+		if (get_appended_cirs(link_index).available ?
+				nof_link_cirs < nof_cirs : nof_link_cirs != nof_cirs) {
+			stringstream err_msg;
+			err_msg << "ReadContinuousDelayFile: number of reference delays of link "
+					<< link_names[link_index] << " (" << nof_link_cirs
+					<< ") differs from number of cirs (" << nof_cirs << ")!";
+			throw logic_error(err_msg.str());
+		}
+	}
+
+	cir_groups[link_index] = new H5::Group(
+			get_link_group(link_index).openGroup("cirs"));
+	return *cir_groups[link_index];
+}
+
+void ReadContinuousDelayFile::read_nof_cirs() {
+	// CIRs appended in SWMR mode are counted by their ends and reference delays. A writer
+	// that crashed may have flushed some links only, so the CIRs of all links are
+	// complete up to the smallest count:
+	if (nof_links > 0 and get_appended_cirs(0).available) {
+		nof_cirs = get_nof_complete_cirs(0);
+		for (size_t k = 1; k < nof_links; k++)
+			nof_cirs = min<cir_number_t>(nof_cirs, get_nof_complete_cirs(k));
+		return;
+	}
+
+	// the layout is stale if CIRs have been written after it, e.g. while the file is open
+	// for writing, one reference delay is written per CIR:
+	bool layouts_available = true;
+	for (size_t k = 0; k < nof_links and layouts_available; k++) {
+		hsize_t nof_reference_delays = 0;
+		get_reference_delays_dataset(k).getSpace().getSimpleExtentDims(
+				&nof_reference_delays);
+		layouts_available = get_link_layout(k).available
+				and get_link_layout(k).nof_cirs == nof_reference_delays;
+	}
+
+	// files of older versions and stale layouts are counted:
+	if (not layouts_available) {
+		nof_cirs = cir_groups.at(0)->getNumObjs();
+		verify_nof_cirs();
+		return;
+	}
+
+	nof_cirs = get_link_layout(0).nof_cirs;
+
+	for (size_t k = 0; k < nof_links; k++) {
+		const uint64_t nof_cirs_in_link = get_link_layout(k).nof_cirs;
+
+		if (nof_cirs != nof_cirs_in_link) {
+			stringstream err_msg;
+			err_msg << "ReadContinuousDelayFile: number of cirs of link "
+					<< link_names[k] << " (" << nof_cirs_in_link
+					<< ") differs from number of cirs of link " << link_names[0]
+					<< " (" << nof_cirs << ")!";
+			throw logic_error(err_msg.str());
+		}
+	}
+}
+
+void ReadContinuousDelayFile::verify_nof_cirs() {
+	for (size_t k = 0; k < nof_links; k++) {
+		const size_t nof_cirs_in_link = get_cir_group(k).getNumObjs();
+		const cir_number_t nof_stored_cirs = get_nof_stored_cirs(k);
+
+		if (nof_stored_cirs != nof_cirs_in_link) {
+			stringstream err_msg;
+			err_msg << "snReadCIRFile: number of cirs for link 0 ("
+					<< nof_stored_cirs
+					<< ") differs from number of cirs for link("
+					<< nof_cirs_in_link << ")!";
+			throw logic_error(err_msg.str());
+		}
+	}
+}
+
+cir_number_t ReadContinuousDelayFile::get_nof_stored_cirs(size_t link_index) {
+	check_link_index(link_index,
+			"ReadContinuousDelayFile::get_nof_stored_cirs");
+
+	const appended_cirs_t &appended = get_appended_cirs(link_index);
+	return appended.available ?
+			min<cir_number_t>(appended.first_cir, nof_cirs) : nof_cirs;
+}
+
+ReadContinuousDelayFile::appended_cirs_t &ReadContinuousDelayFile::get_appended_cirs(
+		size_t link_index) {
+	appended_cirs_t &appended = appended_cirs[link_index];
+	if (appended.read)
+		return appended;
+
+	appended.read = true;
+
+	H5::Group &link_group = get_link_group(link_index);
+	if (H5Lexists(link_group.getId(), "appended_cir_ends", H5P_DEFAULT) <= 0)
+		return appended;
+
+	appended.components = link_group.openDataSet("appended_cirs");
+	appended.ends_dataset = link_group.openDataSet("appended_cir_ends");
+
+	uint64_t first_cir;
+	appended.ends_dataset.openAttribute("first_cir").read(
+			H5::PredType::NATIVE_UINT64, &first_cir);
+	appended.first_cir = first_cir;
+
+	read_appended_ends(appended, false);
+	appended.available = true;
+
+	return appended;
+}
+
+void ReadContinuousDelayFile::read_appended_ends(appended_cirs_t &appended,
+		bool refresh) {
+	if (refresh)
+		refresh_dataset(appended.ends_dataset);
+
+	hsize_t nof_ends;
+	appended.ends_dataset.getSpace().getSimpleExtentDims(&nof_ends);
+
+	// the datasets only grow, so the ends read before stay valid:
+	const size_t nof_read_ends = appended.ends.size();
+	if (nof_ends <= nof_read_ends)
+		return;
+
+	appended.ends.resize(nof_ends);
+	H5::DataSpace fspace = appended.ends_dataset.getSpace();
+	const hsize_t count = nof_ends - nof_read_ends;
+	const hsize_t offset = nof_read_ends;
+	fspace.selectHyperslab(H5S_SELECT_SET, &count, &offset);
+	appended.ends_dataset.read(appended.ends.data() + nof_read_ends,
+			H5::PredType::NATIVE_UINT64, H5::DataSpace(1, &count), fspace);
+
+	// the components are appended before the ends:
+	if (appended.ends.back() > appended.nof_components) {
+		if (refresh)
+			refresh_dataset(appended.components);
+		appended.components.getSpace().getSimpleExtentDims(
+				&appended.nof_components);
+	}
+
+	while (appended.ends.size() > nof_read_ends
+			and appended.ends.back() > appended.nof_components)
+		appended.ends.pop_back();
+}
+
+void ReadContinuousDelayFile::refresh_appended_cirs() {
+	for (size_t k = 0; k < nof_links; k++) {
+		refresh_dataset(get_reference_delays_dataset(k));
+
+		appended_cirs_t &appended = get_appended_cirs(k);
+		if (appended.available)
+			read_appended_ends(appended, true);
+
+		// the writer extends the delay bounds and rewrites the row of the last block on each
+		// flush, so they are read again, as are the other data derived from the CIRs:
+		H5::Group &link_group = get_link_group(k);
+		if (H5Lexists(link_group.getId(), "delay_bounds", H5P_DEFAULT) > 0) {
+			H5::DataSet dataset = link_group.openDataSet("delay_bounds");
+			refresh_dataset(dataset);
+		}
+		delay_bounds[k] = delay_bounds_t();
+		track_indices[k] = track_index_t();
+
+		if (not link_layouts.empty()) {
+			delete link_layouts[k];
+			link_layouts[k] = nullptr;
+		}
+	}
+
+	// files that are not written in SWMR mode do not grow:
+	if (nof_links > 0 and get_appended_cirs(0).available)
+		read_nof_cirs();
+}
+
+cir_number_t ReadContinuousDelayFile::get_nof_complete_cirs(
+		size_t link_index) {
+	hsize_t nof_reference_delays = 0;
+	get_reference_delays_dataset(link_index).getSpace().getSimpleExtentDims(
+			&nof_reference_delays);
+
+	const appended_cirs_t &appended = get_appended_cirs(link_index);
+	if (not appended.available)
+		return nof_reference_delays;
+
+	return min<cir_number_t>(nof_reference_delays,
+			appended.first_cir + appended.ends.size());
+}
+
+void ReadContinuousDelayFile::check_cir(size_t link_index,
+		cir_number_t cir_num, const char *function) const {
+	check_link_index(link_index, function);
+
+	if (cir_num >= nof_cirs) {
+		stringstream ss;
+		ss << function
+				<< ": parameter cir_num is greater than number of cirs in file.";
+		throw logic_error(ss.str());
+	}
+}
+
+void ReadContinuousDelayFile::check_cirs(size_t link_index,
+		cir_number_t first_cir, size_t count, const char *function) const {
+	check_link_index(link_index, function);
+
+	if (first_cir > nof_cirs or count > nof_cirs - first_cir) {
+		stringstream ss;
+		ss << function << ": CIRs " << first_cir << " to "
+				<< first_cir + count << " (excluding) are not inside the file.";
+		throw logic_error(ss.str());
+	}
+}
+
+bool ReadContinuousDelayFile::get_delay_bounds(size_t link_index,
+		cir_number_t first_cir, size_t count, double &min_delay,
+		double &max_delay) {
+	check_cirs(link_index, first_cir, count,
+			"ReadContinuousDelayFile::get_delay_bounds");
+
+	const delay_bounds_t &bounds = get_delay_bounds(link_index);
+	if (bounds.cirs_per_block == 0)
+		return false;
+
+	min_delay = numeric_limits<double>::infinity();
+	max_delay = -numeric_limits<double>::infinity();
+
+	if (count == 0)
+		return true;
+
+	const size_t first_block = first_cir / bounds.cirs_per_block;
+	const size_t last_block = (first_cir + count - 1) / bounds.cirs_per_block;
+
+	// files whose writer was not closed properly lack the rows of the last blocks:
+	if (last_block >= bounds.bounds.size() / 2)
+		return false;
+
+	for (size_t block = first_block; block <= last_block; block++) {
+		min_delay = min(min_delay, bounds.bounds[2 * block]);
+		max_delay = max(max_delay, bounds.bounds[2 * block + 1]);
+	}
+
+	return true;
+}
+
+const ReadContinuousDelayFile::delay_bounds_t &ReadContinuousDelayFile::get_delay_bounds(
+		size_t link_index) {
+	delay_bounds_t &link_bounds = delay_bounds[link_index];
+	if (link_bounds.read)
+		return link_bounds;
+
+	link_bounds.read = true;
+	link_bounds.cirs_per_block = 0;
+
+	H5::Group *link_group = &get_link_group(link_index);
+
+	// files written by older versions of the library do not have delay bounds:
+	if (H5Lexists(link_group->getId(), "delay_bounds", H5P_DEFAULT) <= 0)
+		return link_bounds;
+
+	H5::DataSet dataset = link_group->openDataSet("delay_bounds");
+
+	uint64_t cirs_per_block = 0;
+	dataset.openAttribute("cirs_per_block").read(H5::PredType::NATIVE_UINT64,
+			&cirs_per_block);
+
+	hsize_t dims[2] = { 0, 0 };
+	dataset.getSpace().getSimpleExtentDims(dims);
+
+	if (cirs_per_block == 0 or dims[1] != 2)
+		return link_bounds;
+
+	link_bounds.bounds.resize(dims[0] * 2);
+	if (dims[0] > 0)
+		dataset.read(link_bounds.bounds.data(), H5::PredType::NATIVE_DOUBLE);
+
+	link_bounds.cirs_per_block = cirs_per_block;
+
+	return link_bounds;
 }
 
 ReadContinuousDelayFile::~ReadContinuousDelayFile() {
-	for (auto link_name : link_names)
-		delete cir_groups[link_name];
+	for (auto cir_group : cir_groups)
+		delete cir_group;
 
 	delete cp_echo;
+
+	for (auto cp_subset : cp_subsets)
+		delete cp_subset;
+}
+
+const ReadContinuousDelayFile::track_index_t &ReadContinuousDelayFile::get_track_index(
+		size_t link_index) {
+	track_index_t &index = track_indices[link_index];
+	if (index.read)
+		return index;
+
+	index.read = true;
+	index.available = false;
+
+	H5::Group *link_group = &get_link_group(link_index);
+
+	if (H5Lexists(link_group->getId(), "track_index", H5P_DEFAULT) <= 0)
+		return index;
+
+	H5::Group index_group = link_group->openGroup("track_index");
+
+	H5::DataSet ids_dataset = index_group.openDataSet("ids");
+	index.ids.resize(ids_dataset.getSpace().getSimpleExtentNpoints());
+	if (index.ids.size() > 0)
+		ids_dataset.read(index.ids.data(), H5::PredType::NATIVE_UINT64);
+
+	H5::DataSet offsets_dataset = index_group.openDataSet("offsets");
+	index.offsets.resize(offsets_dataset.getSpace().getSimpleExtentNpoints());
+	offsets_dataset.read(index.offsets.data(), H5::PredType::NATIVE_UINT64);
+
+	if (index.offsets.size() != index.ids.size() + 1) {
+		throw runtime_error(
+				"ReadContinuousDelayFile::get_track_index: track index of link "
+						+ link_names[link_index] + " is inconsistent.");
+	}
+
+	index.available = true;
+
+	return index;
 }
 
 } // end of namespace CDX
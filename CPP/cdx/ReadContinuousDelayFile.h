@@ -7,12 +7,115 @@
 #ifndef SNREADCIRFILE_H_
 #define SNREADCIRFILE_H_
 
+#include <limits>
+
 #include <boost/shared_ptr.hpp>
 
 #include "ReadFile.h"
+#include "CIRArena.h"
+#include "ComponentsSoA.h"
 
 namespace CDX {
 
+/**
+ * \brief Selection criteria for ReadContinuousDelayFile::query.
+ *
+ * CIR number \c n is taken to be recorded at time <tt>n / cir_rate_Hz</tt>. All
+ * windows include their limits. By default, every component of every CIR is selected.
+ */
+struct query_t {
+	query_t() :
+			start_time_s(0.0), end_time_s(
+					std::numeric_limits<double>::infinity()), min_delay_s(
+					-std::numeric_limits<double>::infinity()), max_delay_s(
+					std::numeric_limits<double>::infinity()) {
+	}
+
+	double start_time_s; ///< time of the first CIR to consider in s
+	double end_time_s; ///< time of the last CIR to consider in s
+	double min_delay_s; ///< smallest component delay to select in s
+	double max_delay_s; ///< largest component delay to select in s
+	std::vector<uint16_t> types; ///< component types to select, all types if empty
+};
+
+/**
+ * \brief Components selected by ReadContinuousDelayFile::query, stored as structure of arrays.
+ *
+ * Entry \c i of each vector belongs to the same component.
+ */
+struct query_result_t {
+	query_result_t() :
+			nof_cirs_read(0), nof_cirs_skipped(0) {
+	}
+
+	/** returns the number of selected components */
+	size_t size() const {
+		return delays.size();
+	}
+
+	std::vector<cir_number_t> cir_numbers; ///< number of the CIR the component belongs to
+	std::vector<uint16_t> types; ///< the component's type
+	std::vector<uint64_t> ids; ///< the component's identifier
+	std::vector<double> delays; ///< the component's delay in s
+	std::vector<double> reals; ///< real part of the component's amplitude
+	std::vector<double> imags; ///< imaginary part of the component's amplitude
+
+	size_t nof_cirs_read; ///< number of CIRs inside the time window that were read from the file
+	size_t nof_cirs_skipped; ///< number of CIRs inside the time window skipped due to their block's delay bounds
+};
+
+/**
+ * \brief Trajectory of a single component, returned by ReadContinuousDelayFile::get_track.
+ *
+ * Entry \c i of each vector describes the component in CIR <tt>cir_numbers[i]</tt>.
+ */
+struct track_t {
+	/** returns the number of CIRs the component appears in */
+	size_t size() const {
+		return cir_numbers.size();
+	}
+
+	std::vector<cir_number_t> cir_numbers; ///< numbers of the CIRs containing the component, ascending
+	std::vector<uint16_t> types; ///< the component's type
+	std::vector<double> delays; ///< the component's delay in s
+	std::vector<double> reals; ///< real part of the component's amplitude
+	std::vector<double> imags; ///< imaginary part of the component's amplitude
+};
+
+/**
+ * \brief Consecutive CIRs of a link in compressed sparse row layout, returned by ReadContinuousDelayFile::read_cirs.
+ *
+ * The components of all CIRs are stored one CIR after another as structure of arrays.
+ * The components of CIR <tt>first_cir + k</tt> are the entries
+ * <tt>offsets[k]</tt> to <tt>offsets[k + 1] - 1</tt> of each component vector.
+ * The vectors of fields that were not requested from read_cirs are empty.
+ */
+struct cir_block_t {
+	cir_block_t() :
+			first_cir(0) {
+	}
+
+	/** returns the number of CIRs */
+	size_t nof_cirs() const {
+		return ref_delays.size();
+	}
+
+	/** returns the total number of components */
+	size_t size() const {
+		return offsets.empty() ? 0 : offsets.back();
+	}
+
+	cir_number_t first_cir; ///< number of the first CIR
+	std::vector<uint64_t> offsets; ///< index of the first component of each CIR, followed by the total number of components
+	std::vector<double> ref_delays; ///< the reference delay of each CIR in s
+
+	std::vector<uint16_t> types; ///< the component's type
+	std::vector<uint64_t> ids; ///< the component's identifier
+	std::vector<double> delays; ///< the component's delay in s
+	std::vector<double> reals; ///< real part of the component's amplitude
+	std::vector<double> imags; ///< imaginary part of the component's amplitude
+};
+
 /**
  * \brief	Reads CIRs from CDX file.
  *
@@ -22,17 +125,291 @@ class ReadContinuousDelayFile: public ReadFile {
 public:
 	typedef boost::shared_ptr<ReadContinuousDelayFile> ptr;
 
-	ReadContinuousDelayFile(std::string _filename);
+	/**
+	 * \brief Opens a continuous-delay CDX file.
+	 *
+	 * The groups of the links and their CIRs are opened here. The number of CIRs of each
+	 * link is read from its layout attributes, see link_layout_t. In files of older
+	 * versions without them, the CIRs of all links are counted, see verify_nof_cirs,
+	 * which takes long for files with millions of CIRs. With \c _lazy_open, the number
+	 * of CIRs is taken from the reference delays of link 0, and the groups of a link are
+	 * opened on first use, when the number of reference delays of the link is checked
+	 * instead.
+	 *
+	 * CIRs that a writer appended in SWMR mode are read from the datasets they were
+	 * appended to until the file is compacted, see compact_continuous_delay_file. They are
+	 * counted by their ends and reference delays, so the CIRs a writer that crashed had
+	 * flushed completely can be read. If the links of such a file differ, the smallest
+	 * number of CIRs of a link is taken.
+	 *
+	 * \param[in] _filename File name
+	 * \param[in] _access_plist File access properties the file is opened with, e.g. to
+	 * limit the size of the HDF5 metadata cache, see get_reader_access_plist
+	 * \param[in] _lazy_open Open the groups of each link on first use
+	 * \param[in] _flags H5F_ACC_RDONLY, or with H5F_ACC_SWMR_READ for files that are written
+	 * in SWMR mode, see FollowContinuousDelayFile, or were left behind by a writer that
+	 * crashed in SWMR mode, which HDF5 refuses to open otherwise
+	 */
+	ReadContinuousDelayFile(std::string _filename,
+			const H5::FileAccPropList &_access_plist =
+					H5::FileAccPropList::DEFAULT, bool _lazy_open = false,
+			unsigned int _flags = H5F_ACC_RDONLY);
 	virtual ~ReadContinuousDelayFile();
 
+	/**
+	 * \brief Checks that all links have get_nof_stored_cirs CIR datasets.
+	 *
+	 * Counts the datasets of each link, which takes long for files with millions of CIRs.
+	 * Files without layout attributes are checked by the constructor unless they are
+	 * opened lazily.
+	 *
+	 * \throw std::logic_error if the number of CIRs of a link differs
+	 */
+	void verify_nof_cirs();
+
+	/** returns true if the groups of the links are opened on first use */
+	bool get_lazy_open() const {
+		return lazy_open;
+	}
+
+	/**
+	 * \brief Returns the number of CIRs of a link that are stored as datasets of their own.
+	 *
+	 * The CIRs from this number on were appended by a writer in SWMR mode and are read
+	 * from the dataset \c appended_cirs of the link, see WriteContinuousDelayFile::prepare_swmr_write.
+	 * Equals get_nof_cirs for files that have been compacted or never been written in
+	 * SWMR mode.
+	 *
+	 * \param[in] link_index Link index, see get_link_index
+	 */
+	cir_number_t get_nof_stored_cirs(size_t link_index);
+
 	/**
 	 * \brief	returns CIR with a given number
 	 *
 	 * \param	<cir_num> CIR number
+	 * \param	<fields> Mask of the fields to read, see component_fields_t. The other fields
+	 * 			are zero.
 	 *
 	 * \return	CIR
 	 */
-	cir_t get_cir(std::string link, unsigned int cir_num);
+	cir_t get_cir(std::string link, unsigned int cir_num, unsigned fields =
+			all_component_fields);
+
+	/**
+	 * \brief Returns the CIR with a given number of the link with a given index.
+	 *
+	 * \param[in] link_index Link index, see get_link_index
+	 * \param[in] cir_num CIR number
+	 * \param[in] fields Mask of the fields to read, see get_cir
+	 * \return CIR
+	 */
+	cir_t get_cir(size_t link_index, cir_number_t cir_num, unsigned fields =
+			all_component_fields);
+
+	/**
+	 * \brief Returns a CIR whose components are stored in an arena.
+	 *
+	 * The components are read into a buffer of the reader and converted into memory of
+	 * the arena, so no memory is allocated once the buffer and the arena are large enough.
+	 *
+	 * \param[in] link_index Link index, see get_link_index
+	 * \param[in] cir_num CIR number
+	 * \param[in] arena Arena for the components
+	 * \param[in] fields Mask of the fields to read, see get_cir
+	 * \return CIR, valid until the arena is released
+	 */
+	arena_cir_t get_cir(size_t link_index, cir_number_t cir_num,
+			CIRArena &arena, unsigned fields = all_component_fields);
+
+	/**
+	 * \brief Reads a CIR into a structure of arrays.
+	 *
+	 * Each member of the stored compound type is read with a read of its own directly
+	 * into its array, so no buffer of the reader is involved.
+	 *
+	 * \param[in] link_index Link index, see get_link_index
+	 * \param[in] cir_num CIR number
+	 * \param[out] components Is resized and filled, pass the same object again to reuse its memory
+	 * \param[in] fields Mask of the fields to read, see component_fields_t. The arrays of
+	 * the other fields are resized but not filled.
+	 * \return Reference delay of the CIR in s
+	 */
+	double read_cir(size_t link_index, cir_number_t cir_num,
+			ComponentsSoA &components, unsigned fields = all_component_fields);
+
+	/**
+	 * \brief Returns consecutive CIRs whose components are stored in an arena.
+	 *
+	 * The reference delays of all CIRs are read at once.
+	 *
+	 * \param[in] link_index Link index, see get_link_index
+	 * \param[in] first_cir Number of the first CIR
+	 * \param[in] count Number of CIRs
+	 * \param[in] arena Arena for the components
+	 * \param[out] cirs Is resized to \c count and filled, valid until the arena is released
+	 * \param[in] fields Mask of the fields to read, see get_cir
+	 */
+	void get_cirs(size_t link_index, cir_number_t first_cir, size_t count,
+			CIRArena &arena, std::vector<arena_cir_t> &cirs, unsigned fields =
+					all_component_fields);
+
+	/**
+	 * \brief Reads consecutive CIRs of a link into a block of arrays.
+	 *
+	 * Each CIR is stored in a dataset of its own, so the components are read with one
+	 * read per CIR, directly one after another into a buffer of the reader, and then split
+	 * into the arrays of the block. The components of CIRs appended in SWMR mode are
+	 * adjacent, they are read with a single read. The reference delays are read with a
+	 * single read as well.
+	 *
+	 * \param[in] link_index Link index, see get_link_index
+	 * \param[in] first_cir Number of the first CIR
+	 * \param[in] count Number of CIRs
+	 * \param[out] block Is resized and filled, pass the same block again to reuse its memory
+	 * \param[in] fields Mask of the fields to read, see component_fields_t. The vectors of
+	 * the other fields are cleared.
+	 */
+	void read_cirs(size_t link_index, cir_number_t first_cir, size_t count,
+			cir_block_t &block, unsigned fields = all_component_fields);
+
+	/**
+	 * \brief Returns consecutive CIRs of a link as block of arrays, see read_cirs.
+	 */
+	cir_block_t read_cirs(size_t link_index, cir_number_t first_cir,
+			size_t count);
+
+	/**
+	 * \brief Returns consecutive CIRs of a link as block of arrays, see read_cirs.
+	 */
+	cir_block_t read_cirs(std::string link, cir_number_t first_cir,
+			size_t count);
+
+	/**
+	 * \brief Returns the component types of the link with a given index.
+	 *
+	 * \param[in] link_index Link index, see get_link_index
+	 * \return Names of the component types, by type
+	 */
+	component_types_t get_component_types(size_t link_index);
+
+	/**
+	 * \brief Reads the components of a CIR as stored in the file and its reference delay.
+	 *
+	 * Unlike get_cir, the components are not converted to impulse_t, which can be done
+	 * later by convert_components, e.g. outside of a lock.
+	 *
+	 * \param[in] link Link name
+	 * \param[in] cir_num CIR number
+	 * \param[out] components Is resized to the number of components and filled
+	 * \param[in] fields Mask of the fields to read, see component_fields_t. The other
+	 * fields are zero.
+	 * \return Reference delay of the CIR in s
+	 */
+	double get_raw_cir(const std::string &link, cir_number_t cir_num,
+			std::vector<hdf5_impulse_t> &components, unsigned fields =
+					all_component_fields);
+
+	/**
+	 * \brief Reads the components of a CIR of the link with a given index, see get_raw_cir.
+	 */
+	double get_raw_cir(size_t link_index, cir_number_t cir_num,
+			std::vector<hdf5_impulse_t> &components, unsigned fields =
+					all_component_fields);
+
+	/**
+	 * \brief Converts components as stored in the file to impulse_t.
+	 *
+	 * \param[in] raw_components Components as read by get_raw_cir
+	 * \param[out] components Is resized to the number of components and filled
+	 */
+	static void convert_components(
+			const std::vector<hdf5_impulse_t> &raw_components,
+			components_t &components);
+
+	/**
+	 * \brief Converts \c count components as stored in the file to impulse_t.
+	 */
+	static void convert_components(const hdf5_impulse_t *raw_components,
+			size_t count, impulse_t *components);
+
+	/**
+	 * \brief Returns the components of a CIR as stored in the file, without copying if possible.
+	 *
+	 * Contiguous CIR datasets with the native layout of hdf5_impulse_t are accessed through
+	 * a read-only memory mapping of the file. All other datasets, or all datasets if
+	 * memory mapping is disabled by set_mmap_enabled, are read with H5Dread into a buffer
+	 * owned by the view. The file location of each mapped CIR is remembered, so repeated
+	 * views of the same CIR do not access the HDF5 library at all. The reference delay is
+	 * not part of the view.
+	 *
+	 * \param[in] link Link name
+	 * \param[in] cir_num CIR number
+	 * \return View of the components, valid as long as the reader exists
+	 */
+	DataView<hdf5_impulse_t> get_cir_view(std::string link,
+			cir_number_t cir_num);
+
+	/**
+	 * \brief Returns the components of a CIR of the link with a given index, see get_cir_view.
+	 */
+	DataView<hdf5_impulse_t> get_cir_view(size_t link_index,
+			cir_number_t cir_num);
+
+	/**
+	 * \brief Returns all components of a link that match a time window, a delay window and a set of types.
+	 *
+	 * Files written with a \c delay_bounds dataset per link store the minimum and maximum
+	 * delay of each block of CIRs. Blocks whose delays lie completely outside the delay
+	 * window are skipped without reading their CIRs. Files without this dataset are scanned
+	 * completely within the time window.
+	 *
+	 * \param[in] link Link name
+	 * \param[in] query Selection criteria
+	 * \return The selected components in the order of their CIR numbers
+	 */
+	query_result_t query(std::string link, const query_t &query);
+
+	/**
+	 * \brief Selects components of the link with a given index, see query.
+	 */
+	query_result_t query(size_t link_index, const query_t &query);
+
+	/**
+	 * \brief Returns bounds of the delays of consecutive CIRs from the delay bounds of their blocks.
+	 *
+	 * The bounds are the minimum and maximum delay of all blocks that contain one of the
+	 * CIRs, so they enclose the delays of the CIRs but are wider if the CIRs do not cover
+	 * whole blocks. No CIR is read. If all blocks are empty, the minimum is infinity and
+	 * the maximum is -infinity.
+	 *
+	 * \param[in] link_index Link index, see get_link_index
+	 * \param[in] first_cir Number of the first CIR
+	 * \param[in] count Number of CIRs
+	 * \param[out] min_delay Lower bound of the delays in s
+	 * \param[out] max_delay Upper bound of the delays in s
+	 * \return false if the link has no delay bounds, see query
+	 */
+	bool get_delay_bounds(size_t link_index, cir_number_t first_cir,
+			size_t count, double &min_delay, double &max_delay);
+
+	/**
+	 * \brief Returns the trajectory of the component with a given identifier.
+	 *
+	 * If the link has a track index (see WriteContinuousDelayFile and build_track_index),
+	 * only the positions of the component are read, so the effort grows with the length of
+	 * the track. Without an index, all CIRs of the link are scanned.
+	 *
+	 * \param[in] link Link name
+	 * \param[in] id Component identifier
+	 * \return The component in all CIRs it appears in
+	 */
+	track_t get_track(std::string link, uint64_t id);
+
+	/**
+	 * \brief Returns the trajectory of a component of the link with a given index, see get_track.
+	 */
+	track_t get_track(size_t link_index, uint64_t id);
 
 	/**
 	 * \brief	Return the number of CIRs in file
@@ -43,11 +420,184 @@ public:
 	}
 
 protected:
+	/**
+	 * \brief Reads the raw components of a CIR as stored in the file.
+	 *
+	 * \param[in] link_index Link index
+	 * \param[in] cir_num CIR number
+	 * \param[out] components Is resized to the number of components and filled
+	 * \param[in] fields Mask of the fields to read, the other fields are set to zero
+	 */
+	void read_components(size_t link_index, cir_number_t cir_num,
+			std::vector<hdf5_impulse_t> &components, unsigned fields =
+					all_component_fields);
+
+	/**
+	 * \brief Reads some fields of the selected components of a dataset into an array of hdf5_impulse_t.
+	 *
+	 * The other fields of the array are left unchanged.
+	 *
+	 * \param[in] dataset Dataset of the components, see open_cir_dataset
+	 * \param[in] space Dataspace of the dataset with \c nof_components components selected
+	 */
+	void read_fields(const H5::DataSet &dataset, const H5::DataSpace &space,
+			hdf5_impulse_t *components, size_t nof_components, unsigned fields);
+
+	/**
+	 * \brief Returns a compound type of the size of hdf5_impulse_t with only some of its members.
+	 */
+	const H5::CompType &get_fields_type(unsigned fields);
+
+	/**
+	 * \brief Opens the dataset that holds the components of a CIR and selects them.
+	 *
+	 * CIRs appended in SWMR mode are a range of the dataset \c appended_cirs of the link,
+	 * all others a dataset of their own, which is selected completely.
+	 *
+	 * \param[in] link_index Link index
+	 * \param[in] cir_num CIR number
+	 * \param[out] space Is set to the dataspace of the dataset with the components of the CIR selected
+	 * \return The dataset
+	 */
+	H5::DataSet open_cir_dataset(size_t link_index, cir_number_t cir_num,
+			H5::DataSpace &space);
+
+	/**
+	 * \brief Throws a std::logic_error if a link index or CIR number is out of range.
+	 */
+	void check_cir(size_t link_index, cir_number_t cir_num,
+			const char *function) const;
+
+	/**
+	 * \brief Throws a std::logic_error if a link index is out of range or a range of CIRs is not inside the file.
+	 */
+	void check_cirs(size_t link_index, cir_number_t first_cir, size_t count,
+			const char *function) const;
+
+	/**
+	 * \brief Delay bounds of the blocks of CIRs of a link, read from its \c delay_bounds dataset.
+	 */
+	struct delay_bounds_t {
+		delay_bounds_t() :
+				read(false), cirs_per_block(0) {
+		}
+
+		bool read; ///< true if the delay bounds have been read from the file
+		size_t cirs_per_block; ///< number of CIRs per block, zero if the file has no delay bounds
+		std::vector<double> bounds; ///< minimum and maximum delay of each block, interleaved
+	};
+
+	/** reads the delay bounds of a link on first use */
+	const delay_bounds_t &get_delay_bounds(size_t link_index);
+
+	/**
+	 * \brief Identifiers and offsets of the track index of a link.
+	 */
+	struct track_index_t {
+		track_index_t() :
+				read(false), available(false) {
+		}
+
+		bool read; ///< true if the track index has been looked up in the file
+		bool available; ///< false if the link has no track index
+		std::vector<uint64_t> ids; ///< sorted component identifiers
+		std::vector<uint64_t> offsets; ///< first entry of each identifier, followed by the number of entries
+	};
+
+	/** reads the identifiers and offsets of the track index of a link on first use */
+	const track_index_t &get_track_index(size_t link_index);
+
+	/**
+	 * \brief Sets nof_cirs from the layout attributes of the links, or counts the CIRs of files without them.
+	 *
+	 * The CIRs are counted as well if the layout of a link does not match its number of
+	 * reference delays, e.g. while the file is still being written. Files with CIRs
+	 * appended in SWMR mode take the smallest get_nof_complete_cirs of all links.
+	 *
+	 * \throw std::logic_error if the number of CIRs of a link differs
+	 */
+	void read_nof_cirs();
+
+	/**
+	 * \brief The CIRs of a link that a writer appended in SWMR mode.
+	 *
+	 * See WriteContinuousDelayFile::prepare_swmr_write for the datasets.
+	 */
+	struct appended_cirs_t {
+		appended_cirs_t() :
+				read(false), available(false), first_cir(0), nof_components(0) {
+		}
+
+		bool read; ///< true if the datasets have been looked up in the file
+		bool available; ///< false if the link has no appended CIRs
+		cir_number_t first_cir; ///< number of the first appended CIR, the CIRs before are stored as datasets of their own
+		H5::DataSet components; ///< the components of all appended CIRs
+		H5::DataSet ends_dataset; ///< the end of each appended CIR in components
+		hsize_t nof_components; ///< number of components of the dataset when its extent was last read
+		std::vector<uint64_t> ends; ///< ends of the appended CIRs whose components are complete
+	};
+
+	/** looks up the appended CIRs of a link and reads their ends on first use */
+	appended_cirs_t &get_appended_cirs(size_t link_index);
+
+	/**
+	 * \brief Reads the ends of the CIRs appended since the ends were last read.
+	 *
+	 * Ends beyond the components of the dataset, which a writer that crashed while flushing
+	 * leaves behind, are dropped.
+	 *
+	 * \param[in] appended The appended CIRs of a link
+	 * \param[in] refresh Refresh the datasets first, which a writer in SWMR mode appends to
+	 */
+	void read_appended_ends(appended_cirs_t &appended, bool refresh);
+
+	/**
+	 * \brief Refreshes the datasets a writer in SWMR mode appends to and updates nof_cirs.
+	 *
+	 * The file must have been opened with H5F_ACC_SWMR_READ. The number of CIRs of files
+	 * without appended CIRs does not change. The cached delay bounds, track indices and
+	 * layouts are dropped, so they are read again on their next use.
+	 */
+	void refresh_appended_cirs();
+
+	/**
+	 * \brief Returns the number of reference delays of a link, bounded by its appended CIRs whose components are complete.
+	 *
+	 * A writer in SWMR mode appends the reference delays after it has flushed the CIRs, so
+	 * the bound only matters for files of a writer that crashed while flushing.
+	 */
+	cir_number_t get_nof_complete_cirs(size_t link_index);
+
+	/**
+	 * \brief Returns the cirs group of a link, opening it on first use.
+	 *
+	 * With lazy opening, the number of reference delays of the link is checked first.
+	 */
+	H5::Group &get_cir_group(size_t link_index);
+
+	/**
+	 * \brief Location of a CIR's components in the mapped file.
+	 */
+	struct cir_location_t {
+		haddr_t offset; ///< file offset of the components, HADDR_UNDEF if not known or not mappable
+		size_t nof_components; ///< number of components
+	};
+
 	unsigned int nof_cirs;
-	std::map<std::string, H5::Group *> cir_groups;
+	bool lazy_open; ///< true if the groups of the links are opened on first use
+	std::vector<H5::Group *> cir_groups; ///< the cirs group of each link, indexed by link index, nullptr until opened by get_cir_group
+	std::vector<std::vector<cir_location_t> > cir_locations; ///< locations of mapped CIRs for each link
+	std::vector<delay_bounds_t> delay_bounds; ///< cached delay bounds for each link
+	std::vector<track_index_t> track_indices; ///< cached track index for each link
+	std::vector<appended_cirs_t> appended_cirs; ///< the CIRs appended in SWMR mode of each link, indexed by link index
 
 	// for function get_cir:
 	H5::CompType *cp_echo;
+	std::vector<H5::CompType> cp_fields; ///< compound types with a single member, indexed by component_field_t
+	std::vector<H5::CompType *> cp_subsets; ///< compound types with some members of hdf5_impulse_t, indexed by mask, created on first use
+	H5::DSetMemXferPropList field_xfer; ///< transfer properties of the reads of some members
+	std::vector<hdf5_impulse_t> raw_buffer; ///< components of the CIRs being read by get_cir with arena, get_cirs and read_cirs, shrunk after blocks larger than a budget
+	char name_buffer[24]; ///< the name of the dataset of the CIR being opened
 };
 
 } // end of namespace CDX
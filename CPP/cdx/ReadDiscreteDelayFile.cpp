@@ -7,13 +7,25 @@
 
 #include "ReadDiscreteDelayFile.h"
 
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+
 using namespace std;
 
 namespace CDX {
 
-ReadDiscreteDelayFile::ReadDiscreteDelayFile(string _file_name) :
-		ReadFile(_file_name) {
-	// Try block to detect exceptions raised by any of the calls inside it
+ReadDiscreteDelayFile::ReadDiscreteDelayFile(string _file_name,
+		const H5::FileAccPropList &_access_plist) :
+		ReadFile(_file_name, _access_plist) {
+
+	// delay-type has to be discrete-delay:
+	if (delay_type != "discrete-delay") {
+		stringstream err_msg;
+		err_msg << "delay_type (" << delay_type
+				<< ") must be 'discrete-delay'!";
+		throw logic_error(err_msg.str());
+	}
 
 	// read simulation parameters
 	H5::DataSet(h5file.openDataSet("/parameters/delay_smpl_freq_Hz")).read(
@@ -23,88 +35,179 @@ ReadDiscreteDelayFile::ReadDiscreteDelayFile(string _file_name) :
 
 vector<vector<complex<double> > > ReadDiscreteDelayFile::get_cirs(
 		std::string link) {
+	return get_cirs(get_link_index(link));
+}
+
+vector<vector<complex<double> > > ReadDiscreteDelayFile::get_cirs(
+		size_t link_index) {
+	hsize_t dims[2];
+	get_dimensions(link_index, dims);
 
-	if (cir_groups.count(link) < 1) {
-		throw "ReadDiscreteDelayCDXFile::get_cir: did not find link in file.";
+	const size_t nof_delay_smpls = dims[0];
+	const size_t nof_columns = dims[1];
+	const size_t nof_cirs = min<size_t>(nof_columns, get_nof_cirs(link_index));
+
+	const DataView<double> cirs_real = get_cirs_real_view(link_index);
+	const DataView<double> cirs_imag = get_cirs_imag_view(link_index);
+
+	vector<vector<complex<double> > > cirs(nof_cirs);
+	for (size_t k = 0; k < cirs.size(); k++) {
+		cirs.at(k).resize(nof_delay_smpls);
+		for (size_t n = 0; n < cirs.at(k).size(); n++) {
+			cirs.at(k).at(n) = complex<double>(cirs_real[n * nof_columns + k],
+					cirs_imag[n * nof_columns + k]);
+		}
 	}
 
-	vector<vector<complex<double> > > cirs;
+	return cirs;
+}
+
+vector<vector<complex<double> > > ReadDiscreteDelayFile::get_cirs(
+		size_t link_index, size_t first_cir, size_t nof_cirs,
+		size_t first_delay_sample, size_t nof_delay_samples) {
+	hsize_t dims[2];
+	get_dimensions(link_index, dims);
+
+	const size_t nof_cirs_in_link = get_nof_cirs(link_index);
+	if (first_cir > nof_cirs_in_link or nof_cirs > nof_cirs_in_link - first_cir
+			or first_delay_sample > dims[0]
+			or nof_delay_samples > dims[0] - first_delay_sample) {
+		stringstream err_msg;
+		err_msg << "ReadDiscreteDelayFile::get_cirs: window exceeds the "
+				<< nof_cirs_in_link << " CIRs of " << dims[0]
+				<< " delay samples of link " << link_names[link_index];
+		throw logic_error(err_msg.str());
+	}
 
-	// read data
-	H5::DataSet dataset_real = H5::DataSet(
-			link_groups[link]->openDataSet("cirs_real"));
-	H5::DataSet dataset_imag = H5::DataSet(
-			link_groups[link]->openDataSet("cirs_imag"));
+	vector<vector<complex<double> > > cirs(nof_cirs,
+			vector<complex<double> >(nof_delay_samples));
+	if (nof_cirs == 0 or nof_delay_samples == 0)
+		return cirs;
+
+	const int RANK = 2;
+	const hsize_t offset[RANK] = { first_delay_sample, first_cir };
+	const hsize_t count[RANK] = { nof_delay_samples, nof_cirs };
+	H5::DataSpace memspace(RANK, count);
+
+	vector<double> real(nof_delay_samples * nof_cirs);
+	vector<double> imag(nof_delay_samples * nof_cirs);
+	for (bool imag_part : { false, true }) {
+		H5::DataSet &dataset = get_cirs_dataset(link_index, imag_part);
+		H5::DataSpace dataspace = dataset.getSpace();
+		dataspace.selectHyperslab(H5S_SELECT_SET, count, offset);
+		dataset.read(imag_part ? imag.data() : real.data(),
+				H5::PredType::NATIVE_DOUBLE, memspace, dataspace);
+	}
 
-	H5::DataSpace dataspace_real = H5::DataSpace(dataset_real.getSpace());
-	H5::DataSpace dataspace_imag = H5::DataSpace(dataset_imag.getSpace());
+	for (size_t n = 0; n < nof_delay_samples; n++)
+		for (size_t k = 0; k < nof_cirs; k++)
+			cirs[k][n] = complex<double>(real[n * nof_cirs + k],
+					imag[n * nof_cirs + k]);
 
-	int rank_real = dataspace_real.getSimpleExtentNdims();
-//		int rank_imag = dataspace_imag.getSimpleExtentNdims();
+	return cirs;
+}
 
-	/*
-	 * Get the dimension size of each dimension in the dataspace_real and
-	 * display them.
-	 */
-	hsize_t dims_out_real[rank_real];
-//		int ndims_real =
-	dataspace_real.getSimpleExtentDims(dims_out_real, NULL);
+DataView<double> ReadDiscreteDelayFile::get_cirs_real_view(std::string link) {
+	return get_cirs_real_view(get_link_index(link));
+}
 
-	hsize_t dims_out_imag[rank_real];
-//		int ndims_imag =
-	dataspace_imag.getSimpleExtentDims(dims_out_imag, NULL);
+DataView<double> ReadDiscreteDelayFile::get_cirs_imag_view(std::string link) {
+	return get_cirs_imag_view(get_link_index(link));
+}
 
-	if (sdebug)
-		cout << "rank " << rank_real << ", dimensions "
-				<< (unsigned long) (dims_out_real[0]) << " x "
-				<< (unsigned long) (dims_out_real[1]) << endl;
+DataView<double> ReadDiscreteDelayFile::get_cirs_real_view(size_t link_index) {
+	hsize_t dims[2];
+	get_dimensions(link_index, dims);
 
-	if (dims_out_real[0] != dims_out_imag[0]) {
-		throw("dimension 0 of cirs_real does not match dimension 0 of cirs_imag");
-	}
-	if (dims_out_real[1] != dims_out_imag[1]) {
-		throw("dimension 1 of cirs_real does not match dimension 1 of cirs_imag");
+	return read_view<double>(get_cirs_dataset(link_index, false),
+			H5::PredType::NATIVE_DOUBLE);
+}
+
+DataView<double> ReadDiscreteDelayFile::get_cirs_imag_view(size_t link_index) {
+	hsize_t dims[2];
+	get_dimensions(link_index, dims);
+
+	return read_view<double>(get_cirs_dataset(link_index, true),
+			H5::PredType::NATIVE_DOUBLE);
+}
+
+size_t ReadDiscreteDelayFile::get_nof_delay_samples(std::string link) {
+	return get_nof_delay_samples(get_link_index(link));
+}
+
+size_t ReadDiscreteDelayFile::get_nof_delay_samples(size_t link_index) {
+	const link_layout_t &layout = get_link_layout(link_index);
+	if (layout.available and layout.max_nof_components > 0)
+		return layout.max_nof_components;
+
+	hsize_t dims[2];
+	get_dimensions(link_index, dims);
+	return dims[0];
+}
+
+size_t ReadDiscreteDelayFile::get_nof_cirs(std::string link) {
+	return get_nof_cirs(get_link_index(link));
+}
+
+size_t ReadDiscreteDelayFile::get_nof_cirs(size_t link_index) {
+	// the datasets of a link without CIRs have one column:
+	const link_layout_t &layout = get_link_layout(link_index);
+	if (layout.available)
+		return layout.nof_cirs;
+
+	hsize_t dims[2];
+	get_dimensions(link_index, dims);
+	return dims[1];
+}
+
+void ReadDiscreteDelayFile::get_dimensions(size_t link_index,
+		hsize_t dims[2]) {
+	check_link_index(link_index, "ReadDiscreteDelayFile");
+
+	H5::DataSpace dataspace_real = get_cirs_dataset(link_index, false).getSpace();
+	H5::DataSpace dataspace_imag = get_cirs_dataset(link_index, true).getSpace();
+
+	if (dataspace_real.getSimpleExtentNdims() != 2
+			or dataspace_imag.getSimpleExtentNdims() != 2) {
+		throw runtime_error(
+				"ReadDiscreteDelayFile: cirs_real and cirs_imag must have rank 2");
 	}
 
-	const unsigned int nof_delay_smpls = dims_out_real[0];
-	const unsigned int nof_cirs = dims_out_real[1];
+	hsize_t dims_imag[2];
+	dataspace_real.getSimpleExtentDims(dims);
+	dataspace_imag.getSimpleExtentDims(dims_imag);
 
-	if (sdebug) {
-		cout << "nof_delay_smpls: " << nof_delay_smpls << endl;
-		cout << "nof_cirs: " << nof_cirs << endl;
-		cout << "reading real data..." << endl;
+	if (dims[0] != dims_imag[0]) {
+		throw runtime_error(
+				"dimension 0 of cirs_real does not match dimension 0 of cirs_imag");
 	}
-	double cirs_real[nof_delay_smpls][nof_cirs];
-	/*
-	 // Define the memory dataspace.
-	 hsize_t dimsm[2];  memory space dimensions
-	 dimsm[0] = nof_delay_smpls;
-	 dimsm[1] = nof_cirs;
-	 DataSpace memspace(2, dimsm);
-	 dataset_real.read(cirs_real, H5::PredType::NATIVE_DOUBLE, memspace, dataspace_real);
-	 */
-	dataset_real.read(cirs_real, H5::PredType::NATIVE_DOUBLE);
-
-	if (sdebug)
-		cout << "reading imag data..." << endl;
-	double cirs_imag[nof_delay_smpls][nof_cirs];
-	dataset_imag.read(cirs_imag, H5::PredType::NATIVE_DOUBLE);
-
-	cirs.resize(nof_cirs);
-	for (size_t k = 0; k < cirs.size(); k++) {
-		cirs.at(k).resize(nof_delay_smpls);
-		for (size_t n = 0; n < cirs.at(k).size(); n++) {
-			cirs.at(k).at(n) = complex<double>(cirs_real[n][k],
-					cirs_imag[n][k]);
-		}
+	if (dims[1] != dims_imag[1]) {
+		throw runtime_error(
+				"dimension 1 of cirs_real does not match dimension 1 of cirs_imag");
 	}
+}
 
-//		result_cir.ref_delay = ref_delays.at(link).at(cir_num);
+H5::DataSet &ReadDiscreteDelayFile::get_cirs_dataset(size_t link_index,
+		bool imag) {
+	vector<H5::DataSet *> &datasets =
+			imag ? cirs_imag_datasets : cirs_real_datasets;
+	if (datasets.empty())
+		datasets.resize(nof_links, nullptr);
 
-	return cirs;
+	if (datasets[link_index] == nullptr)
+		datasets[link_index] = new H5::DataSet(
+				get_link_group(link_index).openDataSet(
+						imag ? "cirs_imag" : "cirs_real"));
+
+	return *datasets[link_index];
 }
 
 ReadDiscreteDelayFile::~ReadDiscreteDelayFile() {
+	for (auto dataset : cirs_real_datasets)
+		delete dataset;
+
+	for (auto dataset : cirs_imag_datasets)
+		delete dataset;
 }
 
 } // end of namespace CDX
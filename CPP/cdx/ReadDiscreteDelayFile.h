@@ -20,7 +20,16 @@ namespace CDX {
  */
 class ReadDiscreteDelayFile: public ReadFile {
 public:
-	ReadDiscreteDelayFile(std::string filename);
+	/**
+	 * \brief Opens a discrete-delay CDX file.
+	 *
+	 * \param[in] filename File name
+	 * \param[in] _access_plist File access properties the file is opened with, e.g. a
+	 * larger chunk cache from get_reader_access_plist
+	 */
+	ReadDiscreteDelayFile(std::string filename,
+			const H5::FileAccPropList &_access_plist =
+					H5::FileAccPropList::DEFAULT);
 	virtual ~ReadDiscreteDelayFile();
 
 	/**
@@ -29,6 +38,70 @@ public:
 	 */
 	std::vector<std::vector<std::complex<double> > > get_cirs(std::string link);
 
+	/**
+	 * \brief Returns all CIRs of the link with a given index, see get_link_index.
+	 */
+	std::vector<std::vector<std::complex<double> > > get_cirs(
+			size_t link_index);
+
+	/**
+	 * \brief Returns a window of delay samples of consecutive CIRs of a link.
+	 *
+	 * Only the selected part of the datasets is read. The datasets stay open, so their
+	 * chunk cache is kept between calls, see get_reader_access_plist.
+	 *
+	 * \param[in] link_index Link index
+	 * \param[in] first_cir Number of the first CIR
+	 * \param[in] nof_cirs Number of CIRs
+	 * \param[in] first_delay_sample First delay sample of each CIR
+	 * \param[in] nof_delay_samples Number of delay samples of each CIR
+	 * \return \c nof_cirs CIRs of \c nof_delay_samples samples each
+	 * \throw std::logic_error if the window exceeds the CIRs or delay samples of the link
+	 */
+	std::vector<std::vector<std::complex<double> > > get_cirs(size_t link_index,
+			size_t first_cir, size_t nof_cirs, size_t first_delay_sample,
+			size_t nof_delay_samples);
+
+	/**
+	 * \brief Returns the real parts of all CIRs of a link, without copying if possible.
+	 *
+	 * The data is ordered as stored in the file: delay sample \c n of CIR \c k is element
+	 * <tt>n * stride + k</tt>, where the stride is
+	 * <tt>view.size() / get_nof_delay_samples(link)</tt>. It equals get_nof_cirs(link) in
+	 * files that have been closed by the writer, the datasets of files still being
+	 * written may hold CIRs that get_nof_cirs does not count yet. Contiguous datasets are
+	 * accessed through a read-only memory mapping of the file, all others are read with
+	 * H5Dread. The datasets written by WriteDiscreteDelayFile are chunked and are always
+	 * read.
+	 *
+	 * \param[in] link Link name
+	 * \return View of the real parts, valid as long as the reader exists
+	 */
+	DataView<double> get_cirs_real_view(std::string link);
+
+	/**
+	 * \brief Returns the imaginary parts of all CIRs of a link, ordered like get_cirs_real_view.
+	 */
+	DataView<double> get_cirs_imag_view(std::string link);
+
+	/** returns the real parts of all CIRs of the link with a given index, see get_cirs_real_view */
+	DataView<double> get_cirs_real_view(size_t link_index);
+
+	/** returns the imaginary parts of all CIRs of the link with a given index, see get_cirs_imag_view */
+	DataView<double> get_cirs_imag_view(size_t link_index);
+
+	/** returns the number of delay samples of a link */
+	size_t get_nof_delay_samples(std::string link);
+
+	/** returns the number of delay samples of the link with a given index */
+	size_t get_nof_delay_samples(size_t link_index);
+
+	/** returns the number of CIRs of a link, read from its layout attributes if it has them */
+	size_t get_nof_cirs(std::string link);
+
+	/** returns the number of CIRs of the link with a given index */
+	size_t get_nof_cirs(size_t link_index);
+
 	//	cir_struct get_cir(unsigned int link, unsigned int cir_num);
 
 	/** returns sampling rate in delay direction */
@@ -37,9 +110,20 @@ public:
 	}
 
 protected:
-	unsigned int nof_cirs;
+	/**
+	 * \brief Returns the dimensions (delay samples, CIRs) of the dataset cirs_real of a link.
+	 */
+	void get_dimensions(size_t link_index, hsize_t dims[2]);
+
+	/**
+	 * \brief Returns the dataset cirs_real or cirs_imag of a link, opened on first use.
+	 */
+	H5::DataSet &get_cirs_dataset(size_t link_index, bool imag);
 
 	double delay_smpl_freq;
+
+	std::vector<H5::DataSet *> cirs_real_datasets; ///< the open dataset cirs_real of each link, indexed by link index
+	std::vector<H5::DataSet *> cirs_imag_datasets; ///< the open dataset cirs_imag of each link, indexed by link index
 };
 
 } // end of namespace CDX
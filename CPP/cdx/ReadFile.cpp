@@ -4,23 +4,109 @@
  */
 
 #include "ReadFile.h"
+
+#include <algorithm>
 #include <iostream>
+#include <stdexcept>
 
 namespace CDX {
 
 using namespace std;
 
-ReadFile::ReadFile(string _file_name) :
-		File(_file_name) {
+H5::FileAccPropList get_reader_access_plist(const reader_options_t &options) {
+	H5::FileAccPropList access_plist;
+
+	if (options.chunk_cache_size > 0 or options.chunk_cache_slots > 0
+			or options.chunk_cache_w0 >= 0.0) {
+		int mdc_nelmts;
+		size_t rdcc_nslots, rdcc_nbytes;
+		double rdcc_w0;
+		H5Pget_cache(access_plist.getId(), &mdc_nelmts, &rdcc_nslots,
+				&rdcc_nbytes, &rdcc_w0);
+
+		if (options.chunk_cache_size > 0)
+			rdcc_nbytes = options.chunk_cache_size;
+		if (options.chunk_cache_slots > 0)
+			rdcc_nslots = options.chunk_cache_slots;
+		if (options.chunk_cache_w0 >= 0.0)
+			rdcc_w0 = min(options.chunk_cache_w0, 1.0);
+
+		H5Pset_cache(access_plist.getId(), mdc_nelmts, rdcc_nslots, rdcc_nbytes,
+				rdcc_w0);
+	}
+
+	if (options.metadata_cache_size > 0) {
+		H5AC_cache_config_t cache_config;
+		cache_config.version = H5AC__CURR_CACHE_CONFIG_VERSION;
+		H5Pget_mdc_config(access_plist.getId(), &cache_config);
+
+		cache_config.set_initial_size = true;
+		cache_config.initial_size = options.metadata_cache_size;
+		cache_config.max_size = options.metadata_cache_size;
+		cache_config.min_size = min(cache_config.min_size,
+				options.metadata_cache_size);
+		cache_config.incr_mode = H5C_incr__off;
+		cache_config.flash_incr_mode = H5C_flash_incr__off;
+		cache_config.decr_mode = H5C_decr__off;
+		H5Pset_mdc_config(access_plist.getId(), &cache_config);
+	}
+
+	if (options.page_buffer_size > 0)
+		H5Pset_page_buffer_size(access_plist.getId(), options.page_buffer_size,
+				0, 0);
+
+	switch (options.driver) {
+	case sec2_driver:
+		break;
+	case core_driver:
+		// the file is only read, so nothing is written back:
+		access_plist.setCore(options.core_increment, false);
+		break;
+	case direct_driver:
+#ifdef H5_HAVE_DIRECT
+		H5Pset_fapl_direct(access_plist.getId(), options.direct_alignment,
+				options.direct_block_size, options.direct_copy_buffer_size);
+		break;
+#else
+		throw logic_error(
+				"get_reader_access_plist: HDF5 was built without the direct driver");
+#endif
+	}
+
+	return access_plist;
+}
+
+H5::FileAccPropList get_limited_cache_access_plist(size_t metadata_cache_size) {
+	reader_options_t options;
+	options.metadata_cache_size = metadata_cache_size;
+	return get_reader_access_plist(options);
+}
+
+ReadFile::ReadFile(string _file_name,
+		const H5::FileAccPropList &_access_plist, bool _lazy_open,
+		unsigned int _flags) :
+		File(_file_name, _access_plist, _flags, _lazy_open), mmap_enabled(
+				true), mmap_eligible_file(
+				-1), file_number(0), mapped_file(nullptr) {
 
 }
 
 ReadFile::~ReadFile() {
+	delete mapped_file;
+
+	for (auto dataset : reference_delays_datasets)
+		delete dataset;
+
+	for (auto layout : link_layouts)
+		delete layout;
 }
 
 double ReadFile::get_reference_delay(std::string link, size_t number) {
-	H5::DataSet dataset = H5::DataSet(
-			link_groups[link]->openDataSet("reference_delays"));
+	return get_reference_delay(get_link_index(link), number);
+}
+
+double ReadFile::get_reference_delay(size_t link_index, size_t number) {
+	H5::DataSet &dataset = get_reference_delays_dataset(link_index);
 
 	H5::DataSpace dataspace = H5::DataSpace(dataset.getSpace());
 
@@ -47,25 +133,119 @@ double ReadFile::get_reference_delay(std::string link, size_t number) {
 	return ref_delay_h5[0];
 }
 
+void ReadFile::get_reference_delays(size_t link_index, size_t first,
+		size_t count, double *reference_delays) {
+	if (count == 0)
+		return;
+
+	H5::DataSet &dataset = get_reference_delays_dataset(link_index);
+
+	H5::DataSpace dataspace = dataset.getSpace();
+
+	const int RANK = 1;
+	const hsize_t offset[RANK] = { first };
+	const hsize_t dims[RANK] = { count };
+	dataspace.selectHyperslab(H5S_SELECT_SET, dims, offset);
+
+	H5::DataSpace memspace(RANK, dims);
+
+	dataset.read(reference_delays, H5::PredType::NATIVE_DOUBLE, memspace,
+			dataspace);
+}
+
+H5::DataSet &ReadFile::get_reference_delays_dataset(size_t link_index) {
+	check_link_index(link_index, "ReadFile::get_reference_delays_dataset");
+
+	if (reference_delays_datasets.empty())
+		reference_delays_datasets.resize(nof_links, nullptr);
+
+	if (reference_delays_datasets[link_index] == nullptr)
+		reference_delays_datasets[link_index] = new H5::DataSet(
+				get_link_group(link_index).openDataSet("reference_delays"));
+
+	return *reference_delays_datasets[link_index];
+}
+
+const link_layout_t &ReadFile::get_link_layout(size_t link_index) {
+	check_link_index(link_index, "ReadFile::get_link_layout");
+
+	if (link_layouts.empty())
+		link_layouts.resize(nof_links, nullptr);
+
+	if (link_layouts[link_index] == nullptr)
+		link_layouts[link_index] = new link_layout_t(
+				read_link_layout(get_link_group(link_index)));
+
+	return *link_layouts[link_index];
+}
+
 vector<double> ReadFile::get_reference_delays(std::string link) {
-	H5::DataSet dataset = H5::DataSet(
-			link_groups[link]->openDataSet("reference_delays"));
+	return get_reference_delays(get_link_index(link));
+}
+
+vector<double> ReadFile::get_reference_delays(size_t link_index) {
+	check_link_index(link_index, "ReadFile::get_reference_delays");
+
+	H5::DataSet &dataset = get_reference_delays_dataset(link_index);
 
 	H5::DataSpace dataspace = H5::DataSpace(dataset.getSpace());
 
 	size_t nof_cirs = dataspace.getSimpleExtentNpoints();
 
-	double ref_delays_h5[nof_cirs];
-	dataset.read(ref_delays_h5, H5::PredType::NATIVE_DOUBLE);
-
-	// convert to vector:
+	// read directly into the vector:
 	vector<double> ref_delays(nof_cirs);
 
-	for (size_t m = 0; m < ref_delays.size(); m++) {
-		ref_delays.at(m) = ref_delays_h5[m];
-	}
+	if (nof_cirs > 0)
+		dataset.read(ref_delays.data(), H5::PredType::NATIVE_DOUBLE);
 
 	return ref_delays;
 }
 
+haddr_t ReadFile::get_mapped_offset(const H5::DataSet &dataset,
+		const H5::DataType &mem_type, size_t nof_bytes) {
+	if (not mmap_enabled)
+		return HADDR_UNDEF;
+
+	// file offsets only correspond to HDF5 addresses for a single file without user block:
+	if (mmap_eligible_file < 0) {
+		mmap_eligible_file = h5file.getAccessPlist().getDriver() == H5FD_SEC2
+				and h5file.getCreatePlist().getUserblock() == 0;
+
+		H5O_info_t info;
+		if (H5Oget_info2(h5file.getId(), &info, H5O_INFO_BASIC) < 0)
+			mmap_eligible_file = 0;
+		file_number = info.fileno;
+	}
+
+	if (mmap_eligible_file == 0)
+		return HADDR_UNDEF;
+
+	// datasets reached through external links, like the CIRs of a master file, are stored
+	// in other files:
+	H5O_info_t info;
+	if (H5Oget_info2(dataset.getId(), &info, H5O_INFO_BASIC) < 0
+			or info.fileno != file_number)
+		return HADDR_UNDEF;
+
+	// only defined for contiguous datasets with allocated storage:
+	const haddr_t offset = H5Dget_offset(dataset.getId());
+	if (offset == HADDR_UNDEF)
+		return HADDR_UNDEF;
+
+	if (dataset.getStorageSize() != nof_bytes)
+		return HADDR_UNDEF;
+
+	if (not (dataset.getDataType() == mem_type))
+		return HADDR_UNDEF;
+
+	return offset;
+}
+
+const void *ReadFile::get_mapped_region(haddr_t offset, size_t nof_bytes) {
+	if (mapped_file == nullptr)
+		mapped_file = new MappedFile(file_name);
+
+	return mapped_file->get_region(offset, nof_bytes);
+}
+
 } // end of namespace CDX
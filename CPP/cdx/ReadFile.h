@@ -7,22 +7,261 @@
 #define READCDXFILE_H_
 
 #include "File.h"
+#include "LinkLayout.h"
+#include "MappedFile.h"
 
 namespace CDX {
 
+/**
+ * \brief Read-only view of the elements of a dataset.
+ *
+ * If the dataset could be mapped into memory, the view points directly into the mapped
+ * file. Otherwise, the view owns a buffer that holds a copy read with H5Dread. The view
+ * must not outlive the reader that created it.
+ */
+template<typename T>
+class DataView {
+public:
+	/** creates an empty view */
+	DataView() :
+			ptr(nullptr), count(0), mapped(false) {
+	}
+
+	/** creates a view of mapped memory */
+	DataView(const T *_ptr, size_t _count) :
+			ptr(_ptr), count(_count), mapped(true) {
+	}
+
+	/** creates a view that owns a copy of the data */
+	explicit DataView(std::vector<T> &&_buffer) :
+			ptr(_buffer.data()), count(_buffer.size()), mapped(false), buffer(
+					std::move(_buffer)) {
+	}
+
+	DataView(DataView &&) = default;
+	DataView &operator=(DataView &&) = default;
+
+	/** returns a pointer to the first element */
+	const T *data() const {
+		return ptr;
+	}
+
+	/** returns the number of elements */
+	size_t size() const {
+		return count;
+	}
+
+	/** returns true if the view points into the mapped file, false if it holds a copy */
+	bool is_mapped() const {
+		return mapped;
+	}
+
+	const T &operator[](size_t k) const {
+		return ptr[k];
+	}
+
+	const T *begin() const {
+		return ptr;
+	}
+
+	const T *end() const {
+		return ptr + count;
+	}
+
+private:
+	DataView(const DataView &);
+	DataView &operator=(const DataView &);
+
+	const T *ptr; ///< first element
+	size_t count; ///< number of elements
+	bool mapped; ///< true if ptr points into the mapped file
+	std::vector<T> buffer; ///< copy of the data if the dataset is not mapped
+};
+
+/**
+ * \brief HDF5 virtual file drivers a reader can open a file with, see reader_options_t.
+ */
+enum file_driver_t {
+	sec2_driver, ///< POSIX I/O through the page cache of the operating system, the HDF5 default
+	core_driver, ///< reads the whole file into memory when it is opened
+	direct_driver ///< POSIX I/O with O_DIRECT, bypassing the page cache, only if HDF5 was built with it
+};
+
+/**
+ * \brief Caching and I/O settings of a reader, see get_reader_access_plist.
+ *
+ * The default values keep the HDF5 defaults.
+ */
+struct reader_options_t {
+	reader_options_t() :
+			chunk_cache_size(0), chunk_cache_slots(0), chunk_cache_w0(-1.0), metadata_cache_size(
+					0), page_buffer_size(0), driver(sec2_driver), core_increment(
+					1 << 20), direct_alignment(4096), direct_block_size(4096), direct_copy_buffer_size(
+					16 << 20) {
+	}
+
+	size_t chunk_cache_size; ///< size of the raw data chunk cache of each dataset in bytes, 0 for the HDF5 default of 1 MB
+	size_t chunk_cache_slots; ///< number of hash table slots of the chunk cache, ideally a prime about 100 times the number of chunks that fit, 0 for the HDF5 default of 521
+	double chunk_cache_w0; ///< preemption policy of the chunk cache between 0 and 1, 1 evicts fully read chunks first, negative for the HDF5 default of 0.75
+	size_t metadata_cache_size; ///< fixed size of the metadata cache in bytes, 0 for the adaptive HDF5 default, see get_limited_cache_access_plist
+	size_t page_buffer_size; ///< size of the page buffer in bytes, 0 to disable it. Opening fails for files that were not written with the paged file space strategy
+	file_driver_t driver; ///< virtual file driver
+	size_t core_increment; ///< with core_driver, the increment in bytes by which the memory image grows
+	size_t direct_alignment; ///< with direct_driver, the memory alignment in bytes
+	size_t direct_block_size; ///< with direct_driver, the file system block size in bytes
+	size_t direct_copy_buffer_size; ///< with direct_driver, the copy buffer size in bytes
+};
+
+/**
+ * \brief Returns file access properties with the caching and I/O settings of a reader.
+ *
+ * The properties are passed to the constructor of a reader, e.g.
+ * ReadContinuousDelayFile or ReadDiscreteDelayFile. The chunk cache settings apply to
+ * every dataset the reader opens. Wide discrete-delay datasets are chunked by CIR, so the
+ * chunk cache should hold all CIRs of a window that is read repeatedly, e.g. with
+ * ReadDiscreteDelayFile::get_cirs for a range of delay samples.
+ *
+ * Memory-mapped views, see ReadFile::set_mmap_enabled, are only used with sec2_driver.
+ *
+ * \param[in] options The settings
+ * \throw std::logic_error if direct_driver is selected but HDF5 was built without it
+ */
+H5::FileAccPropList get_reader_access_plist(const reader_options_t &options);
+
+/**
+ * \brief Returns file access properties that limit the HDF5 metadata cache to a fixed size.
+ *
+ * HDF5 grows the metadata cache of a file while its objects are accessed. Tools that read
+ * every CIR of a file once, e.g. resample and merge, pass these properties to the reader,
+ * so the memory does not grow with the number of CIRs.
+ *
+ * \param[in] metadata_cache_size Size of the metadata cache in bytes
+ */
+H5::FileAccPropList get_limited_cache_access_plist(size_t metadata_cache_size);
+
 /**
  * \brief	Base class for reading CDX files.
  */
 class ReadFile: public File {
 public:
-	ReadFile(std::string _file_name);
+	/**
+	 * \brief Opens a file for reading.
+	 *
+	 * \param[in] _file_name File name
+	 * \param[in] _access_plist File access properties the file is opened with
+	 * \param[in] _lazy_open Open the group of each link on first use, see File::File
+	 * \param[in] _flags H5F_ACC_RDONLY, or with H5F_ACC_SWMR_READ for files written in SWMR
+	 * mode, see FollowContinuousDelayFile
+	 */
+	ReadFile(std::string _file_name, const H5::FileAccPropList &_access_plist =
+			H5::FileAccPropList::DEFAULT, bool _lazy_open = false,
+			unsigned int _flags = H5F_ACC_RDONLY);
 	virtual ~ReadFile();
 
-protected:
-	double get_reference_delay(std::string link, size_t number);
+	/**
+	 * \brief Enables or disables memory-mapped access for views of datasets.
+	 *
+	 * Enabled by default. If disabled, all views are read with H5Dread.
+	 */
+	void set_mmap_enabled(bool enabled) {
+		mmap_enabled = enabled;
+	}
+
+	/** returns true if memory-mapped access is enabled */
+	bool get_mmap_enabled() const {
+		return mmap_enabled;
+	}
 
 	/** return reference delays for a specific link */
 	std::vector<double> get_reference_delays(std::string link);
+
+	/** returns the reference delays of the link with a given index */
+	std::vector<double> get_reference_delays(size_t link_index);
+
+	/**
+	 * \brief Reads the reference delays of consecutive CIRs with a single read.
+	 *
+	 * \param[in] link_index Link index
+	 * \param[in] first Number of the first CIR
+	 * \param[in] count Number of CIRs
+	 * \param[out] reference_delays Destination for \c count values
+	 */
+	void get_reference_delays(size_t link_index, size_t first, size_t count,
+			double *reference_delays);
+
+	/**
+	 * \brief Returns the layout of the link with a given index, read on first use.
+	 *
+	 * \return The layout, not available for files written by older versions of the
+	 * library, see link_layout_t
+	 */
+	const link_layout_t &get_link_layout(size_t link_index);
+
+protected:
+	double get_reference_delay(std::string link, size_t number);
+
+	/** returns the reference delay of a CIR of the link with a given index */
+	double get_reference_delay(size_t link_index, size_t number);
+
+	/**
+	 * \brief Returns the reference delays dataset of a link, opening it on first use.
+	 *
+	 * The dataset stays open, so it is not looked up in the link group for each CIR.
+	 */
+	H5::DataSet &get_reference_delays_dataset(size_t link_index);
+
+	/**
+	 * \brief Returns the file offset of a dataset's data if it can be accessed through the mapped file.
+	 *
+	 * A dataset can be accessed directly if it has contiguous layout with allocated storage,
+	 * its file datatype equals the memory datatype and the file uses the default (sec2)
+	 * driver without user block.
+	 *
+	 * \param[in] dataset The dataset
+	 * \param[in] mem_type Memory datatype of the elements
+	 * \param[in] nof_bytes Size of the dataset's data in bytes
+	 * \return Offset of the data or HADDR_UNDEF if the dataset cannot be accessed directly
+	 */
+	haddr_t get_mapped_offset(const H5::DataSet &dataset,
+			const H5::DataType &mem_type, size_t nof_bytes);
+
+	/**
+	 * \brief Returns the address of a region of the mapped file, mapping the file on first use.
+	 *
+	 * \return Address of the region or nullptr if the file cannot be mapped
+	 */
+	const void *get_mapped_region(haddr_t offset, size_t nof_bytes);
+
+	/**
+	 * \brief Returns a view of all elements of a dataset, mapped if possible.
+	 */
+	template<typename T>
+	DataView<T> read_view(const H5::DataSet &dataset,
+			const H5::DataType &mem_type) {
+		const size_t count = dataset.getSpace().getSimpleExtentNpoints();
+
+		if (count == 0)
+			return DataView<T>();
+
+		const haddr_t offset = get_mapped_offset(dataset, mem_type,
+				count * sizeof(T));
+		const void *mapped_data =
+				offset == HADDR_UNDEF ?
+						nullptr : get_mapped_region(offset, count * sizeof(T));
+		if (mapped_data != nullptr)
+			return DataView<T>(static_cast<const T *>(mapped_data), count);
+
+		std::vector<T> buffer(count);
+		dataset.read(buffer.data(), mem_type);
+		return DataView<T>(std::move(buffer));
+	}
+
+	bool mmap_enabled; ///< views use the mapped file if true
+	int mmap_eligible_file; ///< -1 if not checked yet, otherwise 1 if driver and user block allow mapping
+	unsigned long file_number; ///< HDF5 file number of the file, set with mmap_eligible_file
+	MappedFile *mapped_file; ///< the file mapped into memory, created on first use
+	std::vector<H5::DataSet *> reference_delays_datasets; ///< the open reference delays dataset of each link, indexed by link index
+	std::vector<link_layout_t *> link_layouts; ///< the layout of each link, indexed by link index, nullptr until read by get_link_layout
 };
 
 } // end of namespace CDX
@@ -0,0 +1,180 @@
+/**
+ * \file	Resample.cpp
+ *
+ * \brief	Decimation, cropping and filtering of continuous-delay CDX files.
+ */
+
+#include "Resample.h"
+#include "ReadContinuousDelayFile.h"
+#include "WriteContinuousDelayFile.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+using namespace std;
+
+namespace CDX {
+
+/// size of the HDF5 metadata cache of the input file in bytes
+static const size_t metadata_cache_size = 4 * 1024 * 1024;
+
+/**
+ * \brief Returns the number of the first CIR at or after a time, at most nof_cirs.
+ */
+static cir_number_t first_cir_at(double time_s, double cir_rate_Hz,
+		cir_number_t nof_cirs) {
+	if (time_s <= 0.0)
+		return 0;
+
+	if (time_s * cir_rate_Hz >= nof_cirs)
+		return nof_cirs;
+
+	// CIR n is at time n / cir_rate_Hz, correct rounding errors of the product:
+	cir_number_t n = ceil(time_s * cir_rate_Hz);
+	while (n > 0 and (n - 1) / cir_rate_Hz >= time_s)
+		n--;
+	while (n < nof_cirs and n / cir_rate_Hz < time_s)
+		n++;
+
+	return n;
+}
+
+resample_stats_t resample(const std::string &input_file_name,
+		const std::string &output_file_name,
+		const resample_options_t &options) {
+	if (options.decimation == 0)
+		throw logic_error("resample: decimation must be at least 1.");
+
+	if (options.batch_size == 0)
+		throw logic_error("resample: batch_size must be at least 1.");
+
+	if (options.end_time_s < options.start_time_s)
+		throw logic_error("resample: end_time_s is before start_time_s.");
+
+	// every CIR is read once, so the metadata of its dataset is not needed again. The
+	// HDF5 metadata cache is limited to a fixed size, otherwise it grows to several hundred
+	// MB for files with many CIRs. Evict-on-close would also bound it, but makes closing
+	// each dataset about 25x slower:
+	ReadContinuousDelayFile cdx_in(input_file_name,
+			get_limited_cache_access_plist(metadata_cache_size));
+
+	const vector<string> link_names =
+			options.links.empty() ? cdx_in.get_link_names() : options.links;
+	const size_t nof_links = link_names.size();
+
+	vector<bool> keep_type(numeric_limits<uint16_t>::max() + 1,
+			options.types.empty());
+	for (uint16_t type : options.types)
+		keep_type[type] = true;
+
+	vector<size_t> input_link_indices;
+	links_to_component_types_t component_types;
+	for (const auto &link_name : link_names) {
+		input_link_indices.push_back(cdx_in.get_link_index(link_name));
+
+		component_types[link_name];
+		for (const auto &component_type : cdx_in.get_component_types(
+				input_link_indices.back()))
+			if (keep_type[component_type.first])
+				component_types[link_name].insert(component_type);
+	}
+
+	const double cir_rate_Hz = cdx_in.get_cir_rate_Hz();
+	const cir_number_t first_cir = first_cir_at(options.start_time_s,
+			cir_rate_Hz, cdx_in.get_nof_cirs());
+	const cir_number_t end_cir = first_cir_at(options.end_time_s, cir_rate_Hz,
+			cdx_in.get_nof_cirs());
+
+	WriteContinuousDelayFile cdx_out(output_file_name, cdx_in.get_c0_m_s(),
+			cir_rate_Hz / options.decimation,
+			cdx_in.get_transmitter_frequency_Hz(), link_names, component_types,
+			options.write_track_index);
+	cdx_out.enable_async_writer(options.batch_size);
+
+	resample_stats_t stats;
+	cir_block_t block;
+	vector<hdf5_impulse_t> raw_components;
+
+	const cir_number_t cirs_per_batch = options.batch_size
+			* options.decimation;
+	for (cir_number_t batch_first = first_cir; batch_first < end_cir;
+			batch_first += cirs_per_batch) {
+		// number of output CIRs in this batch:
+		const size_t count = min<cir_number_t>(options.batch_size,
+				(end_cir - batch_first + options.decimation - 1)
+						/ options.decimation);
+
+		// the CIRs are moved into the queue of the writer, so the batch is allocated anew:
+		vector<vector<components_t> > cirs(count,
+				vector<components_t>(nof_links));
+		vector<vector<double> > reference_delays(count,
+				vector<double>(nof_links));
+
+		for (size_t l = 0; l < nof_links; l++) {
+			// the writer thread calls HDF5 at the same time while holding the mutex:
+			if (options.decimation == 1) {
+				{
+					lock_guard<mutex> hdf5_lock(get_hdf5_mutex());
+					cdx_in.read_cirs(input_link_indices[l], batch_first, count,
+							block);
+				}
+
+				for (size_t k = 0; k < count; k++) {
+					reference_delays[k][l] = block.ref_delays[k];
+
+					for (size_t i = block.offsets[k]; i < block.offsets[k + 1];
+							i++) {
+						if (not keep_type[block.types[i]])
+							continue;
+
+						impulse_t component;
+						component.type = block.types[i];
+						component.id = block.ids[i];
+						component.delay = block.delays[i];
+						component.amplitude = complex<double>(block.reals[i],
+								block.imags[i]);
+						cirs[k][l].push_back(component);
+					}
+				}
+				stats.nof_read_components += block.size();
+			} else {
+				for (size_t k = 0; k < count; k++) {
+					{
+						lock_guard<mutex> hdf5_lock(get_hdf5_mutex());
+						reference_delays[k][l] = cdx_in.get_raw_cir(
+								input_link_indices[l],
+								batch_first + k * options.decimation,
+								raw_components);
+					}
+
+					for (const auto &raw_component : raw_components) {
+						if (not keep_type[raw_component.type])
+							continue;
+
+						impulse_t component;
+						ReadContinuousDelayFile::convert_components(
+								&raw_component, 1, &component);
+						cirs[k][l].push_back(component);
+					}
+					stats.nof_read_components += raw_components.size();
+				}
+			}
+		}
+
+		for (size_t k = 0; k < count; k++) {
+			for (const auto &cir : cirs[k])
+				stats.nof_written_components += cir.size();
+
+			cdx_out.write_cir(std::move(cirs[k]),
+					std::move(reference_delays[k]), stats.nof_written_cirs++);
+		}
+		stats.nof_read_cirs += count;
+	}
+
+	cdx_out.close();
+
+	return stats;
+}
+
+} // end of namespace CDX
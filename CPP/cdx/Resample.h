@@ -0,0 +1,74 @@
+/**
+ * \file	Resample.h
+ *
+ * \brief	Decimation, cropping and filtering of continuous-delay CDX files.
+ */
+
+#ifndef CDX_RESAMPLE_H_
+#define CDX_RESAMPLE_H_
+
+#include <limits>
+
+#include "File.h"
+
+namespace CDX {
+
+/**
+ * \brief Selection of CIRs, links and components copied by resample.
+ */
+struct resample_options_t {
+	resample_options_t() :
+			decimation(1), start_time_s(0.0), end_time_s(
+					std::numeric_limits<double>::infinity()), batch_size(256), write_track_index(
+					false) {
+	}
+
+	size_t decimation; ///< only every decimation-th CIR of the time window is copied, at least 1
+	double start_time_s; ///< CIRs before this time are dropped, CIR n is at time n / cir_rate_Hz
+	double end_time_s; ///< CIRs at or after this time are dropped
+	std::vector<std::string> links; ///< names of the links to copy, all links if empty
+	std::vector<uint16_t> types; ///< types of the components to copy, all types if empty
+	size_t batch_size; ///< number of CIRs of a link read in one batch, at least 1
+	bool write_track_index; ///< write a track index to the output file
+};
+
+/**
+ * \brief Numbers of CIRs and components read and written by resample.
+ */
+struct resample_stats_t {
+	resample_stats_t() :
+			nof_read_cirs(0), nof_written_cirs(0), nof_read_components(0), nof_written_components(
+					0) {
+	}
+
+	uint64_t nof_read_cirs; ///< CIRs read from each output link
+	uint64_t nof_written_cirs; ///< CIRs written to each output link
+	uint64_t nof_read_components; ///< components read from all output links
+	uint64_t nof_written_components; ///< components written to all output links
+};
+
+/**
+ * \brief Copies a selection of a continuous-delay CDX file into a new file.
+ *
+ * CIR \c n of the output file is input CIR <tt>first + n * decimation</tt>, where \c first
+ * is the first CIR at or after \c start_time_s. The CIR rate of the output file is the
+ * input rate divided by the decimation. Reference delays, component types and all other
+ * parameters are copied.
+ *
+ * The CIRs are streamed: without decimation, \c batch_size consecutive CIRs of a link
+ * are read with one call to ReadContinuousDelayFile::read_cirs. The writer writes on its
+ * asynchronous thread. At most one batch is held in memory, so the memory does not
+ * depend on the number of CIRs in the file.
+ *
+ * \param[in] input_file_name Continuous-delay CDX file to read
+ * \param[in] output_file_name File to create, an existing file is overwritten
+ * \param[in] options Selection of CIRs, links and components
+ * \return Numbers of CIRs and components read and written
+ */
+resample_stats_t resample(const std::string &input_file_name,
+		const std::string &output_file_name,
+		const resample_options_t &options);
+
+} // end of namespace CDX
+
+#endif /* CDX_RESAMPLE_H_ */
@@ -0,0 +1,480 @@
+/**
+ * \file	Shards.cpp
+ *
+ * \brief	Writing a CDX file as shards in parallel, presented as one file by a master file.
+ */
+
+#include "Shards.h"
+#include "ReadContinuousDelayFile.h"
+#include "ReadDiscreteDelayFile.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+
+using namespace std;
+
+namespace CDX {
+
+std::vector<shard_range_t> split_into_shards(cir_number_t nof_cirs,
+		size_t nof_shards) {
+	if (nof_shards == 0)
+		throw logic_error("split_into_shards: nof_shards must be at least 1.");
+
+	const cir_number_t cirs_per_block =
+			WriteContinuousDelayFile::cirs_per_delay_bounds_block;
+	const cir_number_t nof_blocks = (nof_cirs + cirs_per_block - 1)
+			/ cirs_per_block;
+
+	vector<shard_range_t> ranges(nof_shards);
+	cir_number_t block = 0;
+	for (size_t k = 0; k < nof_shards; k++) {
+		// the first shards get one of the remaining blocks each:
+		const cir_number_t nof_shard_blocks = nof_blocks / nof_shards
+				+ (k < nof_blocks % nof_shards ? 1 : 0);
+
+		ranges[k].first_cir = min(nof_cirs, block * cirs_per_block);
+		ranges[k].nof_cirs = min(nof_cirs,
+				(block + nof_shard_blocks) * cirs_per_block)
+				- ranges[k].first_cir;
+		block += nof_shard_blocks;
+	}
+
+	return ranges;
+}
+
+std::string get_shard_file_name(const std::string &file_name, size_t shard) {
+	return file_name + ".shard" + to_string(shard);
+}
+
+/**
+ * \brief Returns the name under which a master file references a shard.
+ *
+ * HDF5 looks up relative file names of external links and sources of virtual datasets in
+ * the directory of the file that contains them, so shards in the directory of the master
+ * file are referenced without directory.
+ */
+static string get_reference_name(const string &master_file_name,
+		const string &shard_file_name) {
+	const size_t slash = master_file_name.rfind('/');
+	if (slash == string::npos)
+		return shard_file_name;
+
+	const string directory = master_file_name.substr(0, slash + 1);
+	if (shard_file_name.compare(0, directory.size(), directory) == 0)
+		return shard_file_name.substr(directory.size());
+
+	return shard_file_name;
+}
+
+/**
+ * \brief Throws a std::runtime_error if a shard has other parameters or links than the first one.
+ */
+static void check_shard(const File &first, const File &shard,
+		const string &shard_file_name) {
+	first.check_same_parameters(shard, "write master file");
+
+	vector<string> names = shard.get_link_names();
+	vector<string> first_names = first.get_link_names();
+	sort(names.begin(), names.end());
+	sort(first_names.begin(), first_names.end());
+	if (names != first_names)
+		throw runtime_error(
+				"write master file: " + shard_file_name
+						+ " has other links than the first shard.");
+}
+
+/**
+ * \brief Creates a virtual dataset that concatenates a dataset of all shards along one dimension.
+ *
+ * \param[in] group Group of the virtual dataset in the master file
+ * \param[in] name Name of the virtual dataset
+ * \param[in] dims Dimensions of the virtual dataset
+ * \param[in] dimension Dimension along which the datasets of the shards are concatenated
+ * \param[in] source_file_names Reference names of the shards, see get_reference_name
+ * \param[in] source_path Path of the dataset in each shard
+ * \param[in] sizes Extent along \c dimension of the dataset of each shard
+ */
+static void create_virtual_dataset(H5::Group &group, const string &name,
+		const vector<hsize_t> &dims, size_t dimension,
+		const vector<string> &source_file_names, const string &source_path,
+		const vector<hsize_t> &sizes) {
+	const int rank = dims.size();
+	H5::DataSpace space(rank, dims.data());
+
+	H5::DSetCreatPropList plist;
+	hsize_t offset = 0;
+	for (size_t s = 0; s < source_file_names.size(); s++) {
+		if (sizes[s] == 0)
+			continue;
+
+		vector<hsize_t> start(rank, 0);
+		vector<hsize_t> count = dims;
+		start[dimension] = offset;
+		count[dimension] = sizes[s];
+
+		H5::DataSpace virtual_space(rank, dims.data());
+		virtual_space.selectHyperslab(H5S_SELECT_SET, count.data(),
+				start.data());
+		H5::DataSpace source_space(rank, count.data());
+
+		if (H5Pset_virtual(plist.getId(), virtual_space.getId(),
+				source_file_names[s].c_str(), source_path.c_str(),
+				source_space.getId()) < 0)
+			throw runtime_error(
+					"write master file: mapping " + source_path + " of "
+							+ source_file_names[s] + " failed.");
+
+		offset += sizes[s];
+	}
+
+	// a virtual dataset needs at least one mapping:
+	if (offset == 0)
+		group.createDataSet(name, H5::PredType::NATIVE_DOUBLE, space);
+	else
+		group.createDataSet(name, H5::PredType::NATIVE_DOUBLE, space, plist);
+}
+
+void write_continuous_delay_master(const std::string &file_name,
+		const std::vector<std::string> &shard_file_names) {
+	if (shard_file_names.empty())
+		throw logic_error("write_continuous_delay_master: no shards given.");
+
+	vector<unique_ptr<ReadContinuousDelayFile> > shards;
+	vector<string> reference_names;
+	vector<cir_number_t> first_cirs;
+	cir_number_t nof_cirs = 0;
+	for (const auto &shard_file_name : shard_file_names) {
+		shards.emplace_back(new ReadContinuousDelayFile(shard_file_name));
+		check_shard(*shards[0], *shards.back(), shard_file_name);
+
+		reference_names.push_back(
+				get_reference_name(file_name, shard_file_name));
+		first_cirs.push_back(nof_cirs);
+		nof_cirs += shards.back()->get_nof_cirs();
+	}
+
+	const size_t nof_shards = shards.size();
+	const cir_number_t cirs_per_block =
+			WriteContinuousDelayFile::cirs_per_delay_bounds_block;
+	const size_t nof_blocks = (nof_cirs + cirs_per_block - 1) / cirs_per_block;
+
+	H5::H5File h5file(file_name, H5F_ACC_TRUNC);
+	shards[0]->copy_object("/parameters", h5file, "/parameters");
+	H5::Group links_group = h5file.createGroup("/links");
+
+	for (const auto &link_name : shards[0]->get_link_names()) {
+		const string link_path = "/links/" + link_name;
+
+		vector<size_t> link_indices;
+		vector<hsize_t> sizes;
+		for (size_t s = 0; s < nof_shards; s++) {
+			link_indices.push_back(shards[s]->get_link_index(link_name));
+			sizes.push_back(shards[s]->get_nof_cirs());
+
+			if (shards[s]->get_component_types(link_indices.back())
+					!= shards[0]->get_component_types(link_indices[0]))
+				throw runtime_error(
+						"write master file: " + shard_file_names[s]
+								+ " has other component types for link "
+								+ link_name + " than the first shard.");
+		}
+
+		H5::Group link_group = links_group.createGroup(link_name);
+		shards[0]->copy_object(link_path + "/component_types", link_group,
+				"component_types");
+
+		// each CIR is an external link to its dataset in the shard:
+		H5::Group cirs_group = link_group.createGroup("cirs");
+		char name[24];
+		for (size_t s = 0; s < nof_shards; s++)
+			for (cir_number_t n = 0; n < sizes[s]; n++) {
+				snprintf(name, sizeof(name), "%llu",
+						static_cast<unsigned long long>(n));
+				const string target = link_path + "/cirs/" + name;
+
+				snprintf(name, sizeof(name), "%llu",
+						static_cast<unsigned long long>(first_cirs[s] + n));
+				if (H5Lcreate_external(reference_names[s].c_str(),
+						target.c_str(), cirs_group.getId(), name, H5P_DEFAULT,
+						H5P_DEFAULT) < 0)
+					throw runtime_error(
+							"write master file: linking " + target + " of "
+									+ shard_file_names[s] + " failed.");
+			}
+
+		create_virtual_dataset(link_group, "reference_delays", { nof_cirs },
+				0, reference_names, link_path + "/reference_delays", sizes);
+
+		// without the layouts of all shards, readers count the CIRs of the master file:
+		link_layout_t layout;
+		layout.available = true;
+		layout.nof_cirs = nof_cirs;
+		layout.sample_type = "impulse";
+		for (size_t s = 0; s < nof_shards; s++) {
+			const link_layout_t &shard_layout = shards[s]->get_link_layout(
+					link_indices[s]);
+			layout.available = layout.available and shard_layout.available;
+			layout.max_nof_components = max(layout.max_nof_components,
+					shard_layout.max_nof_components);
+		}
+		if (layout.available)
+			write_link_layout(link_group, layout);
+
+		// the delay bounds of each block are the bounds of the CIRs of the shards in it,
+		// exact if the shards start at block boundaries, see split_into_shards:
+		vector<double> bounds(2 * nof_blocks);
+		bool bounds_available = true;
+		size_t s = 0;
+		for (size_t block = 0; bounds_available and block < nof_blocks;
+				block++) {
+			const cir_number_t block_start = block * cirs_per_block;
+			const cir_number_t block_end = min(nof_cirs,
+					block_start + cirs_per_block);
+
+			bounds[2 * block] = numeric_limits<double>::infinity();
+			bounds[2 * block + 1] = -numeric_limits<double>::infinity();
+
+			for (cir_number_t n = block_start; n < block_end;) {
+				while (n >= first_cirs[s] + sizes[s])
+					s++;
+
+				const cir_number_t count = min<cir_number_t>(block_end,
+						first_cirs[s] + sizes[s]) - n;
+				double min_delay, max_delay;
+				if (not shards[s]->get_delay_bounds(link_indices[s],
+						n - first_cirs[s], count, min_delay, max_delay)) {
+					bounds_available = false;
+					break;
+				}
+
+				bounds[2 * block] = min(bounds[2 * block], min_delay);
+				bounds[2 * block + 1] = max(bounds[2 * block + 1], max_delay);
+				n += count;
+			}
+		}
+
+		// without the bounds of all shards, queries scan the master file completely:
+		if (bounds_available) {
+			const hsize_t dims[2] = { nof_blocks, 2 };
+			H5::DataSet dataset = link_group.createDataSet("delay_bounds",
+					H5::PredType::NATIVE_DOUBLE, H5::DataSpace(2, dims));
+			if (nof_blocks > 0)
+				dataset.write(bounds.data(), H5::PredType::NATIVE_DOUBLE);
+
+			const uint64_t attribute_value = cirs_per_block;
+			H5::Attribute attribute = dataset.createAttribute(
+					"cirs_per_block", H5::PredType::NATIVE_UINT64,
+					H5::DataSpace(H5S_SCALAR));
+			attribute.write(H5::PredType::NATIVE_UINT64, &attribute_value);
+		}
+	}
+}
+
+void write_discrete_delay_master(const std::string &file_name,
+		const std::vector<std::string> &shard_file_names) {
+	if (shard_file_names.empty())
+		throw logic_error("write_discrete_delay_master: no shards given.");
+
+	vector<unique_ptr<ReadDiscreteDelayFile> > shards;
+	vector<string> reference_names;
+	for (const auto &shard_file_name : shard_file_names) {
+		shards.emplace_back(new ReadDiscreteDelayFile(shard_file_name));
+		check_shard(*shards[0], *shards.back(), shard_file_name);
+
+		if (shards.back()->get_delay_smpl_freq()
+				!= shards[0]->get_delay_smpl_freq())
+			throw runtime_error(
+					"write master file: " + shard_file_name
+							+ " has another delay sampling frequency than the first shard.");
+
+		reference_names.push_back(
+				get_reference_name(file_name, shard_file_name));
+	}
+
+	const size_t nof_shards = shards.size();
+
+	H5::H5File h5file(file_name, H5F_ACC_TRUNC);
+	shards[0]->copy_object("/parameters", h5file, "/parameters");
+	H5::Group links_group = h5file.createGroup("/links");
+
+	for (const auto &link_name : shards[0]->get_link_names()) {
+		const string link_path = "/links/" + link_name;
+		const size_t nof_delay_samples = shards[0]->get_nof_delay_samples(
+				link_name);
+
+		// the number of reference delays is the number of CIRs, the CIR datasets of a
+		// link without CIRs have one column:
+		vector<hsize_t> sizes;
+		hsize_t nof_cirs = 0;
+		for (size_t s = 0; s < nof_shards; s++) {
+			if (shards[s]->get_nof_delay_samples(link_name)
+					!= nof_delay_samples)
+				throw runtime_error(
+						"write master file: " + shard_file_names[s]
+								+ " has another number of delay samples for link "
+								+ link_name + " than the first shard.");
+
+			sizes.push_back(shards[s]->get_reference_delays(link_name).size());
+			nof_cirs += sizes.back();
+		}
+
+		H5::Group link_group = links_group.createGroup(link_name);
+		shards[0]->copy_object(link_path + "/y_axis", link_group, "y_axis");
+
+		create_virtual_dataset(link_group, "cirs_real", { nof_delay_samples,
+				nof_cirs }, 1, reference_names, link_path + "/cirs_real",
+				sizes);
+		create_virtual_dataset(link_group, "cirs_imag", { nof_delay_samples,
+				nof_cirs }, 1, reference_names, link_path + "/cirs_imag",
+				sizes);
+		create_virtual_dataset(link_group, "reference_delays", { nof_cirs }, 0,
+				reference_names, link_path + "/reference_delays", sizes);
+
+		// the virtual datasets are not chunked:
+		link_layout_t layout;
+		layout.nof_cirs = nof_cirs;
+		layout.max_nof_components = nof_delay_samples;
+		layout.sample_type = "double";
+		write_link_layout(link_group, layout);
+
+		// the times of the CIRs, like WriteDiscreteDelayFile writes them:
+		vector<double> x_axis(nof_cirs);
+		for (size_t n = 0; n < nof_cirs; n++)
+			x_axis[n] = static_cast<double>(n) / shards[0]->get_cir_rate_Hz();
+
+		const hsize_t dims[2] = { nof_cirs, 1 };
+		H5::DataSet dataset = link_group.createDataSet("x_axis",
+				H5::PredType::NATIVE_DOUBLE, H5::DataSpace(2, dims));
+		if (nof_cirs > 0)
+			dataset.write(x_axis.data(), H5::PredType::NATIVE_DOUBLE);
+	}
+}
+
+ShardedWriteContinuousDelayFile::ShardedWriteContinuousDelayFile(
+		std::string _file_name, double _c0_m_s, double _cir_rate_Hz,
+		double _transmitter_frequency_Hz,
+		const std::vector<std::string> &_link_names,
+		links_to_component_types_t &_component_types, cir_number_t _nof_cirs,
+		size_t nof_shards, size_t queue_depth) :
+		file_name(_file_name), nof_cirs(_nof_cirs), ranges(
+				split_into_shards(_nof_cirs, nof_shards)), finalized(false) {
+	for (size_t k = 0; k < ranges.size(); k++) {
+		shards.emplace_back(
+				new WriteContinuousDelayFile(get_shard_file_name(file_name, k),
+						_c0_m_s, _cir_rate_Hz, _transmitter_frequency_Hz,
+						_link_names, _component_types));
+		next_cirs.push_back(ranges[k].first_cir);
+	}
+
+	// the writer threads are started when all shards have been created, because an idle
+	// writer thread does not call HDF5:
+	for (auto &shard : shards)
+		shard->enable_async_writer(queue_depth);
+}
+
+ShardedWriteContinuousDelayFile::~ShardedWriteContinuousDelayFile() {
+	if (finalized)
+		return;
+
+	try {
+		finalize();
+	} catch (exception &e) {
+		cerr << "ShardedWriteContinuousDelayFile: finalizing " << file_name
+				<< " failed: " << e.what() << endl;
+	} catch (H5::Exception &e) {
+		cerr << "ShardedWriteContinuousDelayFile: finalizing " << file_name
+				<< " failed: " << e.getDetailMsg() << endl;
+	}
+}
+
+size_t ShardedWriteContinuousDelayFile::get_shard(
+		cir_number_t cir_number) const {
+	if (cir_number >= nof_cirs) {
+		stringstream msg;
+		msg << "ShardedWriteContinuousDelayFile::get_shard: CIR " << cir_number
+				<< " is not inside the file of " << nof_cirs << " CIRs.";
+		throw logic_error(msg.str());
+	}
+
+	// the last shard that starts at or before the CIR, empty shards are at the end:
+	const auto it = upper_bound(ranges.begin(), ranges.end(), cir_number,
+			[](cir_number_t n, const shard_range_t &range) {return n < range.first_cir;});
+	return (it - ranges.begin()) - 1;
+}
+
+void ShardedWriteContinuousDelayFile::write_cir(
+		std::vector<components_t> &&cirs,
+		std::vector<double> &&reference_delays, cir_number_t cir_number) {
+	if (finalized)
+		throw logic_error(
+				"ShardedWriteContinuousDelayFile::write_cir: the file has been finalized.");
+
+	const size_t shard = get_shard(cir_number);
+	if (cir_number != next_cirs[shard]) {
+		stringstream msg;
+		msg << "ShardedWriteContinuousDelayFile::write_cir: CIR " << cir_number
+				<< " is not the next CIR of shard " << shard << ", which is "
+				<< next_cirs[shard] << ".";
+		throw logic_error(msg.str());
+	}
+
+	shards[shard]->write_cir(std::move(cirs), std::move(reference_delays),
+			cir_number - ranges[shard].first_cir);
+	next_cirs[shard]++;
+}
+
+void ShardedWriteContinuousDelayFile::write_cir(
+		const std::vector<components_t> &cirs,
+		const std::vector<double> &reference_delays, cir_number_t cir_number) {
+	write_cir(vector<components_t>(cirs), vector<double>(reference_delays),
+			cir_number);
+}
+
+void ShardedWriteContinuousDelayFile::finalize() {
+	if (finalized)
+		throw logic_error(
+				"ShardedWriteContinuousDelayFile::finalize: the file has already been finalized.");
+	finalized = true;
+
+	// all writer threads have to be idle before the first shard is closed, closing calls
+	// HDF5 without holding get_hdf5_mutex():
+	exception_ptr error;
+	for (auto &shard : shards)
+		try {
+			shard->flush();
+		} catch (...) {
+			if (not error)
+				error = current_exception();
+		}
+	for (auto &shard : shards)
+		try {
+			shard->close();
+		} catch (...) {
+			if (not error)
+				error = current_exception();
+		}
+	shards.clear();
+
+	if (error)
+		rethrow_exception(error);
+
+	vector<string> shard_file_names;
+	for (size_t k = 0; k < ranges.size(); k++) {
+		if (next_cirs[k] != ranges[k].first_cir + ranges[k].nof_cirs) {
+			stringstream msg;
+			msg << "ShardedWriteContinuousDelayFile::finalize: shard " << k
+					<< " has " << next_cirs[k] - ranges[k].first_cir << " of "
+					<< ranges[k].nof_cirs << " CIRs.";
+			throw logic_error(msg.str());
+		}
+		shard_file_names.push_back(get_shard_file_name(file_name, k));
+	}
+
+	write_continuous_delay_master(file_name, shard_file_names);
+}
+
+} // end of namespace CDX
@@ -0,0 +1,165 @@
+/**
+ * \file	Shards.h
+ *
+ * \brief	Writing a CDX file as shards in parallel, presented as one file by a master file.
+ */
+
+#ifndef CDX_SHARDS_H_
+#define CDX_SHARDS_H_
+
+#include <memory>
+
+#include "WriteContinuousDelayFile.h"
+
+namespace CDX {
+
+/**
+ * \brief Contiguous range of CIRs stored in a shard.
+ */
+struct shard_range_t {
+	cir_number_t first_cir; ///< number of the first CIR of the shard in the master file
+	size_t nof_cirs; ///< number of CIRs of the shard
+};
+
+/**
+ * \brief Splits CIRs into contiguous ranges of nearly equal size.
+ *
+ * All ranges but the last start and end at a multiple of
+ * WriteContinuousDelayFile::cirs_per_delay_bounds_block, so the delay bounds of the master
+ * file are exact. Some ranges are empty if there are fewer blocks than shards.
+ *
+ * \param[in] nof_cirs Number of CIRs
+ * \param[in] nof_shards Number of shards, at least 1
+ * \return The range of each shard
+ */
+std::vector<shard_range_t> split_into_shards(cir_number_t nof_cirs,
+		size_t nof_shards);
+
+/**
+ * \brief Returns the name of a shard of a file, <tt>file_name.shard<k></tt>.
+ */
+std::string get_shard_file_name(const std::string &file_name, size_t shard);
+
+/**
+ * \brief Writes a continuous-delay master file that presents continuous-delay shards as one file.
+ *
+ * The shards must have the same parameters, links and component types. CIR \c n of shard
+ * \c s becomes CIR <tt>n + N</tt> of the master file, where \c N is the number of CIRs of
+ * the shards before \c s. The master file stores
+ *
+ *  - an external link to the dataset in its shard for each CIR,
+ *  - the reference delays of each link as virtual dataset of the reference delays of the
+ *    shards, and
+ *  - the delay bounds of each link, computed from the delay bounds of the shards.
+ *
+ * ReadContinuousDelayFile reads the master file like any other file. Shards next to the
+ * master file are referenced by their name without directory, so the files can be moved
+ * together.
+ *
+ * \param[in] file_name File name of the master file, an existing file is overwritten
+ * \param[in] shard_file_names File names of the shards in order of their CIRs
+ */
+void write_continuous_delay_master(const std::string &file_name,
+		const std::vector<std::string> &shard_file_names);
+
+/**
+ * \brief Writes a discrete-delay master file that presents discrete-delay shards as one file.
+ *
+ * The shards must have the same parameters, links and numbers of delay samples per link.
+ * The CIRs, reference delays and times of each link are virtual datasets of the datasets
+ * of the shards, the delay axis is copied from the first shard.
+ *
+ * \param[in] file_name File name of the master file, an existing file is overwritten
+ * \param[in] shard_file_names File names of the shards in order of their CIRs
+ */
+void write_discrete_delay_master(const std::string &file_name,
+		const std::vector<std::string> &shard_file_names);
+
+/**
+ * \brief Writes a continuous-delay CDX file as shards from several threads.
+ *
+ * HDF5 serializes all calls into the library, so threads writing to a single file do not
+ * scale. Here, the CIRs are split into contiguous ranges, see split_into_shards, and each
+ * range is written to a shard of its own by a WriteContinuousDelayFile with enabled
+ * asynchronous writer. write_cir only queues the CIR, so a worker thread that computes the
+ * CIRs of one shard does not wait for the writes of the other shards. finalize closes the
+ * shards and writes the master file, see write_continuous_delay_master.
+ *
+ * write_cir may be called concurrently for CIRs of different shards. The CIRs of each
+ * shard must be written in order by one thread at a time. No other method may be called
+ * concurrently.
+ */
+class ShardedWriteContinuousDelayFile {
+public:
+	/**
+	 * \brief Creates the shards.
+	 *
+	 * \param[in] _file_name File name of the master file, the shards are named by get_shard_file_name
+	 * \param[in] _nof_cirs Number of CIRs of the file
+	 * \param[in] nof_shards Number of shards, usually the number of worker threads
+	 * \param[in] queue_depth Queue depth of the asynchronous writer of each shard
+	 *
+	 * The other parameters are those of WriteContinuousDelayFile.
+	 */
+	ShardedWriteContinuousDelayFile(std::string _file_name, double _c0_m_s,
+			double _cir_rate_Hz, double _transmitter_frequency_Hz,
+			const std::vector<std::string> &_link_names,
+			links_to_component_types_t &_component_types,
+			cir_number_t _nof_cirs, size_t nof_shards,
+			size_t queue_depth = 64);
+
+	/**
+	 * \brief Finalizes the file if finalize has not been called, printing errors.
+	 */
+	virtual ~ShardedWriteContinuousDelayFile();
+
+	/** returns the number of shards */
+	size_t get_nof_shards() const {
+		return ranges.size();
+	}
+
+	/** returns the range of CIRs of a shard */
+	const shard_range_t &get_shard_range(size_t shard) const {
+		return ranges.at(shard);
+	}
+
+	/** returns the shard that contains a CIR */
+	size_t get_shard(cir_number_t cir_number) const;
+
+	/**
+	 * \brief Queues a CIR for writing to its shard.
+	 *
+	 * \param[in] cirs The components for each link index, see File::get_link_index
+	 * \param[in] reference_delays The reference delay for each link index
+	 * \param[in] cir_number Number of the CIR in the master file, the next CIR of its shard
+	 */
+	void write_cir(std::vector<components_t> &&cirs,
+			std::vector<double> &&reference_delays, cir_number_t cir_number);
+
+	/**
+	 * \brief Queues a copy of a CIR for writing to its shard, see the overload taking rvalues.
+	 */
+	void write_cir(const std::vector<components_t> &cirs,
+			const std::vector<double> &reference_delays,
+			cir_number_t cir_number);
+
+	/**
+	 * \brief Waits for all queued CIRs, closes the shards and writes the master file.
+	 *
+	 * Throws a std::logic_error if a shard has not received all its CIRs, and rethrows
+	 * errors of the writer threads.
+	 */
+	void finalize();
+
+private:
+	const std::string file_name; ///< file name of the master file
+	const cir_number_t nof_cirs; ///< number of CIRs of the file
+	std::vector<shard_range_t> ranges; ///< the range of CIRs of each shard
+	std::vector<std::unique_ptr<WriteContinuousDelayFile> > shards; ///< the writer of each shard, reset by finalize
+	std::vector<cir_number_t> next_cirs; ///< number of the next CIR of each shard
+	bool finalized; ///< finalize has been called
+};
+
+} // end of namespace CDX
+
+#endif /* CDX_SHARDS_H_ */
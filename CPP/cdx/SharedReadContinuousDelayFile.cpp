@@ -0,0 +1,169 @@
+/**
+ * \file SharedReadContinuousDelayFile.cpp
+ */
+
+#include "SharedReadContinuousDelayFile.h"
+
+#include <algorithm>
+
+using namespace std;
+
+namespace CDX {
+
+SharedReadContinuousDelayFile::SharedReadContinuousDelayFile(string file_name,
+		bool use_io_thread) :
+		stop(false) {
+	lock_guard<mutex> hdf5_lock(get_hdf5_mutex());
+
+	reader.reset(new ReadContinuousDelayFile(file_name));
+
+	nof_cirs = reader->get_nof_cirs();
+	link_names = reader->get_link_names();
+	cir_rate_Hz = reader->get_cir_rate_Hz();
+	c0_m_s = reader->get_c0_m_s();
+	transmitter_frequency_Hz = reader->get_transmitter_frequency_Hz();
+
+	if (use_io_thread)
+		io_thread = thread(&SharedReadContinuousDelayFile::serve_requests,
+				this);
+}
+
+SharedReadContinuousDelayFile::~SharedReadContinuousDelayFile() {
+	if (io_thread.joinable()) {
+		{
+			lock_guard<mutex> lock(requests_mutex);
+			stop = true;
+		}
+		requests_pending.notify_one();
+		io_thread.join();
+	}
+
+	lock_guard<mutex> hdf5_lock(get_hdf5_mutex());
+	reader.reset();
+}
+
+cir_t SharedReadContinuousDelayFile::get_cir(const string &link,
+		cir_number_t cir_num) {
+	return get_cir(get_link_index(link), cir_num);
+}
+
+cir_t SharedReadContinuousDelayFile::get_cir(size_t link_index,
+		cir_number_t cir_num, unsigned fields) {
+	vector<hdf5_impulse_t> raw_components;
+
+	cir_t cir;
+	cir.ref_delay = get_raw_cir(link_index, cir_num, raw_components, fields);
+
+	// the conversion does not need the HDF5 library:
+	ReadContinuousDelayFile::convert_components(raw_components,
+			cir.components);
+
+	return cir;
+}
+
+double SharedReadContinuousDelayFile::get_raw_cir(const string &link,
+		cir_number_t cir_num, vector<hdf5_impulse_t> &components) {
+	return get_raw_cir(get_link_index(link), cir_num, components);
+}
+
+double SharedReadContinuousDelayFile::get_raw_cir(size_t link_index,
+		cir_number_t cir_num, vector<hdf5_impulse_t> &components,
+		unsigned fields) {
+	if (not io_thread.joinable()) {
+		lock_guard<mutex> hdf5_lock(get_hdf5_mutex());
+		return reader->get_raw_cir(link_index, cir_num, components, fields);
+	}
+
+	request_t request;
+	request.link_index = link_index;
+	request.cir_num = cir_num;
+	request.components = &components;
+	request.fields = fields;
+	request.ref_delay = 0.0;
+	request.done = false;
+
+	{
+		unique_lock<mutex> lock(requests_mutex);
+		requests.push_back(&request);
+		requests_pending.notify_one();
+		requests_done.wait(lock, [&request] {return request.done;});
+	}
+
+	if (request.error)
+		rethrow_exception(request.error);
+
+	return request.ref_delay;
+}
+
+DataView<hdf5_impulse_t> SharedReadContinuousDelayFile::get_cir_view(
+		const string &link, cir_number_t cir_num) {
+	lock_guard<mutex> hdf5_lock(get_hdf5_mutex());
+	return reader->get_cir_view(link, cir_num);
+}
+
+void SharedReadContinuousDelayFile::read_cirs(size_t link_index,
+		cir_number_t first_cir, size_t count, cir_block_t &block,
+		unsigned fields) {
+	lock_guard<mutex> hdf5_lock(get_hdf5_mutex());
+	reader->read_cirs(link_index, first_cir, count, block, fields);
+}
+
+query_result_t SharedReadContinuousDelayFile::query(const string &link,
+		const query_t &query) {
+	lock_guard<mutex> hdf5_lock(get_hdf5_mutex());
+	return reader->query(link, query);
+}
+
+track_t SharedReadContinuousDelayFile::get_track(const string &link,
+		uint64_t id) {
+	lock_guard<mutex> hdf5_lock(get_hdf5_mutex());
+	return reader->get_track(link, id);
+}
+
+void SharedReadContinuousDelayFile::serve_requests() {
+	vector<request_t*> batch;
+
+	while (true) {
+		{
+			unique_lock<mutex> lock(requests_mutex);
+			requests_pending.wait(lock,
+					[this] {return stop or not requests.empty();});
+
+			if (requests.empty())
+				return; // stop has been requested and all requests have been served
+
+			batch.swap(requests);
+		}
+
+		// serve the requests in file order:
+		sort(batch.begin(), batch.end(),
+				[](const request_t *a, const request_t *b) {
+					return a->link_index < b->link_index or (a->link_index == b->link_index and a->cir_num < b->cir_num);
+				});
+
+		{
+			lock_guard<mutex> hdf5_lock(get_hdf5_mutex());
+
+			for (auto request : batch) {
+				try {
+					request->ref_delay = reader->get_raw_cir(request->link_index,
+							request->cir_num, *request->components,
+							request->fields);
+				} catch (...) {
+					request->error = current_exception();
+				}
+			}
+		}
+
+		{
+			lock_guard<mutex> lock(requests_mutex);
+			for (auto request : batch)
+				request->done = true;
+		}
+		requests_done.notify_all();
+
+		batch.clear();
+	}
+}
+
+} /* namespace CDX */
@@ -0,0 +1,180 @@
+/**
+ * \file SharedReadContinuousDelayFile.h
+ *
+ * \brief Thread-safe reader for continuous-delay CDX files.
+ */
+
+#ifndef CDX_SHAREDREADCONTINUOUSDELAYFILE_H_
+#define CDX_SHAREDREADCONTINUOUSDELAYFILE_H_
+
+#include <condition_variable>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "ReadContinuousDelayFile.h"
+
+namespace CDX {
+
+/**
+ * \brief Reader for continuous-delay CDX files that can be shared by many threads.
+ *
+ * All calls into the HDF5 library are serialized by get_hdf5_mutex(). Only the raw
+ * components are read while the mutex is held, their conversion to impulse_t is done
+ * by the calling thread after the mutex has been released.
+ *
+ * If constructed with \c use_io_thread, all reads are done by a dedicated I/O thread
+ * instead. Requests of concurrent callers are collected while the I/O thread is busy and
+ * served as one batch in the order of their link and CIR number, so the mutex is taken
+ * once per batch and adjacent CIRs are read one after another.
+ *
+ * The parameters and link names of the file do not change after construction and can
+ * be accessed without locking.
+ */
+class SharedReadContinuousDelayFile {
+public:
+	typedef boost::shared_ptr<SharedReadContinuousDelayFile> ptr;
+
+	/**
+	 * \brief Opens a continuous-delay CDX file.
+	 *
+	 * \param[in] file_name File name
+	 * \param[in] use_io_thread Serve all reads from a dedicated I/O thread
+	 */
+	SharedReadContinuousDelayFile(std::string file_name, bool use_io_thread =
+			false);
+
+	/**
+	 * \brief Stops the I/O thread, if any, and closes the file.
+	 *
+	 * No other thread may use the reader anymore.
+	 */
+	virtual ~SharedReadContinuousDelayFile();
+
+	/**
+	 * \brief Returns the CIR with a given number, see ReadContinuousDelayFile::get_cir.
+	 */
+	cir_t get_cir(const std::string &link, cir_number_t cir_num);
+
+	/**
+	 * \brief Returns the CIR with a given number of the link with a given index.
+	 */
+	cir_t get_cir(size_t link_index, cir_number_t cir_num, unsigned fields =
+			all_component_fields);
+
+	/**
+	 * \brief Reads the components of a CIR as stored in the file and its reference delay.
+	 *
+	 * See ReadContinuousDelayFile::get_raw_cir.
+	 */
+	double get_raw_cir(const std::string &link, cir_number_t cir_num,
+			std::vector<hdf5_impulse_t> &components);
+
+	/**
+	 * \brief Reads the components of a CIR of the link with a given index.
+	 */
+	double get_raw_cir(size_t link_index, cir_number_t cir_num,
+			std::vector<hdf5_impulse_t> &components, unsigned fields =
+					all_component_fields);
+
+	/**
+	 * \brief Returns the components of a CIR as stored in the file, see ReadContinuousDelayFile::get_cir_view.
+	 *
+	 * Mapped views can be read concurrently without locking.
+	 */
+	DataView<hdf5_impulse_t> get_cir_view(const std::string &link,
+			cir_number_t cir_num);
+
+	/**
+	 * \brief Reads consecutive CIRs of a link into a block of arrays, see ReadContinuousDelayFile::read_cirs.
+	 */
+	void read_cirs(size_t link_index, cir_number_t first_cir, size_t count,
+			cir_block_t &block, unsigned fields = all_component_fields);
+
+	/**
+	 * \brief Selects components of a link, see ReadContinuousDelayFile::query.
+	 */
+	query_result_t query(const std::string &link, const query_t &query);
+
+	/**
+	 * \brief Returns the trajectory of a component, see ReadContinuousDelayFile::get_track.
+	 */
+	track_t get_track(const std::string &link, uint64_t id);
+
+	/** returns the number of CIRs in the file */
+	cir_number_t get_nof_cirs() const {
+		return nof_cirs;
+	}
+
+	/** returns the number of links */
+	size_t get_nof_links() const {
+		return link_names.size();
+	}
+
+	/** returns the link names */
+	const std::vector<std::string> &get_link_names() const {
+		return link_names;
+	}
+
+	/**
+	 * \brief Returns the index of a link, see File::get_link_index.
+	 */
+	size_t get_link_index(const std::string &link_name) const {
+		return reader->get_link_index(link_name);
+	}
+
+	/** returns the CIR rate in Hz */
+	double get_cir_rate_Hz() const {
+		return cir_rate_Hz;
+	}
+
+	/** returns the speed of light in m/s */
+	double get_c0_m_s() const {
+		return c0_m_s;
+	}
+
+	/** returns the transmitter frequency in Hz */
+	double get_transmitter_frequency_Hz() const {
+		return transmitter_frequency_Hz;
+	}
+
+protected:
+	/**
+	 * \brief A read waiting for the I/O thread.
+	 */
+	struct request_t {
+		size_t link_index; ///< link index
+		cir_number_t cir_num; ///< CIR number
+		std::vector<hdf5_impulse_t> *components; ///< destination of the components, owned by the caller
+		unsigned fields; ///< mask of the fields to read
+		double ref_delay; ///< the CIR's reference delay, set by the I/O thread
+		std::exception_ptr error; ///< exception thrown while serving the request
+		bool done; ///< set by the I/O thread when the request has been served
+	};
+
+	/**
+	 * \brief Main loop of the I/O thread.
+	 */
+	void serve_requests();
+
+	std::unique_ptr<ReadContinuousDelayFile> reader; ///< the underlying reader, only used with the HDF5 mutex held
+
+	cir_number_t nof_cirs; ///< the number of CIRs in the file
+	std::vector<std::string> link_names; ///< the link names
+	double cir_rate_Hz; ///< the CIR rate in Hz
+	double c0_m_s; ///< the speed of light in m/s
+	double transmitter_frequency_Hz; ///< the transmitter frequency in Hz
+
+	std::mutex requests_mutex; ///< protects requests, stop and the done flags of the requests
+	std::condition_variable requests_pending; ///< signaled when a request has been queued or the I/O thread has to stop
+	std::condition_variable requests_done; ///< signaled when a batch of requests has been served
+	std::vector<request_t*> requests; ///< requests waiting for the I/O thread
+	bool stop; ///< tells the I/O thread to stop
+	std::thread io_thread; ///< the I/O thread, not joinable if not used
+};
+
+} /* namespace CDX */
+
+#endif /* CDX_SHAREDREADCONTINUOUSDELAYFILE_H_ */
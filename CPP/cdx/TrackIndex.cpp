@@ -0,0 +1,118 @@
+/**
+ * \file	TrackIndex.cpp
+ *
+ * \brief	Creation of the component identifier index of continuous-delay CDX files.
+ */
+
+#include "TrackIndex.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include <boost/lexical_cast.hpp>
+
+using namespace std;
+
+namespace CDX {
+
+/**
+ * \brief Writes a 1D dataset of unsigned integers.
+ */
+template<typename T>
+static void write_vector(H5::Group &group, const char *name,
+		const H5::PredType &type, const vector<T> &data) {
+	const int RANK = 1;
+	hsize_t dims[RANK] = { data.size() };
+	H5::DataSpace dataspace(RANK, dims);
+
+	H5::DataSet dataset = group.createDataSet(name, type, dataspace);
+	if (data.size() > 0)
+		dataset.write(data.data(), type);
+}
+
+void write_track_index(H5::Group &link_group,
+		std::vector<track_entry_t> &entries) {
+	// entries are appended in CIR order, a stable sort keeps that order for each id:
+	stable_sort(entries.begin(), entries.end(),
+			[](const track_entry_t &a, const track_entry_t &b) {
+				return a.id < b.id;
+			});
+
+	vector<uint64_t> ids;
+	vector<uint64_t> offsets;
+	vector<uint64_t> cir_numbers(entries.size());
+	vector<uint32_t> components(entries.size());
+
+	for (size_t k = 0; k < entries.size(); k++) {
+		if (k == 0 or entries[k].id != entries[k - 1].id) {
+			ids.push_back(entries[k].id);
+			offsets.push_back(k);
+		}
+		cir_numbers[k] = entries[k].cir_number;
+		components[k] = entries[k].component;
+	}
+	offsets.push_back(entries.size());
+
+	if (H5Lexists(link_group.getId(), "track_index", H5P_DEFAULT) > 0)
+		link_group.unlink("track_index");
+
+	H5::Group index_group = link_group.createGroup("track_index");
+
+	write_vector(index_group, "ids", H5::PredType::NATIVE_UINT64, ids);
+	write_vector(index_group, "offsets", H5::PredType::NATIVE_UINT64, offsets);
+	write_vector(index_group, "cir_numbers", H5::PredType::NATIVE_UINT64,
+			cir_numbers);
+	write_vector(index_group, "components", H5::PredType::NATIVE_UINT32,
+			components);
+}
+
+void build_link_track_index(H5::Group &link_group) {
+	// compound type with the id member only, HDF5 converts just this member:
+	H5::CompType id_type(sizeof(uint64_t));
+	id_type.insertMember("id", 0, H5::PredType::NATIVE_UINT64);
+
+	H5::Group cirs_group = link_group.openGroup("cirs");
+
+	const hsize_t nof_cirs = cirs_group.getNumObjs();
+
+	vector<track_entry_t> entries;
+	vector<uint64_t> ids;
+
+	for (cir_number_t cir_number = 0; cir_number < nof_cirs; cir_number++) {
+		H5::DataSet dataset = cirs_group.openDataSet(
+				boost::lexical_cast<string>(cir_number));
+
+		ids.resize(dataset.getSpace().getSimpleExtentNpoints());
+		if (ids.size() > 0)
+			dataset.read(ids.data(), id_type);
+
+		for (size_t c = 0; c < ids.size(); c++) {
+			const track_entry_t entry = { ids[c], cir_number,
+					static_cast<uint32_t>(c) };
+			entries.push_back(entry);
+		}
+	}
+
+	write_track_index(link_group, entries);
+}
+
+void build_track_index(const std::string &file_name) {
+	H5::H5File h5file(file_name.c_str(), H5F_ACC_RDWR);
+
+	if (File::read_string_h5(h5file, "/parameters/delay_type")
+			!= "continuous-delay") {
+		throw logic_error(
+				"build_track_index: " + file_name
+						+ " is not a continuous-delay CDX file.");
+	}
+
+	H5::Group links_group = h5file.openGroup("/links");
+
+	for (hsize_t l = 0; l < links_group.getNumObjs(); l++) {
+		H5::Group link_group = links_group.openGroup(
+				links_group.getObjnameByIdx(l));
+		build_link_track_index(link_group);
+	}
+}
+
+} // end of namespace CDX
@@ -0,0 +1,64 @@
+/**
+ * \file	TrackIndex.h
+ *
+ * \brief	Secondary index from component identifiers to the CIRs they appear in.
+ */
+
+#ifndef CDX_TRACKINDEX_H_
+#define CDX_TRACKINDEX_H_
+
+#include "File.h"
+
+namespace CDX {
+
+/**
+ * \brief Position of one component in a continuous-delay CDX file.
+ */
+struct track_entry_t {
+	uint64_t id; ///< the component's identifier
+	cir_number_t cir_number; ///< number of the CIR that contains the component
+	uint32_t component; ///< index of the component inside its CIR
+};
+
+/**
+ * \brief Writes the track index of a link.
+ *
+ * The index is stored in the group \c track_index of the link and consists of the
+ * datasets
+ *
+ *  - \c ids: sorted unique component identifiers,
+ *  - \c offsets: for each identifier, the index of its first entry in the following two
+ *    datasets, with a final element holding the total number of entries, and
+ *  - \c cir_numbers and \c components: CIR number and component index of each entry,
+ *    sorted by identifier and CIR number.
+ *
+ * An existing index of the link is replaced.
+ *
+ * \param[in] link_group Group of the link
+ * \param[in,out] entries Positions of all components of the link, sorted in place
+ */
+void write_track_index(H5::Group &link_group,
+		std::vector<track_entry_t> &entries);
+
+/**
+ * \brief Builds the track index of a link from the identifiers of its CIRs.
+ *
+ * Only the \c id member of each CIR is read, and only the entries of this link are held
+ * in memory. An existing index of the link is replaced.
+ *
+ * \param[in] link_group Group of the link, opened for writing
+ */
+void build_link_track_index(H5::Group &link_group);
+
+/**
+ * \brief Builds the track indices of all links of an existing continuous-delay CDX file.
+ *
+ * Only the \c id member of each CIR is read. The file is opened for writing.
+ *
+ * \param[in] file_name File name
+ */
+void build_track_index(const std::string &file_name);
+
+} // end of namespace CDX
+
+#endif /* CDX_TRACKINDEX_H_ */
@@ -4,20 +4,121 @@
  */
 
 #include "WriteContinuousDelayFile.h"
+#include "ReadContinuousDelayFile.h"
 
+#include <algorithm>
+#include <cstdio>
 #include <iostream>
 #include <stdexcept>
+#include <limits>
 
 using namespace std;
 
 namespace CDX {
 
+const size_t WriteContinuousDelayFile::cirs_per_delay_bounds_block;
+const size_t WriteContinuousDelayFile::appended_components_per_chunk;
+
+/**
+ * \brief Appends elements to a one-dimensional dataset with unlimited dimension.
+ */
+static void append_to_dataset(H5::DataSet &dataset, const H5::DataType &type,
+		const void *data, size_t count) {
+	if (count == 0)
+		return;
+
+	hsize_t size;
+	dataset.getSpace().getSimpleExtentDims(&size);
+
+	const hsize_t new_size = size + count;
+	dataset.extend(&new_size);
+
+	H5::DataSpace fspace = dataset.getSpace();
+	const hsize_t hcount = count;
+	fspace.selectHyperslab(H5S_SELECT_SET, &hcount, &size);
+
+	dataset.write(data, type, H5::DataSpace(1, &hcount), fspace);
+}
+
+/**
+ * \brief Stores the CIRs appended to a link in SWMR mode as datasets of their own.
+ *
+ * Removes the datasets the CIRs were appended to, see
+ * WriteContinuousDelayFile::prepare_swmr_write. CIRs whose components are missing, because
+ * the writer crashed while flushing, are dropped.
+ */
+static void store_appended_cirs(H5::Group &link_group,
+		const H5::CompType &component_type) {
+	if (H5Lexists(link_group.getId(), "appended_cir_ends", H5P_DEFAULT) <= 0)
+		return;
+
+	H5::DataSet ends_dataset = link_group.openDataSet("appended_cir_ends");
+	H5::DataSet cirs_dataset = link_group.openDataSet("appended_cirs");
+
+	uint64_t first_cir;
+	ends_dataset.openAttribute("first_cir").read(H5::PredType::NATIVE_UINT64,
+			&first_cir);
+
+	hsize_t nof_cirs, nof_components;
+	ends_dataset.getSpace().getSimpleExtentDims(&nof_cirs);
+	cirs_dataset.getSpace().getSimpleExtentDims(&nof_components);
+
+	vector<uint64_t> ends(nof_cirs);
+	if (nof_cirs > 0)
+		ends_dataset.read(ends.data(), H5::PredType::NATIVE_UINT64);
+
+	while (nof_cirs > 0 and ends[nof_cirs - 1] > nof_components)
+		nof_cirs--;
+
+	H5::Group cirs_group = link_group.openGroup("cirs");
+	vector<hdf5_impulse_t> components;
+	char name[24];
+
+	// the components are read for a bounded number of CIRs at a time:
+	const size_t cirs_per_read = 1024;
+	for (size_t first = 0; first < nof_cirs; first += cirs_per_read) {
+		const size_t count = min<size_t>(cirs_per_read, nof_cirs - first);
+		const hsize_t start = first > 0 ? ends[first - 1] : 0;
+		const hsize_t size = ends[first + count - 1] - start;
+
+		components.resize(size);
+		if (size > 0) {
+			H5::DataSpace fspace = cirs_dataset.getSpace();
+			fspace.selectHyperslab(H5S_SELECT_SET, &size, &start);
+			cirs_dataset.read(components.data(), component_type,
+					H5::DataSpace(1, &size), fspace);
+		}
+
+		for (size_t n = first; n < first + count; n++) {
+			const hsize_t begin = n > 0 ? ends[n - 1] : 0;
+			const hsize_t dims[1] = { ends[n] - begin };
+
+			snprintf(name, sizeof(name), "%llu",
+					static_cast<unsigned long long>(first_cir + n));
+			H5::DataSet dataset = cirs_group.createDataSet(name, component_type,
+					H5::DataSpace(1, dims));
+			if (dims[0] > 0)
+				dataset.write(components.data() + (begin - start),
+						component_type);
+		}
+	}
+
+	ends_dataset.close();
+	cirs_dataset.close();
+	link_group.unlink("appended_cirs");
+	link_group.unlink("appended_cir_ends");
+}
+
 WriteContinuousDelayFile::WriteContinuousDelayFile(std::string _file_name,
 		double _c0_m_s, double _cir_rate_Hz, double _transmitter_frequency_Hz,
 		const std::vector<std::string> &_link_names,
-		links_to_component_types_t &_component_types) :
+		links_to_component_types_t &_component_types, bool _write_track_index,
+		const H5::FileAccPropList &_access_plist,
+		const writer_options_t &_options) :
 		WriteFile(_file_name, _c0_m_s, _cir_rate_Hz, _transmitter_frequency_Hz,
-				_link_names), component_types(_component_types) {
+				_link_names, _access_plist, _options), component_types(_component_types), nof_written_cirs(
+				0), max_nof_components(nof_links, 0), track_index_enabled(_write_track_index), closed(false), writer_busy(false), stop_writer(
+				false) {
 
 	// write CDX file type to HDF5 file:
 	write("/parameters/delay_type", "continuous-delay");
@@ -37,17 +138,83 @@ WriteContinuousDelayFile::WriteContinuousDelayFile(std::string _file_name,
 		throw runtime_error(
 				"WriteContinuousDelayFile: link_names.size() is zero");
 
+
 	// creating groups for links and cirs:
-	for (auto link_name : link_names) {
+	for (size_t k = 0; k < nof_links; k++) {
+		const string &link_name = link_names[k];
+
 		H5::Group *new_cir_group = new H5::Group(
-				link_groups[link_name]->createGroup("cirs"));
-		group_cirs[link_name] = new_cir_group;
+				create_group(*link_groups[k], "cirs"));
+		group_cirs.push_back(new_cir_group);
 
 		// write component types to file for each link:
-		write(link_groups[link_name], "component_types",
-				component_types[link_name]);
+		write(link_groups[k], "component_types", component_types[link_name]);
+
+		// create dataset for the minimum and maximum delay of each block of CIRs:
+		const int RANK = 2;
+		hsize_t dims[RANK] = { 0, 2 };
+		hsize_t maxdims[RANK] = { H5S_UNLIMITED, 2 };
+		H5::DataSpace dataspace(RANK, dims, maxdims);
+
+		H5::DSetCreatPropList cparms;
+		hsize_t chunk_dims[RANK] = { cirs_per_delay_bounds_block, 2 };
+		cparms.setChunk(RANK, chunk_dims);
+
+		H5::DataSet dataset = link_groups[k]->createDataSet("delay_bounds",
+				H5::PredType::NATIVE_DOUBLE, dataspace, cparms);
+
+		const uint64_t cirs_per_block = cirs_per_delay_bounds_block;
+		H5::Attribute attribute = dataset.createAttribute("cirs_per_block",
+				H5::PredType::NATIVE_UINT64, H5::DataSpace(H5S_SCALAR));
+		attribute.write(H5::PredType::NATIVE_UINT64, &cirs_per_block);
+
+		block_delay_bounds.push_back(
+				make_pair(numeric_limits<double>::infinity(),
+						-numeric_limits<double>::infinity()));
+	}
+
+	create_component_types();
+	write_link_layouts();
+}
+
+WriteContinuousDelayFile::WriteContinuousDelayFile(std::string _file_name,
+		bool _write_track_index, const H5::FileAccPropList &_access_plist) :
+		WriteFile(_file_name, _access_plist), nof_written_cirs(0), track_index_enabled(
+				_write_track_index), closed(false), writer_busy(false), stop_writer(
+				false) {
+	if (delay_type != "continuous-delay")
+		throw runtime_error(
+				"WriteContinuousDelayFile: " + file_name
+						+ " is not a continuous-delay file.");
+
+	create_component_types();
+
+	cir_number_t nof_complete_cirs = numeric_limits<cir_number_t>::max();
+	for (size_t k = 0; k < nof_links; k++) {
+		store_appended_cirs(*link_groups[k], *cp_cmplx);
+
+		group_cirs.push_back(new H5::Group(link_groups[k]->openGroup("cirs")));
+		nof_complete_cirs = min(nof_complete_cirs, count_complete_cirs(k));
+	}
+
+	// appended CIRs store times only if the file does, see writer_options_t::track_times:
+	if (nof_links > 0) {
+		const hid_t create_plist = H5Gget_create_plist(group_cirs[0]->getId());
+		hbool_t track_times = true;
+		H5Pget_obj_track_times(create_plist, &track_times);
+		H5Pclose(create_plist);
+		H5Pset_obj_track_times(cir_create_plist.getId(), track_times);
 	}
 
+	for (size_t k = 0; k < nof_links; k++)
+		truncate_link(k, nof_complete_cirs);
+
+	nof_written_cirs = nof_complete_cirs;
+	restore_cir_state();
+	write_link_layouts();
+}
+
+void WriteContinuousDelayFile::create_component_types() {
 	cp_cmplx = new H5::CompType(sizeof(hdf5_impulse_t));
 	cp_cmplx->insertMember("type", HOFFSET(hdf5_impulse_t, type),
 			H5::PredType::NATIVE_INT16);
@@ -59,71 +226,802 @@ WriteContinuousDelayFile::WriteContinuousDelayFile(std::string _file_name,
 			H5::PredType::NATIVE_DOUBLE);
 	cp_cmplx->insertMember("imag", HOFFSET(hdf5_impulse_t, imag),
 			H5::PredType::NATIVE_DOUBLE);
+
+	for (size_t field = 0; field < nof_component_fields; field++)
+		cp_fields.push_back(get_component_field_type(field));
+}
+
+cir_number_t WriteContinuousDelayFile::count_complete_cirs(size_t link_index) {
+	hsize_t nof_reference_delays;
+	link_groups[link_index]->openDataSet("reference_delays").getSpace().getSimpleExtentDims(
+			&nof_reference_delays);
+
+	cir_number_t nof_cirs = min<cir_number_t>(nof_reference_delays,
+			group_cirs[link_index]->getNumObjs());
+
+	// the datasets are created in order, so the CIRs of a crashed writer can only be
+	// missing at the end:
+	while (nof_cirs > 0) {
+		snprintf(name_buffer, sizeof(name_buffer), "%llu",
+				static_cast<unsigned long long>(nof_cirs - 1));
+		if (H5Lexists(group_cirs[link_index]->getId(), name_buffer, H5P_DEFAULT)
+				> 0)
+			break;
+		nof_cirs--;
+	}
+
+	return nof_cirs;
+}
+
+void WriteContinuousDelayFile::truncate_link(size_t link_index,
+		cir_number_t nof_cirs) {
+	H5::Group &cirs_group = *group_cirs[link_index];
+
+	if (cirs_group.getNumObjs() > nof_cirs) {
+		vector<string> names;
+		for (hsize_t i = 0; i < cirs_group.getNumObjs(); i++) {
+			const string name = cirs_group.getObjnameByIdx(i);
+			if (stoull(name) >= nof_cirs)
+				names.push_back(name);
+		}
+
+		for (const auto &name : names)
+			cirs_group.unlink(name);
+	}
+
+	H5::Group &link_group = *link_groups[link_index];
+
+	const hsize_t nof_reference_delays = nof_cirs;
+	link_group.openDataSet("reference_delays").extend(&nof_reference_delays);
+
+	const hsize_t delay_bounds_dims[2] = { (nof_cirs
+			+ cirs_per_delay_bounds_block - 1) / cirs_per_delay_bounds_block, 2 };
+	link_group.openDataSet("delay_bounds").extend(delay_bounds_dims);
+
+	// the index is written anew on closing if it is enabled:
+	if (H5Lexists(link_group.getId(), "track_index", H5P_DEFAULT) > 0)
+		link_group.unlink("track_index");
+}
+
+void WriteContinuousDelayFile::restore_cir_state() {
+	const cir_number_t block_start = nof_written_cirs
+			- nof_written_cirs % cirs_per_delay_bounds_block;
+
+	for (size_t k = 0; k < nof_links; k++) {
+		pair<double, double> bounds(numeric_limits<double>::infinity(),
+				-numeric_limits<double>::infinity());
+
+		// files of older versions do not store the largest number of components:
+		const link_layout_t layout = read_link_layout(*link_groups[k]);
+		max_nof_components.push_back(
+				layout.available ? layout.max_nof_components : 0);
+
+		// the largest number of components of files without layout needs all CIRs, the
+		// delay bounds those of the last block:
+		const cir_number_t first_cir = layout.available ? block_start : 0;
+		for (cir_number_t n = first_cir; n < nof_written_cirs; n++) {
+			snprintf(name_buffer, sizeof(name_buffer), "%llu",
+					static_cast<unsigned long long>(n));
+			H5::DataSet dataset = group_cirs[k]->openDataSet(name_buffer);
+
+			hsize_t nof_components;
+			dataset.getSpace().getSimpleExtentDims(&nof_components);
+			max_nof_components[k] = max<uint64_t>(max_nof_components[k],
+					nof_components);
+			conversion_buffer.resize(nof_components);
+			if (nof_components > 0)
+				dataset.read(conversion_buffer.data(), *cp_cmplx);
+
+			if (n >= block_start)
+				for (size_t i = 0; i < nof_components; i++) {
+					bounds.first = min(bounds.first, conversion_buffer[i].delay);
+					bounds.second = max(bounds.second,
+							conversion_buffer[i].delay);
+				}
+		}
+
+		block_delay_bounds.push_back(bounds);
+	}
 }
 
 void WriteContinuousDelayFile::write_cir(
 		std::map<std::string, components_t> cirs,
 		std::map<std::string, double> reference_delays,
 		cir_number_t cir_number) {
+	check_cir_sizes(cirs.size(), reference_delays.size());
+
+	vector<components_t> cirs_by_index(nof_links);
+	for (auto &cir : cirs)
+		cirs_by_index[get_link_index(cir.first)].swap(cir.second);
+
+	vector<double> reference_delays_by_index(nof_links);
+	for (const auto &reference_delay : reference_delays)
+		reference_delays_by_index[get_link_index(reference_delay.first)] =
+				reference_delay.second;
+
+	write_cir(std::move(cirs_by_index), std::move(reference_delays_by_index),
+			cir_number);
+}
+
+void WriteContinuousDelayFile::write_cir(const std::vector<components_t> &cirs,
+		const std::vector<double> &reference_delays, cir_number_t cir_number) {
+	check_open("WriteContinuousDelayFile::write_cir");
+	check_cir_sizes(cirs.size(), reference_delays.size());
 
-	if (cirs.size() != nof_links) {
+	if (writer_thread.joinable()) {
+		queue_cir(vector<components_t>(cirs), vector<double>(reference_delays),
+				cir_number);
+		return;
+	}
+
+	for (size_t k = 0; k < nof_links; k++) {
+		// write reference delay:
+		store_reference_delays(k, &reference_delays[k], 1);
+
+		// write CIR:
+		write_components(k, cirs[k], cir_number);
+	}
+
+	finish_cir();
+	flush_file_if_due(1);
+}
+
+void WriteContinuousDelayFile::write_cir(std::vector<components_t> &&cirs,
+		std::vector<double> &&reference_delays, cir_number_t cir_number) {
+	if (writer_thread.joinable()) {
+		check_open("WriteContinuousDelayFile::write_cir");
+		check_cir_sizes(cirs.size(), reference_delays.size());
+		queue_cir(std::move(cirs), std::move(reference_delays), cir_number);
+		return;
+	}
+
+	const vector<components_t> &const_cirs = cirs;
+	const vector<double> &const_reference_delays = reference_delays;
+	write_cir(const_cirs, const_reference_delays, cir_number);
+}
+
+void WriteContinuousDelayFile::write_cir(const std::vector<ComponentsSoA> &cirs,
+		const std::vector<double> &reference_delays, cir_number_t cir_number) {
+	check_open("WriteContinuousDelayFile::write_cir");
+	check_cir_sizes(cirs.size(), reference_delays.size());
+
+	if (writer_thread.joinable()) {
+		vector<components_t> converted_cirs(nof_links);
+		for (size_t k = 0; k < nof_links; k++)
+			to_components(cirs[k], converted_cirs[k]);
+
+		queue_cir(std::move(converted_cirs), vector<double>(reference_delays),
+				cir_number);
+		return;
+	}
+
+	for (size_t k = 0; k < nof_links; k++) {
+		store_reference_delays(k, &reference_delays[k], 1);
+		write_components(k, cirs[k], cir_number);
+	}
+
+	finish_cir();
+	flush_file_if_due(1);
+}
+
+void WriteContinuousDelayFile::copy_cirs(ReadContinuousDelayFile &cdx_in,
+		const std::vector<size_t> &input_link_indices, cir_number_t first_cir,
+		size_t count) {
+	check_open("WriteContinuousDelayFile::copy_cirs");
+
+	if (input_link_indices.size() != nof_links) {
 		stringstream msg;
-		msg << "error: Number of provided CIRs (" << cirs.size()
+		msg << "WriteContinuousDelayFile::copy_cirs: number of input links ("
+				<< input_link_indices.size()
+				<< ") does not match number of links in file (" << nof_links
+				<< ").";
+		throw logic_error(msg.str());
+	}
+
+	if (first_cir > cdx_in.get_nof_cirs()
+			or count > cdx_in.get_nof_cirs() - first_cir) {
+		stringstream msg;
+		msg << "WriteContinuousDelayFile::copy_cirs: CIRs " << first_cir
+				<< " to " << first_cir + count
+				<< " (excluding) are not inside the input file.";
+		throw logic_error(msg.str());
+	}
+
+	if (swmr_write_enabled)
+		throw logic_error(
+				"WriteContinuousDelayFile::copy_cirs: datasets cannot be copied in SWMR mode.");
+
+	vector<H5::Group> input_cir_groups;
+	for (size_t input_link_index : input_link_indices)
+		input_cir_groups.push_back(
+				cdx_in.get_file_handle().openGroup(
+						"/links/" + cdx_in.get_link_name(input_link_index)
+								+ "/cirs"));
+
+	// CIRs queued before have to be written before the copied ones:
+	flush();
+
+	vector<double> reference_delays;
+	cir_block_t block;
+	ComponentsSoA components;
+	char input_name[24];
+
+	cir_number_t input_cir = first_cir;
+	const cir_number_t end_cir = first_cir + count;
+	while (input_cir < end_cir) {
+		// the CIRs are copied in segments that end at the end of a block of this file, so
+		// the delay bounds of a segment belong to a single block:
+		const size_t nof_segment_cirs = min<cir_number_t>(end_cir - input_cir,
+				cirs_per_delay_bounds_block
+						- nof_written_cirs % cirs_per_delay_bounds_block);
+
+		for (size_t k = 0; k < nof_links; k++) {
+			const size_t input_link_index = input_link_indices[k];
+
+			reference_delays.resize(nof_segment_cirs);
+			cdx_in.get_reference_delays(input_link_index, input_cir,
+					nof_segment_cirs, reference_delays.data());
+			store_reference_delays(k, reference_delays.data(),
+					nof_segment_cirs);
+
+			pair<double, double> &bounds = block_delay_bounds[k];
+			double min_delay, max_delay;
+			unsigned fields = 0;
+			if (cdx_in.get_delay_bounds(input_link_index, input_cir,
+					nof_segment_cirs, min_delay, max_delay)) {
+				bounds.first = min(bounds.first, min_delay);
+				bounds.second = max(bounds.second, max_delay);
+			} else
+				fields |= fields_delay;
+
+			// the sizes of the CIRs come from the CIRs read anyway, otherwise from the
+			// layout of the input link, which bounds them, or from reading the smallest
+			// member:
+			const link_layout_t &input_layout = cdx_in.get_link_layout(
+					input_link_index);
+			if (fields == 0 and input_layout.available)
+				max_nof_components[k] = max(max_nof_components[k],
+						input_layout.max_nof_components);
+			else if (fields == 0)
+				fields = fields_type;
+
+			if (fields != 0) {
+				cdx_in.read_cirs(input_link_index, input_cir, nof_segment_cirs,
+						block, fields);
+
+				for (size_t n = 0; n < nof_segment_cirs; n++) {
+					max_nof_components[k] = max<uint64_t>(max_nof_components[k],
+							block.offsets[n + 1] - block.offsets[n]);
+
+					if (fields & fields_delay)
+						for (size_t i = block.offsets[n];
+								i < block.offsets[n + 1]; i++) {
+							bounds.first = min(bounds.first, block.delays[i]);
+							bounds.second = max(bounds.second, block.delays[i]);
+						}
+				}
+			}
+
+			const cir_number_t nof_stored_cirs = cdx_in.get_nof_stored_cirs(
+					input_link_index);
+
+			for (size_t n = 0; n < nof_segment_cirs; n++) {
+				// CIRs appended in SWMR mode have no dataset that could be copied:
+				if (input_cir + n >= nof_stored_cirs) {
+					cdx_in.read_cir(input_link_index, input_cir + n, components);
+					write_components(k, components, nof_written_cirs + n);
+					continue;
+				}
+
+				snprintf(input_name, sizeof(input_name), "%llu",
+						static_cast<unsigned long long>(input_cir + n));
+				snprintf(name_buffer, sizeof(name_buffer), "%llu",
+						static_cast<unsigned long long>(nof_written_cirs + n));
+
+				if (H5Ocopy(input_cir_groups[k].getId(), input_name,
+						group_cirs[k]->getId(), name_buffer, H5P_DEFAULT,
+						H5P_DEFAULT) < 0) {
+					stringstream msg;
+					msg << "WriteContinuousDelayFile::copy_cirs: copying CIR "
+							<< input_cir + n << " of link "
+							<< cdx_in.get_link_name(input_link_index)
+							<< " failed.";
+					throw runtime_error(msg.str());
+				}
+			}
+		}
+
+		for (size_t n = 0; n < nof_segment_cirs; n++)
+			finish_cir();
+
+		input_cir += nof_segment_cirs;
+	}
+}
+
+void WriteContinuousDelayFile::check_cir_sizes(size_t nof_cirs,
+		size_t nof_reference_delays) const {
+	if (nof_cirs != nof_links) {
+		stringstream msg;
+		msg << "error: Number of provided CIRs (" << nof_cirs
 				<< ") does not match number of links in file (" << nof_links
 				<< ").";
 		throw runtime_error(msg.str());
 	}
 
-	if (reference_delays.size() != nof_links) {
+	if (nof_reference_delays != nof_links) {
 		stringstream msg;
 		msg << "error: Number of provided reference delays ("
-				<< reference_delays.size()
+				<< nof_reference_delays
 				<< ") does not match number of links in file (" << nof_links
 				<< ").";
 		throw logic_error(msg.str());
 	}
+}
 
-	for (auto cir : cirs) {
-		const string link_name = cir.first;
+void WriteContinuousDelayFile::queue_cir(std::vector<components_t> &&cirs,
+		std::vector<double> &&reference_delays, cir_number_t cir_number) {
+	unique_lock<mutex> lock(queue_mutex);
 
-		// write reference delay:
-		append_reference_delay(link_groups[link_name],
-				reference_delays[link_name]);
+	if (writer_error)
+		rethrow_exception(writer_error);
 
-		// write CIR:
-		const vector<CDX::impulse_t> impulses = cir.second;
+	if (queue.size() >= async_stats.queue_depth) {
+		async_stats.nof_blocked_calls++;
+		queue_changed.wait(lock,
+				[this] {return queue.size() < async_stats.queue_depth or writer_error;});
+		if (writer_error)
+			rethrow_exception(writer_error);
+	}
+
+	queued_cir_t queued_cir;
+	queued_cir.cirs.swap(cirs);
+	queued_cir.reference_delays.swap(reference_delays);
+	queued_cir.cir_number = cir_number;
+	queued_cir.queue_time = chrono::steady_clock::now();
+	queue.push_back(std::move(queued_cir));
+
+	async_stats.nof_queued_cirs++;
+	async_stats.max_queue_occupancy = max(async_stats.max_queue_occupancy,
+			queue.size());
+
+	lock.unlock();
+	queue_changed.notify_all();
+}
+
+void WriteContinuousDelayFile::write_components(size_t link_index,
+		const components_t &impulses, cir_number_t cir_number) {
+	// the buffer only allocates memory if the CIR is larger than all CIRs before:
+	conversion_buffer.resize(impulses.size());
+
+	for (size_t i = 0; i < impulses.size(); i++) {
+		conversion_buffer[i].type = impulses[i].type;
+		conversion_buffer[i].id = impulses[i].id;
+		conversion_buffer[i].delay = impulses[i].delay;
+		conversion_buffer[i].real = impulses[i].amplitude.real();
+		conversion_buffer[i].imag = impulses[i].amplitude.imag();
+	}
 
-		stringstream dsName;
-		dsName << cir_number;
+	max_nof_components[link_index] = max<uint64_t>(
+			max_nof_components[link_index], impulses.size());
 
-		hdf5_impulse_t wdata[impulses.size()];
+	if (swmr_write_enabled) {
+		vector<hdf5_impulse_t> &pending = pending_components[link_index];
+		pending.insert(pending.end(), conversion_buffer.begin(),
+				conversion_buffer.end());
+		pending_ends[link_index].push_back(
+				nof_appended_components[link_index] + pending.size());
+	} else {
+		snprintf(name_buffer, sizeof(name_buffer), "%llu",
+				static_cast<unsigned long long>(cir_number));
 
 		const size_t RANK = 1;
 		hsize_t dimsf3[RANK]; // dataset dimensions
 		dimsf3[0] = impulses.size();
 		H5::DataSpace dspace3(RANK, dimsf3);
 
-		H5::DataSet dset3 = group_cirs[link_name]->createDataSet(
-				dsName.str().c_str(), *cp_cmplx, dspace3);
+		H5::DataSet dset3 = group_cirs[link_index]->createDataSet(name_buffer,
+				*cp_cmplx, dspace3, cir_create_plist);
+		dset3.write(conversion_buffer.data(), *cp_cmplx);
+	}
+
+	// update delay bounds of the current block:
+	pair<double, double> &bounds = block_delay_bounds[link_index];
+	for (size_t i = 0; i < impulses.size(); i++) {
+		bounds.first = min(bounds.first, impulses[i].delay);
+		bounds.second = max(bounds.second, impulses[i].delay);
+	}
+}
+
+void WriteContinuousDelayFile::write_components(size_t link_index,
+		const ComponentsSoA &impulses, cir_number_t cir_number) {
+	max_nof_components[link_index] = max<uint64_t>(
+			max_nof_components[link_index], impulses.size());
 
+	if (swmr_write_enabled) {
+		vector<hdf5_impulse_t> &pending = pending_components[link_index];
 		for (size_t i = 0; i < impulses.size(); i++) {
-			wdata[i].type = impulses.at(i).type;
-			wdata[i].id = impulses.at(i).id;
-			wdata[i].delay = impulses.at(i).delay;
-			wdata[i].real = impulses.at(i).amplitude.real();
-			wdata[i].imag = impulses.at(i).amplitude.imag();
+			const hdf5_impulse_t component = { impulses.types[i],
+					impulses.ids[i], impulses.delays[i], impulses.reals[i],
+					impulses.imags[i] };
+			pending.push_back(component);
+		}
+		pending_ends[link_index].push_back(
+				nof_appended_components[link_index] + pending.size());
+	} else {
+		snprintf(name_buffer, sizeof(name_buffer), "%llu",
+				static_cast<unsigned long long>(cir_number));
+
+		const hsize_t dims[1] = { impulses.size() };
+		H5::DataSet dataset = group_cirs[link_index]->createDataSet(name_buffer,
+				*cp_cmplx, H5::DataSpace(1, dims), cir_create_plist);
+
+		if (impulses.size() > 0) {
+			set_conversion_buffer(field_xfer, impulses.size());
+
+			for (size_t field = 0; field < nof_component_fields; field++)
+				dataset.write(impulses.get_field_data(field), cp_fields[field],
+						H5::DataSpace::ALL, H5::DataSpace::ALL, field_xfer);
+		}
+	}
+
+	// update delay bounds of the current block:
+	pair<double, double> &bounds = block_delay_bounds[link_index];
+	for (size_t i = 0; i < impulses.size(); i++) {
+		bounds.first = min(bounds.first, impulses.delays[i]);
+		bounds.second = max(bounds.second, impulses.delays[i]);
+	}
+}
+
+void WriteContinuousDelayFile::finish_cir() {
+	nof_written_cirs++;
+
+	// block complete, write its delay bounds:
+	if (nof_written_cirs % cirs_per_delay_bounds_block == 0) {
+		for (size_t k = 0; k < nof_links; k++) {
+			write_delay_bounds(k);
+			block_delay_bounds[k] = make_pair(
+					numeric_limits<double>::infinity(),
+					-numeric_limits<double>::infinity());
+		}
+	}
+}
+
+void WriteContinuousDelayFile::enable_async_writer(size_t queue_depth) {
+	check_open("WriteContinuousDelayFile::enable_async_writer");
+
+	if (queue_depth == 0)
+		throw logic_error(
+				"WriteContinuousDelayFile::enable_async_writer: queue_depth must be at least 1.");
+
+	if (writer_thread.joinable())
+		throw logic_error(
+				"WriteContinuousDelayFile::enable_async_writer: asynchronous writer is already enabled.");
+
+	async_stats = async_write_stats_t();
+	async_stats.queue_depth = queue_depth;
+
+	writer_thread = thread(&WriteContinuousDelayFile::write_queued_cirs, this);
+}
+
+void WriteContinuousDelayFile::flush() {
+	if (not writer_thread.joinable())
+		return;
+
+	unique_lock<mutex> lock(queue_mutex);
+	queue_changed.wait(lock,
+			[this] {return (queue.empty() and not writer_busy) or writer_error;});
+
+	if (writer_error)
+		rethrow_exception(writer_error);
+}
+
+async_write_stats_t WriteContinuousDelayFile::get_async_write_stats() {
+	lock_guard<mutex> lock(queue_mutex);
+	async_write_stats_t stats = async_stats;
+	stats.queue_occupancy = queue.size();
+	return stats;
+}
+
+void WriteContinuousDelayFile::write_queued_cirs() {
+	deque<queued_cir_t> batch;
+	vector<vector<double> > batch_reference_delays(nof_links);
+
+	while (true) {
+		{
+			unique_lock<mutex> lock(queue_mutex);
+			writer_busy = false;
+			queue_changed.notify_all();
+
+			queue_changed.wait(lock,
+					[this] {return stop_writer or not queue.empty();});
+
+			if (queue.empty())
+				return; // stop has been requested and all CIRs have been written
+
+			batch.swap(queue);
+			writer_busy = true;
+		}
+		queue_changed.notify_all(); // the queue has room again
+
+		try {
+			lock_guard<mutex> hdf5_lock(get_hdf5_mutex());
+
+			for (const auto &queued_cir : batch) {
+				for (size_t k = 0; k < nof_links; k++)
+					write_components(k, queued_cir.cirs[k],
+							queued_cir.cir_number);
+
+				// the reference delays are kept for each CIR that is counted:
+				for (size_t k = 0; k < nof_links; k++)
+					batch_reference_delays[k].push_back(
+							queued_cir.reference_delays[k]);
+
+				finish_cir();
+			}
+
+			// the reference delays of the batch are appended at once:
+			store_batch_reference_delays(batch_reference_delays);
+
+			flush_file_if_due(batch.size());
+		} catch (...) {
+			// the CIRs of the batch written before the error get their reference delays,
+			// a further error is not reported, close does not complete the file anyway:
+			try {
+				lock_guard<mutex> hdf5_lock(get_hdf5_mutex());
+				store_batch_reference_delays(batch_reference_delays);
+			} catch (...) {
+			}
+
+			lock_guard<mutex> lock(queue_mutex);
+			writer_error = current_exception();
+			queue.clear();
+			writer_busy = false;
+			queue_changed.notify_all();
+			return;
+		}
+
+		const auto now = chrono::steady_clock::now();
+
+		{
+			lock_guard<mutex> lock(queue_mutex);
+			for (const auto &queued_cir : batch) {
+				const double latency_s = chrono::duration<double>(
+						now - queued_cir.queue_time).count();
+				async_stats.total_latency_s += latency_s;
+				async_stats.max_latency_s = max(async_stats.max_latency_s,
+						latency_s);
+			}
+			async_stats.nof_written_cirs += batch.size();
+			async_stats.nof_batches++;
 		}
 
-		dset3.write(wdata, *cp_cmplx);
+		batch.clear();
+	}
+}
+
+void WriteContinuousDelayFile::store_batch_reference_delays(
+		std::vector<std::vector<double> > &reference_delays) {
+	for (size_t k = 0; k < nof_links; k++) {
+		store_reference_delays(k, reference_delays[k].data(),
+				reference_delays[k].size());
+		reference_delays[k].clear();
+	}
+}
+
+void WriteContinuousDelayFile::stop_async_writer() {
+	if (not writer_thread.joinable())
+		return;
+
+	{
+		lock_guard<mutex> lock(queue_mutex);
+		stop_writer = true;
+	}
+	queue_changed.notify_all();
+	writer_thread.join();
+}
+
+void WriteContinuousDelayFile::check_open(const char *function) const {
+	if (closed)
+		throw logic_error(string(function) + ": the file has been closed.");
+}
+
+void WriteContinuousDelayFile::write_delay_bounds(size_t link_index) {
+	if (nof_written_cirs == 0)
+		return;
+
+	const hsize_t block = (nof_written_cirs - 1) / cirs_per_delay_bounds_block;
+
+	H5::DataSet dataset = link_groups[link_index]->openDataSet("delay_bounds");
+
+	const int RANK = 2;
+	hsize_t dims[RANK];
+	dataset.getSpace().getSimpleExtentDims(dims);
+
+	if (dims[0] < block + 1) {
+		hsize_t new_size[RANK] = { block + 1, 2 };
+		dataset.extend(new_size);
 	}
+
+	H5::DataSpace fspace = dataset.getSpace();
+	hsize_t offset[RANK] = { block, 0 };
+	hsize_t count[RANK] = { 1, 2 };
+	fspace.selectHyperslab(H5S_SELECT_SET, count, offset);
+
+	H5::DataSpace mspace(RANK, count);
+
+	const pair<double, double> &bounds = block_delay_bounds[link_index];
+	const double data[2] = { bounds.first, bounds.second };
+	dataset.write(data, H5::PredType::NATIVE_DOUBLE, mspace, fspace);
+}
+
+void WriteContinuousDelayFile::sync() {
+	check_open("WriteContinuousDelayFile::sync");
+	flush();
+	flush_file();
+}
+
+std::vector<char> WriteContinuousDelayFile::get_file_image() {
+	check_open("WriteContinuousDelayFile::get_file_image");
+
+	if (swmr_write_enabled)
+		throw logic_error(
+				"WriteContinuousDelayFile::get_file_image: not available in SWMR mode.");
+
+	flush();
+
+	if (track_index_enabled)
+		for (size_t k = 0; k < nof_links; k++)
+			build_link_track_index(*link_groups[k]);
+
+	return WriteFile::get_file_image();
+}
+
+void WriteContinuousDelayFile::prepare_swmr_write() {
+	// the writer thread must not append while the datasets are created:
+	flush();
+
+	// the CIRs written so far are stored in their final layout:
+	write_link_layouts();
+
+	for (size_t k = 0; k < nof_links; k++) {
+		const hsize_t dims[1] = { 0 };
+		const hsize_t maxdims[1] = { H5S_UNLIMITED };
+		H5::DataSpace space(1, dims, maxdims);
+
+		H5::DSetCreatPropList cirs_plist;
+		const hsize_t cirs_chunk[1] = { appended_components_per_chunk };
+		cirs_plist.setChunk(1, cirs_chunk);
+		appended_cirs_datasets.push_back(
+				link_groups[k]->createDataSet("appended_cirs", *cp_cmplx, space,
+						cirs_plist));
+
+		H5::DSetCreatPropList ends_plist;
+		const hsize_t ends_chunk[1] = { cirs_per_delay_bounds_block };
+		ends_plist.setChunk(1, ends_chunk);
+		appended_ends_datasets.push_back(
+				link_groups[k]->createDataSet("appended_cir_ends",
+						H5::PredType::NATIVE_UINT64, space, ends_plist));
+
+		const uint64_t first_cir = nof_written_cirs;
+		appended_ends_datasets.back().createAttribute("first_cir",
+				H5::PredType::NATIVE_UINT64, H5::DataSpace()).write(
+				H5::PredType::NATIVE_UINT64, &first_cir);
+	}
+
+	pending_components.resize(nof_links);
+	pending_ends.resize(nof_links);
+	nof_appended_components.assign(nof_links, 0);
+}
+
+void WriteContinuousDelayFile::append_pending_cirs() {
+	for (size_t k = 0; k < nof_links; k++) {
+		// the components are appended first, so every end refers to written components:
+		append_to_dataset(appended_cirs_datasets[k], *cp_cmplx,
+				pending_components[k].data(), pending_components[k].size());
+		append_to_dataset(appended_ends_datasets[k],
+				H5::PredType::NATIVE_UINT64, pending_ends[k].data(),
+				pending_ends[k].size());
+
+		nof_appended_components[k] += pending_components[k].size();
+		pending_components[k].clear();
+		pending_ends[k].clear();
+	}
+}
+
+void WriteContinuousDelayFile::write_derived_data() {
+	// the delay bounds of complete blocks have been written by finish_cir:
+	if (nof_written_cirs % cirs_per_delay_bounds_block != 0)
+		for (size_t k = 0; k < nof_links; k++)
+			write_delay_bounds(k);
+
+	// the layout describes the CIRs stored as datasets of their own, see close:
+	if (not swmr_write_enabled)
+		write_link_layouts();
+}
+
+link_layout_t WriteContinuousDelayFile::get_written_layout(
+		size_t link_index) const {
+	link_layout_t layout;
+	layout.nof_cirs = nof_written_cirs;
+	layout.max_nof_components = max_nof_components[link_index];
+	layout.sample_type = "impulse";
+	return layout;
+}
+
+void WriteContinuousDelayFile::write_link_layouts() {
+	for (size_t k = 0; k < nof_links; k++)
+		write_link_layout(*link_groups[k], get_written_layout(k));
 }
 
 WriteContinuousDelayFile::~WriteContinuousDelayFile() {
+	try {
+		close();
+	} catch (exception &e) {
+		cerr << "WriteContinuousDelayFile: closing " << file_name << " failed: "
+				<< e.what() << endl;
+	} catch (H5::Exception &e) {
+		cerr << "WriteContinuousDelayFile: closing " << file_name << " failed: "
+				<< e.getDetailMsg() << endl;
+	} catch (...) {
+		cerr << "WriteContinuousDelayFile: closing " << file_name << " failed."
+				<< endl;
+	}
+
 	// close cirs groups which were opened in constructor
-	for (const auto link_name : link_names)
-		delete group_cirs[link_name];
+	for (auto group_cir : group_cirs)
+		delete group_cir;
 
 	delete cp_cmplx;
 }
 
+void WriteContinuousDelayFile::close() {
+	if (closed)
+		return;
+
+	// an error of close is not repeated by the destructor:
+	closed = true;
+
+	// write all queued CIRs before closing the file:
+	stop_async_writer();
+
+	// write delay bounds of the last, incomplete block:
+	if (nof_written_cirs % cirs_per_delay_bounds_block != 0)
+		for (size_t k = 0; k < nof_links; k++)
+			write_delay_bounds(k);
+
+	if (swmr_write_enabled) {
+		// readers may have the file open, so the appended CIRs stay where they are and
+		// the layout describes the CIRs stored before, see compact_continuous_delay_file:
+		flush_file();
+
+		appended_cirs_datasets.clear();
+		appended_ends_datasets.clear();
+	} else if (not writer_error) {
+		// after an error of the writer thread, the CIRs queued after it are lost, so the
+		// layout and the track index are not written for the incomplete file. Readers count
+		// the CIRs, as the layout does not match the number of reference delays:
+		write_link_layouts();
+
+		if (track_index_enabled)
+			for (size_t k = 0; k < nof_links; k++)
+				build_link_track_index(*link_groups[k]);
+	}
+
+	for (auto group_cir : group_cirs)
+		delete group_cir;
+	group_cirs.clear();
+	close_file();
+
+	if (writer_error)
+		rethrow_exception(writer_error);
+}
+
+void compact_continuous_delay_file(const std::string &file_name,
+		bool write_track_index) {
+	// the constructor that resumes a file stores the appended CIRs as datasets of their
+	// own, closing writes the layout and the track index:
+	WriteContinuousDelayFile cdx_out(file_name, write_track_index);
+	cdx_out.close();
+}
+
 } // end of namespace CDX
@@ -6,11 +6,46 @@
 #ifndef WriteContinuousDelayCDXFile_H_
 #define WriteContinuousDelayCDXFile_H_
 
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+
 #include "WriteFile.h"
+#include "TrackIndex.h"
+#include "ComponentsSoA.h"
 
 namespace CDX {
 
-typedef uint64_t cir_number_t;
+class ReadContinuousDelayFile;
+
+/**
+ * \brief Counters of the asynchronous writer of a WriteContinuousDelayFile.
+ */
+struct async_write_stats_t {
+	async_write_stats_t() :
+			queue_depth(0), queue_occupancy(0), max_queue_occupancy(0), nof_queued_cirs(
+					0), nof_written_cirs(0), nof_batches(0), nof_blocked_calls(
+					0), total_latency_s(0.0), max_latency_s(0.0) {
+	}
+
+	/** returns the mean time in s from queuing a CIR until it was written */
+	double mean_latency_s() const {
+		return nof_written_cirs > 0 ? total_latency_s / nof_written_cirs : 0.0;
+	}
+
+	size_t queue_depth; ///< maximum number of queued CIRs
+	size_t queue_occupancy; ///< number of CIRs currently queued
+	size_t max_queue_occupancy; ///< largest number of CIRs queued at the same time
+	uint64_t nof_queued_cirs; ///< number of CIRs passed to write_cir
+	uint64_t nof_written_cirs; ///< number of CIRs written to the file
+	uint64_t nof_batches; ///< number of batches the CIRs were written in
+	uint64_t nof_blocked_calls; ///< number of calls to write_cir that waited for a free queue entry
+	double total_latency_s; ///< sum of the times from queuing until writing of all written CIRs in s
+	double max_latency_s; ///< largest time from queuing until writing of a CIR in s
+};
 
 /**
  * \brief Class for writing continuous-delay CDX files.
@@ -21,28 +56,381 @@ public:
 	 * \brief Constructor.
 	 *
 	 * \param _component_types A map of component types for each link
+	 * \param _write_track_index If true, the track index of each link is built from the
+	 * identifiers of its CIRs when the file is closed, one link at a time, see
+	 * build_link_track_index and ReadContinuousDelayFile::get_track
+	 * \param _access_plist File access properties, see get_swmr_access_plist and
+	 * get_in_memory_access_plist
+	 * \param _options File space and group storage settings, e.g. paged aggregation
 	 */
 	WriteContinuousDelayFile(std::string _file_name, double _c0_m_s,
 			double _cir_rate_Hz, double _transmitter_frequency_Hz,
 			const std::vector<std::string> &_link_names,
-			links_to_component_types_t &_component_types);
+			links_to_component_types_t &_component_types,
+			bool _write_track_index = false,
+			const H5::FileAccPropList &_access_plist =
+					H5::FileAccPropList::DEFAULT,
+			const writer_options_t &_options = writer_options_t());
 
+	/**
+	 * \brief Opens a partially written file to append CIRs after its last complete CIR.
+	 *
+	 * CIRs that were not written to all links, or whose reference delays are missing, are
+	 * removed, e.g. those of a writer that crashed. CIRs appended in SWMR mode are stored as
+	 * datasets of their own first. The delay bounds of the last, incomplete block are
+	 * restored from its CIRs. A track index of the file is removed, and rebuilt from all
+	 * CIRs when the file is closed if \c _write_track_index is true.
+	 *
+	 * \param[in] _file_name File name of an existing continuous-delay file
+	 * \param[in] _write_track_index See the other constructor
+	 * \param[in] _access_plist File access properties, see get_swmr_access_plist and
+	 * get_in_memory_access_plist
+	 */
+	WriteContinuousDelayFile(std::string _file_name, bool _write_track_index =
+			false, const H5::FileAccPropList &_access_plist =
+			H5::FileAccPropList::DEFAULT);
+
+	/**
+	 * \brief Closes the file if close has not been called, printing errors.
+	 *
+	 * A destructor cannot report errors, so call close to learn whether the file is
+	 * complete.
+	 */
 	virtual ~WriteContinuousDelayFile();
 
+	/**
+	 * \brief Writes the queued CIRs and the data that summarizes all CIRs, and closes the file.
+	 *
+	 * The delay bounds of the last, incomplete block, the layout of each link and the track
+	 * index are written. An exception that stopped the asynchronous writer is rethrown
+	 * after the CIRs written before it have been completed. Layout and track index are
+	 * not written then, as the file lacks the CIRs queued after the error. No method that
+	 * writes may be called afterwards. Does nothing if the file has already been closed.
+	 *
+	 * In SWMR mode, no objects can be created and readers may have the file open, so the
+	 * file is only flushed. The CIRs stay in the datasets they were appended to, the
+	 * layout describes the CIRs written before SWMR mode and no track index is written,
+	 * see compact_continuous_delay_file.
+	 */
+	void close();
+
 	/**
 	 * \brief Write single CIR to file
+	 *
+	 * Convenience wrapper of the overloads keyed by link index. The components are moved
+	 * out of the maps, which are taken by value, so pass them with std::move to avoid
+	 * copying.
 	 */
 	void write_cir(std::map<std::string, components_t> cirs,
 			std::map<std::string, double> reference_delays,
 			cir_number_t cir_number);
 
+	/**
+	 * \brief Writes a single CIR to the file.
+	 *
+	 * Entry \c k of both vectors belongs to the link with index \c k, see get_link_index.
+	 * The components are converted in a buffer that is reused for all CIRs, so writing
+	 * synchronously does not allocate memory once the buffer has reached the size of the
+	 * largest CIR.
+	 *
+	 * If the asynchronous writer is enabled, the CIR is copied into the queue and the call
+	 * returns as soon as there is room in the queue. An error of the writer thread is
+	 * rethrown by the next call.
+	 *
+	 * \param[in] cirs The components for each link
+	 * \param[in] reference_delays The reference delay for each link
+	 * \param[in] cir_number The CIR number
+	 */
+	void write_cir(const std::vector<components_t> &cirs,
+			const std::vector<double> &reference_delays,
+			cir_number_t cir_number);
+
+	/**
+	 * \brief Writes a single CIR to the file, moving it into the queue of the asynchronous writer.
+	 *
+	 * Same as the overload taking const references, but if the asynchronous writer is
+	 * enabled, the components are moved into the queue instead of being copied.
+	 */
+	void write_cir(std::vector<components_t> &&cirs,
+			std::vector<double> &&reference_delays, cir_number_t cir_number);
+
+	/**
+	 * \brief Writes a single CIR given as structures of arrays to the file.
+	 *
+	 * Entry \c k of both vectors belongs to the link with index \c k, see get_link_index.
+	 * Each member of the stored compound type is written with a write of its own directly
+	 * from its array, so the components are not converted.
+	 *
+	 * If the asynchronous writer is enabled, the CIR is converted to components_t and
+	 * queued.
+	 *
+	 * \param[in] cirs The components for each link
+	 * \param[in] reference_delays The reference delay for each link
+	 * \param[in] cir_number The CIR number
+	 */
+	void write_cir(const std::vector<ComponentsSoA> &cirs,
+			const std::vector<double> &reference_delays,
+			cir_number_t cir_number);
+
+	/**
+	 * \brief Appends consecutive CIRs of another continuous-delay file by copying their datasets.
+	 *
+	 * The dataset of each CIR is copied with H5Ocopy, so its components are neither
+	 * converted nor held in memory. The copied CIRs are numbered consecutively after the
+	 * CIRs written so far and their reference delays are appended.
+	 *
+	 * The delay bounds of the copied CIRs are taken from the delay bounds of cdx_in, see
+	 * ReadContinuousDelayFile::get_delay_bounds. They can be wider than the delays of the
+	 * CIRs if the copied CIRs are not aligned to the blocks of both files, which only makes
+	 * queries read blocks they could have skipped. The delays are read from files without
+	 * delay bounds. Unless components are read, the largest number of components of the
+	 * copied CIRs is taken from the layout of the input link, see link_layout_t, which can
+	 * exceed it.
+	 *
+	 * CIRs that cdx_in has not stored as datasets of their own, see
+	 * ReadContinuousDelayFile::get_nof_stored_cirs, are read and written instead.
+	 *
+	 * CIRs queued for the asynchronous writer are written first. Not available in SWMR
+	 * mode, which cannot create the datasets.
+	 *
+	 * \param[in] cdx_in The file to copy from
+	 * \param[in] input_link_indices Index of the link of cdx_in that is copied into each link of this file, indexed by link index
+	 * \param[in] first_cir Number of the first CIR of cdx_in
+	 * \param[in] count Number of CIRs
+	 */
+	void copy_cirs(ReadContinuousDelayFile &cdx_in,
+			const std::vector<size_t> &input_link_indices,
+			cir_number_t first_cir, size_t count);
+
+	/**
+	 * \brief Writes CIRs on a background thread from now on.
+	 *
+	 * write_cir moves the CIRs into a queue of at most \c queue_depth entries, waiting if it
+	 * is full. The writer thread writes all CIRs queued while it was busy as one batch while
+	 * holding get_hdf5_mutex(). While the writer is enabled, no other method of the object
+	 * may be called concurrently to write_cir, flush and get_async_write_stats.
+	 *
+	 * \param[in] queue_depth Maximum number of queued CIRs, at least 1
+	 */
+	void enable_async_writer(size_t queue_depth = 64);
+
+	/**
+	 * \brief Waits until all queued CIRs have been written.
+	 *
+	 * Rethrows the exception that stopped the writer thread, if any. Does nothing if the
+	 * asynchronous writer is not enabled.
+	 */
+	void flush();
+
+	/**
+	 * \brief Returns the counters of the asynchronous writer.
+	 */
+	async_write_stats_t get_async_write_stats();
+
+	/**
+	 * \brief Waits until all queued CIRs have been written and flushes the file, see WriteFile::sync.
+	 */
+	virtual void sync();
+
+	/**
+	 * \brief Writes all CIRs, the track index and the layout and returns an image of the file.
+	 *
+	 * The image holds everything close would write, so it can be read like a
+	 * closed file. Writing can continue afterwards.
+	 *
+	 * \throw std::logic_error in SWMR mode, where the CIRs are only stored in their final
+	 * layout by compact_continuous_delay_file
+	 */
+	virtual std::vector<char> get_file_image();
+
+	/** returns the number of CIRs written to each link so far, including resumed ones */
+	cir_number_t get_nof_written_cirs() const {
+		return nof_written_cirs;
+	}
+
+	/**
+	 * \brief Number of consecutive CIRs summarized by one row of a link's \c delay_bounds dataset.
+	 */
+	static const size_t cirs_per_delay_bounds_block = 64;
+
+	/**
+	 * \brief Number of components per chunk of the dataset of a link that holds the components of all CIRs appended in SWMR mode.
+	 */
+	static const size_t appended_components_per_chunk = 1024;
+
+protected:
+	/**
+	 * \brief Creates the datasets the CIRs are appended to in SWMR mode.
+	 *
+	 * HDF5 cannot create datasets in SWMR mode, so the components of all CIRs of a link
+	 * are appended to the dataset \c appended_cirs and the end of each CIR in it to
+	 * \c appended_cir_ends, whose attribute \c first_cir holds the number of the first
+	 * appended CIR. ReadContinuousDelayFile reads the CIRs from there, close leaves them
+	 * in place, as readers may have the file open. compact_continuous_delay_file stores
+	 * them as datasets of their own.
+	 */
+	virtual void prepare_swmr_write();
+
+	/**
+	 * \brief Appends the CIRs held back since the last flush to the datasets of the links.
+	 */
+	virtual void append_pending_cirs();
+
+	/**
+	 * \brief Writes the delay bounds of the current, incomplete block.
+	 */
+	virtual void write_derived_data();
+
 private:
-	std::map<std::string, H5::Group *> group_cirs; ///< pointers to cir datasets in file
+	/**
+	 * \brief A CIR waiting for the writer thread.
+	 */
+	struct queued_cir_t {
+		std::vector<components_t> cirs; ///< the components for each link index
+		std::vector<double> reference_delays; ///< the reference delay for each link index
+		cir_number_t cir_number; ///< the CIR number
+		std::chrono::steady_clock::time_point queue_time; ///< time the CIR was queued
+	};
+
+	/**
+	 * \brief Writes the components of a CIR of one link and updates its delay bounds.
+	 */
+	void write_components(size_t link_index, const components_t &impulses,
+			cir_number_t cir_number);
+
+	/**
+	 * \brief Writes the components of a CIR of one link given as structure of arrays, see write_components.
+	 */
+	void write_components(size_t link_index, const ComponentsSoA &impulses,
+			cir_number_t cir_number);
+
+	/**
+	 * \brief Creates the compound types of the components.
+	 */
+	void create_component_types();
+
+	/**
+	 * \brief Returns the number of CIRs of a link that have a dataset and a reference delay.
+	 */
+	cir_number_t count_complete_cirs(size_t link_index);
+
+	/**
+	 * \brief Removes the CIRs of a link from a CIR number on, together with their reference delays and delay bounds.
+	 */
+	void truncate_link(size_t link_index, cir_number_t nof_cirs);
+
+	/**
+	 * \brief Restores the delay bounds of the incomplete last block and the largest number of components from the CIRs of a resumed file.
+	 */
+	void restore_cir_state();
+
+	/**
+	 * \brief Returns the layout of the CIRs of a link written so far.
+	 */
+	link_layout_t get_written_layout(size_t link_index) const;
+
+	/**
+	 * \brief Writes the layout attributes of all links, see link_layout_t.
+	 */
+	void write_link_layouts();
+
+	/**
+	 * \brief Checks the number of components and reference delays passed to write_cir.
+	 */
+	void check_cir_sizes(size_t nof_cirs, size_t nof_reference_delays) const;
+
+	/**
+	 * \brief Moves a CIR into the queue of the asynchronous writer, waiting for room in the queue.
+	 */
+	void queue_cir(std::vector<components_t> &&cirs,
+			std::vector<double> &&reference_delays, cir_number_t cir_number);
+
+	/**
+	 * \brief Counts a CIR as written to all links and writes the delay bounds of a completed block.
+	 */
+	void finish_cir();
+
+	/**
+	 * \brief Main loop of the writer thread.
+	 */
+	void write_queued_cirs();
+
+	/**
+	 * \brief Stores the reference delays of the CIRs of a batch of the writer thread and clears them.
+	 */
+	void store_batch_reference_delays(
+			std::vector<std::vector<double> > &reference_delays);
+
+	/**
+	 * \brief Stops the writer thread after it has written all queued CIRs.
+	 *
+	 * An exception that stopped the writer thread is kept in writer_error.
+	 */
+	void stop_async_writer();
+
+	/**
+	 * \brief Throws a std::logic_error if the file has been closed.
+	 *
+	 * \param[in] function Name of the calling function for the error message
+	 */
+	void check_open(const char *function) const;
+
+	/**
+	 * \brief Writes the delay bounds of the current block of CIRs for a link.
+	 *
+	 * The row is (over-)written at the index of the current block, so an incomplete
+	 * block can be written and later be replaced by its final bounds.
+	 */
+	void write_delay_bounds(size_t link_index);
+
+	std::vector<H5::Group *> group_cirs; ///< pointers to cir datasets in file, indexed by link index
 	links_to_component_types_t component_types; ///< holds the component's types for each link, link_name->component_types
 
+	cir_number_t nof_written_cirs; ///< number of CIRs written to each link so far
+	std::vector<std::pair<double, double> > block_delay_bounds; ///< minimum and maximum delay of the current block for each link
+	std::vector<uint64_t> max_nof_components; ///< the largest number of components of a CIR written to each link
+
+	const bool track_index_enabled; ///< build the track index from the written CIRs on close
+
 	H5::CompType *cp_cmplx;
+	std::vector<H5::CompType> cp_fields; ///< compound types with a single member, indexed by component_field_t
+	H5::DSetMemXferPropList field_xfer; ///< transfer properties of the reads and writes of single members
+
+	std::vector<H5::DataSet> appended_cirs_datasets; ///< the dataset the components are appended to in SWMR mode, indexed by link index
+	std::vector<H5::DataSet> appended_ends_datasets; ///< the dataset the ends of the CIRs are appended to in SWMR mode, indexed by link index
+	std::vector<std::vector<hdf5_impulse_t> > pending_components; ///< components held back for the next flush in SWMR mode, indexed by link index
+	std::vector<std::vector<uint64_t> > pending_ends; ///< ends of the CIRs held back for the next flush in SWMR mode, indexed by link index
+	std::vector<uint64_t> nof_appended_components; ///< number of components appended in SWMR mode, indexed by link index
+
+	std::vector<hdf5_impulse_t> conversion_buffer; ///< the components of the CIR being written in file format
+	char name_buffer[24]; ///< the name of the dataset of the CIR being written
+	bool closed; ///< close has been called
+
+	std::mutex queue_mutex; ///< protects the members below
+	std::condition_variable queue_changed; ///< signaled when CIRs have been queued or written or the writer thread has to stop
+	std::deque<queued_cir_t> queue; ///< CIRs waiting for the writer thread
+	bool writer_busy; ///< the writer thread is writing a batch
+	bool stop_writer; ///< tells the writer thread to stop when the queue is empty
+	std::exception_ptr writer_error; ///< exception that stopped the writer thread
+	async_write_stats_t async_stats; ///< the counters of the asynchronous writer
+	std::thread writer_thread; ///< the writer thread, not joinable if the asynchronous writer is not enabled
 };
 
+/**
+ * \brief Stores the CIRs that a writer appended in SWMR mode as datasets of their own.
+ *
+ * The file is resumed and closed, see WriteContinuousDelayFile::WriteContinuousDelayFile,
+ * so CIRs that a writer which crashed did not complete are removed, and the layout of
+ * each link and optionally the track index are written. Files without appended CIRs
+ * only get these written. The file is restructured, so no reader or writer may have it
+ * open.
+ *
+ * \param[in] file_name File name of a continuous-delay file
+ * \param[in] write_track_index Build the track index of each link
+ */
+void compact_continuous_delay_file(const std::string &file_name,
+		bool write_track_index = false);
+
 } // end of namespace CDX
 
 #endif /* WriteContinuousDelayCDXFile_H_ */
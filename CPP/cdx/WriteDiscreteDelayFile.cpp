@@ -5,6 +5,7 @@
 
 #include "WriteDiscreteDelayFile.h"
 
+#include <algorithm>
 #include <iostream>
 #include <stdexcept>
 
@@ -14,44 +15,193 @@ namespace CDX {
 
 WriteDiscreteDelayFile::WriteDiscreteDelayFile(std::string _file_name,
 		double _c0_m_s, double _cir_rate_Hz, double _transmitter_frequency_Hz,
-		const std::vector<std::string> &_link_names, double _delay_smpl_freq_Hz) :
+		const std::vector<std::string> &_link_names, double _delay_smpl_freq_Hz,
+		const H5::FileAccPropList &_access_plist,
+		const writer_options_t &_options) :
 		WriteFile(_file_name, _c0_m_s, _cir_rate_Hz,
-				_transmitter_frequency_Hz, _link_names), delay_smpl_freq_Hz(
-				_delay_smpl_freq_Hz) {
+				_transmitter_frequency_Hz, _link_names, _access_plist, _options), numbers_of_delay_samples(
+				nof_links, 0), min_delays(nof_links, 0), delay_smpl_freq_Hz(
+				_delay_smpl_freq_Hz), act_cirs(nof_links, 0), closed(false) {
 
 	write("/parameters/delay_type", "discrete-delay");
 	write("/parameters/delay_smpl_freq_Hz", delay_smpl_freq_Hz);
 
 	for (size_t k = 0; k < nof_links; k++) {
-		numbers_of_delay_samples[link_names.at(k)] = 0;
-		min_delays[link_names.at(k)] = 0;
-		act_cirs[link_names.at(k)] = 0;
+		create_x_axis(k);
+		write_link_layout(k);
 	}
 }
 
+WriteDiscreteDelayFile::WriteDiscreteDelayFile(std::string _file_name,
+		const H5::FileAccPropList &_access_plist) :
+		WriteFile(_file_name, _access_plist), numbers_of_delay_samples(
+				nof_links, 0), min_delays(nof_links, 0), delay_smpl_freq_Hz(
+				read_double_h5(h5file, "/parameters/delay_smpl_freq_Hz")), act_cirs(
+				nof_links, 0), closed(false) {
+	if (delay_type != "discrete-delay")
+		throw runtime_error(
+				"WriteDiscreteDelayFile: " + file_name
+						+ " is not a discrete-delay file.");
+
+	for (size_t k = 0; k < nof_links; k++) {
+		H5::Group &link_group = *link_groups[k];
+
+		// files of older versions store the time axis with fixed size:
+		if (H5Lexists(link_group.getId(), "x_axis", H5P_DEFAULT) > 0)
+			link_group.unlink("x_axis");
+		create_x_axis(k);
+
+		if (H5Lexists(link_group.getId(), "cirs_real", H5P_DEFAULT) <= 0)
+			continue; // the link has not been set up
+
+		H5::DataSet real_dataset = link_group.openDataSet("cirs_real");
+		H5::DataSet imag_dataset = link_group.openDataSet("cirs_imag");
+		H5::DataSet reference_delays_dataset = link_group.openDataSet(
+				"reference_delays");
+
+		hsize_t real_dims[2], imag_dims[2], nof_reference_delays;
+		real_dataset.getSpace().getSimpleExtentDims(real_dims);
+		imag_dataset.getSpace().getSimpleExtentDims(imag_dims);
+		reference_delays_dataset.getSpace().getSimpleExtentDims(
+				&nof_reference_delays);
+
+		numbers_of_delay_samples[k] = real_dims[0];
+
+		H5::DataSet y_axis_dataset = link_group.openDataSet("y_axis");
+		vector<double> y_axis(numbers_of_delay_samples[k]);
+		if (not y_axis.empty()) {
+			y_axis_dataset.read(y_axis.data(), H5::PredType::NATIVE_DOUBLE);
+			min_delays[k] = y_axis[0];
+		}
+
+		// the datasets are extended before they are written, the reference delay is
+		// appended last:
+		act_cirs[k] = min<hsize_t>(nof_reference_delays,
+				min(real_dims[1], imag_dims[1]));
+
+		const hsize_t cirs_dims[2] = { real_dims[0], max<hsize_t>(act_cirs[k],
+				1) };
+		real_dataset.extend(cirs_dims);
+		imag_dataset.extend(cirs_dims);
+
+		const hsize_t reference_delays_dims = act_cirs[k];
+		reference_delays_dataset.extend(&reference_delays_dims);
+	}
+
+	write_derived_data();
+}
+
 WriteDiscreteDelayFile::~WriteDiscreteDelayFile() {
-	for (size_t k = 0; k < link_names.size(); k++) {
-		const size_t nof_cirs = act_cirs[link_names.at(k)];
-		// calculate x-axis:
-		vector<double> x_axis(nof_cirs);
-		const double cir_rate_Hz = get_cir_rate_Hz();
-		for (size_t n = 0; n < nof_cirs; n++)
-			x_axis.at(n) = static_cast<double>(n) / cir_rate_Hz;
-
-		write(link_groups[link_names.at(k)], "x_axis", x_axis);
+	try {
+		close();
+	} catch (exception &e) {
+		cerr << "WriteDiscreteDelayFile: closing " << file_name << " failed: "
+				<< e.what() << endl;
+	} catch (H5::Exception &e) {
+		cerr << "WriteDiscreteDelayFile: closing " << file_name << " failed: "
+				<< e.getDetailMsg() << endl;
+	} catch (...) {
+		cerr << "WriteDiscreteDelayFile: closing " << file_name << " failed."
+				<< endl;
+	}
+}
+
+void WriteDiscreteDelayFile::close() {
+	if (closed)
+		return;
+
+	// an error of close is not repeated by the destructor:
+	closed = true;
+
+	flush_file();
+	close_file();
+}
+
+void WriteDiscreteDelayFile::check_open(const char *function) const {
+	if (closed)
+		throw logic_error(string(function) + ": the file has been closed.");
+}
+
+void WriteDiscreteDelayFile::create_x_axis(size_t link_index) {
+	const int RANK = 2;
+	hsize_t dims[RANK] = { 0, 1 };
+	hsize_t maxdims[RANK] = { H5S_UNLIMITED, 1 };
+	H5::DataSpace dataspace(RANK, dims, maxdims);
+
+	H5::DSetCreatPropList cparms;
+	hsize_t chunk_dims[RANK] = { 64, 1 };
+	cparms.setChunk(RANK, chunk_dims);
+
+	link_groups[link_index]->createDataSet("x_axis", H5::PredType::NATIVE_DOUBLE,
+			dataspace, cparms);
+}
+
+void WriteDiscreteDelayFile::write_link_layout(size_t link_index) {
+	link_layout_t layout;
+	layout.nof_cirs = act_cirs[link_index];
+	layout.max_nof_components = numbers_of_delay_samples[link_index];
+	layout.sample_type = "double";
+
+	// the datasets of the CIRs are created by setup_link:
+	if (numbers_of_delay_samples[link_index] > 0)
+		layout.chunk_dims = { numbers_of_delay_samples[link_index], 1 };
+
+	CDX::write_link_layout(*link_groups[link_index], layout);
+}
+
+void WriteDiscreteDelayFile::write_derived_data() {
+	const double cir_rate_Hz = get_cir_rate_Hz();
+
+	for (size_t k = 0; k < nof_links; k++) {
+		write_link_layout(k);
+
+		H5::DataSet dataset = link_groups[k]->openDataSet("x_axis");
+
+		hsize_t dims[2];
+		dataset.getSpace().getSimpleExtentDims(dims);
+		if (dims[0] >= act_cirs[k])
+			continue;
+
+		// calculate the new part of the x-axis:
+		vector<double> x_axis(act_cirs[k] - dims[0]);
+		for (size_t n = 0; n < x_axis.size(); n++)
+			x_axis[n] = static_cast<double>(dims[0] + n) / cir_rate_Hz;
+
+		const hsize_t new_dims[2] = { act_cirs[k], 1 };
+		dataset.extend(new_dims);
+
+		H5::DataSpace fspace = dataset.getSpace();
+		const hsize_t offset[2] = { dims[0], 0 };
+		const hsize_t count[2] = { x_axis.size(), 1 };
+		fspace.selectHyperslab(H5S_SELECT_SET, count, offset);
+
+		dataset.write(x_axis.data(), H5::PredType::NATIVE_DOUBLE,
+				H5::DataSpace(2, count), fspace);
 	}
 }
 
 void WriteDiscreteDelayFile::setup_link(std::string link_name,
 		size_t number_of_delay_samples, double min_delay) {
-	numbers_of_delay_samples[link_name] = number_of_delay_samples;
-	min_delays[link_name] = min_delay;
+	setup_link(get_link_index(link_name), number_of_delay_samples, min_delay);
+}
+
+void WriteDiscreteDelayFile::setup_link(size_t link_index,
+		size_t number_of_delay_samples, double min_delay) {
+	check_open("WriteDiscreteDelayFile::setup_link");
+	check_link_index(link_index, "WriteDiscreteDelayFile::setup_link");
+
+	if (swmr_write_enabled)
+		throw logic_error(
+				"WriteDiscreteDelayFile::setup_link: links cannot be set up in SWMR mode.");
+
+	numbers_of_delay_samples[link_index] = number_of_delay_samples;
+	min_delays[link_index] = min_delay;
 
 	// calculate y-axis:
 	vector<double> y_axis(number_of_delay_samples);
 	for (size_t k = 0; k < number_of_delay_samples; k++)
 		y_axis.at(k) = min_delay + static_cast<double>(k) / delay_smpl_freq_Hz;
-	write(link_groups[link_name], "y_axis", y_axis);
+	write(link_groups[link_index], "y_axis", y_axis);
 
 	const int RANK = 2;
 	// Create the data space with unlimited dimensions.
@@ -73,11 +223,13 @@ void WriteDiscreteDelayFile::setup_link(std::string link_name,
 	/*
 	 * Create a new dataset within the file using cparms
 	 * creation properties. */
-	H5::DataSet dataset_r = link_groups[link_name]->createDataSet("cirs_real",
+	H5::DataSet dataset_r = link_groups[link_index]->createDataSet("cirs_real",
 			H5::PredType::NATIVE_DOUBLE, mspace1, cparms);
-	H5::DataSet dataset_i = link_groups[link_name]->createDataSet("cirs_imag",
+	H5::DataSet dataset_i = link_groups[link_index]->createDataSet("cirs_imag",
 			H5::PredType::NATIVE_DOUBLE, mspace1, cparms);
 
+	write_link_layout(link_index);
+
 }
 
 void WriteDiscreteDelayFile::append_2d_dataset(H5::Group *group, string path,
@@ -89,6 +241,14 @@ void WriteDiscreteDelayFile::append_2d_dataset(H5::Group *group, string path,
 	hsize_t maxdims[RANK] = { H5S_UNLIMITED, H5S_UNLIMITED };
 	H5::DataSpace mspace1(RANK, dims, maxdims);
 
+	append_2d_dataset(group, path, data, mspace1, length, act_cir);
+}
+
+void WriteDiscreteDelayFile::append_2d_dataset(H5::Group *group,
+		const std::string &path, const double *data,
+		const H5::DataSpace &mspace, size_t length, size_t act_cir) {
+	const int RANK = 2;
+
 	// open dataset
 	H5::DataSet dataset = group->openDataSet(path);
 	// Extend the dataset.
@@ -106,47 +266,62 @@ void WriteDiscreteDelayFile::append_2d_dataset(H5::Group *group, string path,
 	fspace1.selectHyperslab(H5S_SELECT_SET, dims1, offset);
 
 	// Write the data to the hyperslab.
-	dataset.write(data, H5::PredType::NATIVE_DOUBLE, mspace1, fspace1);
+	dataset.write(data, H5::PredType::NATIVE_DOUBLE, mspace, fspace1);
 }
 
 void WriteDiscreteDelayFile::append_cir_snapshot(std::string link_name,
 		const vector<complex<double> > &data, double ref_delay) {
+	append_cir_snapshot(get_link_index(link_name), data, ref_delay);
+}
+
+void WriteDiscreteDelayFile::append_cir_snapshot(size_t link_index,
+		const vector<complex<double> > &data, double ref_delay) {
+	check_open("WriteDiscreteDelayFile::append_cir_snapshot");
+	check_link_index(link_index, "WriteDiscreteDelayFile::append_cir_snapshot");
+
 	// check if setup_link() has been called already:
 
-	if (numbers_of_delay_samples[link_name] == 0)
+	if (numbers_of_delay_samples[link_index] == 0)
 		throw logic_error(
 				"WriteDiscreteDelayCDXFile::append_cir_snapshot: setup_link() needs to be called before calling this function.");
 
 	// partly from http://www.hdfgroup.org/HDF5/doc/cpplus_RM/extend__ds_8cpp-example.html
 	// consistency check:
-	if (data.size() != numbers_of_delay_samples[link_name]) {
+	if (data.size() != numbers_of_delay_samples[link_index]) {
 		stringstream msg;
-		msg << "error: link: " << link_name << ", data.size() (" << data.size()
-				<< ") != number_of_delay_samples ("
-				<< numbers_of_delay_samples[link_name] << ") !\n";
+		msg << "error: link: " << link_names[link_index] << ", data.size() ("
+				<< data.size() << ") != number_of_delay_samples ("
+				<< numbers_of_delay_samples[link_index] << ") !\n";
 		throw logic_error(msg.str());
 	}
 
-	const size_t nof_samples = numbers_of_delay_samples[link_name];
+	const size_t nof_samples = numbers_of_delay_samples[link_index];
 
-	// convert vector to double[]
-	double data_r[nof_samples];
-	double data_i[nof_samples];
-	for (size_t k = 0; k < nof_samples; k++) {
-		data_r[k] = data.at(k).real();
-		data_i[k] = data.at(k).imag();
-	}
+	// std::complex<double> is stored as two doubles, so the real and imaginary parts are
+	// written directly from data with a stride of two, without copying them:
+	const int MEM_RANK = 1;
+	const hsize_t mem_dims[MEM_RANK] = { 2 * nof_samples };
+	H5::DataSpace mspace(MEM_RANK, mem_dims);
+	const hsize_t stride[MEM_RANK] = { 2 };
+	const hsize_t count[MEM_RANK] = { nof_samples };
+
+	const double *parts = reinterpret_cast<const double *>(data.data());
 
-	append_2d_dataset(link_groups[link_name], "cirs_real", data_r, nof_samples,
-			act_cirs[link_name]);
+	const hsize_t real_offset[MEM_RANK] = { 0 };
+	mspace.selectHyperslab(H5S_SELECT_SET, count, real_offset, stride);
+	append_2d_dataset(link_groups[link_index], "cirs_real", parts, mspace,
+			nof_samples, act_cirs[link_index]);
 
-	append_2d_dataset(link_groups[link_name], "cirs_imag", data_i, nof_samples,
-			act_cirs[link_name]);
+	const hsize_t imag_offset[MEM_RANK] = { 1 };
+	mspace.selectHyperslab(H5S_SELECT_SET, count, imag_offset, stride);
+	append_2d_dataset(link_groups[link_index], "cirs_imag", parts, mspace,
+			nof_samples, act_cirs[link_index]);
 
 	// append reference delay: ///////////////
-	append_reference_delay(link_groups[link_name], ref_delay);
+	store_reference_delays(link_index, &ref_delay, 1);
 
-	act_cirs[link_name]++;
+	act_cirs[link_index]++;
+	flush_file_if_due(1);
 }
 
 } // end of namespace CDX
@@ -17,37 +17,117 @@ class WriteDiscreteDelayFile: public WriteFile {
 public:
 	/**
 	 * \param min_delay delay value of first delay bin
+	 * \param _access_plist File access properties, get_swmr_access_plist for SWMR mode,
+	 * get_in_memory_access_plist to keep the file in memory
+	 * \param _options File space and group storage settings, e.g. paged aggregation
 	 */
 	WriteDiscreteDelayFile(std::string _file_name, double _c0_m_s,
 			double _cir_rate_Hz, double _transmitter_frequency_Hz,
 			const std::vector<std::string> &_link_names,
-			double _delay_smpl_freq_Hz);
+			double _delay_smpl_freq_Hz,
+			const H5::FileAccPropList &_access_plist =
+					H5::FileAccPropList::DEFAULT,
+			const writer_options_t &_options = writer_options_t());
 
+	/**
+	 * \brief Reopens a discrete-delay file for appending CIRs, e.g. after the writer crashed.
+	 *
+	 * Links that have not been set up can be set up. The CIRs of each link are cut to the
+	 * number of its reference delays, so a CIR whose write was interrupted is dropped.
+	 *
+	 * \param[in] _file_name File name of an existing discrete-delay file
+	 * \param[in] _access_plist File access properties, get_swmr_access_plist for SWMR mode,
+	 * get_in_memory_access_plist to keep the file in memory
+	 */
+	WriteDiscreteDelayFile(std::string _file_name,
+			const H5::FileAccPropList &_access_plist =
+					H5::FileAccPropList::DEFAULT);
+
+	/**
+	 * \brief Closes the file if close has not been called, printing errors.
+	 *
+	 * A destructor cannot report errors, so call close to learn whether the file is
+	 * complete.
+	 */
 	virtual ~WriteDiscreteDelayFile();
 
+	/**
+	 * \brief Writes the pending CIRs, the time axis and the layout of each link, and closes the file.
+	 *
+	 * In SWMR mode, the CIRs and reference delays held back for the next flush are appended
+	 * first. No method that writes may be called afterwards. Does nothing if the file has
+	 * already been closed.
+	 */
+	void close();
+
 	/**
 	 * \b Configures a link.
 	 *
 	 * \param[in] link Number of the link.
 	 * \param[in] number_of_delay_samples Number of samples in the delay dimension.
 	 * \param[in] min_delay Minimal delay, this serves as the lower value on the vertical axis.
+	 *
+	 * Links must be set up before SWMR mode is enabled.
 	 */
 	void setup_link(std::string link_name, size_t number_of_delay_samples,
 			double min_delay);
 
+	/**
+	 * \brief Configures the link with a given index, see get_link_index.
+	 */
+	void setup_link(size_t link_index, size_t number_of_delay_samples,
+			double min_delay);
+
 	/** This function appends a cir with discrete delay data to a CDX file*/
 	void append_cir_snapshot(std::string link_name,
 			const std::vector<std::complex<double> > &data, double ref_delay);
 
+	/**
+	 * \brief Appends a CIR to the link with a given index, see get_link_index.
+	 */
+	void append_cir_snapshot(size_t link_index,
+			const std::vector<std::complex<double> > &data, double ref_delay);
+
 	void append_2d_dataset(H5::Group *group, std::string path, double *data,
 			size_t length, size_t act_cir);
 
+protected:
+	/**
+	 * \brief Extends the time axis of each link to its CIRs and updates the layout attributes.
+	 */
+	virtual void write_derived_data();
+
 private:
-	std::map<std::string, size_t> numbers_of_delay_samples;
-	std::map<std::string, double> min_delays;
+	/**
+	 * \brief Creates the extendible time axis of a link.
+	 */
+	void create_x_axis(size_t link_index);
+
+	/**
+	 * \brief Writes the layout attributes of a link, see link_layout_t.
+	 */
+	void write_link_layout(size_t link_index);
+
+	/**
+	 * \brief Throws a std::logic_error if the file has been closed.
+	 *
+	 * \param[in] function Name of the calling function for the error message
+	 */
+	void check_open(const char *function) const;
+
+	/**
+	 * \brief Writes \c length elements of data, selected by mspace, as column act_cir of a 2D dataset.
+	 */
+	void append_2d_dataset(H5::Group *group, const std::string &path,
+			const double *data, const H5::DataSpace &mspace, size_t length,
+			size_t act_cir);
+
+	std::vector<size_t> numbers_of_delay_samples; ///< number of delay samples of each link, zero until the link is set up
+	std::vector<double> min_delays; ///< the minimal delay of each link
 	double delay_smpl_freq_Hz;
 
-	std::map<std::string, size_t> act_cirs;
+	std::vector<size_t> act_cirs; ///< number of CIRs appended to each link
+	bool closed; ///< close has been called
 };
 
 } // end of namespace CDX
@@ -6,9 +6,11 @@
 
 #include "WriteFile.h"
 
+#include <algorithm>
 #include <iostream>
 #include <vector>
 #include <complex>
+#include <sstream>
 #include <stdexcept>
 
 #include <boost/lexical_cast.hpp>
@@ -17,11 +19,103 @@ using namespace std;
 
 namespace CDX {
 
+H5::FileAccPropList get_swmr_access_plist() {
+	H5::FileAccPropList access_plist;
+	access_plist.setLibverBounds(H5F_LIBVER_LATEST, H5F_LIBVER_LATEST);
+	return access_plist;
+}
+
+/**
+ * \brief Returns the file creation properties for the file space settings of the writer options.
+ */
+static H5::FileCreatPropList get_create_plist(const writer_options_t &options) {
+	H5::FileCreatPropList create_plist;
+
+	if (options.paged_aggregation) {
+		if (options.page_size < 512)
+			throw logic_error(
+					"WriteFile: the page size of paged aggregation must be at least 512 bytes.");
+		H5Pset_file_space_strategy(create_plist.getId(),
+				H5F_FSPACE_STRATEGY_PAGE, options.persist_free_space, 1);
+		H5Pset_file_space_page_size(create_plist.getId(), options.page_size);
+	} else if (options.persist_free_space)
+		H5Pset_file_space_strategy(create_plist.getId(),
+				H5F_FSPACE_STRATEGY_FSM_AGGR, true, 1);
+
+	return create_plist;
+}
+
+/**
+ * \brief Returns a copy of file access properties with the aggregation settings of the writer options.
+ */
+static H5::FileAccPropList with_writer_options(
+		const H5::FileAccPropList &access_plist,
+		const writer_options_t &options) {
+	H5::FileAccPropList plist;
+	if (access_plist.getId() != H5P_DEFAULT)
+		plist.copy(access_plist);
+
+	if (options.meta_block_size > 0)
+		H5Pset_meta_block_size(plist.getId(), options.meta_block_size);
+	if (options.small_data_block_size > 0)
+		H5Pset_small_data_block_size(plist.getId(),
+				options.small_data_block_size);
+
+	// groups with compact or dense link storage are created in the 1.8 format or later:
+	if (options.new_style_groups) {
+		H5F_libver_t low, high;
+		H5Pget_libver_bounds(plist.getId(), &low, &high);
+		if (low < H5F_LIBVER_V18)
+			H5Pset_libver_bounds(plist.getId(), H5F_LIBVER_V18,
+					max(high, H5F_LIBVER_V18));
+	}
+
+	return plist;
+}
+
+/**
+ * \brief Returns a copy of file access properties that clear the status flags of the file on opening.
+ *
+ * HDF5 marks a file in the latest format as open for writing and refuses to open it for
+ * writing again until the mark is removed on closing, so it refuses files of crashed
+ * writers. The property is the one h5clear sets.
+ */
+static H5::FileAccPropList with_cleared_status_flags(
+		const H5::FileAccPropList &access_plist) {
+	H5::FileAccPropList plist;
+	if (access_plist.getId() != H5P_DEFAULT)
+		plist.copy(access_plist);
+
+	hbool_t clear_status_flags = true;
+	if (H5Pset(plist.getId(), "clear_status_flags", &clear_status_flags) < 0)
+		throw runtime_error(
+				"WriteFile: setting the property to clear the status flags failed.");
+
+	return plist;
+}
+
 WriteFile::WriteFile(std::string _file_name, double _c0_m_s,
 		double _cir_rate_Hz, double _transmitter_frequency_Hz,
-		std::vector<std::string> _link_names) :
+		std::vector<std::string> _link_names,
+		const H5::FileAccPropList &_access_plist,
+		const writer_options_t &_options) :
 		File(_file_name, _c0_m_s, _cir_rate_Hz, _transmitter_frequency_Hz,
-				_link_names) {
+				_link_names, with_writer_options(_access_plist, _options),
+				get_create_plist(_options)), group_create_plist(H5P_GROUP_CREATE), swmr_write_enabled(
+				false), nof_unflushed_cirs(
+				0), last_flush_time(chrono::steady_clock::now()), pending_reference_delays(
+				nof_links) {
+
+	if (_options.new_style_groups or _options.track_creation_order)
+		H5Pset_link_phase_change(group_create_plist.getId(),
+				_options.max_compact_links, _options.min_dense_links);
+	if (_options.track_creation_order)
+		H5Pset_link_creation_order(group_create_plist.getId(),
+				H5P_CRT_ORDER_TRACKED | H5P_CRT_ORDER_INDEXED);
+	if (not _options.track_times) {
+		H5Pset_obj_track_times(group_create_plist.getId(), false);
+		H5Pset_obj_track_times(cir_create_plist.getId(), false);
+	}
 
 	// creating groups for all links:
 	for (size_t k = 0; k < nof_links; k++) {
@@ -32,10 +126,10 @@ WriteFile::WriteFile(std::string _file_name, double _c0_m_s,
 		}
 
 		H5::Group *new_link_group = new H5::Group(
-				links_group.createGroup(link_names.at(k)));
-		link_groups[link_names.at(k)] = new_link_group;
+				create_group(links_group, link_names.at(k)));
+		link_groups[k] = new_link_group;
 
-		create_reference_delays_dataset(link_groups[link_names.at(k)]);
+		create_reference_delays_dataset(link_groups[k]);
 	}
 
 	// write parameters to file:
@@ -46,9 +140,117 @@ WriteFile::WriteFile(std::string _file_name, double _c0_m_s,
 
 }
 
+WriteFile::WriteFile(std::string _file_name,
+		const H5::FileAccPropList &_access_plist) :
+		File(_file_name, with_cleared_status_flags(_access_plist),
+				H5F_ACC_RDWR), swmr_write_enabled(false), nof_unflushed_cirs(0), last_flush_time(
+				chrono::steady_clock::now()), pending_reference_delays(nof_links) {
+}
+
 WriteFile::~WriteFile() {
 }
 
+void WriteFile::enable_swmr_write(const swmr_options_t &options) {
+	if (swmr_write_enabled)
+		throw logic_error(
+				"WriteFile::enable_swmr_write: SWMR mode is already enabled.");
+
+	prepare_swmr_write();
+
+	if (H5Fstart_swmr_write(h5file.getId()) < 0)
+		throw runtime_error(
+				"WriteFile::enable_swmr_write: switching " + file_name
+						+ " to SWMR mode failed, was it created with get_swmr_access_plist?");
+
+	swmr_write_enabled = true;
+	swmr_options = options;
+	nof_unflushed_cirs = 0;
+	last_flush_time = chrono::steady_clock::now();
+}
+
+void WriteFile::sync() {
+	flush_file();
+}
+
+std::vector<char> WriteFile::get_file_image() {
+	sync();
+	return File::get_file_image();
+}
+
+void WriteFile::flush_file() {
+	if (swmr_write_enabled) {
+		append_pending_cirs();
+
+		// readers take the number of reference delays as the number of complete CIRs, so
+		// the CIRs are on disk before the reference delays are appended:
+		h5file.flush(H5F_SCOPE_LOCAL);
+
+		for (size_t k = 0; k < nof_links; k++) {
+			append_reference_delays(link_groups[k],
+					pending_reference_delays[k].data(),
+					pending_reference_delays[k].size());
+			pending_reference_delays[k].clear();
+		}
+	}
+
+	write_derived_data();
+	h5file.flush(H5F_SCOPE_LOCAL);
+
+	nof_unflushed_cirs = 0;
+	last_flush_time = chrono::steady_clock::now();
+}
+
+void WriteFile::flush_file_if_due(size_t nof_cirs) {
+	if (not swmr_write_enabled)
+		return;
+
+	nof_unflushed_cirs += nof_cirs;
+
+	const bool cirs_due = swmr_options.flush_interval_cirs > 0
+			and nof_unflushed_cirs >= swmr_options.flush_interval_cirs;
+	const bool time_due = swmr_options.flush_interval_s > 0
+			and chrono::duration<double>(
+					chrono::steady_clock::now() - last_flush_time).count()
+					>= swmr_options.flush_interval_s;
+
+	if (cirs_due or time_due)
+		flush_file();
+}
+
+void WriteFile::store_reference_delays(size_t link_index,
+		const double *reference_delays, size_t count) {
+	if (swmr_write_enabled)
+		pending_reference_delays[link_index].insert(
+				pending_reference_delays[link_index].end(), reference_delays,
+				reference_delays + count);
+	else
+		append_reference_delays(link_groups[link_index], reference_delays,
+				count);
+}
+
+void WriteFile::close_file() {
+	for (auto &link_group : link_groups) {
+		delete link_group;
+		link_group = nullptr;
+	}
+
+	links_group.close();
+	h5file.close();
+}
+
+H5::Group WriteFile::create_group(const H5::Group &parent,
+		const std::string &name) {
+	const hid_t id = H5Gcreate2(parent.getId(), name.c_str(), H5P_DEFAULT,
+			group_create_plist.getId(), H5P_DEFAULT);
+	if (id < 0)
+		throw runtime_error("WriteFile: creating group " + name + " failed.");
+
+	// the object holds a reference of its own:
+	H5::Group group(id);
+	H5Gclose(id);
+	return group;
+}
+
 void WriteFile::create_group(string path) {
 	H5::Group group_links(h5file.createGroup(path.c_str()));
 }
@@ -97,20 +299,27 @@ void WriteFile::write(string path, const vector<double> &data) {
 
 	H5::DataSet dset3 = h5file.createDataSet(path.c_str(),
 			H5::PredType::NATIVE_DOUBLE, dspace3);
-	dset3.write(&data[0], H5::PredType::NATIVE_DOUBLE);
+	dset3.write(data.data(), H5::PredType::NATIVE_DOUBLE);
 }
 
 void WriteFile::write(string path, const vector<vector<double> > &data) {
-	// convert to double[][]:
-	size_t dim1 = data.size();
-	size_t dim2 = data.at(0).size();
+	const size_t dim1 = data.size();
+	const size_t dim2 = dim1 > 0 ? data[0].size() : 0;
 
-	double wdata[dim1][dim2];
+	// copy the rows into one heap buffer, it can be larger than the stack:
+	vector<double> wdata;
+	wdata.reserve(dim1 * dim2);
 	for (size_t k = 0; k < dim1; k++) {
-		for (size_t n = 0; n < dim2; n++) {
-			wdata[k][n] = data.at(k).at(n);
+		if (data[k].size() != dim2) {
+			stringstream msg;
+			msg << "WriteFile::write: row " << k << " of " << path << " has "
+					<< data[k].size() << " elements instead of " << dim2
+					<< ".";
+			throw logic_error(msg.str());
 		}
+		wdata.insert(wdata.end(), data[k].begin(), data[k].end());
 	}
+
 	const size_t RANK = 2;
 	hsize_t dimsf3[RANK]; // dataset dimensions
 	dimsf3[0] = dim1;
@@ -118,16 +327,11 @@ void WriteFile::write(string path, const vector<vector<double> > &data) {
 	H5::DataSpace dspace3(RANK, dimsf3);
 	H5::DataSet dset3 = h5file.createDataSet(path.c_str(),
 			H5::PredType::NATIVE_DOUBLE, dspace3);
-	dset3.write(wdata, H5::PredType::NATIVE_DOUBLE);
+	dset3.write(wdata.data(), H5::PredType::NATIVE_DOUBLE);
 }
 
-#if H5_VERS_MAJOR >= 1 and H5_VERS_MINOR >= 10 and H5_VERS_RELEASE >= 1
 void WriteFile::write(const H5::H5Location *h5file, const std::string &path,
 		const std::vector<std::string> &data) {
-#else
-void WriteFile::write(const H5::CommonFG *h5file, const std::string &path,
-		const std::vector<std::string> &data) {
-#endif
 
 	// based on
 	// http://stackoverflow.com/questions/581209/how-to-best-write-out-a-stdvector-stdstring-container-to-a-hdf5-dataset
@@ -152,13 +356,8 @@ void WriteFile::write(const H5::CommonFG *h5file, const std::string &path,
 	dset.write(arr_c_str.data(), str_type);
 }
 
-#if H5_VERS_MAJOR >= 1 and H5_VERS_MINOR >= 10 and H5_VERS_RELEASE >= 1
 void WriteFile::write(const H5::H5Location* h5file, const std::string& path,
 		const std::map<uint16_t, std::string>& data) {
-#else
-void WriteFile::write(const H5::CommonFG* h5file, const std::string& path,
-		const std::map<uint16_t, std::string>& data) {
-#endif
 
 	// C struct for the compound data typo:
 	typedef struct component_type_t {
@@ -240,15 +439,23 @@ void WriteFile::write(H5::Group *group, string path,
 	H5::DataSpace dspace3(RANK, dimsf3);
 	H5::DataSet dset3 = group->createDataSet(path.c_str(),
 			H5::PredType::NATIVE_DOUBLE, dspace3);
-	dset3.write(&data[0], H5::PredType::NATIVE_DOUBLE);
+	dset3.write(data.data(), H5::PredType::NATIVE_DOUBLE);
 }
 
 void WriteFile::append_reference_delay(H5::Group *group,
 		double reference_delay) {
+	append_reference_delays(group, &reference_delay, 1);
+}
+
+void WriteFile::append_reference_delays(H5::Group *group,
+		const double *reference_delays, size_t count) {
+	if (count == 0)
+		return;
+
 	const int RANK = 1;
 
 	// Create the data space with unlimited dimensions
-	hsize_t dims_refdelay[RANK] = { 1 }; // dataset dimensions at creation
+	hsize_t dims_refdelay[RANK] = { count }; // dataset dimensions at creation
 	hsize_t maxdims_refdelay[RANK] = { H5S_UNLIMITED };
 	H5::DataSpace mspace1_refdelay(RANK, dims_refdelay, maxdims_refdelay);
 
@@ -259,20 +466,19 @@ void WriteFile::append_reference_delay(H5::Group *group,
 
 	// Extend the dataset
 	hsize_t new_size[RANK];
-	new_size[0] = actual_dims + 1;
+	new_size[0] = actual_dims + count;
 	dataset.extend(new_size);
 
 	// Select a hyperslab:
 	H5::DataSpace fspace1_refdelay = dataset.getSpace();
 	hsize_t offset_refdelay[RANK] = { actual_dims };
-	hsize_t dims1_refdelay[RANK] = { 1 }; // data1 dimensions
+	hsize_t dims1_refdelay[RANK] = { count }; // data1 dimensions
 	fspace1_refdelay.selectHyperslab(H5S_SELECT_SET, dims1_refdelay,
 			offset_refdelay);
 
 	// Write the data to the hyperslab:
-	double ref_delay_data[1] = { reference_delay };
-	dataset.write(ref_delay_data, H5::PredType::NATIVE_DOUBLE, mspace1_refdelay,
-			fspace1_refdelay);
+	dataset.write(reference_delays, H5::PredType::NATIVE_DOUBLE,
+			mspace1_refdelay, fspace1_refdelay);
 }
 
 } // end of namespace CDX
@@ -7,20 +7,128 @@
 #ifndef WRITECDXFILE_H_
 #define WRITECDXFILE_H_
 
+#include <chrono>
+
 #include "File.h"
+#include "LinkLayout.h"
 
 namespace CDX {
 
+/**
+ * \brief Flush cadence of a writer in SWMR mode, see WriteFile::enable_swmr_write.
+ *
+ * The file is flushed as soon as one of the limits is reached.
+ */
+struct swmr_options_t {
+	swmr_options_t() :
+			flush_interval_cirs(64), flush_interval_s(1.0) {
+	}
+
+	size_t flush_interval_cirs; ///< number of CIRs after which the file is flushed, 0 for no limit
+	double flush_interval_s; ///< time in s after the last flush after which the file is flushed, 0 for no limit
+};
+
+/**
+ * \brief File space and group storage settings of a writer, see WriteFile::WriteFile.
+ *
+ * By default, HDF5 allocates the metadata of each CIR dataset next to its components, so
+ * the metadata of a file with many small CIRs is spread over the whole file and reading it
+ * needs many small reads. Paged aggregation and larger aggregation blocks keep metadata
+ * and raw data apart. The default values keep the HDF5 defaults. The settings are fixed
+ * when a file is created, a writer that appends to an existing file keeps them.
+ */
+struct writer_options_t {
+	writer_options_t() :
+			paged_aggregation(false), page_size(4096), persist_free_space(
+					false), meta_block_size(0), small_data_block_size(0), new_style_groups(
+					false), max_compact_links(8), min_dense_links(6), track_creation_order(
+					false), track_times(true) {
+	}
+
+	bool paged_aggregation; ///< allocate metadata and raw data in separate pages of page_size bytes, which readers can cache with reader_options_t::page_buffer_size, needs HDF5 1.10 to read
+	hsize_t page_size; ///< page size in bytes with paged_aggregation, at least 512
+	bool persist_free_space; ///< keep track of the free space in the file after closing, so it is reused by writers that append
+	hsize_t meta_block_size; ///< minimum size in bytes of the blocks metadata is aggregated in, 0 for the HDF5 default of 2048
+	hsize_t small_data_block_size; ///< minimum size in bytes of the blocks small raw data, e.g. the components of CIRs, is aggregated in, 0 for the HDF5 default of 2048
+	bool new_style_groups; ///< store the links of groups in the object header or in a heap with a B-tree index instead of a symbol table, needs HDF5 1.8 to read
+	unsigned max_compact_links; ///< with new_style_groups, the largest number of links stored in the object header of a group
+	unsigned min_dense_links; ///< with new_style_groups, the smallest number of links stored in a heap, after links have been deleted
+	bool track_creation_order; ///< track and index the creation order of the links of groups, implies new_style_groups
+	bool track_times; ///< store access, modification, change and birth times in the object headers of groups and CIR datasets
+};
+
+/**
+ * \brief Returns file access properties for creating files that can be written in SWMR mode.
+ *
+ * SWMR (single writer, multiple readers) needs the latest HDF5 file format, which HDF5
+ * versions before 1.10 cannot read.
+ */
+H5::FileAccPropList get_swmr_access_plist();
+
 /**
  * \brief Base class for writing continuous-delay and discrete-delay CDX files.
  */
 class WriteFile: public File {
 public:
+	/**
+	 * \brief Creates a file.
+	 *
+	 * \param[in] _access_plist File access properties, see get_swmr_access_plist and
+	 * get_in_memory_access_plist
+	 * \param[in] _options File space and group storage settings
+	 */
 	WriteFile(std::string _file_name, double _c0_m_s, double _cir_rate_Hz,
-			double _transmitter_frequency, std::vector<std::string> _link_names);
+			double _transmitter_frequency, std::vector<std::string> _link_names,
+			const H5::FileAccPropList &_access_plist =
+					H5::FileAccPropList::DEFAULT,
+			const writer_options_t &_options = writer_options_t());
+
+	/**
+	 * \brief Opens an existing file for appending.
+	 *
+	 * The file may have been left behind by a writer that crashed in SWMR mode, whose file
+	 * HDF5 otherwise refuses to open for writing.
+	 */
+	WriteFile(std::string _file_name, const H5::FileAccPropList &_access_plist);
 
 	virtual ~WriteFile();
 
+	/**
+	 * \brief Switches the file to SWMR (single writer, multiple readers) mode.
+	 *
+	 * Readers can open the file with H5F_ACC_SWMR_READ while it is written and see the
+	 * CIRs written up to the last flush. The CIRs are flushed automatically with the
+	 * cadence given by \c options, or with sync. Each flush leaves a consistent file
+	 * behind, so after a crash at most the CIRs written since the last flush are lost.
+	 *
+	 * The file must have been created with get_swmr_access_plist. HDF5 cannot create
+	 * objects in SWMR mode, so all links of a discrete-delay file must be set up before.
+	 *
+	 * \param[in] options The flush cadence
+	 */
+	void enable_swmr_write(const swmr_options_t &options = swmr_options_t());
+
+	/** returns true if the file is written in SWMR mode */
+	bool get_swmr_write_enabled() const {
+		return swmr_write_enabled;
+	}
+
+	/**
+	 * \brief Writes all CIRs held back for the next flush and flushes the file.
+	 *
+	 * The reference delays are appended after the CIRs have been flushed, so a reader can
+	 * take their number as the number of complete CIRs.
+	 */
+	virtual void sync();
+
+	/**
+	 * \brief Writes the data held back and derived data like sync and returns an image of the file.
+	 *
+	 * Files that are only kept in memory, see get_in_memory_access_plist, are handed on
+	 * this way before the writer is closed.
+	 */
+	virtual std::vector<char> get_file_image();
+
 	/** creates group at path */
 	void create_group(std::string path);
 
@@ -47,24 +155,14 @@ public:
 	/**
 	 * \brief Writes vector of strings to path.
 	 */
-#if H5_VERS_MAJOR >= 1 and H5_VERS_MINOR >= 10 and H5_VERS_RELEASE >= 1
 	void write(const H5::H5Location *h5file, const std::string &path,
 			const std::vector<std::string> &data);
-#else
-	void write(const H5::CommonFG *h5file, const std::string &path,
-			const std::vector<std::string> &data);
-#endif
 
 	/**
 	 * \brief Writes a std::map<uint16_t, std::string> to path.
 	 */
-#if H5_VERS_MAJOR >= 1 and H5_VERS_MINOR >= 10 and H5_VERS_RELEASE >= 1
 	void write(const H5::H5Location *h5file, const std::string &path,
 			const std::map<uint16_t, std::string> &data);
-#else
-	void write(const H5::CommonFG *h5file, const std::string &path,
-			const std::map<uint16_t, std::string> &data);
-#endif
 	/**
 	 * \brief Writes double value to path into group.
 	 */
@@ -77,6 +175,61 @@ public:
 	void write(std::string path, const std::vector<std::vector<double> > &data);
 
 protected:
+	/**
+	 * \brief Creates the datasets that the writer needs in SWMR mode, called before switching.
+	 */
+	virtual void prepare_swmr_write() {
+	}
+
+	/**
+	 * \brief Writes the CIRs held back for the next flush in SWMR mode, called by flush_file.
+	 */
+	virtual void append_pending_cirs() {
+	}
+
+	/**
+	 * \brief Updates data derived from the written CIRs, called by flush_file after the reference delays.
+	 */
+	virtual void write_derived_data() {
+	}
+
+	/**
+	 * \brief Appends the pending reference delays and derived data and flushes the file, see sync.
+	 *
+	 * Unlike sync, this does not wait for an asynchronous writer, so writer threads call it.
+	 */
+	void flush_file();
+
+	/**
+	 * \brief Counts written CIRs and flushes the file in SWMR mode when the cadence is due.
+	 */
+	void flush_file_if_due(size_t nof_cirs);
+
+	/**
+	 * \brief Appends reference delays to a link, held back for the next flush in SWMR mode.
+	 */
+	void store_reference_delays(size_t link_index,
+			const double *reference_delays, size_t count);
+
+	/**
+	 * \brief Closes all HDF5 objects of the file and the file itself.
+	 */
+	void close_file();
+
+	/**
+	 * \brief Creates a group with the group creation properties of the writer options.
+	 */
+	H5::Group create_group(const H5::Group &parent, const std::string &name);
+
+	H5::PropList group_create_plist; ///< creation properties of the groups of links and CIRs, see writer_options_t
+	H5::DSetCreatPropList cir_create_plist; ///< creation properties of the datasets of CIRs, see writer_options_t
+
+	bool swmr_write_enabled; ///< the file is written in SWMR mode
+	swmr_options_t swmr_options; ///< the flush cadence in SWMR mode
+	size_t nof_unflushed_cirs; ///< number of CIRs written since the last flush
+	std::chrono::steady_clock::time_point last_flush_time; ///< time of the last flush
+	std::vector<std::vector<double> > pending_reference_delays; ///< reference delays held back for the next flush in SWMR mode, indexed by link index
+
 	/**
 	 * \brief Creates 1D dataset for reference delays in file.
 	 * Initial size is zero and dataset has unlimited dimension.
@@ -87,6 +240,12 @@ protected:
 	 * \brief Append single value to reference delay dataset.
 	 */
 	void append_reference_delay(H5::Group *group, double reference_delay);
+
+	/**
+	 * \brief Append values to reference delay dataset.
+	 */
+	void append_reference_delays(H5::Group *group,
+			const double *reference_delays, size_t count);
 };
 
 } // end of namespace CDX
@@ -0,0 +1,116 @@
+/**
+ * \file cdx-test-arena.cpp
+ *
+ * \brief Reads a continuous-delay CDX file into a CIRArena with get_cir and get_cirs and
+ * compares the CIRs to those returned by get_cir without arena. Checks that the arena
+ * consolidates its blocks on release and then reads further batches without growing.
+ */
+
+#include "../../cdx/WriteContinuousDelayFile.h"
+#include "../../cdx/ReadContinuousDelayFile.h"
+#include "../cdx-test-common.h"
+
+#include <iostream>
+#include <stdexcept>
+#include <sstream>
+
+using namespace std;
+
+const size_t nof_cirs = 400;
+const size_t batch_size = 50;
+
+static size_t nof_components_of(CDX::cir_number_t cir_number) {
+	return (cir_number * 13) % 40;
+}
+
+static void compare(const CDX::arena_cir_t &arena_cir, const CDX::cir_t &cir,
+		CDX::cir_number_t cir_number) {
+	bool ok = arena_cir.ref_delay == cir.ref_delay
+			and arena_cir.size() == cir.components.size()
+			and arena_cir.size() == nof_components_of(cir_number);
+
+	for (size_t c = 0; ok and c < arena_cir.size(); c++)
+		ok = arena_cir[c].type == cir.components[c].type
+				and arena_cir[c].id == cir.components[c].id
+				and arena_cir[c].delay == cir.components[c].delay
+				and arena_cir[c].amplitude == cir.components[c].amplitude;
+
+	if (not ok) {
+		stringstream ss;
+		ss << "CIR " << cir_number << " read into arena does not match get_cir.";
+		fail(ss.str());
+	}
+}
+
+int main(void) {
+	cout << "cdx-test-arena start." << endl;
+
+	const string file_name = "cdx-test-arena.cdx";
+
+	{
+		CDX::links_to_component_types_t links_to_component_types = { {
+				"link0", { { 0, "LOS" } } } };
+		CDX::WriteContinuousDelayFile cdx_out(file_name, 3e8, 100.0, 1e9, {
+				"link0" }, links_to_component_types);
+
+		vector<CDX::components_t> cirs(1);
+		for (CDX::cir_number_t cir_number = 0; cir_number < nof_cirs;
+				cir_number++) {
+			cirs[0].resize(nof_components_of(cir_number));
+			for (size_t c = 0; c < cirs[0].size(); c++) {
+				cirs[0][c].type = c % 3;
+				cirs[0][c].id = c;
+				cirs[0][c].delay = 1e-6 * c + 1e-9 * cir_number;
+				cirs[0][c].amplitude = complex<double>(c, cir_number);
+			}
+			cdx_out.write_cir(cirs, vector<double>(1, 1e-3 * cir_number),
+					cir_number);
+		}
+	}
+
+	CDX::ReadContinuousDelayFile cdx_in(file_name);
+	const size_t link_index = cdx_in.get_link_index("link0");
+
+	// a small first block, so the first batch needs several blocks:
+	CDX::CIRArena arena(1024);
+
+	cout << "checking get_cir with arena..." << endl;
+	for (CDX::cir_number_t cir_number = 0; cir_number < nof_cirs;
+			cir_number++)
+		compare(cdx_in.get_cir(link_index, cir_number, arena),
+				cdx_in.get_cir(link_index, cir_number), cir_number);
+
+	if (arena.get_nof_blocks() < 2)
+		fail("expected the arena to need several blocks.");
+
+	arena.release();
+	if (arena.get_nof_blocks() != 1 or arena.get_bytes_allocated() != 0)
+		fail("release did not consolidate the blocks of the arena.");
+
+	cout << "checking get_cirs with arena..." << endl;
+	const size_t capacity = arena.get_capacity();
+	vector<CDX::arena_cir_t> batch;
+	for (CDX::cir_number_t first = 0; first < nof_cirs; first += batch_size) {
+		cdx_in.get_cirs(link_index, first, batch_size, arena, batch);
+
+		if (batch.size() != batch_size)
+			fail("get_cirs returned the wrong number of CIRs.");
+
+		for (size_t k = 0; k < batch.size(); k++)
+			compare(batch[k], cdx_in.get_cir(link_index, first + k),
+					first + k);
+
+		arena.release();
+	}
+
+	if (arena.get_nof_blocks() != 1 or arena.get_capacity() != capacity)
+		fail("arena grew while reading batches smaller than the first one.");
+
+	try {
+		cdx_in.get_cirs(link_index, nof_cirs - 1, 2, arena, batch);
+		fail("get_cirs past the last CIR did not throw.");
+	} catch (logic_error &) {
+	}
+
+	cout << "all done." << endl;
+}
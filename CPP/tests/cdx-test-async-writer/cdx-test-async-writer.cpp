@@ -0,0 +1,223 @@
+/**
+ * \file cdx-test-async-writer.cpp
+ *
+ * \brief Writes a continuous-delay CDX file with the asynchronous writer of
+ * WriteContinuousDelayFile and a small queue, reads it back and compares it to the
+ * written data. Then checks that an error of the writer thread is reported by flush and
+ * close, that the CIRs written before an error within a batch keep their reference delays
+ * without an updated layout, and that close completes the file while the writer still
+ * exists.
+ */
+
+#include "../../cdx/WriteContinuousDelayFile.h"
+#include "../../cdx/ReadContinuousDelayFile.h"
+
+#include <iostream>
+#include <mutex>
+#include <stdexcept>
+#include <sstream>
+
+using namespace std;
+
+const size_t nof_cirs = 1000;
+
+static CDX::components_t components_of(const string &link,
+		CDX::cir_number_t cir_number) {
+	CDX::components_t components(cir_number % 5 + (link == "link1" ? 1 : 0));
+	for (size_t c = 0; c < components.size(); c++) {
+		components[c].type = c == 0 ? 0 : 256;
+		components[c].id = c;
+		components[c].delay = 1e-6 * c + 1e-9 * cir_number;
+		components[c].amplitude = complex<double>(c, cir_number);
+	}
+	return components;
+}
+
+int main(void) {
+	cout << "cdx-test-async-writer start." << endl;
+
+	const string file_name = "cdx-test-async-writer.cdx";
+	const vector<string> link_names = { "link0", "link1" };
+
+	CDX::component_types_t component_types = { { 0, "LOS" },
+			{ 256, "Scatterer" } };
+	CDX::links_to_component_types_t links_to_component_types = { { "link0",
+			component_types }, { "link1", component_types } };
+
+	cout << "writing CIRs asynchronously..." << endl;
+	{
+		CDX::WriteContinuousDelayFile cdx_out(file_name, 3e8, 100.0, 1e9,
+				link_names, links_to_component_types);
+		cdx_out.enable_async_writer(4);
+
+		for (CDX::cir_number_t cir_number = 0; cir_number < nof_cirs;
+				cir_number++) {
+			map<string, CDX::components_t> cirs;
+			map<string, double> reference_delays;
+			for (const auto &link : link_names) {
+				cirs[link] = components_of(link, cir_number);
+				reference_delays[link] = 1e-3 * cir_number;
+			}
+			cdx_out.write_cir(std::move(cirs), std::move(reference_delays),
+					cir_number);
+		}
+
+		cdx_out.flush();
+
+		const CDX::async_write_stats_t stats = cdx_out.get_async_write_stats();
+		if (stats.nof_queued_cirs != nof_cirs
+				or stats.nof_written_cirs != nof_cirs
+				or stats.queue_occupancy != 0 or stats.max_queue_occupancy > 4
+				or stats.nof_batches == 0)
+			throw runtime_error("asynchronous writer counters are wrong.");
+		cout << "  " << stats.nof_batches << " batches, mean latency "
+				<< stats.mean_latency_s() << " s, "
+				<< stats.nof_blocked_calls << " blocked calls" << endl;
+	}
+
+	cout << "reading CIRs..." << endl;
+	{
+		CDX::ReadContinuousDelayFile cdx_in(file_name);
+		if (cdx_in.get_nof_cirs() != nof_cirs)
+			throw runtime_error("number of CIRs does not match.");
+
+		for (const auto &link : link_names) {
+			for (unsigned int cir_number = 0; cir_number < nof_cirs;
+					cir_number++) {
+				const CDX::cir_t cir = cdx_in.get_cir(link, cir_number);
+				const CDX::components_t expected = components_of(link,
+						cir_number);
+
+				bool ok = cir.ref_delay == 1e-3 * cir_number
+						and cir.components.size() == expected.size();
+				for (size_t c = 0; ok and c < expected.size(); c++)
+					ok = cir.components[c].id == expected[c].id
+							and cir.components[c].delay == expected[c].delay
+							and cir.components[c].amplitude
+									== expected[c].amplitude;
+
+				if (not ok) {
+					stringstream ss;
+					ss << "CIR " << cir_number << " of " << link
+							<< " does not match input data.";
+					throw runtime_error(ss.str());
+				}
+			}
+		}
+	}
+
+	cout << "checking error reporting..." << endl;
+	{
+		CDX::WriteContinuousDelayFile cdx_out(file_name, 3e8, 100.0, 1e9,
+				link_names, links_to_component_types);
+		cdx_out.enable_async_writer(4);
+
+		// writing the same CIR number twice fails in the writer thread:
+		for (CDX::cir_number_t k = 0; k < 2; k++)
+			cdx_out.write_cir( { { "link0", components_of("link0", 0) }, {
+					"link1", components_of("link1", 0) } }, { { "link0", 0.0 },
+					{ "link1", 0.0 } }, 0);
+
+		bool error_reported = false;
+		try {
+			cdx_out.flush();
+		} catch (...) {
+			error_reported = true;
+		}
+
+		if (not error_reported)
+			throw runtime_error("error of the writer thread was not reported.");
+
+		error_reported = false;
+		try {
+			cdx_out.close();
+		} catch (...) {
+			error_reported = true;
+		}
+
+		if (not error_reported)
+			throw runtime_error("error of the writer thread was not reported by close.");
+	}
+
+	cout << "checking the file after an error within a batch..." << endl;
+	{
+		CDX::WriteContinuousDelayFile cdx_out(file_name, 3e8, 100.0, 1e9,
+				link_names, links_to_component_types, true);
+		cdx_out.enable_async_writer(64);
+
+		// the writer thread waits for the HDF5 library, so the CIRs are written in a batch
+		// that fails at the second CIR 5, after CIRs 0 to 9 have been written:
+		{
+			lock_guard<mutex> hdf5_lock(CDX::get_hdf5_mutex());
+			for (CDX::cir_number_t k = 0; k < 20; k++) {
+				const CDX::cir_number_t n = k == 10 ? 5 : k;
+				cdx_out.write_cir( { { "link0", components_of("link0", n) }, {
+						"link1", components_of("link1", n) } }, { { "link0",
+						1e-6 * n }, { "link1", 2e-6 * n } }, n);
+			}
+		}
+
+		bool error_reported = false;
+		try {
+			cdx_out.close();
+		} catch (...) {
+			error_reported = true;
+		}
+
+		if (not error_reported)
+			throw runtime_error("error of the writer thread was not reported by close.");
+
+		// each CIR written has its reference delays:
+		CDX::ReadContinuousDelayFile cdx_in(file_name);
+		if (cdx_in.get_nof_cirs() < 10
+				or cdx_in.get_reference_delays(0).size() != cdx_in.get_nof_cirs()
+				or cdx_in.get_reference_delays(1).size() != cdx_in.get_nof_cirs())
+			throw runtime_error("CIRs before the error lack reference delays.");
+
+		for (CDX::cir_number_t k = 0; k < cdx_in.get_nof_cirs(); k++)
+			if (cdx_in.get_cir("link1", k).ref_delay != 2e-6 * k)
+				throw runtime_error("wrong reference delay before the error.");
+
+		// the layout written by the constructor is not updated:
+		if (cdx_in.get_link_layout(0).nof_cirs != 0)
+			throw runtime_error("the layout describes the incomplete file.");
+	}
+
+	cout << "checking close..." << endl;
+	{
+		CDX::WriteContinuousDelayFile cdx_out(file_name, 3e8, 100.0, 1e9,
+				link_names, links_to_component_types, true);
+		cdx_out.enable_async_writer(4);
+		for (CDX::cir_number_t k = 0; k < 100; k++)
+			cdx_out.write_cir( { { "link0", components_of("link0", k) }, {
+					"link1", components_of("link1", k) } }, { { "link0", 0.0 },
+					{ "link1", 0.0 } }, k);
+		cdx_out.close();
+		cdx_out.close();
+
+		// the file is complete before the destructor runs:
+		{
+			CDX::ReadContinuousDelayFile cdx_in(file_name);
+			if (cdx_in.get_nof_cirs() != 100
+					or cdx_in.get_link_layout(0).max_nof_components != 4
+					or cdx_in.get_track(0, 0).cir_numbers.size() != 80)
+				throw runtime_error("close did not complete the file.");
+		}
+
+		bool logic_error_thrown = false;
+		try {
+			cdx_out.write_cir( { { "link0", components_of("link0", 100) }, {
+					"link1", components_of("link1", 100) } }, { { "link0",
+					0.0 }, { "link1", 0.0 } }, 100);
+		} catch (logic_error &) {
+			logic_error_thrown = true;
+		}
+
+		if (not logic_error_thrown)
+			throw runtime_error("writing to a closed file did not throw.");
+	}
+
+	remove(file_name.c_str());
+
+	cout << "all done." << endl;
+}
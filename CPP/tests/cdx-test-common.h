@@ -0,0 +1,87 @@
+/**
+ * \file cdx-test-common.h
+ *
+ * \brief Helpers shared by the tests: reporting failures, expecting errors, and a fixture
+ * of CIRs that are written and checked by several tests.
+ */
+
+#ifndef CDX_TEST_COMMON_H_
+#define CDX_TEST_COMMON_H_
+
+#include "../cdx/WriteContinuousDelayFile.h"
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+inline void fail(const std::string &msg) {
+	throw std::runtime_error(msg);
+}
+
+/**
+ * \brief Calls f and fails if it does not throw std::logic_error.
+ */
+template<typename F>
+inline void expect_logic_error(F f, const std::string &what) {
+	try {
+		f();
+	} catch (std::logic_error &) {
+		return;
+	}
+	fail(what + " did not throw std::logic_error.");
+}
+
+/**
+ * \brief CIRs whose contents follow from the link and the CIR number, so that a test can
+ * check any CIR it reads without keeping the written ones.
+ */
+namespace fixture {
+
+inline size_t nof_components_of(size_t link_index,
+		CDX::cir_number_t cir_number) {
+	return (cir_number + link_index) % 5;
+}
+
+inline CDX::impulse_t component_of(size_t link_index,
+		CDX::cir_number_t cir_number, size_t c) {
+	CDX::impulse_t component;
+	component.type = c % 2;
+	component.id = 10 * link_index + c;
+	component.delay = 1e-6 * c + 1e-7 * cir_number;
+	component.amplitude = std::complex<double>(cir_number, link_index + c);
+	return component;
+}
+
+inline double reference_delay_of(size_t link_index,
+		CDX::cir_number_t cir_number) {
+	return 1e-3 * link_index + 1e-6 * cir_number;
+}
+
+inline bool equal(const CDX::impulse_t &a, const CDX::impulse_t &b) {
+	return a.type == b.type and a.id == b.id and a.delay == b.delay
+			and a.amplitude == b.amplitude;
+}
+
+/**
+ * \brief Writes CIRs first_cir to end_cir - 1 of all links.
+ */
+inline void write_cirs(CDX::WriteContinuousDelayFile &cdx_out,
+		CDX::cir_number_t first_cir, CDX::cir_number_t end_cir) {
+	const size_t nof_links = cdx_out.get_nof_links();
+
+	std::vector<CDX::components_t> cirs(nof_links);
+	std::vector<double> reference_delays(nof_links);
+	for (CDX::cir_number_t n = first_cir; n < end_cir; n++) {
+		for (size_t l = 0; l < nof_links; l++) {
+			cirs[l].clear();
+			for (size_t c = 0; c < nof_components_of(l, n); c++)
+				cirs[l].push_back(component_of(l, n, c));
+			reference_delays[l] = reference_delay_of(l, n);
+		}
+		cdx_out.write_cir(cirs, reference_delays, n);
+	}
+}
+
+} // end of namespace fixture
+
+#endif /* CDX_TEST_COMMON_H_ */
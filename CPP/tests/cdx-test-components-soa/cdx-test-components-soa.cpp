@@ -0,0 +1,154 @@
+/**
+ * \file cdx-test-components-soa.cpp
+ *
+ * \brief Converts components to and from CDX::ComponentsSoA and checks the alignment of its
+ * arrays. Writes CIRs of two links, one from components_t and one from ComponentsSoA, and
+ * reads them back with get_cir and read_cir. Some CIRs have no components.
+ */
+
+#include "../../cdx/WriteContinuousDelayFile.h"
+#include "../../cdx/ReadContinuousDelayFile.h"
+#include "../cdx-test-common.h"
+
+#include <iostream>
+#include <stdexcept>
+#include <sstream>
+
+using namespace std;
+
+const size_t nof_cirs = 100;
+
+static size_t nof_components_of(CDX::cir_number_t cir_number) {
+	return (cir_number * 5) % 13;
+}
+
+static CDX::impulse_t component_of(size_t link_index,
+		CDX::cir_number_t cir_number, size_t c) {
+	CDX::impulse_t component;
+	component.type = c % 2;
+	component.id = 1000 * link_index + c;
+	component.delay = 1e-6 * cir_number + 1e-9 * c;
+	component.amplitude = complex<double>(cir_number, -1.0 * c);
+	return component;
+}
+
+static bool equal(const CDX::impulse_t &a, const CDX::impulse_t &b) {
+	return a.type == b.type and a.id == b.id and a.delay == b.delay
+			and a.amplitude == b.amplitude;
+}
+
+static bool is_aligned(const void *p) {
+	return reinterpret_cast<uintptr_t>(p) % 64 == 0;
+}
+
+static void test_conversion() {
+	CDX::components_t components;
+	for (size_t c = 0; c < 37; c++)
+		components.push_back(component_of(0, 3, c));
+
+	CDX::ComponentsSoA soa;
+	CDX::to_soa(components, soa);
+
+	if (soa.size() != components.size())
+		fail("to_soa: wrong size.");
+
+	for (size_t field = 0; field < CDX::nof_component_fields; field++)
+		if (not is_aligned(soa.get_field_data(field)))
+			fail("ComponentsSoA: array is not aligned to 64 bytes.");
+
+	CDX::components_t converted;
+	CDX::to_components(soa, converted);
+	if (converted.size() != components.size())
+		fail("to_components: wrong size.");
+	for (size_t c = 0; c < components.size(); c++)
+		if (not equal(converted[c], components[c])
+				or not equal(soa.get(c), components[c]))
+			fail("conversion does not preserve components.");
+
+	CDX::ComponentsSoA pushed;
+	for (size_t c = 0; c < components.size(); c++)
+		pushed.push_back(components[c]);
+	if (pushed.reals != soa.reals or pushed.ids != soa.ids)
+		fail("push_back does not match to_soa.");
+}
+
+int main(void) {
+	cout << "cdx-test-components-soa start." << endl;
+
+	cout << "checking conversions..." << endl;
+	test_conversion();
+
+	const string file_name = "cdx-test-components-soa.cdx";
+
+	cout << "writing file..." << endl;
+	{
+		CDX::links_to_component_types_t links_to_component_types = { {
+				"link0", { { 0, "LOS" }, { 1, "Scatterer" } } }, { "link1", { {
+				0, "LOS" }, { 1, "Scatterer" } } } };
+		CDX::WriteContinuousDelayFile cdx_out(file_name, 3e8, 100.0, 1e9, {
+				"link0", "link1" }, links_to_component_types, true);
+
+		// link 0 is written from components_t, link 1 from ComponentsSoA, so the
+		// CIRs are written alternately by both overloads:
+		vector<CDX::components_t> cirs(2);
+		vector<CDX::ComponentsSoA> soa_cirs(2);
+		for (CDX::cir_number_t cir_number = 0; cir_number < nof_cirs;
+				cir_number++) {
+			for (size_t link_index = 0; link_index < 2; link_index++) {
+				cirs[link_index].clear();
+				for (size_t c = 0; c < nof_components_of(cir_number); c++)
+					cirs[link_index].push_back(
+							component_of(link_index, cir_number, c));
+				CDX::to_soa(cirs[link_index], soa_cirs[link_index]);
+			}
+
+			const vector<double> reference_delays = { 1e-6 * cir_number, 2e-6
+					* cir_number };
+			if (cir_number % 2 == 0)
+				cdx_out.write_cir(cirs, reference_delays, cir_number);
+			else
+				cdx_out.write_cir(soa_cirs, reference_delays, cir_number);
+		}
+	}
+
+	cout << "reading file..." << endl;
+	CDX::ReadContinuousDelayFile cdx_in(file_name);
+	CDX::ComponentsSoA soa;
+
+	for (size_t link_index = 0; link_index < 2; link_index++)
+		for (CDX::cir_number_t cir_number = 0; cir_number < nof_cirs;
+				cir_number++) {
+			const CDX::cir_t cir = cdx_in.get_cir(link_index, cir_number);
+			const double ref_delay = cdx_in.read_cir(link_index, cir_number,
+					soa);
+
+			bool ok = cir.ref_delay == (link_index + 1) * 1e-6 * cir_number
+					and ref_delay == cir.ref_delay
+					and cir.components.size() == nof_components_of(cir_number)
+					and soa.size() == cir.components.size();
+
+			for (size_t c = 0; ok and c < cir.components.size(); c++)
+				ok = equal(cir.components[c],
+						component_of(link_index, cir_number, c))
+						and equal(soa.get(c), cir.components[c]);
+
+			if (not ok) {
+				stringstream ss;
+				ss << "CIR " << cir_number << " of link " << link_index
+						<< " does not match input data.";
+				fail(ss.str());
+			}
+		}
+
+	// the track index is built from the identifiers of both overloads:
+	size_t nof_track_entries = 0;
+	for (CDX::cir_number_t cir_number = 0; cir_number < nof_cirs; cir_number++)
+		if (nof_components_of(cir_number) > 1)
+			nof_track_entries++;
+
+	const CDX::track_t track = cdx_in.get_track(size_t(1), 1001);
+	if (track.size() != nof_track_entries)
+		fail("track of link1 has wrong number of entries.");
+
+	cout << "all done." << endl;
+}
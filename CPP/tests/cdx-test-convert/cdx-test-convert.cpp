@@ -0,0 +1,75 @@
+/**
+ * \file cdx-test-convert.cpp
+ *
+ * \brief Checks the sinc interpolation of CDX::sample_components against a direct
+ * evaluation of the sinc pulses.
+ */
+
+#include "../../cdx/Convert.h"
+#include "../cdx-test-common.h"
+
+#include <cmath>
+#include <iostream>
+#include <stdexcept>
+
+using namespace std;
+
+static CDX::impulse_t get_component(double delay, complex<double> amplitude) {
+	CDX::impulse_t component;
+	component.type = 0;
+	component.id = 0;
+	component.delay = delay;
+	component.amplitude = amplitude;
+	return component;
+}
+
+int main(void) {
+	cout << "cdx-test-convert start." << endl;
+
+	const double fs = 100e6;
+	const double first_delay = 70e-6;
+	vector<complex<double> > samples(64, complex<double>(1.0, 1.0));
+
+	cout << "component on a sample..." << endl;
+	CDX::components_t components = { get_component(first_delay + 10.0 / fs,
+			complex<double>(0.5, -2.0)) };
+	CDX::sample_components(components, first_delay, fs, samples);
+	for (size_t k = 0; k < samples.size(); k++)
+		if (abs(samples[k] - (k == 10 ? components[0].amplitude : 0.0))
+				> 1e-9)
+			fail("a component on a sample is not a single sample.");
+
+	cout << "components between samples..." << endl;
+	components = { get_component(first_delay + 3.3 / fs, complex<double>(1.0,
+			0.0)), get_component(first_delay + 20.75 / fs,
+			complex<double>(-0.2, 0.4)), get_component(first_delay - 2.5 / fs,
+			complex<double>(0.0, 1.0)) };
+	CDX::sample_components(components, first_delay, fs, samples);
+	for (size_t k = 0; k < samples.size(); k++) {
+		complex<double> expected(0.0, 0.0);
+		for (const auto &component : components) {
+			const double x = M_PI * fs
+					* (first_delay + k / fs - component.delay);
+			expected += component.amplitude * sin(x) / x;
+		}
+		if (abs(samples[k] - expected) > 1e-9)
+			fail("wrong sample between the samples of the components.");
+	}
+
+	cout << "component next to a sample..." << endl;
+	components = { get_component(first_delay + (10.0 + 1e-7) / fs,
+			complex<double>(1.0, 0.0)) };
+	CDX::sample_components(components, first_delay, fs, samples);
+	const double x = M_PI * fs * (first_delay + 10.0 / fs - components[0].delay);
+	if (abs(samples[10] - sin(x) / x) > 1e-12)
+		fail("imprecise sample next to a component.");
+
+	cout << "no components..." << endl;
+	components.clear();
+	CDX::sample_components(components, first_delay, fs, samples);
+	for (const auto &sample : samples)
+		if (sample != complex<double>(0.0, 0.0))
+			fail("samples without components are not zero.");
+
+	cout << "all done." << endl;
+}
@@ -0,0 +1,205 @@
+/**
+ * \file cdx-test-field-mask.cpp
+ *
+ * \brief Reads CIRs of a continuous-delay CDX file with masks of the fields to read through
+ * get_cir, the arena, read_cir, read_cirs, the shared reader and the prefetcher. The
+ * requested fields have to match the full CIR, the other fields have to be zero or, for
+ * blocks, empty. Invalid masks have to throw.
+ */
+
+#include "../../cdx/WriteContinuousDelayFile.h"
+#include "../../cdx/ReadContinuousDelayFile.h"
+#include "../../cdx/CIRPrefetcher.h"
+#include "../cdx-test-common.h"
+
+#include <iostream>
+#include <stdexcept>
+#include <sstream>
+
+using namespace std;
+
+const size_t nof_cirs = 50;
+
+static size_t nof_components_of(CDX::cir_number_t cir_number) {
+	return (cir_number * 3) % 8;
+}
+
+/**
+ * \brief Returns the component with only the fields of a mask, the others set to zero.
+ */
+static CDX::impulse_t masked(const CDX::impulse_t &component, unsigned fields) {
+	CDX::impulse_t result;
+	result.type = fields & CDX::fields_type ? component.type : 0;
+	result.id = fields & CDX::fields_id ? component.id : 0;
+	result.delay = fields & CDX::fields_delay ? component.delay : 0.0;
+	result.amplitude = complex<double>(
+			fields & CDX::fields_real ? component.amplitude.real() : 0.0,
+			fields & CDX::fields_imag ? component.amplitude.imag() : 0.0);
+	return result;
+}
+
+static bool equal(const CDX::impulse_t &a, const CDX::impulse_t &b) {
+	return a.type == b.type and a.id == b.id and a.delay == b.delay
+			and a.amplitude == b.amplitude;
+}
+
+static void check(bool ok, const string &api, unsigned fields,
+		CDX::cir_number_t cir_number) {
+	if (not ok) {
+		stringstream ss;
+		ss << api << " with fields " << fields << " does not match CIR "
+				<< cir_number << ".";
+		fail(ss.str());
+	}
+}
+
+int main(void) {
+	cout << "cdx-test-field-mask start." << endl;
+
+	const string file_name = "cdx-test-field-mask.cdx";
+
+	{
+		CDX::links_to_component_types_t links_to_component_types = { {
+				"link0", { { 0, "LOS" }, { 1, "Scatterer" } } } };
+		CDX::WriteContinuousDelayFile cdx_out(file_name, 3e8, 100.0, 1e9, {
+				"link0" }, links_to_component_types);
+
+		vector<CDX::components_t> cirs(1);
+		for (CDX::cir_number_t cir_number = 0; cir_number < nof_cirs;
+				cir_number++) {
+			cirs[0].resize(nof_components_of(cir_number));
+			for (size_t c = 0; c < cirs[0].size(); c++) {
+				cirs[0][c].type = 1 + c % 2;
+				cirs[0][c].id = 100 + c;
+				cirs[0][c].delay = 1e-6 * (c + 1) + 1e-9 * cir_number;
+				cirs[0][c].amplitude = complex<double>(c + 1.0,
+						-1.0 - cir_number);
+			}
+			cdx_out.write_cir(cirs, vector<double>(1, 1e-3 * cir_number),
+					cir_number);
+		}
+	}
+
+	CDX::ReadContinuousDelayFile cdx_in(file_name);
+	CDX::SharedReadContinuousDelayFile shared_in(file_name);
+
+	vector<CDX::cir_t> full_cirs;
+	for (CDX::cir_number_t cir_number = 0; cir_number < nof_cirs; cir_number++)
+		full_cirs.push_back(cdx_in.get_cir(size_t(0), cir_number));
+
+	const unsigned masks[] = { CDX::fields_type, CDX::fields_id,
+			CDX::fields_delay, CDX::fields_real, CDX::fields_imag,
+			CDX::fields_amplitude, CDX::fields_delay | CDX::fields_amplitude,
+			CDX::fields_id | CDX::fields_delay, CDX::all_component_fields };
+
+	for (unsigned fields : masks) {
+		cout << "checking fields " << fields << "..." << endl;
+
+		CDX::CIRArena arena;
+		vector<CDX::arena_cir_t> arena_cirs;
+		cdx_in.get_cirs(0, 0, nof_cirs, arena, arena_cirs, fields);
+
+		CDX::cir_block_t block;
+		cdx_in.read_cirs(0, 0, nof_cirs, block, fields);
+		if (block.size() != block.offsets.back()
+				or block.types.size()
+						!= (fields & CDX::fields_type ? block.size() : 0)
+				or block.ids.size()
+						!= (fields & CDX::fields_id ? block.size() : 0)
+				or block.delays.size()
+						!= (fields & CDX::fields_delay ? block.size() : 0)
+				or block.reals.size()
+						!= (fields & CDX::fields_real ? block.size() : 0)
+				or block.imags.size()
+						!= (fields & CDX::fields_imag ? block.size() : 0))
+			fail("read_cirs: arrays have wrong sizes.");
+
+		CDX::CIRPrefetcher prefetcher(shared_in, "link0", 4, fields);
+
+		CDX::ComponentsSoA soa;
+		for (CDX::cir_number_t cir_number = 0; cir_number < nof_cirs;
+				cir_number++) {
+			const CDX::cir_t &full = full_cirs[cir_number];
+			const size_t n = full.components.size();
+
+			const CDX::cir_t by_name = cdx_in.get_cir("link0", cir_number,
+					fields);
+			const CDX::cir_t shared = shared_in.get_cir(size_t(0), cir_number,
+					fields);
+			const CDX::cir_t &prefetched = prefetcher.get_cir(cir_number);
+			const CDX::arena_cir_t arena_cir = cdx_in.get_cir(0, cir_number,
+					arena, fields);
+			const double soa_ref_delay = cdx_in.read_cir(0, cir_number, soa,
+					fields);
+
+			bool ok = by_name.ref_delay == full.ref_delay
+					and by_name.components.size() == n;
+			for (size_t c = 0; ok and c < n; c++)
+				ok = equal(by_name.components[c],
+						masked(full.components[c], fields));
+			check(ok, "get_cir", fields, cir_number);
+
+			ok = shared.components.size() == n
+					and prefetched.components.size() == n;
+			for (size_t c = 0; ok and c < n; c++)
+				ok = equal(shared.components[c], by_name.components[c])
+						and equal(prefetched.components[c],
+								by_name.components[c]);
+			check(ok, "shared reader or prefetcher", fields, cir_number);
+
+			ok = arena_cir.size() == n and arena_cirs[cir_number].size() == n
+					and arena_cirs[cir_number].ref_delay == full.ref_delay;
+			for (size_t c = 0; ok and c < n; c++)
+				ok = equal(arena_cir[c], by_name.components[c])
+						and equal(arena_cirs[cir_number][c],
+								by_name.components[c]);
+			check(ok, "get_cir or get_cirs with arena", fields, cir_number);
+
+			ok = soa_ref_delay == full.ref_delay and soa.size() == n;
+			for (size_t c = 0; ok and c < n; c++)
+				ok = (not (fields & CDX::fields_type)
+						or soa.types[c] == full.components[c].type)
+						and (not (fields & CDX::fields_id)
+								or soa.ids[c] == full.components[c].id)
+						and (not (fields & CDX::fields_delay)
+								or soa.delays[c] == full.components[c].delay)
+						and (not (fields & CDX::fields_real)
+								or soa.reals[c]
+										== full.components[c].amplitude.real())
+						and (not (fields & CDX::fields_imag)
+								or soa.imags[c]
+										== full.components[c].amplitude.imag());
+			check(ok, "read_cir", fields, cir_number);
+
+			ok = block.ref_delays[cir_number] == full.ref_delay
+					and block.offsets[cir_number + 1]
+							- block.offsets[cir_number] == n;
+			for (size_t c = 0; ok and c < n; c++) {
+				const size_t i = block.offsets[cir_number] + c;
+				const CDX::impulse_t expected = masked(full.components[c],
+						fields);
+				ok = (block.types.empty() or block.types[i] == expected.type)
+						and (block.ids.empty() or block.ids[i] == expected.id)
+						and (block.delays.empty()
+								or block.delays[i] == expected.delay)
+						and (block.reals.empty()
+								or block.reals[i] == expected.amplitude.real())
+						and (block.imags.empty()
+								or block.imags[i] == expected.amplitude.imag());
+			}
+			check(ok, "read_cirs", fields, cir_number);
+		}
+	}
+
+	cout << "checking invalid masks..." << endl;
+	CDX::cir_block_t block;
+	expect_logic_error([&cdx_in] {cdx_in.get_cir(size_t(0), 1, 0);},
+			"get_cir with empty mask");
+	expect_logic_error(
+			[&cdx_in] {cdx_in.get_cir(size_t(0), 1, CDX::all_component_fields + 1);},
+			"get_cir with unknown field");
+	expect_logic_error([&cdx_in, &block] {cdx_in.read_cirs(0, 0, 1, block, 0);},
+			"read_cirs with empty mask");
+
+	cout << "all done." << endl;
+}
@@ -0,0 +1,302 @@
+/**
+ * \file cdx-test-follow.cpp
+ *
+ * \brief Follows a continuous-delay CDX file with CDX::FollowContinuousDelayFile while a
+ * child process writes it in SWMR mode, partly before and partly after switching to SWMR
+ * mode. Checks that the CIRs arrive in several steps, in order and complete, and that the
+ * closed file is followed as well, before and after it has been compacted. Checks that a
+ * query after a refresh finds the CIRs appended to a block of delay bounds it saw before.
+ */
+
+#include "../../cdx/WriteContinuousDelayFile.h"
+#include "../../cdx/FollowContinuousDelayFile.h"
+#include "../cdx-test-common.h"
+
+#include <cstdio>
+#include <iostream>
+#include <stdexcept>
+#include <sstream>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace std;
+using namespace fixture;
+
+/// CIRs written before the writer switches to SWMR mode
+const CDX::cir_number_t nof_cirs_before_swmr = 40;
+
+/// total number of CIRs written
+const CDX::cir_number_t nof_cirs = 300;
+
+/**
+ * \brief Sends a byte to the other process.
+ */
+static void signal_other(int fd) {
+	const char byte = 0;
+	if (write(fd, &byte, 1) != 1)
+		fail("write to pipe failed.");
+}
+
+/**
+ * \brief Waits for a byte of the other process.
+ */
+static void wait_for_other(int fd) {
+	char byte;
+	if (read(fd, &byte, 1) != 1)
+		fail("read from pipe failed.");
+}
+
+/**
+ * \brief Writes the file in the child process, synchronized with the follower by pipes.
+ */
+static void write_file(const string &file_name, int to_follower,
+		int to_writer) {
+	const vector<string> link_names = { "link0", "link1" };
+	CDX::links_to_component_types_t component_types;
+	for (const auto &link_name : link_names)
+		component_types[link_name] = { { 0, "LOS" }, { 1, "Scatterer" } };
+
+	CDX::WriteContinuousDelayFile cdx_out(file_name, 3e8, 100.0, 1e9,
+			link_names, component_types, false, CDX::get_swmr_access_plist());
+	write_cirs(cdx_out, 0, nof_cirs_before_swmr);
+
+	CDX::swmr_options_t options;
+	options.flush_interval_cirs = 16;
+	options.flush_interval_s = 0.0;
+	cdx_out.enable_swmr_write(options);
+
+	signal_other(to_follower);
+
+	for (CDX::cir_number_t n = nof_cirs_before_swmr; n < nof_cirs; n++) {
+		write_cirs(cdx_out, n, n + 1);
+		usleep(200);
+	}
+	cdx_out.sync();
+
+	// the file is closed after the follower:
+	wait_for_other(to_writer);
+}
+
+/**
+ * \brief Writes CIRs with a single component at a given delay.
+ */
+static void write_cirs_at(CDX::WriteContinuousDelayFile &cdx_out,
+		CDX::cir_number_t first_cir, CDX::cir_number_t end_cir, double delay) {
+	CDX::components_t cir(1);
+	cir[0].type = 0;
+	cir[0].id = 0;
+	cir[0].delay = delay;
+	cir[0].amplitude = complex<double>(1.0, 0.0);
+
+	for (CDX::cir_number_t n = first_cir; n < end_cir; n++)
+		cdx_out.write_cir({ cir }, { 0.0 }, n);
+}
+
+/**
+ * \brief Writes a file in SWMR mode in the child process in two steps, both of them in
+ * the first block of the delay bounds.
+ */
+static void write_query_file(const string &file_name, int to_follower,
+		int to_writer) {
+	CDX::links_to_component_types_t component_types;
+	component_types["link0"] = { { 0, "LOS" } };
+
+	CDX::WriteContinuousDelayFile cdx_out(file_name, 3e8, 100.0, 1e9,
+			{ "link0" }, component_types, false, CDX::get_swmr_access_plist());
+
+	CDX::swmr_options_t options;
+	options.flush_interval_cirs = 0;
+	options.flush_interval_s = 0.0;
+	cdx_out.enable_swmr_write(options);
+
+	write_cirs_at(cdx_out, 0, 10, 1e-6);
+	cdx_out.sync();
+	signal_other(to_follower);
+
+	wait_for_other(to_writer);
+	write_cirs_at(cdx_out, 10, 20, 5.5e-6);
+	cdx_out.sync();
+	signal_other(to_follower);
+
+	wait_for_other(to_writer);
+}
+
+/**
+ * \brief Runs a writer in a child process, which gets the pipes to and from the follower.
+ */
+template<typename F>
+static pid_t start_writer(F writer, int to_follower[2], int to_writer[2]) {
+	if (pipe(to_follower) != 0 or pipe(to_writer) != 0)
+		fail("pipe failed.");
+
+	cout.flush();
+	const pid_t pid = fork();
+	if (pid < 0)
+		fail("fork failed.");
+
+	if (pid == 0) {
+		try {
+			writer(to_follower[1], to_writer[0]);
+		} catch (...) {
+			_exit(2);
+		}
+		_exit(0);
+	}
+
+	return pid;
+}
+
+static void wait_for_writer(pid_t pid) {
+	int status;
+	waitpid(pid, &status, 0);
+	if (not WIFEXITED(status) or WEXITSTATUS(status) != 0)
+		fail("the writing child process failed.");
+}
+
+/**
+ * \brief Checks a block of CIRs returned by the follower.
+ */
+static void check_block(const CDX::cir_block_t &block, size_t link_index) {
+	for (size_t k = 0; k < block.nof_cirs(); k++) {
+		const CDX::cir_number_t n = block.first_cir + k;
+
+		bool ok = block.ref_delays[k] == reference_delay_of(link_index, n)
+				and block.offsets[k + 1] - block.offsets[k]
+						== nof_components_of(link_index, n);
+		for (size_t i = block.offsets[k], c = 0; ok and i < block.offsets[k + 1];
+				i++, c++) {
+			const CDX::impulse_t component = component_of(link_index, n, c);
+			ok = block.types[i] == component.type
+					and block.ids[i] == component.id
+					and block.delays[i] == component.delay
+					and block.reals[i] == component.amplitude.real()
+					and block.imags[i] == component.amplitude.imag();
+		}
+
+		if (not ok) {
+			stringstream ss;
+			ss << "CIR " << n << " of link " << link_index << " does not match.";
+			fail(ss.str());
+		}
+	}
+}
+
+/**
+ * \brief Reads all CIRs with read_new_cirs and returns the number of calls that returned CIRs.
+ */
+static size_t follow(CDX::FollowContinuousDelayFile &cdx_in) {
+	vector<CDX::cir_block_t> blocks;
+	size_t nof_steps = 0;
+
+	while (cdx_in.get_next_cir() < nof_cirs) {
+		const CDX::cir_number_t first_cir = cdx_in.get_next_cir();
+		const size_t count = cdx_in.read_new_cirs(blocks, 10.0);
+		if (count == 0)
+			fail("no new CIRs within 10 s.");
+
+		if (blocks.size() != 2 or blocks[0].first_cir != first_cir
+				or blocks[0].nof_cirs() != count or blocks[1].nof_cirs() != count)
+			fail("read_new_cirs returned wrong blocks.");
+
+		for (size_t l = 0; l < blocks.size(); l++)
+			check_block(blocks[l], l);
+
+		nof_steps++;
+	}
+
+	if (cdx_in.get_next_cir() != nof_cirs)
+		fail("follower read too many CIRs.");
+
+	return nof_steps;
+}
+
+int main(void) {
+	cout << "cdx-test-follow start." << endl;
+
+	const string file_name = "cdx-test-follow.cdx";
+
+	int to_follower[2], to_writer[2];
+	pid_t pid = start_writer([&](int to_follower, int to_writer) {
+		write_file(file_name, to_follower, to_writer);
+	}, to_follower, to_writer);
+
+	cout << "following the file while it is written..." << endl;
+
+	wait_for_other(to_follower[0]);
+
+	{
+		CDX::FollowContinuousDelayFile cdx_in(file_name);
+		if (cdx_in.get_nof_cirs() < nof_cirs_before_swmr)
+			fail("CIRs written before SWMR mode are missing.");
+
+		const size_t nof_steps = follow(cdx_in);
+		if (nof_steps < 3) {
+			stringstream ss;
+			ss << "follower saw the CIRs in " << nof_steps << " steps only.";
+			fail(ss.str());
+		}
+
+		// nothing is left to read:
+		vector<CDX::cir_block_t> blocks;
+		if (cdx_in.read_new_cirs(blocks, 0.0) != 0)
+			fail("read_new_cirs returned CIRs after the last one.");
+
+		try {
+			CDX::cir_block_t block;
+			cdx_in.read_cirs(0, nof_cirs - 1, 2, block);
+			fail("reading CIRs after the last one did not throw.");
+		} catch (logic_error &) {
+		}
+	}
+
+	signal_other(to_writer[1]);
+	wait_for_writer(pid);
+
+	cout << "following the closed file..." << endl;
+	{
+		CDX::FollowContinuousDelayFile cdx_in(file_name);
+		if (cdx_in.get_nof_cirs() != nof_cirs or follow(cdx_in) != 1)
+			fail("the closed file was not read at once.");
+	}
+
+	cout << "following the compacted file..." << endl;
+	CDX::compact_continuous_delay_file(file_name);
+	{
+		CDX::FollowContinuousDelayFile cdx_in(file_name);
+		if (cdx_in.get_nof_stored_cirs(0) != nof_cirs)
+			fail("the compacted file has appended CIRs.");
+		if (cdx_in.get_nof_cirs() != nof_cirs or follow(cdx_in) != 1)
+			fail("the compacted file was not read at once.");
+	}
+
+	cout << "querying CIRs appended to the block of a previous query..." << endl;
+	pid = start_writer([&](int to_follower, int to_writer) {
+		write_query_file(file_name, to_follower, to_writer);
+	}, to_follower, to_writer);
+	{
+		wait_for_other(to_follower[0]);
+		CDX::FollowContinuousDelayFile cdx_in(file_name);
+
+		CDX::query_t query;
+		query.min_delay_s = 5e-6;
+		query.max_delay_s = 6e-6;
+		if (cdx_in.get_nof_cirs() != 10 or cdx_in.query(0, query).size() != 0)
+			fail("wrong result of the query of the first CIRs.");
+
+		signal_other(to_writer[1]);
+		wait_for_other(to_follower[0]);
+
+		if (cdx_in.refresh() != 20)
+			fail("the CIRs appended to the block are missing.");
+		const CDX::query_result_t result = cdx_in.query(0, query);
+		if (result.size() != 10 or result.cir_numbers.front() != 10)
+			fail("the query skipped CIRs appended after the previous query.");
+	}
+	signal_other(to_writer[1]);
+	wait_for_writer(pid);
+
+	remove(file_name.c_str());
+
+	cout << "all done." << endl;
+}
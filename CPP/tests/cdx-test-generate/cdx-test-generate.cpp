@@ -0,0 +1,211 @@
+/**
+ * \file cdx-test-generate.cpp
+ *
+ * \brief Generates continuous-delay and discrete-delay CDX files with CDX::generate and
+ * checks that they do not depend on the number of threads, that the seed changes them,
+ * that scatterers are born and die, and that the output options are applied.
+ */
+
+#include "../../cdx/Generate.h"
+#include "../../cdx/ReadContinuousDelayFile.h"
+#include "../../cdx/ReadDiscreteDelayFile.h"
+#include "../../cdx/Shards.h"
+#include "../cdx-test-common.h"
+
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <set>
+#include <stdexcept>
+
+using namespace std;
+
+static CDX::generate_options_t get_options() {
+	CDX::generate_options_t options;
+	options.nof_satellites = 3;
+	options.nof_cirs = 1000;
+	options.cir_rate_Hz = 100.0;
+	options.mean_nof_scatterers = 20.0;
+	options.mean_scatterer_lifetime_s = 1.0;
+	options.nof_threads = 1;
+	return options;
+}
+
+/**
+ * \brief Returns true if all CIRs of both files are equal.
+ */
+static bool equal_cirs(const string &file_name_a, const string &file_name_b) {
+	CDX::ReadContinuousDelayFile cdx_a(file_name_a);
+	CDX::ReadContinuousDelayFile cdx_b(file_name_b);
+	if (cdx_a.get_nof_links() != cdx_b.get_nof_links()
+			or cdx_a.get_nof_cirs() != cdx_b.get_nof_cirs())
+		return false;
+
+	for (size_t l = 0; l < cdx_a.get_nof_links(); l++)
+		for (CDX::cir_number_t n = 0; n < cdx_a.get_nof_cirs(); n++) {
+			const CDX::cir_t a = cdx_a.get_cir(l, n);
+			const CDX::cir_t b = cdx_b.get_cir(l, n);
+			if (a.ref_delay != b.ref_delay
+					or a.components.size() != b.components.size())
+				return false;
+			for (size_t c = 0; c < a.components.size(); c++)
+				if (a.components[c].id != b.components[c].id
+						or a.components[c].type != b.components[c].type
+						or a.components[c].delay != b.components[c].delay
+						or a.components[c].amplitude
+								!= b.components[c].amplitude)
+					return false;
+		}
+	return true;
+}
+
+static void test_continuous_delay(const string &file_name,
+		const string &other_file_name) {
+	cout << "continuous-delay file..." << endl;
+	CDX::generate_options_t options = get_options();
+	const CDX::generate_stats_t stats = CDX::generate(file_name, options);
+
+	{
+		CDX::ReadContinuousDelayFile cdx_in(file_name);
+		if (cdx_in.get_nof_links() != options.nof_satellites
+				or cdx_in.get_link_names()[2] != "satellite2"
+				or cdx_in.get_nof_cirs() != options.nof_cirs
+				or stats.nof_cirs != options.nof_cirs)
+			fail("wrong links or number of CIRs.");
+
+		uint64_t nof_components = 0;
+		for (size_t l = 0; l < cdx_in.get_nof_links(); l++) {
+			set<uint64_t> first_ids, last_ids;
+			for (CDX::cir_number_t n = 0; n < cdx_in.get_nof_cirs(); n++) {
+				const CDX::cir_t cir = cdx_in.get_cir(l, n);
+				nof_components += cir.components.size();
+
+				if (cir.components.empty() or cir.components[0].type != 0
+						or cir.components[0].id != 0
+						or cir.components[0].delay != cir.ref_delay
+						or abs(abs(cir.components[0].amplitude) - 1.0) > 1e-12)
+					fail("CIR does not start with the LOS component.");
+
+				for (size_t c = 1; c < cir.components.size(); c++) {
+					if (cir.components[c].type != 256
+							or cir.components[c].delay <= cir.ref_delay)
+						fail("wrong scatterer.");
+					if (n == 0)
+						first_ids.insert(cir.components[c].id);
+					if (n + 1 == cdx_in.get_nof_cirs())
+						last_ids.insert(cir.components[c].id);
+				}
+			}
+
+			// after 10 s, no scatterer of the first CIR is alive with a mean lifetime of 1 s:
+			if (first_ids.empty() or last_ids.empty())
+				fail("no scatterers alive.");
+			for (uint64_t id : first_ids)
+				if (last_ids.count(id))
+					fail("a scatterer does not die.");
+		}
+
+		if (stats.nof_components != nof_components)
+			fail("wrong number of components in the stats.");
+
+		// on average mean_nof_scatterers are alive, each for about 100 CIRs:
+		const double mean_nof_scatterers = double(
+				nof_components - options.nof_satellites * options.nof_cirs)
+				/ (options.nof_satellites * options.nof_cirs);
+		if (fabs(mean_nof_scatterers - options.mean_nof_scatterers) > 5.0)
+			fail("wrong mean number of scatterers.");
+		if (stats.nof_scatterers < options.nof_satellites * 150
+				or stats.nof_scatterers > options.nof_satellites * 300)
+			fail("wrong number of scatterers in the stats.");
+	}
+
+	cout << "threads and seeds..." << endl;
+	options.nof_threads = 4;
+	if (CDX::generate(other_file_name, options).nof_scatterers
+			!= stats.nof_scatterers or not equal_cirs(file_name, other_file_name))
+		fail("the file depends on the number of threads.");
+
+	options.seed = 2;
+	CDX::generate(other_file_name, options);
+	if (equal_cirs(file_name, other_file_name))
+		fail("the file does not depend on the seed.");
+
+	cout << "shards..." << endl;
+	options.seed = 1;
+	options.nof_shards = 3;
+	CDX::generate(other_file_name, options);
+	if (not equal_cirs(file_name, other_file_name))
+		fail("shards differ from the file.");
+	for (size_t k = 0; k < options.nof_shards; k++)
+		remove(CDX::get_shard_file_name(other_file_name, k).c_str());
+
+	cout << "track index and writer options..." << endl;
+	options = get_options();
+	options.nof_cirs = 300;
+	options.write_track_index = true;
+	options.writer_options.new_style_groups = true;
+	options.writer_options.paged_aggregation = true;
+	CDX::generate(other_file_name, options);
+	{
+		CDX::ReadContinuousDelayFile cdx_in(other_file_name);
+		if (cdx_in.get_track(0, 0).cir_numbers.size() != options.nof_cirs)
+			fail("wrong track of the LOS component.");
+	}
+	remove(other_file_name.c_str());
+}
+
+static void test_discrete_delay(const string &file_name,
+		const string &other_file_name) {
+	cout << "discrete-delay file..." << endl;
+	CDX::generate_options_t options = get_options();
+	options.nof_cirs = 300;
+	options.discrete_delay = true;
+	options.nof_delay_samples = 64;
+	CDX::generate(file_name, options);
+
+	options.nof_threads = 3;
+	CDX::generate(other_file_name, options);
+
+	CDX::ReadDiscreteDelayFile cdx_in(file_name);
+	CDX::ReadDiscreteDelayFile other_cdx_in(other_file_name);
+	for (size_t l = 0; l < options.nof_satellites; l++) {
+		const auto cirs = cdx_in.get_cirs(l);
+		if (cirs.size() != options.nof_cirs
+				or cirs[0].size() != options.nof_delay_samples)
+			fail("wrong discrete-delay CIRs.");
+		if (cirs != other_cdx_in.get_cirs(l))
+			fail("the discrete-delay file depends on the number of threads.");
+
+		// the LOS component is at sample 4, much stronger than the scatterers at -20 dB:
+		for (const auto &cir : cirs)
+			if (abs(cir[4]) < 0.5 or abs(cir[0]) > abs(cir[4]))
+				fail("the LOS component is not at its delay sample.");
+	}
+}
+
+int main(void) {
+	cout << "cdx-test-generate start." << endl;
+
+	const string file_name = "cdx-test-generate.cdx";
+	const string other_file_name = "cdx-test-generate-other.cdx";
+
+	test_continuous_delay(file_name, other_file_name);
+	test_discrete_delay(file_name, other_file_name);
+
+	expect_logic_error([&]() {
+		CDX::generate_options_t options;
+		options.nof_satellites = 0;
+		CDX::generate(file_name, options);
+	}, "generate without satellites");
+	expect_logic_error([&]() {
+		CDX::generate_options_t options;
+		options.discrete_delay = true;
+		options.nof_shards = 2;
+		CDX::generate(file_name, options);
+	}, "generate a discrete-delay file as shards");
+
+	remove(file_name.c_str());
+	remove(other_file_name.c_str());
+
+	cout << "all done." << endl;
+}
@@ -0,0 +1,206 @@
+/**
+ * \file cdx-test-in-memory.cpp
+ *
+ * \brief Writes continuous-delay and discrete-delay CDX files in memory, hands them to
+ * readers as file images and checks that the readers return the written CIRs and that no
+ * file is written to disk, unless a backing store is requested. Also resumes writing a
+ * file opened from an image and takes the image of a file on disk.
+ */
+
+#include "../../cdx/WriteContinuousDelayFile.h"
+#include "../../cdx/ReadContinuousDelayFile.h"
+#include "../../cdx/WriteDiscreteDelayFile.h"
+#include "../../cdx/ReadDiscreteDelayFile.h"
+#include "../cdx-test-common.h"
+
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+using namespace std;
+
+const vector<string> link_names = { "link0", "link1" };
+const CDX::cir_number_t nof_cirs = 50;
+
+static bool exists(const string &file_name) {
+	return ifstream(file_name).good();
+}
+
+static size_t nof_components_of(size_t link_index,
+		CDX::cir_number_t cir_number) {
+	return (cir_number + link_index) % 4;
+}
+
+static void write_cirs(CDX::WriteContinuousDelayFile &cdx_out,
+		CDX::cir_number_t first_cir, CDX::cir_number_t end_cir) {
+	vector<CDX::components_t> cirs(link_names.size());
+	for (CDX::cir_number_t n = first_cir; n < end_cir; n++) {
+		for (size_t l = 0; l < cirs.size(); l++) {
+			cirs[l].resize(nof_components_of(l, n));
+			for (size_t c = 0; c < cirs[l].size(); c++) {
+				cirs[l][c].type = 0;
+				cirs[l][c].id = c;
+				cirs[l][c].delay = 1e-6 * c;
+				cirs[l][c].amplitude = complex<double>(n, l);
+			}
+		}
+		cdx_out.write_cir(cirs, { 1e-6 * n, 2e-6 * n }, n);
+	}
+}
+
+static CDX::links_to_component_types_t component_types = { { "link0", { {
+		0, "LOS" } } }, { "link1", { { 0, "LOS" } } } };
+
+/**
+ * \brief Checks the CIRs, reference delays and tracks of a continuous-delay file.
+ */
+static void check_continuous_file(CDX::ReadContinuousDelayFile &cdx_in,
+		CDX::cir_number_t nof_cirs, const string &what) {
+	if (cdx_in.get_nof_cirs() != nof_cirs)
+		fail(what + ": wrong number of CIRs.");
+
+	for (size_t l = 0; l < link_names.size(); l++) {
+		for (CDX::cir_number_t n = 0; n < nof_cirs; n++) {
+			const CDX::cir_t cir = cdx_in.get_cir(l, n);
+			if (cir.components.size() != nof_components_of(l, n)
+					or cir.ref_delay != 1e-6 * (l + 1) * n
+					or (not cir.components.empty()
+							and cir.components[0].amplitude
+									!= complex<double>(n, l)))
+				fail(what + ": wrong CIR.");
+		}
+
+		// component 0 is in all CIRs with at least one component:
+		size_t nof_cirs_with_components = 0;
+		for (CDX::cir_number_t n = 0; n < nof_cirs; n++)
+			nof_cirs_with_components += nof_components_of(l, n) > 0;
+		if (cdx_in.get_track(l, 0).cir_numbers.size()
+				!= nof_cirs_with_components)
+			fail(what + ": wrong track.");
+	}
+}
+
+static void test_continuous_delay(const string &file_name) {
+	cout << "continuous-delay file in memory..." << endl;
+	vector<char> image;
+	{
+		CDX::WriteContinuousDelayFile cdx_out(file_name, 3e8, 100.0, 1e9,
+				link_names, component_types, true,
+				CDX::get_in_memory_access_plist());
+		write_cirs(cdx_out, 0, nof_cirs);
+		image = cdx_out.get_file_image();
+
+		// writing continues after the image has been taken:
+		write_cirs(cdx_out, nof_cirs, nof_cirs + 10);
+	}
+	if (exists(file_name))
+		fail("file in memory was written to disk.");
+
+	{
+		CDX::ReadContinuousDelayFile cdx_in(file_name,
+				CDX::get_file_image_access_plist(image));
+		check_continuous_file(cdx_in, nof_cirs, "image of a writer");
+	}
+
+	cout << "resuming a file from an image..." << endl;
+	{
+		CDX::WriteContinuousDelayFile cdx_out(file_name, true,
+				CDX::get_file_image_access_plist(image));
+		write_cirs(cdx_out, nof_cirs, 2 * nof_cirs);
+		image = cdx_out.get_file_image();
+	}
+	if (exists(file_name))
+		fail("file resumed from an image was written to disk.");
+	{
+		CDX::ReadContinuousDelayFile cdx_in(file_name,
+				CDX::get_file_image_access_plist(image));
+		check_continuous_file(cdx_in, 2 * nof_cirs, "image of a resumed file");
+	}
+
+	cout << "continuous-delay file with backing store..." << endl;
+	{
+		CDX::WriteContinuousDelayFile cdx_out(file_name, 3e8, 100.0, 1e9,
+				link_names, component_types, true,
+				CDX::get_in_memory_access_plist(true));
+		write_cirs(cdx_out, 0, nof_cirs);
+	}
+	{
+		CDX::ReadContinuousDelayFile cdx_in(file_name);
+		check_continuous_file(cdx_in, nof_cirs, "backing store");
+
+		// the image of a file on disk:
+		image = cdx_in.get_file_image();
+	}
+	remove(file_name.c_str());
+	{
+		CDX::ReadContinuousDelayFile cdx_in(file_name,
+				CDX::get_file_image_access_plist(image));
+		check_continuous_file(cdx_in, nof_cirs, "image of a reader");
+	}
+
+	cout << "SWMR mode..." << endl;
+	{
+		CDX::WriteContinuousDelayFile cdx_out(file_name, 3e8, 100.0, 1e9,
+				link_names, component_types, false,
+				CDX::get_swmr_access_plist());
+		cdx_out.enable_swmr_write();
+		write_cirs(cdx_out, 0, 5);
+		expect_logic_error([&]() {
+			cdx_out.get_file_image();
+		}, "get_file_image in SWMR mode");
+	}
+	remove(file_name.c_str());
+
+	expect_logic_error([&]() {
+		CDX::get_file_image_access_plist(vector<char>());
+	}, "get_file_image_access_plist of an empty image");
+}
+
+static void test_discrete_delay(const string &file_name) {
+	cout << "discrete-delay file in memory..." << endl;
+	const size_t nof_delay_samples = 16;
+
+	vector<char> image;
+	{
+		CDX::WriteDiscreteDelayFile cdx_out(file_name, 3e8, 100.0, 1e9,
+				link_names, 1e8, CDX::get_in_memory_access_plist());
+		cdx_out.setup_link(0, nof_delay_samples, 0.0);
+		cdx_out.setup_link(1, nof_delay_samples, 0.0);
+
+		vector<complex<double> > cir(nof_delay_samples);
+		for (size_t k = 0; k < nof_cirs; k++) {
+			for (size_t n = 0; n < cir.size(); n++)
+				cir[n] = complex<double>(k, n);
+			cdx_out.append_cir_snapshot(0, cir, 1e-6 * k);
+			cdx_out.append_cir_snapshot(1, cir, 1e-6 * k);
+		}
+		image = cdx_out.get_file_image();
+	}
+	if (exists(file_name))
+		fail("discrete-delay file in memory was written to disk.");
+
+	CDX::ReadDiscreteDelayFile cdx_in(file_name,
+			CDX::get_file_image_access_plist(image));
+	for (size_t l = 0; l < link_names.size(); l++) {
+		const auto cirs = cdx_in.get_cirs(l);
+		if (cirs.size() != nof_cirs or cirs.back().size() != nof_delay_samples
+				or cirs.back().back()
+						!= complex<double>(nof_cirs - 1, nof_delay_samples - 1))
+			fail("wrong discrete-delay CIRs.");
+	}
+}
+
+int main(void) {
+	cout << "cdx-test-in-memory start." << endl;
+
+	const string file_name = "cdx-test-in-memory.cdx";
+	remove(file_name.c_str());
+
+	test_continuous_delay(file_name);
+	test_discrete_delay(file_name);
+
+	remove(file_name.c_str());
+
+	cout << "all done." << endl;
+}
@@ -0,0 +1,164 @@
+/**
+ * \file cdx-test-large-buffers.cpp
+ *
+ * \brief Writes and reads datasets of 10^7 elements through all paths of the library that
+ * used to hold their data in arrays on the stack: a 2D matrix written by WriteFile::write,
+ * a CIR with 10^7 components, the reference delays of 10^7 CIRs and a discrete-delay CIR
+ * with 10^7 delay samples. Each of these overflowed the default stack of 8 MB before.
+ */
+
+#include "../../cdx/WriteContinuousDelayFile.h"
+#include "../../cdx/ReadContinuousDelayFile.h"
+#include "../../cdx/WriteDiscreteDelayFile.h"
+#include "../../cdx/ReadDiscreteDelayFile.h"
+#include "../cdx-test-common.h"
+
+#include <cstdio>
+#include <iostream>
+#include <stdexcept>
+#include <sstream>
+
+using namespace std;
+
+const size_t nof_elements = 10000000;
+
+static void test_matrix_and_cir(const string &file_name) {
+	const size_t nof_rows = 1000;
+	const size_t nof_columns = nof_elements / nof_rows;
+
+	{
+		CDX::links_to_component_types_t links_to_component_types = { {
+				"link0", { { 0, "LOS" } } } };
+		CDX::WriteContinuousDelayFile cdx_out(file_name, 3e8, 100.0, 1e9, {
+				"link0" }, links_to_component_types);
+
+		cout << "writing matrix of " << nof_rows << " x " << nof_columns
+				<< " elements..." << endl;
+		{
+			vector<vector<double> > matrix(nof_rows,
+					vector<double>(nof_columns));
+			for (size_t k = 0; k < nof_rows; k++)
+				for (size_t n = 0; n < nof_columns; n++)
+					matrix[k][n] = k * nof_columns + n;
+			cdx_out.create_group("/stress");
+			cdx_out.write("/stress/matrix", matrix);
+		}
+
+		cout << "writing CIR with " << nof_elements << " components..."
+				<< endl;
+		vector<CDX::components_t> cirs(1);
+		cirs[0].resize(nof_elements);
+		for (size_t c = 0; c < nof_elements; c++) {
+			cirs[0][c].type = 0;
+			cirs[0][c].id = c;
+			cirs[0][c].delay = 1e-12 * c;
+			cirs[0][c].amplitude = complex<double>(c, -1.0 * c);
+		}
+		cdx_out.write_cir(std::move(cirs), vector<double>(1, 1e-6), 0);
+	}
+
+	{
+		H5::H5File h5file(file_name, H5F_ACC_RDONLY);
+		H5::DataSet dataset = h5file.openDataSet("/stress/matrix");
+		hsize_t dims[2];
+		dataset.getSpace().getSimpleExtentDims(dims);
+		if (dims[0] != nof_rows or dims[1] != nof_columns)
+			fail("matrix has wrong dimensions.");
+
+		vector<double> matrix(nof_elements);
+		dataset.read(matrix.data(), H5::PredType::NATIVE_DOUBLE);
+		for (size_t k = 0; k < nof_elements; k++)
+			if (matrix[k] != k)
+				fail("matrix does not match input data.");
+	}
+
+	cout << "reading CIR with " << nof_elements << " components..." << endl;
+	CDX::ReadContinuousDelayFile cdx_in(file_name);
+	const CDX::cir_t cir = cdx_in.get_cir("link0", 0);
+
+	if (cir.ref_delay != 1e-6 or cir.components.size() != nof_elements)
+		fail("CIR has wrong size or reference delay.");
+
+	for (size_t c = 0; c < nof_elements; c++)
+		if (cir.components[c].id != c
+				or cir.components[c].delay != 1e-12 * c
+				or cir.components[c].amplitude
+						!= complex<double>(c, -1.0 * c))
+			fail("CIR does not match input data.");
+}
+
+static void test_reference_delays(const string &file_name) {
+	cout << "reading " << nof_elements << " reference delays..." << endl;
+
+	// the writers append reference delays to a dataset with chunks of one element, which
+	// is slow for this many CIRs, so the dataset is replaced by a contiguous one:
+	{
+		H5::H5File h5file(file_name, H5F_ACC_RDWR);
+		H5::Group link_group = h5file.openGroup("/links/link0");
+		link_group.unlink("reference_delays");
+
+		const hsize_t dims[1] = { nof_elements };
+		H5::DataSet dataset = link_group.createDataSet("reference_delays",
+				H5::PredType::NATIVE_DOUBLE, H5::DataSpace(1, dims));
+
+		vector<double> reference_delays(nof_elements);
+		for (size_t k = 0; k < nof_elements; k++)
+			reference_delays[k] = 1e-9 * k;
+		dataset.write(reference_delays.data(), H5::PredType::NATIVE_DOUBLE);
+	}
+
+	CDX::ReadContinuousDelayFile cdx_in(file_name);
+	const vector<double> reference_delays = cdx_in.get_reference_delays(
+			"link0");
+
+	if (reference_delays.size() != nof_elements)
+		fail("wrong number of reference delays.");
+
+	for (size_t k = 0; k < nof_elements; k++)
+		if (reference_delays[k] != 1e-9 * k)
+			fail("reference delays do not match input data.");
+}
+
+static void test_discrete_delay(const string &file_name) {
+	cout << "writing discrete-delay CIR with " << nof_elements
+			<< " delay samples..." << endl;
+
+	{
+		CDX::WriteDiscreteDelayFile cdx_out(file_name, 3e8, 100.0, 1e9, {
+				"link0" }, 1e9);
+		cdx_out.setup_link("link0", nof_elements, 0.0);
+
+		vector<complex<double> > data(nof_elements);
+		for (size_t n = 0; n < nof_elements; n++)
+			data[n] = complex<double>(n, 0.5 * n);
+		cdx_out.append_cir_snapshot("link0", data, 0.0);
+	}
+
+	cout << "reading discrete-delay CIR..." << endl;
+	CDX::ReadDiscreteDelayFile cdx_in(file_name);
+	const vector<vector<complex<double> > > cirs = cdx_in.get_cirs("link0");
+
+	if (cirs.size() != 1 or cirs[0].size() != nof_elements)
+		fail("discrete-delay CIR has wrong dimensions.");
+
+	for (size_t n = 0; n < nof_elements; n++)
+		if (cirs[0][n] != complex<double>(n, 0.5 * n))
+			fail("discrete-delay CIR does not match input data.");
+}
+
+int main(void) {
+	cout << "cdx-test-large-buffers start." << endl;
+
+	const string continuous_file_name = "cdx-test-large-buffers-continuous.cdx";
+	const string discrete_file_name = "cdx-test-large-buffers-discrete.cdx";
+
+	test_matrix_and_cir(continuous_file_name);
+	test_reference_delays(continuous_file_name);
+	test_discrete_delay(discrete_file_name);
+
+	// the files are several hundred MB:
+	remove(continuous_file_name.c_str());
+	remove(discrete_file_name.c_str());
+
+	cout << "all done." << endl;
+}
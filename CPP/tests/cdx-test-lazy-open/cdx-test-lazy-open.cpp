@@ -0,0 +1,184 @@
+/**
+ * \file cdx-test-lazy-open.cpp
+ *
+ * \brief Opens a continuous-delay CDX file lazily and eagerly and checks that both readers
+ * return the same CIRs, reference delays, component types and tracks. Then breaks the file
+ * in two ways and checks that the lazy reader reports a link with a different number of
+ * reference delays on first use and that both readers report a link with a missing CIR
+ * dataset in verify_nof_cirs.
+ */
+
+#include "../../cdx/WriteContinuousDelayFile.h"
+#include "../../cdx/ReadContinuousDelayFile.h"
+#include "../cdx-test-common.h"
+
+#include <cstdio>
+#include <iostream>
+#include <stdexcept>
+#include <sstream>
+
+using namespace std;
+
+const size_t nof_links = 3;
+const CDX::cir_number_t nof_cirs = 50;
+
+static size_t nof_components_of(size_t link_index,
+		CDX::cir_number_t cir_number) {
+	return (cir_number + 2 * link_index) % 6;
+}
+
+static void write_file(const string &file_name) {
+	vector<string> link_names;
+	CDX::links_to_component_types_t component_types;
+	for (size_t l = 0; l < nof_links; l++) {
+		link_names.push_back("link" + to_string(l));
+		component_types[link_names.back()] = { { 0, "LOS" }, { 1, "Scatterer" } };
+	}
+
+	CDX::WriteContinuousDelayFile cdx_out(file_name, 3e8, 100.0, 1e9,
+			link_names, component_types, true);
+
+	vector<CDX::components_t> cirs(nof_links);
+	vector<double> reference_delays(nof_links);
+	for (CDX::cir_number_t n = 0; n < nof_cirs; n++) {
+		for (size_t l = 0; l < nof_links; l++) {
+			cirs[l].resize(nof_components_of(l, n));
+			for (size_t c = 0; c < cirs[l].size(); c++) {
+				cirs[l][c].type = c % 2;
+				cirs[l][c].id = c;
+				cirs[l][c].delay = 1e-6 * c + 1e-8 * n;
+				cirs[l][c].amplitude = complex<double>(n, 10.0 * l + c);
+			}
+			reference_delays[l] = 1e-3 * l + 1e-6 * n;
+		}
+		cdx_out.write_cir(cirs, reference_delays, n);
+	}
+}
+
+static bool equal(const CDX::cir_t &a, const CDX::cir_t &b) {
+	if (a.ref_delay != b.ref_delay or a.components.size() != b.components.size())
+		return false;
+
+	for (size_t c = 0; c < a.components.size(); c++)
+		if (a.components[c].type != b.components[c].type
+				or a.components[c].id != b.components[c].id
+				or a.components[c].delay != b.components[c].delay
+				or a.components[c].amplitude != b.components[c].amplitude)
+			return false;
+
+	return true;
+}
+
+static void compare_readers(const string &file_name) {
+	CDX::ReadContinuousDelayFile eager(file_name);
+	CDX::ReadContinuousDelayFile lazy(file_name, H5::FileAccPropList::DEFAULT,
+			true);
+
+	if (eager.get_lazy_open() or not lazy.get_lazy_open())
+		fail("get_lazy_open returned a wrong value.");
+
+	if (lazy.get_nof_cirs() != nof_cirs or eager.get_nof_cirs() != nof_cirs
+			or lazy.get_nof_links() != nof_links)
+		fail("lazy reader returned a wrong number of CIRs or links.");
+
+	// the links are used in reverse order, so link 0 is opened last:
+	for (size_t l = nof_links; l-- > 0;) {
+		for (CDX::cir_number_t n = 0; n < nof_cirs; n++)
+			if (not equal(lazy.get_cir(l, n), eager.get_cir(l, n))) {
+				stringstream ss;
+				ss << "CIR " << n << " of link " << l << " differs.";
+				fail(ss.str());
+			}
+
+		if (lazy.get_reference_delays(l) != eager.get_reference_delays(l)
+				or lazy.get_component_types(l) != eager.get_component_types(l))
+			fail("reference delays or component types differ.");
+
+		const CDX::track_t lazy_track = lazy.get_track(l, 1);
+		const CDX::track_t eager_track = eager.get_track(l, 1);
+		if (lazy_track.cir_numbers != eager_track.cir_numbers
+				or lazy_track.delays != eager_track.delays)
+			fail("tracks differ.");
+	}
+
+	lazy.verify_nof_cirs();
+}
+
+/**
+ * \brief Drops the last reference delay of a link.
+ */
+static void shrink_reference_delays(const string &file_name,
+		const string &link_name) {
+	H5::H5File file(file_name, H5F_ACC_RDWR);
+	H5::DataSet dataset = file.openDataSet(
+			"/links/" + link_name + "/reference_delays");
+	const hsize_t size = nof_cirs - 1;
+	dataset.extend(&size);
+}
+
+/**
+ * \brief Deletes the dataset of the last CIR of a link.
+ */
+static void delete_last_cir(const string &file_name, const string &link_name) {
+	H5::H5File file(file_name, H5F_ACC_RDWR);
+	file.unlink(
+			"/links/" + link_name + "/cirs/" + to_string(nof_cirs - 1));
+}
+
+int main(void) {
+	cout << "cdx-test-lazy-open start." << endl;
+
+	const string file_name = "cdx-test-lazy-open.cdx";
+
+	cout << "comparing lazy and eager readers..." << endl;
+	write_file(file_name);
+	compare_readers(file_name);
+
+	cout << "checking a link with a missing CIR..." << endl;
+	delete_last_cir(file_name, "link2");
+	for (bool lazy_open : { false, true }) {
+		CDX::ReadContinuousDelayFile cdx_in(file_name,
+				H5::FileAccPropList::DEFAULT, lazy_open);
+		if (cdx_in.get_nof_cirs() != nof_cirs)
+			fail("reader returned a wrong number of CIRs.");
+		cdx_in.get_cir(2, 0);
+		expect_logic_error([&]() {
+			cdx_in.verify_nof_cirs();
+		}, "verify_nof_cirs of a file with a missing CIR");
+	}
+
+	cout << "checking a link with fewer reference delays..." << endl;
+	write_file(file_name);
+	shrink_reference_delays(file_name, "link1");
+	{
+		CDX::ReadContinuousDelayFile lazy(file_name,
+				H5::FileAccPropList::DEFAULT, true);
+		lazy.get_cir(0, 0);
+		lazy.get_cir(2, 0);
+		expect_logic_error([&]() {
+			lazy.get_cir(1, 0);
+		}, "first use of a link with fewer reference delays");
+	}
+
+	cout << "checking a file without links..." << endl;
+	write_file(file_name);
+	{
+		// the writers refuse files without links:
+		H5::H5File file(file_name, H5F_ACC_RDWR);
+		for (size_t l = 0; l < nof_links; l++)
+			file.unlink("/links/link" + to_string(l));
+	}
+	{
+		CDX::ReadContinuousDelayFile lazy(file_name,
+				H5::FileAccPropList::DEFAULT, true);
+		if (lazy.get_nof_links() != 0 or lazy.get_nof_cirs() != 0)
+			fail("file without links has links or CIRs.");
+		expect_logic_error([&]() {
+			lazy.get_reference_delays(0);
+		}, "reference delays of a file without links");
+	}
+
+	remove(file_name.c_str());
+
+	cout << "all done." << endl;
+}
@@ -0,0 +1,180 @@
+/**
+ * \file cdx-test-link-index.cpp
+ *
+ * \brief Writes continuous-delay and discrete-delay CDX files with many links through the
+ * overloads keyed by link index and reads them back by link index and by link name. The
+ * links are not named in alphabetical order, so the link indices of the writer and the
+ * reader differ and have to be resolved with get_link_index.
+ */
+
+#include "../../cdx/WriteContinuousDelayFile.h"
+#include "../../cdx/ReadContinuousDelayFile.h"
+#include "../../cdx/WriteDiscreteDelayFile.h"
+#include "../../cdx/ReadDiscreteDelayFile.h"
+#include "../cdx-test-common.h"
+
+#include <iostream>
+#include <stdexcept>
+#include <sstream>
+
+using namespace std;
+
+const size_t nof_links = 40;
+const size_t nof_cirs = 20;
+const size_t nof_delay_samples = 16;
+
+/**
+ * \brief Returns the name of link k, in reverse alphabetical order.
+ */
+static string link_name_of(size_t k) {
+	stringstream ss;
+	ss << "link" << (nof_links - k) * 7;
+	return ss.str();
+}
+
+static size_t nof_components_of(size_t k, CDX::cir_number_t cir_number) {
+	return (k + cir_number) % 5;
+}
+
+static complex<double> amplitude_of(size_t k, CDX::cir_number_t cir_number,
+		size_t c) {
+	return complex<double>(k, 1000.0 * cir_number + c);
+}
+
+static void test_continuous_delay(const string &file_name) {
+	vector<string> link_names;
+	CDX::links_to_component_types_t links_to_component_types;
+	for (size_t k = 0; k < nof_links; k++) {
+		link_names.push_back(link_name_of(k));
+		links_to_component_types[link_names.back()] = { { 0, "LOS" } };
+	}
+
+	{
+		CDX::WriteContinuousDelayFile cdx_out(file_name, 3e8, 100.0, 1e9,
+				link_names, links_to_component_types);
+
+		for (size_t k = 0; k < nof_links; k++)
+			if (cdx_out.get_link_index(link_names[k]) != k
+					or cdx_out.get_link_name(k) != link_names[k])
+				fail("writer: link index does not match order of link names.");
+
+		vector<CDX::components_t> cirs(nof_links);
+		vector<double> reference_delays(nof_links);
+
+		for (CDX::cir_number_t cir_number = 0; cir_number < nof_cirs;
+				cir_number++) {
+			for (size_t k = 0; k < nof_links; k++) {
+				cirs[k].resize(nof_components_of(k, cir_number));
+				for (size_t c = 0; c < cirs[k].size(); c++) {
+					cirs[k][c].type = 0;
+					cirs[k][c].id = c;
+					cirs[k][c].delay = 1e-6 * c;
+					cirs[k][c].amplitude = amplitude_of(k, cir_number, c);
+				}
+				reference_delays[k] = 1e-3 * k + 1e-6 * cir_number;
+			}
+			cdx_out.write_cir(cirs, reference_delays, cir_number);
+		}
+	}
+
+	CDX::ReadContinuousDelayFile cdx_in(file_name);
+
+	expect_logic_error([&cdx_in] {cdx_in.get_link_index("no-such-link");},
+			"get_link_index of unknown link");
+	expect_logic_error([&cdx_in] {cdx_in.get_cir(nof_links, 0);},
+			"get_cir with link index out of range");
+	expect_logic_error([&cdx_in] {cdx_in.get_cir(size_t(0), nof_cirs);},
+			"get_cir with CIR number out of range");
+
+	for (size_t k = 0; k < nof_links; k++) {
+		const size_t link_index = cdx_in.get_link_index(link_name_of(k));
+		if (cdx_in.get_link_name(link_index) != link_name_of(k))
+			fail("reader: get_link_name does not match get_link_index.");
+
+		for (CDX::cir_number_t cir_number = 0; cir_number < nof_cirs;
+				cir_number++) {
+			const CDX::cir_t by_index = cdx_in.get_cir(link_index, cir_number);
+			const CDX::cir_t by_name = cdx_in.get_cir(link_name_of(k),
+					cir_number);
+
+			bool ok = by_index.ref_delay == 1e-3 * k + 1e-6 * cir_number
+					and by_name.ref_delay == by_index.ref_delay
+					and by_index.components.size()
+							== nof_components_of(k, cir_number)
+					and by_name.components.size()
+							== by_index.components.size();
+			for (size_t c = 0; ok and c < by_index.components.size(); c++)
+				ok = by_index.components[c].amplitude
+						== amplitude_of(k, cir_number, c)
+						and by_name.components[c].amplitude
+								== by_index.components[c].amplitude;
+
+			if (not ok) {
+				stringstream ss;
+				ss << "CIR " << cir_number << " of " << link_name_of(k)
+						<< " does not match input data.";
+				fail(ss.str());
+			}
+		}
+	}
+}
+
+static void test_discrete_delay(const string &file_name) {
+	vector<string> link_names;
+	for (size_t k = 0; k < nof_links; k++)
+		link_names.push_back(link_name_of(k));
+
+	{
+		CDX::WriteDiscreteDelayFile cdx_out(file_name, 3e8, 100.0, 1e9,
+				link_names, 1e8);
+
+		expect_logic_error(
+				[&cdx_out] {cdx_out.setup_link("no-such-link", nof_delay_samples, 0.0);},
+				"setup_link of unknown link");
+
+		for (size_t k = 0; k < nof_links; k++)
+			cdx_out.setup_link(k, nof_delay_samples, 0.0);
+
+		vector<complex<double> > data(nof_delay_samples);
+		for (CDX::cir_number_t cir_number = 0; cir_number < nof_cirs;
+				cir_number++) {
+			for (size_t k = 0; k < nof_links; k++) {
+				for (size_t n = 0; n < nof_delay_samples; n++)
+					data[n] = amplitude_of(k, cir_number, n);
+				cdx_out.append_cir_snapshot(k, data, 0.0);
+			}
+		}
+	}
+
+	CDX::ReadDiscreteDelayFile cdx_in(file_name);
+
+	for (size_t k = 0; k < nof_links; k++) {
+		const size_t link_index = cdx_in.get_link_index(link_name_of(k));
+
+		if (cdx_in.get_nof_cirs(link_index) != nof_cirs
+				or cdx_in.get_nof_delay_samples(link_index)
+						!= nof_delay_samples)
+			fail("discrete-delay: dimensions do not match input data.");
+
+		const vector<vector<complex<double> > > cirs = cdx_in.get_cirs(
+				link_index);
+		for (CDX::cir_number_t cir_number = 0; cir_number < nof_cirs;
+				cir_number++)
+			for (size_t n = 0; n < nof_delay_samples; n++)
+				if (cirs.at(cir_number).at(n)
+						!= amplitude_of(k, cir_number, n))
+					fail("discrete-delay: CIR does not match input data.");
+	}
+}
+
+int main(void) {
+	cout << "cdx-test-link-index start." << endl;
+
+	cout << "checking continuous-delay file..." << endl;
+	test_continuous_delay("cdx-test-link-index-continuous.cdx");
+
+	cout << "checking discrete-delay file..." << endl;
+	test_discrete_delay("cdx-test-link-index-discrete.cdx");
+
+	cout << "all done." << endl;
+}
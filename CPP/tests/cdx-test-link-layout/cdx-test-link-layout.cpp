@@ -0,0 +1,283 @@
+/**
+ * \file cdx-test-link-layout.cpp
+ *
+ * \brief Checks the layout attributes of the links written by the continuous-delay and
+ * discrete-delay writers, by copy_cirs and by resuming a file, and that the readers fall
+ * back to counting for files without them. Removes the attributes to get files like those
+ * of older versions and restores them with build_link_layout.
+ */
+
+#include "../../cdx/WriteContinuousDelayFile.h"
+#include "../../cdx/ReadContinuousDelayFile.h"
+#include "../../cdx/WriteDiscreteDelayFile.h"
+#include "../../cdx/ReadDiscreteDelayFile.h"
+#include "../../cdx/LinkLayout.h"
+#include "../cdx-test-common.h"
+
+#include <cstdio>
+#include <iostream>
+#include <stdexcept>
+#include <sstream>
+
+using namespace std;
+
+const vector<string> link_names = { "link0", "link1" };
+const CDX::cir_number_t nof_cirs = 40;
+
+static size_t nof_components_of(size_t link_index,
+		CDX::cir_number_t cir_number) {
+	return (cir_number * (link_index + 3)) % 11;
+}
+
+/// the largest number of components of a CIR of each link, see nof_components_of
+const vector<uint64_t> max_nof_components = { 10, 10 };
+
+/**
+ * \brief Writes CIRs first_cir to end_cir - 1, with extra components in the CIRs given.
+ */
+static void write_cirs(CDX::WriteContinuousDelayFile &cdx_out,
+		CDX::cir_number_t first_cir, CDX::cir_number_t end_cir,
+		size_t nof_extra_components = 0) {
+	vector<CDX::components_t> cirs(link_names.size());
+	for (CDX::cir_number_t n = first_cir; n < end_cir; n++) {
+		for (size_t l = 0; l < cirs.size(); l++) {
+			cirs[l].resize(nof_components_of(l, n) + nof_extra_components);
+			for (size_t c = 0; c < cirs[l].size(); c++) {
+				cirs[l][c].type = c % 2;
+				cirs[l][c].id = c;
+				cirs[l][c].delay = 1e-6 * c;
+				cirs[l][c].amplitude = complex<double>(n, c);
+			}
+		}
+		cdx_out.write_cir(cirs, { 0.0, 0.0 }, n);
+	}
+}
+
+static void write_continuous_file(const string &file_name) {
+	CDX::links_to_component_types_t component_types;
+	for (const auto &link_name : link_names)
+		component_types[link_name] = { { 0, "LOS" }, { 1, "Scatterer" } };
+
+	CDX::WriteContinuousDelayFile cdx_out(file_name, 3e8, 100.0, 1e9,
+			link_names, component_types);
+	write_cirs(cdx_out, 0, nof_cirs);
+}
+
+/**
+ * \brief Removes the layout attributes of all links, like in files of older versions.
+ */
+static void remove_layouts(const string &file_name) {
+	H5::H5File file(file_name, H5F_ACC_RDWR);
+	H5::Group links_group = file.openGroup("/links");
+	for (hsize_t l = 0; l < links_group.getNumObjs(); l++) {
+		H5::Group link_group = links_group.openGroup(
+				links_group.getObjnameByIdx(l));
+		for (const char *name : { "layout_version", "nof_cirs",
+				"max_nof_components", "sample_type", "chunk_dims" })
+			if (link_group.attrExists(name))
+				link_group.removeAttr(name);
+	}
+}
+
+/**
+ * \brief Checks the layout of a link against the expected values.
+ */
+static void check_layout(const CDX::link_layout_t &layout, uint64_t nof_cirs,
+		uint64_t max_nof_components, const string &sample_type,
+		const vector<hsize_t> &chunk_dims, const string &what) {
+	if (not layout.available or layout.version != CDX::link_layout_version
+			or layout.nof_cirs != nof_cirs
+			or layout.max_nof_components != max_nof_components
+			or layout.sample_type != sample_type
+			or layout.chunk_dims != chunk_dims) {
+		stringstream ss;
+		ss << what << ": wrong layout (" << layout.available << ", "
+				<< layout.nof_cirs << " CIRs, " << layout.max_nof_components
+				<< " components, " << layout.sample_type << ").";
+		fail(ss.str());
+	}
+}
+
+/**
+ * \brief Checks the layouts of a continuous-delay file and that its CIRs can be read.
+ */
+static void check_continuous_file(const string &file_name,
+		CDX::cir_number_t nof_cirs, const vector<uint64_t> &max_nof_components,
+		const string &what) {
+	CDX::ReadContinuousDelayFile cdx_in(file_name);
+	if (cdx_in.get_nof_cirs() != nof_cirs)
+		fail(what + ": wrong number of CIRs.");
+
+	for (size_t l = 0; l < link_names.size(); l++) {
+		check_layout(cdx_in.get_link_layout(l), nof_cirs, max_nof_components[l],
+				"impulse", { }, what);
+
+		const CDX::cir_block_t block = cdx_in.read_cirs(l, 0, nof_cirs);
+		for (CDX::cir_number_t n = 0; n < 10; n++)
+			if (block.offsets[n + 1] - block.offsets[n]
+					!= nof_components_of(l, n))
+				fail(what + ": wrong CIR.");
+	}
+}
+
+static void test_continuous_delay(const string &file_name) {
+	cout << "continuous-delay file..." << endl;
+	write_continuous_file(file_name);
+	check_continuous_file(file_name, nof_cirs, max_nof_components, "writer");
+
+	cout << "continuous-delay file without layout..." << endl;
+	remove_layouts(file_name);
+	{
+		CDX::ReadContinuousDelayFile cdx_in(file_name);
+		if (cdx_in.get_nof_cirs() != nof_cirs
+				or cdx_in.get_link_layout(0).available)
+			fail("file without layout: wrong number of CIRs or layout.");
+		const CDX::cir_block_t block = cdx_in.read_cirs(1, 0, nof_cirs);
+		for (CDX::cir_number_t n = 0; n < nof_cirs; n++)
+			if (block.offsets[n + 1] - block.offsets[n] != nof_components_of(1, n))
+				fail("file without layout: wrong CIR.");
+	}
+
+	cout << "building the layout..." << endl;
+	CDX::build_link_layout(file_name);
+	check_continuous_file(file_name, nof_cirs, max_nof_components,
+			"build_link_layout");
+
+	cout << "resuming a file without layout..." << endl;
+	remove_layouts(file_name);
+	{
+		CDX::WriteContinuousDelayFile cdx_out(file_name);
+		write_cirs(cdx_out, nof_cirs, nof_cirs + 5, 20);
+	}
+	check_continuous_file(file_name, nof_cirs + 5, { 30, 30 }, "resumed file");
+
+	cout << "copying CIRs..." << endl;
+	const string copy_file_name = "cdx-test-link-layout-copy.cdx";
+	{
+		CDX::ReadContinuousDelayFile cdx_in(file_name);
+		CDX::links_to_component_types_t component_types;
+		for (const auto &link_name : link_names)
+			component_types[link_name] = { { 0, "LOS" }, { 1, "Scatterer" } };
+
+		CDX::WriteContinuousDelayFile cdx_out(copy_file_name, 3e8, 100.0, 1e9,
+				link_names, component_types);
+		cdx_out.copy_cirs(cdx_in, { 0, 1 }, 0, nof_cirs);
+	}
+	// the layout of the input bounds the copied CIRs:
+	check_continuous_file(copy_file_name, nof_cirs, { 30, 30 }, "copy");
+
+	remove_layouts(file_name);
+	{
+		CDX::ReadContinuousDelayFile cdx_in(file_name);
+		CDX::links_to_component_types_t component_types;
+		for (const auto &link_name : link_names)
+			component_types[link_name] = { { 0, "LOS" }, { 1, "Scatterer" } };
+
+		CDX::WriteContinuousDelayFile cdx_out(copy_file_name, 3e8, 100.0, 1e9,
+				link_names, component_types);
+		cdx_out.copy_cirs(cdx_in, { 0, 1 }, 0, nof_cirs);
+	}
+	// without layout of the input, the sizes of the copied CIRs are read:
+	check_continuous_file(copy_file_name, nof_cirs, max_nof_components,
+			"copy of a file without layout");
+	remove(copy_file_name.c_str());
+
+	cout << "reading a file while it is written..." << endl;
+	{
+		CDX::links_to_component_types_t component_types;
+		for (const auto &link_name : link_names)
+			component_types[link_name] = { { 0, "LOS" }, { 1, "Scatterer" } };
+
+		CDX::WriteContinuousDelayFile cdx_out(file_name, 3e8, 100.0, 1e9,
+				link_names, component_types);
+		write_cirs(cdx_out, 0, nof_cirs);
+
+		// the layout written when the file was created is stale:
+		CDX::ReadContinuousDelayFile cdx_in(file_name);
+		if (cdx_in.get_nof_cirs() != nof_cirs)
+			fail("reader of an open file returned a wrong number of CIRs.");
+	}
+
+	cout << "inconsistent files..." << endl;
+	write_continuous_file(file_name);
+	{
+		// a layout that does not match the reference delays would be counted:
+		H5::H5File file(file_name, H5F_ACC_RDWR);
+		const uint64_t wrong_nof_cirs = nof_cirs - 1;
+		file.openGroup("/links/link1").openAttribute("nof_cirs").write(
+				H5::PredType::NATIVE_UINT64, &wrong_nof_cirs);
+		const hsize_t size = wrong_nof_cirs;
+		file.openDataSet("/links/link1/reference_delays").extend(&size);
+	}
+	expect_logic_error([&]() {
+		CDX::ReadContinuousDelayFile cdx_in(file_name);
+	}, "open of a file with different numbers of CIRs in the layouts");
+
+	write_continuous_file(file_name);
+	remove_layouts(file_name);
+	{
+		H5::H5File file(file_name, H5F_ACC_RDWR);
+		file.unlink("/links/link1/cirs/" + to_string(nof_cirs - 1));
+	}
+	expect_logic_error([&]() {
+		CDX::ReadContinuousDelayFile cdx_in(file_name);
+	}, "open of a file without layout with a missing CIR");
+}
+
+/**
+ * \brief Checks the layouts and CIRs of a discrete-delay file.
+ */
+static void check_discrete_file(const string &file_name,
+		size_t nof_discrete_cirs, const string &what) {
+	CDX::ReadDiscreteDelayFile cdx_in(file_name);
+
+	check_layout(cdx_in.get_link_layout(0), nof_discrete_cirs, 8, "double",
+			{ 8, 1 }, what);
+	check_layout(cdx_in.get_link_layout(1), 0, 4, "double", { 4, 1 }, what);
+
+	if (cdx_in.get_nof_cirs(0) != nof_discrete_cirs
+			or cdx_in.get_cirs(0).size() != nof_discrete_cirs
+			or cdx_in.get_nof_delay_samples(0) != 8)
+		fail(what + ": wrong CIRs of link0.");
+
+	// the datasets of a link without CIRs have one column:
+	if (cdx_in.get_nof_cirs(1) != 0 or not cdx_in.get_cirs(1).empty()
+			or cdx_in.get_nof_delay_samples(1) != 4)
+		fail(what + ": wrong CIRs of link1.");
+}
+
+static void test_discrete_delay(const string &file_name) {
+	const size_t nof_discrete_cirs = 5;
+
+	cout << "discrete-delay file..." << endl;
+	{
+		CDX::WriteDiscreteDelayFile cdx_out(file_name, 3e8, 100.0, 1e9,
+				link_names, 1e8);
+		cdx_out.setup_link(0, 8, 0.0);
+		cdx_out.setup_link(1, 4, 0.0);
+
+		const vector<complex<double> > cir(8, complex<double>(1.0, 2.0));
+		for (size_t n = 0; n < nof_discrete_cirs; n++)
+			cdx_out.append_cir_snapshot(0, cir, 0.0);
+	}
+	check_discrete_file(file_name, nof_discrete_cirs, "discrete writer");
+
+	cout << "building the layout of a discrete-delay file..." << endl;
+	remove_layouts(file_name);
+	CDX::build_link_layout(file_name);
+	check_discrete_file(file_name, nof_discrete_cirs,
+			"discrete build_link_layout");
+}
+
+int main(void) {
+	cout << "cdx-test-link-layout start." << endl;
+
+	const string file_name = "cdx-test-link-layout.cdx";
+
+	test_continuous_delay(file_name);
+	test_discrete_delay(file_name);
+
+	remove(file_name.c_str());
+
+	cout << "all done." << endl;
+}
@@ -0,0 +1,273 @@
+/**
+ * \file cdx-test-merge.cpp
+ *
+ * \brief Combines continuous-delay CDX files with CDX::merge, with and without bulk copy:
+ * three files concatenated along time, whose sizes are not multiples of the delay bounds
+ * blocks, and two files with disjoint links. Checks the CIRs, reference delays, component
+ * types, queries and track index of the output files and the errors for incompatible inputs.
+ */
+
+#include "../../cdx/WriteContinuousDelayFile.h"
+#include "../../cdx/ReadContinuousDelayFile.h"
+#include "../../cdx/Merge.h"
+#include "../cdx-test-common.h"
+
+#include <cstdio>
+#include <iostream>
+#include <stdexcept>
+#include <sstream>
+
+using namespace std;
+using namespace fixture;
+
+const double cir_rate_Hz = 100.0;
+
+/// CIRs 120 and later contain components of type 2
+const CDX::cir_number_t first_cir_with_type_2 = 120;
+
+/**
+ * \brief Returns component c of CIR cir_number, counted over all input files, of a link:
+ * the fixture component, with type 2 instead of 1 from first_cir_with_type_2 on.
+ */
+static CDX::impulse_t input_component_of(size_t link_code,
+		CDX::cir_number_t cir_number, size_t c) {
+	CDX::impulse_t component = component_of(link_code, cir_number, c);
+	if (component.type == 1 and cir_number >= first_cir_with_type_2)
+		component.type = 2;
+	return component;
+}
+
+/**
+ * \brief Writes CIRs first_cir to first_cir + count - 1 of some links as CIRs 0 to count - 1 of a file.
+ */
+static void write_file(const string &file_name,
+		const vector<string> &link_names, const vector<size_t> &link_codes,
+		CDX::cir_number_t first_cir, size_t count,
+		const CDX::component_types_t &component_types,
+		double rate_Hz = cir_rate_Hz) {
+	CDX::links_to_component_types_t links_to_component_types;
+	for (const auto &link_name : link_names)
+		links_to_component_types[link_name] = component_types;
+
+	CDX::WriteContinuousDelayFile cdx_out(file_name, 3e8, rate_Hz, 1e9,
+			link_names, links_to_component_types);
+
+	vector<CDX::components_t> cirs(link_names.size());
+	vector<double> reference_delays(link_names.size());
+	for (CDX::cir_number_t n = 0; n < count; n++) {
+		for (size_t k = 0; k < link_names.size(); k++) {
+			cirs[k].clear();
+			for (size_t c = 0;
+					c < nof_components_of(link_codes[k], first_cir + n); c++)
+				cirs[k].push_back(
+						input_component_of(link_codes[k], first_cir + n, c));
+			reference_delays[k] = reference_delay_of(link_codes[k],
+					first_cir + n);
+		}
+		cdx_out.write_cir(cirs, reference_delays, n);
+	}
+}
+
+/**
+ * \brief Checks all CIRs of an output link.
+ */
+static void check_link(CDX::ReadContinuousDelayFile &cdx_in,
+		const string &link_name, size_t link_code) {
+	const size_t link_index = cdx_in.get_link_index(link_name);
+
+	for (CDX::cir_number_t n = 0; n < cdx_in.get_nof_cirs(); n++) {
+		const CDX::cir_t cir = cdx_in.get_cir(link_index, n);
+
+		bool ok = cir.ref_delay == reference_delay_of(link_code, n)
+				and cir.components.size() == nof_components_of(link_code, n);
+		for (size_t c = 0; ok and c < cir.components.size(); c++)
+			ok = equal(cir.components[c], input_component_of(link_code, n, c));
+
+		if (not ok) {
+			stringstream ss;
+			ss << "CIR " << n << " of " << link_name << " does not match.";
+			fail(ss.str());
+		}
+	}
+}
+
+/**
+ * \brief Checks that a query with a delay window returns all matching components.
+ *
+ * The query skips blocks by their delay bounds, so it misses components if the bounds of
+ * the merged file are too narrow.
+ */
+static void check_query(CDX::ReadContinuousDelayFile &cdx_in,
+		const string &link_name, size_t link_code) {
+	CDX::query_t query;
+	query.min_delay_s = 10e-6;
+	query.max_delay_s = 11.5e-6;
+
+	size_t nof_expected = 0;
+	for (CDX::cir_number_t n = 0; n < cdx_in.get_nof_cirs(); n++)
+		for (size_t c = 0; c < nof_components_of(link_code, n); c++) {
+			const double delay = input_component_of(link_code, n, c).delay;
+			if (delay >= query.min_delay_s and delay <= query.max_delay_s)
+				nof_expected++;
+		}
+
+	const CDX::query_result_t result = cdx_in.query(link_name, query);
+	if (result.size() != nof_expected or result.nof_cirs_skipped == 0)
+		fail("query of " + link_name + " returned a wrong result.");
+}
+
+/**
+ * \brief Checks the track of a component against the CIRs it appears in.
+ */
+static void check_track(CDX::ReadContinuousDelayFile &cdx_in,
+		const string &link_name, size_t link_code, size_t c) {
+	vector<CDX::cir_number_t> expected;
+	for (CDX::cir_number_t n = 0; n < cdx_in.get_nof_cirs(); n++)
+		if (c < nof_components_of(link_code, n))
+			expected.push_back(n);
+
+	const CDX::track_t track = cdx_in.get_track(link_name,
+			10 * link_code + c);
+	if (track.cir_numbers != expected)
+		fail("track of " + link_name + " does not match.");
+}
+
+/**
+ * \brief Expects a merge to throw an exception of type E.
+ */
+template<typename E>
+static void expect_error(const vector<string> &input_file_names,
+		const CDX::merge_options_t &options, const string &description) {
+	try {
+		CDX::merge(input_file_names, "cdx-test-merge-invalid.cdx", options);
+	} catch (E &) {
+		return;
+	}
+	fail("merge of " + description + " did not throw.");
+}
+
+int main(void) {
+	cout << "cdx-test-merge start." << endl;
+
+	const CDX::component_types_t types = { { 0, "LOS" }, { 1, "Scatterer" } };
+	const CDX::component_types_t types_2 = { { 0, "LOS" },
+			{ 2, "Vegetation" } };
+
+	// three files of 70, 50 and 30 CIRs of links link0 and link1, the last one has other
+	// component types and stores the links in another order:
+	const vector<string> link_names = { "link0", "link1" };
+	const vector<string> time_file_names = { "cdx-test-merge-time0.cdx",
+			"cdx-test-merge-time1.cdx", "cdx-test-merge-time2.cdx" };
+	write_file(time_file_names[0], link_names, { 0, 1 }, 0, 70, types);
+	write_file(time_file_names[1], link_names, { 0, 1 }, 70, 50, types);
+	write_file(time_file_names[2], { "link1", "link0" }, { 1, 0 }, 120, 30,
+			types_2);
+	const size_t nof_cirs = 150;
+
+	for (bool bulk_copy : { true, false }) {
+		cout << "checking concatenation along time, bulk copy " << bulk_copy
+				<< "..." << endl;
+
+		const string output_file_name = "cdx-test-merge-time.cdx";
+
+		CDX::merge_options_t options;
+		options.bulk_copy = bulk_copy;
+		options.batch_size = 16;
+		options.write_track_index = true;
+		const CDX::merge_stats_t stats = CDX::merge(time_file_names,
+				output_file_name, options);
+
+		if (stats.nof_links != 2 or stats.nof_cirs != nof_cirs
+				or stats.nof_copied_cirs + stats.nof_decoded_cirs
+						!= 2 * nof_cirs
+				or (stats.nof_copied_cirs > 0) != bulk_copy)
+			fail("concatenation: wrong statistics.");
+
+		CDX::ReadContinuousDelayFile cdx_in(output_file_name);
+		if (cdx_in.get_nof_cirs() != nof_cirs
+				or cdx_in.get_cir_rate_Hz() != cir_rate_Hz)
+			fail("concatenation: wrong parameters.");
+
+		const CDX::component_types_t component_types =
+				cdx_in.get_component_types(cdx_in.get_link_index("link1"));
+		if (component_types.size() != 3
+				or component_types.at(2) != "Vegetation")
+			fail("concatenation: wrong component types.");
+
+		for (size_t k = 0; k < link_names.size(); k++) {
+			check_link(cdx_in, link_names[k], k);
+			check_query(cdx_in, link_names[k], k);
+			check_track(cdx_in, link_names[k], k, 3);
+		}
+
+		remove(output_file_name.c_str());
+	}
+
+	// two files with disjoint links:
+	const vector<string> links_file_names = { "cdx-test-merge-links0.cdx",
+			"cdx-test-merge-links1.cdx" };
+	write_file(links_file_names[0], { "a0", "a1" }, { 0, 1 }, 0, 40, types);
+	write_file(links_file_names[1], { "b0" }, { 2 }, 0, 40, types);
+
+	for (bool bulk_copy : { true, false }) {
+		cout << "checking merge of links, bulk copy " << bulk_copy << "..."
+				<< endl;
+
+		const string output_file_name = "cdx-test-merge-links.cdx";
+
+		CDX::merge_options_t options;
+		options.mode = CDX::merge_links;
+		options.bulk_copy = bulk_copy;
+		options.write_track_index = true;
+		const CDX::merge_stats_t stats = CDX::merge(links_file_names,
+				output_file_name, options);
+
+		if (stats.nof_links != 3 or stats.nof_cirs != 40)
+			fail("merge of links: wrong statistics.");
+
+		CDX::ReadContinuousDelayFile cdx_in(output_file_name);
+		if (cdx_in.get_nof_cirs() != 40 or cdx_in.get_nof_links() != 3)
+			fail("merge of links: wrong number of CIRs or links.");
+
+		check_link(cdx_in, "a0", 0);
+		check_link(cdx_in, "a1", 1);
+		check_link(cdx_in, "b0", 2);
+		check_track(cdx_in, "b0", 2, 1);
+
+		if (cdx_in.get_component_types(cdx_in.get_link_index("b0")) != types)
+			fail("merge of links: wrong component types.");
+
+		remove(output_file_name.c_str());
+	}
+
+	cout << "checking incompatible input files..." << endl;
+	write_file("cdx-test-merge-rate.cdx", link_names, { 0, 1 }, 0, 10, types,
+			2 * cir_rate_Hz);
+	write_file("cdx-test-merge-names.cdx", link_names, { 0, 1 }, 0, 10,
+			{ { 0, "LOS" }, { 1, "Diffraction" } });
+
+	CDX::merge_options_t options;
+	expect_error<logic_error>({ }, options, "no files");
+	expect_error<runtime_error>( { time_file_names[0],
+			"cdx-test-merge-rate.cdx" }, options, "different CIR rates");
+	expect_error<runtime_error>( { time_file_names[0], links_file_names[0] },
+			options, "different links");
+	expect_error<runtime_error>( { time_file_names[0],
+			"cdx-test-merge-names.cdx" }, options,
+			"different component type names");
+
+	options.mode = CDX::merge_links;
+	expect_error<runtime_error>( { links_file_names[0], links_file_names[0] },
+			options, "overlapping links");
+	expect_error<runtime_error>( { links_file_names[0], time_file_names[1] },
+			options, "different numbers of CIRs");
+
+	for (const auto &file_name : { time_file_names[0], time_file_names[1],
+			time_file_names[2], links_file_names[0], links_file_names[1],
+			string("cdx-test-merge-rate.cdx"), string(
+					"cdx-test-merge-names.cdx"), string(
+					"cdx-test-merge-invalid.cdx") })
+		remove(file_name.c_str());
+
+	cout << "all done." << endl;
+}
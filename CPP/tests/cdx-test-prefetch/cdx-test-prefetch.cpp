@@ -0,0 +1,135 @@
+/**
+ * \file cdx-test-prefetch.cpp
+ *
+ * \brief Reads a continuous-delay CDX file through CIRPrefetchers of several threads that
+ * share one SharedReadContinuousDelayFile. The threads read the CIRs in order, with gaps,
+ * backwards and at random, and compare them to the written data.
+ */
+
+#include "../../cdx/WriteContinuousDelayFile.h"
+#include "../../cdx/CIRPrefetcher.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <sstream>
+#include <thread>
+
+using namespace std;
+
+const size_t nof_cirs = 300;
+
+static size_t nof_components_of(CDX::cir_number_t cir_number) {
+	return cir_number % 7;
+}
+
+static double delay_of(size_t c, CDX::cir_number_t cir_number) {
+	return 1e-6 * c + 1e-9 * cir_number;
+}
+
+static void check_cir(const CDX::cir_t &cir, CDX::cir_number_t cir_number) {
+	bool ok = cir.ref_delay == 1e-3 * cir_number
+			and cir.components.size() == nof_components_of(cir_number);
+
+	for (size_t c = 0; ok and c < cir.components.size(); c++)
+		ok = cir.components[c].id == c
+				and cir.components[c].delay == delay_of(c, cir_number)
+				and cir.components[c].amplitude
+						== complex<double>(c, cir_number);
+
+	if (not ok) {
+		stringstream ss;
+		ss << "CIR " << cir_number << " does not match input data.";
+		throw runtime_error(ss.str());
+	}
+}
+
+/**
+ * \brief Reads the CIRs in an order that depends on pattern and checks them.
+ */
+static void read_cirs(CDX::SharedReadContinuousDelayFile &cdx_in,
+		size_t pattern, size_t depth) {
+	CDX::CIRPrefetcher prefetcher(cdx_in, "link0", depth);
+
+	unsigned int seed = pattern;
+	for (size_t k = 0; k < nof_cirs; k++) {
+		CDX::cir_number_t cir_number;
+		switch (pattern % 4) {
+		case 0:
+			cir_number = k;
+			break;
+		case 1:
+			cir_number = (k * 3) % nof_cirs;
+			break;
+		case 2:
+			cir_number = nof_cirs - 1 - k;
+			break;
+		default:
+			cir_number = rand_r(&seed) % nof_cirs;
+			break;
+		}
+		check_cir(prefetcher.get_cir(cir_number), cir_number);
+	}
+
+	const CDX::prefetch_stats_t stats = prefetcher.get_stats();
+	if (stats.hits + stats.misses != nof_cirs)
+		throw runtime_error("hits and misses do not add up to the number of requests.");
+}
+
+int main(void) {
+	cout << "cdx-test-prefetch start." << endl;
+
+	const string file_name = "cdx-test-prefetch.cdx";
+
+	{
+		CDX::component_types_t component_types = { { 0, "LOS" }, { 256,
+				"Scatterer" } };
+		CDX::links_to_component_types_t links_to_component_types = { { "link0",
+				component_types } };
+
+		CDX::WriteContinuousDelayFile cdx_out(file_name, 3e8, 100.0, 1e9, {
+				"link0" }, links_to_component_types);
+
+		for (CDX::cir_number_t cir_number = 0; cir_number < nof_cirs;
+				cir_number++) {
+			CDX::components_t components(nof_components_of(cir_number));
+			for (size_t c = 0; c < components.size(); c++) {
+				components[c].type = c == 0 ? 0 : 256;
+				components[c].id = c;
+				components[c].delay = delay_of(c, cir_number);
+				components[c].amplitude = complex<double>(c, cir_number);
+			}
+
+			cdx_out.write_cir( { { "link0", components } }, { { "link0", 1e-3
+					* cir_number } }, cir_number);
+		}
+	}
+
+	for (bool use_io_thread : { false, true }) {
+		cout << "reading with " << (use_io_thread ? "" : "no ")
+				<< "I/O thread..." << endl;
+
+		CDX::SharedReadContinuousDelayFile cdx_in(file_name, use_io_thread);
+
+		atomic<int> nof_failed(0);
+		vector<thread> threads;
+		for (size_t t = 0; t < 8; t++)
+			threads.push_back(thread([&cdx_in, &nof_failed, t] {
+				try {
+					read_cirs(cdx_in, t, 1 + t * 5);
+				} catch (exception &e) {
+					cerr << "thread " << t << ": " << e.what() << endl;
+					nof_failed++;
+				}
+			}));
+
+		for (auto &t : threads)
+			t.join();
+
+		if (nof_failed > 0)
+			throw runtime_error("reading CIRs through prefetchers failed.");
+	}
+
+	cout << "all done." << endl;
+}
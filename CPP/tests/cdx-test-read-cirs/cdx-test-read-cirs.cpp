@@ -0,0 +1,113 @@
+/**
+ * \file cdx-test-read-cirs.cpp
+ *
+ * \brief Reads blocks of consecutive CIRs of a continuous-delay CDX file with
+ * ReadContinuousDelayFile::read_cirs and compares them to the CIRs returned by get_cir.
+ * Some CIRs have no components, and one block is reused for blocks of different sizes.
+ */
+
+#include "../../cdx/WriteContinuousDelayFile.h"
+#include "../../cdx/ReadContinuousDelayFile.h"
+#include "../cdx-test-common.h"
+
+#include <iostream>
+#include <stdexcept>
+#include <sstream>
+
+using namespace std;
+
+const size_t nof_cirs = 300;
+
+static size_t nof_components_of(CDX::cir_number_t cir_number) {
+	return (cir_number * 7) % 11;
+}
+
+static void check_block(CDX::ReadContinuousDelayFile &cdx_in,
+		const CDX::cir_block_t &block, CDX::cir_number_t first_cir,
+		size_t count) {
+	if (block.first_cir != first_cir or block.nof_cirs() != count
+			or block.offsets.size() != count + 1 or block.offsets[0] != 0
+			or block.offsets[count] != block.size()
+			or block.types.size() != block.size()
+			or block.ids.size() != block.size()
+			or block.reals.size() != block.size()
+			or block.imags.size() != block.size())
+		fail("block has inconsistent sizes.");
+
+	for (size_t k = 0; k < count; k++) {
+		const CDX::cir_t cir = cdx_in.get_cir("link0", first_cir + k);
+
+		bool ok = block.ref_delays[k] == cir.ref_delay
+				and block.offsets[k + 1] - block.offsets[k]
+						== cir.components.size()
+				and cir.components.size()
+						== nof_components_of(first_cir + k);
+
+		for (size_t c = 0; ok and c < cir.components.size(); c++) {
+			const size_t i = block.offsets[k] + c;
+			ok = block.types[i] == cir.components[c].type
+					and block.ids[i] == cir.components[c].id
+					and block.delays[i] == cir.components[c].delay
+					and block.reals[i] == cir.components[c].amplitude.real()
+					and block.imags[i] == cir.components[c].amplitude.imag();
+		}
+
+		if (not ok) {
+			stringstream ss;
+			ss << "CIR " << first_cir + k << " of block starting at "
+					<< first_cir << " does not match get_cir.";
+			fail(ss.str());
+		}
+	}
+}
+
+int main(void) {
+	cout << "cdx-test-read-cirs start." << endl;
+
+	const string file_name = "cdx-test-read-cirs.cdx";
+
+	{
+		CDX::links_to_component_types_t links_to_component_types = { {
+				"link0", { { 0, "LOS" }, { 1, "Scatterer" } } } };
+		CDX::WriteContinuousDelayFile cdx_out(file_name, 3e8, 100.0, 1e9, {
+				"link0" }, links_to_component_types);
+
+		vector<CDX::components_t> cirs(1);
+		for (CDX::cir_number_t cir_number = 0; cir_number < nof_cirs;
+				cir_number++) {
+			cirs[0].resize(nof_components_of(cir_number));
+			for (size_t c = 0; c < cirs[0].size(); c++) {
+				cirs[0][c].type = c == 0 ? 0 : 1;
+				cirs[0][c].id = 100 * c;
+				cirs[0][c].delay = 1e-6 * c + 1e-9 * cir_number;
+				cirs[0][c].amplitude = complex<double>(c, -1.0 * cir_number);
+			}
+			cdx_out.write_cir(cirs, vector<double>(1, 1e-3 * cir_number),
+					cir_number);
+		}
+	}
+
+	CDX::ReadContinuousDelayFile cdx_in(file_name);
+	const size_t link_index = cdx_in.get_link_index("link0");
+
+	cout << "checking blocks of different sizes..." << endl;
+	CDX::cir_block_t block;
+	for (size_t count : { 1, 7, 64, 300, 0, 3 }) {
+		for (CDX::cir_number_t first = 0; first + count <= nof_cirs; first +=
+				count > 0 ? count : 50) {
+			cdx_in.read_cirs(link_index, first, count, block);
+			check_block(cdx_in, block, first, count);
+		}
+	}
+
+	cout << "checking read_cirs by link name..." << endl;
+	check_block(cdx_in, cdx_in.read_cirs("link0", 10, 20), 10, 20);
+
+	try {
+		cdx_in.read_cirs(link_index, nof_cirs - 5, 6, block);
+		fail("read_cirs past the last CIR did not throw.");
+	} catch (logic_error &) {
+	}
+
+	cout << "all done." << endl;
+}
@@ -0,0 +1,174 @@
+/**
+ * \file cdx-test-reader-options.cpp
+ *
+ * \brief Opens a discrete-delay and a continuous-delay CDX file with different settings
+ * of get_reader_access_plist and checks that the readers return the same CIRs. Checks
+ * windows of delay samples read with ReadDiscreteDelayFile::get_cirs against all CIRs.
+ */
+
+#include "../../cdx/WriteDiscreteDelayFile.h"
+#include "../../cdx/ReadDiscreteDelayFile.h"
+#include "../../cdx/WriteContinuousDelayFile.h"
+#include "../../cdx/ReadContinuousDelayFile.h"
+#include "../cdx-test-common.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include <stdexcept>
+
+using namespace std;
+
+const size_t nof_cirs = 30;
+const size_t nof_delay_samples = 100;
+
+/**
+ * \brief Returns the settings to test, the HDF5 defaults first.
+ */
+static vector<CDX::reader_options_t> get_options() {
+	vector<CDX::reader_options_t> options(5);
+
+	options[1].chunk_cache_size = 4 << 20;
+	options[1].chunk_cache_slots = 12421;
+	options[1].chunk_cache_w0 = 1.0;
+
+	// smaller than a chunk:
+	options[2].chunk_cache_size = 256;
+
+	options[3].metadata_cache_size = 1 << 20;
+
+	options[4].driver = CDX::core_driver;
+	options[4].chunk_cache_size = 4 << 20;
+
+	return options;
+}
+
+static void write_discrete_file(const string &file_name) {
+	CDX::WriteDiscreteDelayFile cdx_out(file_name, 3e8, 100.0, 1e9,
+			{ "link0", "link1" }, 1e8);
+	cdx_out.setup_link(0, nof_delay_samples, 0.0);
+	cdx_out.setup_link(1, 8, 0.0);
+
+	vector<complex<double> > cir(nof_delay_samples);
+	for (size_t k = 0; k < nof_cirs; k++) {
+		for (size_t n = 0; n < cir.size(); n++)
+			cir[n] = complex<double>(k, n);
+		cdx_out.append_cir_snapshot(0, cir, 1e-6 * k);
+	}
+}
+
+static void test_discrete_delay(const string &file_name) {
+	cout << "discrete-delay file..." << endl;
+	write_discrete_file(file_name);
+
+	vector<vector<complex<double> > > expected_cirs;
+	{
+		CDX::ReadDiscreteDelayFile cdx_in(file_name);
+		expected_cirs = cdx_in.get_cirs(0);
+	}
+	if (expected_cirs.size() != nof_cirs)
+		fail("wrong number of CIRs.");
+
+	for (const auto &options : get_options()) {
+		CDX::ReadDiscreteDelayFile cdx_in(file_name,
+				CDX::get_reader_access_plist(options));
+
+		if (cdx_in.get_cirs(0) != expected_cirs)
+			fail("CIRs differ.");
+
+		// windows that slide over the delay samples of blocks of CIRs:
+		for (size_t first_cir = 0; first_cir < nof_cirs; first_cir += 7)
+			for (size_t first_sample = 0; first_sample < nof_delay_samples;
+					first_sample += 30) {
+				const size_t count = min<size_t>(7, nof_cirs - first_cir);
+				const size_t window = min<size_t>(30,
+						nof_delay_samples - first_sample);
+				const auto cirs = cdx_in.get_cirs(0, first_cir, count,
+						first_sample, window);
+
+				if (cirs.size() != count)
+					fail("window has a wrong number of CIRs.");
+				for (size_t k = 0; k < count; k++)
+					if (not equal(cirs[k].begin(), cirs[k].end(),
+							expected_cirs[first_cir + k].begin() + first_sample)
+							or cirs[k].size() != window)
+						fail("window differs from the CIRs.");
+			}
+
+		if (cdx_in.get_cirs(0, nof_cirs, 0, 0, nof_delay_samples).size() != 0
+				or cdx_in.get_cirs(1, 0, 0, 0, 8).size() != 0)
+			fail("empty window is not empty.");
+
+		expect_logic_error([&]() {
+			cdx_in.get_cirs(0, nof_cirs - 1, 2, 0, 1);
+		}, "window beyond the last CIR");
+		expect_logic_error([&]() {
+			cdx_in.get_cirs(0, 0, 1, nof_delay_samples - 1, 2);
+		}, "window beyond the last delay sample");
+		expect_logic_error([&]() {
+			cdx_in.get_cirs(1, 0, 1, 0, 8);
+		}, "window of a link without CIRs");
+	}
+}
+
+static void test_continuous_delay(const string &file_name) {
+	cout << "continuous-delay file..." << endl;
+	{
+		CDX::links_to_component_types_t component_types;
+		component_types["link0"] = { { 0, "LOS" } };
+
+		CDX::WriteContinuousDelayFile cdx_out(file_name, 3e8, 100.0, 1e9,
+				{ "link0" }, component_types);
+
+		vector<CDX::components_t> cirs(1);
+		for (CDX::cir_number_t n = 0; n < nof_cirs; n++) {
+			cirs[0].resize(n % 5);
+			for (size_t c = 0; c < cirs[0].size(); c++) {
+				cirs[0][c].type = 0;
+				cirs[0][c].id = c;
+				cirs[0][c].delay = 1e-6 * c;
+				cirs[0][c].amplitude = complex<double>(n, c);
+			}
+			cdx_out.write_cir(cirs, { 1e-6 * n }, n);
+		}
+	}
+
+	for (const auto &options : get_options()) {
+		CDX::ReadContinuousDelayFile cdx_in(file_name,
+				CDX::get_reader_access_plist(options));
+
+		if (cdx_in.get_nof_cirs() != nof_cirs)
+			fail("wrong number of CIRs.");
+
+		for (CDX::cir_number_t n = 0; n < nof_cirs; n++) {
+			const CDX::cir_t cir = cdx_in.get_cir(0, n);
+			if (cir.components.size() != n % 5 or cir.ref_delay != 1e-6 * n
+					or (not cir.components.empty()
+							and cir.components.back().amplitude
+									!= complex<double>(n,
+											cir.components.size() - 1)))
+				fail("CIR differs.");
+		}
+	}
+}
+
+int main(void) {
+	cout << "cdx-test-reader-options start." << endl;
+
+	const string file_name = "cdx-test-reader-options.cdx";
+
+	test_discrete_delay(file_name);
+	test_continuous_delay(file_name);
+
+#ifndef H5_HAVE_DIRECT
+	expect_logic_error([&]() {
+		CDX::reader_options_t options;
+		options.driver = CDX::direct_driver;
+		CDX::get_reader_access_plist(options);
+	}, "direct driver without HDF5 support");
+#endif
+
+	remove(file_name.c_str());
+
+	cout << "all done." << endl;
+}
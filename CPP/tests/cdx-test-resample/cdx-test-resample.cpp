@@ -0,0 +1,162 @@
+/**
+ * \file cdx-test-resample.cpp
+ *
+ * \brief Resamples a continuous-delay CDX file with CDX::resample: a full copy, and a copy
+ * with decimation, time window, link subset and type filter. Checks the CIRs, reference
+ * delays, component types and CIR rate of the output files.
+ */
+
+#include "../../cdx/WriteContinuousDelayFile.h"
+#include "../../cdx/ReadContinuousDelayFile.h"
+#include "../../cdx/Resample.h"
+#include "../cdx-test-common.h"
+
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+#include <sstream>
+
+using namespace std;
+using namespace fixture;
+
+const size_t nof_cirs = 100;
+const double cir_rate_Hz = 100.0;
+
+/**
+ * \brief Checks an output link against input CIRs first + n * decimation, keeping only
+ * components with type in types or all components if types is empty.
+ */
+static void check_link(CDX::ReadContinuousDelayFile &cdx_in,
+		const string &link_name, size_t input_link_index,
+		CDX::cir_number_t first, size_t decimation,
+		const vector<uint16_t> &types) {
+	const size_t link_index = cdx_in.get_link_index(link_name);
+
+	for (CDX::cir_number_t n = 0; n < cdx_in.get_nof_cirs(); n++) {
+		const CDX::cir_number_t input_cir = first + n * decimation;
+
+		vector<CDX::impulse_t> expected;
+		for (size_t c = 0; c < nof_components_of(input_link_index, input_cir);
+				c++) {
+			const CDX::impulse_t component = component_of(input_link_index,
+					input_cir, c);
+			if (types.empty()
+					or find(types.begin(), types.end(), component.type)
+							!= types.end())
+				expected.push_back(component);
+		}
+
+		const CDX::cir_t cir = cdx_in.get_cir(link_index, n);
+		bool ok = cir.ref_delay
+				== reference_delay_of(input_link_index, input_cir)
+				and cir.components.size() == expected.size();
+		for (size_t c = 0; ok and c < expected.size(); c++)
+			ok = equal(cir.components[c], expected[c]);
+
+		if (not ok) {
+			stringstream ss;
+			ss << "CIR " << n << " of " << link_name
+					<< " does not match input CIR " << input_cir << ".";
+			fail(ss.str());
+		}
+	}
+}
+
+int main(void) {
+	cout << "cdx-test-resample start." << endl;
+
+	const string input_file_name = "cdx-test-resample-input.cdx";
+	const string copy_file_name = "cdx-test-resample-copy.cdx";
+	const string output_file_name = "cdx-test-resample-output.cdx";
+
+	const vector<string> link_names = { "link0", "link1", "link2" };
+	{
+		CDX::links_to_component_types_t links_to_component_types;
+		for (const auto &link_name : link_names)
+			links_to_component_types[link_name] =
+					{ { 0, "LOS" }, { 1, "Scatterer" } };
+
+		CDX::WriteContinuousDelayFile cdx_out(input_file_name, 3e8, cir_rate_Hz,
+				1e9, link_names, links_to_component_types);
+
+		vector<CDX::components_t> cirs(link_names.size());
+		vector<double> reference_delays(link_names.size());
+		for (CDX::cir_number_t cir_number = 0; cir_number < nof_cirs;
+				cir_number++) {
+			for (size_t k = 0; k < link_names.size(); k++) {
+				cirs[k].clear();
+				for (size_t c = 0; c < nof_components_of(k, cir_number); c++)
+					cirs[k].push_back(component_of(k, cir_number, c));
+				reference_delays[k] = reference_delay_of(k, cir_number);
+			}
+			cdx_out.write_cir(cirs, reference_delays, cir_number);
+		}
+	}
+
+	cout << "checking full copy..." << endl;
+	{
+		CDX::resample_options_t options;
+		options.batch_size = 7;
+		const CDX::resample_stats_t stats = CDX::resample(input_file_name,
+				copy_file_name, options);
+
+		if (stats.nof_read_cirs != nof_cirs
+				or stats.nof_written_cirs != nof_cirs
+				or stats.nof_read_components != stats.nof_written_components)
+			fail("full copy: wrong statistics.");
+
+		CDX::ReadContinuousDelayFile cdx_in(copy_file_name);
+		if (cdx_in.get_nof_cirs() != nof_cirs
+				or cdx_in.get_cir_rate_Hz() != cir_rate_Hz
+				or cdx_in.get_link_names().size() != link_names.size())
+			fail("full copy: wrong parameters.");
+
+		for (size_t k = 0; k < link_names.size(); k++)
+			check_link(cdx_in, link_names[k], k, 0, 1, { });
+	}
+
+	cout << "checking decimation, time window, links and types..." << endl;
+	{
+		// CIRs 10 to 79 are inside the window, every third is kept:
+		CDX::resample_options_t options;
+		options.decimation = 3;
+		options.start_time_s = 0.1;
+		options.end_time_s = 0.8;
+		options.links = { "link2", "link0" };
+		options.types = { 1 };
+		options.batch_size = 5;
+		const CDX::resample_stats_t stats = CDX::resample(input_file_name,
+				output_file_name, options);
+
+		const size_t nof_output_cirs = 24;
+		if (stats.nof_read_cirs != nof_output_cirs
+				or stats.nof_written_cirs != nof_output_cirs)
+			fail("resample: wrong number of CIRs.");
+
+		CDX::ReadContinuousDelayFile cdx_in(output_file_name);
+		if (cdx_in.get_nof_cirs() != nof_output_cirs
+				or cdx_in.get_cir_rate_Hz() != cir_rate_Hz / 3
+				or cdx_in.get_link_names().size() != 2)
+			fail("resample: wrong parameters.");
+
+		const CDX::component_types_t component_types =
+				cdx_in.get_component_types(cdx_in.get_link_index("link0"));
+		if (component_types.size() != 1
+				or component_types.at(1) != "Scatterer")
+			fail("resample: wrong component types.");
+
+		check_link(cdx_in, "link0", 0, 10, 3, { 1 });
+		check_link(cdx_in, "link2", 2, 10, 3, { 1 });
+	}
+
+	cout << "checking invalid options..." << endl;
+	CDX::resample_options_t options;
+	options.decimation = 0;
+	try {
+		CDX::resample(input_file_name, output_file_name, options);
+		fail("resample with decimation 0 did not throw.");
+	} catch (logic_error &) {
+	}
+
+	cout << "all done." << endl;
+}
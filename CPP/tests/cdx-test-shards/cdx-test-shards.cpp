@@ -0,0 +1,257 @@
+/**
+ * \file cdx-test-shards.cpp
+ *
+ * \brief Writes continuous-delay CDX files with CDX::ShardedWriteContinuousDelayFile from
+ * one thread per shard, with numbers of CIRs that are not multiples of the delay bounds
+ * blocks and with empty shards, and reads the master files: CIRs, reference delays and
+ * queries. Builds a discrete-delay master file of two shards and checks its CIRs. Checks
+ * the errors for CIRs written out of order, incomplete shards and incompatible shards.
+ */
+
+#include "../../cdx/Shards.h"
+#include "../../cdx/ReadContinuousDelayFile.h"
+#include "../../cdx/WriteDiscreteDelayFile.h"
+#include "../../cdx/ReadDiscreteDelayFile.h"
+#include "../cdx-test-common.h"
+
+#include <cstdio>
+#include <iostream>
+#include <stdexcept>
+#include <sstream>
+#include <thread>
+
+using namespace std;
+using namespace fixture;
+
+const double cir_rate_Hz = 100.0;
+
+/**
+ * \brief Writes the CIRs of a shard, as a worker thread would.
+ */
+static void write_shard(CDX::ShardedWriteContinuousDelayFile &cdx_out,
+		size_t shard, size_t nof_links) {
+	const CDX::shard_range_t range = cdx_out.get_shard_range(shard);
+
+	for (CDX::cir_number_t n = range.first_cir;
+			n < range.first_cir + range.nof_cirs; n++) {
+		vector<CDX::components_t> cirs(nof_links);
+		vector<double> reference_delays(nof_links);
+		for (size_t l = 0; l < nof_links; l++) {
+			for (size_t c = 0; c < nof_components_of(l, n); c++)
+				cirs[l].push_back(component_of(l, n, c));
+			reference_delays[l] = reference_delay_of(l, n);
+		}
+		cdx_out.write_cir(std::move(cirs), std::move(reference_delays), n);
+	}
+}
+
+/**
+ * \brief Writes a sharded file from one thread per shard and checks the master file.
+ */
+static void check_sharded_file(const string &file_name,
+		CDX::cir_number_t nof_cirs, size_t nof_shards) {
+	cout << "checking " << nof_cirs << " CIRs in " << nof_shards
+			<< " shards..." << endl;
+
+	const vector<string> link_names = { "link0", "link1" };
+	CDX::links_to_component_types_t component_types;
+	for (const auto &link_name : link_names)
+		component_types[link_name] = { { 0, "LOS" }, { 1, "Scatterer" } };
+
+	{
+		CDX::ShardedWriteContinuousDelayFile cdx_out(file_name, 3e8,
+				cir_rate_Hz, 1e9, link_names, component_types, nof_cirs,
+				nof_shards, 8);
+
+		if (cdx_out.get_nof_shards() != nof_shards)
+			fail("wrong number of shards.");
+
+		vector<thread> threads;
+		for (size_t k = 0; k < nof_shards; k++)
+			threads.emplace_back(write_shard, ref(cdx_out), k,
+					link_names.size());
+		for (auto &t : threads)
+			t.join();
+
+		cdx_out.finalize();
+	}
+
+	CDX::ReadContinuousDelayFile cdx_in(file_name);
+	if (cdx_in.get_nof_cirs() != nof_cirs
+			or cdx_in.get_cir_rate_Hz() != cir_rate_Hz)
+		fail("master file: wrong number of CIRs or parameters.");
+
+	for (size_t l = 0; l < link_names.size(); l++) {
+		const size_t link_index = cdx_in.get_link_index(link_names[l]);
+
+		const vector<double> reference_delays = cdx_in.get_reference_delays(
+				link_index);
+		if (reference_delays.size() != nof_cirs)
+			fail("master file: wrong number of reference delays.");
+
+		for (CDX::cir_number_t n = 0; n < nof_cirs; n++) {
+			const CDX::cir_t cir = cdx_in.get_cir(link_index, n);
+
+			bool ok = cir.ref_delay == reference_delay_of(l, n)
+					and reference_delays[n] == reference_delay_of(l, n)
+					and cir.components.size() == nof_components_of(l, n);
+			for (size_t c = 0; ok and c < cir.components.size(); c++)
+				ok = equal(cir.components[c], component_of(l, n, c));
+
+			if (not ok) {
+				stringstream ss;
+				ss << "master file: CIR " << n << " of " << link_names[l]
+						<< " does not match.";
+				fail(ss.str());
+			}
+		}
+
+		// the query skips blocks by the delay bounds of the master file:
+		CDX::query_t query;
+		query.min_delay_s = 10e-6;
+		query.max_delay_s = 11.5e-6;
+
+		size_t nof_expected = 0;
+		for (CDX::cir_number_t n = 0; n < nof_cirs; n++)
+			for (size_t c = 0; c < nof_components_of(l, n); c++) {
+				const double delay = component_of(l, n, c).delay;
+				if (delay >= query.min_delay_s and delay <= query.max_delay_s)
+					nof_expected++;
+			}
+
+		const CDX::query_result_t result = cdx_in.query(link_names[l], query);
+		if (result.size() != nof_expected or result.nof_cirs_skipped == 0)
+			fail("master file: query of " + link_names[l]
+					+ " returned a wrong result.");
+	}
+}
+
+/**
+ * \brief Writes a discrete-delay shard with CIRs first_cir to first_cir + count - 1.
+ */
+static void write_discrete_shard(const string &file_name,
+		size_t nof_delay_samples, size_t first_cir, size_t count,
+		double rate_Hz = cir_rate_Hz) {
+	CDX::WriteDiscreteDelayFile cdx_out(file_name, 3e8, rate_Hz, 1e9,
+			{ "link0" }, 1e9);
+	cdx_out.setup_link("link0", nof_delay_samples, 0.0);
+
+	for (size_t n = first_cir; n < first_cir + count; n++) {
+		vector<complex<double> > cir(nof_delay_samples);
+		for (size_t k = 0; k < nof_delay_samples; k++)
+			cir[k] = complex<double>(n, k);
+		cdx_out.append_cir_snapshot("link0", cir, 1e-6 * n);
+	}
+}
+
+static void check_discrete_master() {
+	cout << "checking discrete-delay master file..." << endl;
+
+	const size_t nof_delay_samples = 8;
+	const vector<string> shard_file_names = {
+			"cdx-test-shards-discrete.cdx.shard0",
+			"cdx-test-shards-discrete.cdx.shard1" };
+	write_discrete_shard(shard_file_names[0], nof_delay_samples, 0, 3);
+	write_discrete_shard(shard_file_names[1], nof_delay_samples, 3, 4);
+
+	CDX::write_discrete_delay_master("cdx-test-shards-discrete.cdx",
+			shard_file_names);
+
+	CDX::ReadDiscreteDelayFile cdx_in("cdx-test-shards-discrete.cdx");
+	if (cdx_in.get_nof_cirs("link0") != 7
+			or cdx_in.get_nof_delay_samples("link0") != nof_delay_samples)
+		fail("discrete-delay master file: wrong dimensions.");
+
+	const vector<vector<complex<double> > > cirs = cdx_in.get_cirs("link0");
+	const vector<double> reference_delays = cdx_in.get_reference_delays(
+			"link0");
+	for (size_t n = 0; n < 7; n++) {
+		bool ok = reference_delays.at(n) == 1e-6 * n;
+		for (size_t k = 0; k < nof_delay_samples; k++)
+			ok = ok and cirs.at(n).at(k) == complex<double>(n, k);
+		if (not ok)
+			fail("discrete-delay master file: CIRs do not match.");
+	}
+
+	// shards with other parameters:
+	write_discrete_shard("cdx-test-shards-rate.cdx.shard0", nof_delay_samples,
+			0, 3, 2 * cir_rate_Hz);
+	try {
+		CDX::write_discrete_delay_master("cdx-test-shards-invalid.cdx", {
+				shard_file_names[0], "cdx-test-shards-rate.cdx.shard0" });
+		fail("shards with different CIR rates did not throw.");
+	} catch (runtime_error &e) {
+		if (string(e.what()).find("CIR rate") == string::npos)
+			throw;
+	}
+
+	for (const auto &file_name : { shard_file_names[0], shard_file_names[1],
+			string("cdx-test-shards-rate.cdx.shard0"), string(
+					"cdx-test-shards-discrete.cdx"), string(
+					"cdx-test-shards-invalid.cdx") })
+		remove(file_name.c_str());
+}
+
+static void check_errors() {
+	cout << "checking errors..." << endl;
+
+	CDX::links_to_component_types_t component_types;
+	component_types["link0"] = { { 0, "LOS" } };
+
+	CDX::ShardedWriteContinuousDelayFile cdx_out("cdx-test-shards-errors.cdx",
+			3e8, cir_rate_Hz, 1e9, { "link0" }, component_types, 200, 2);
+
+	// CIR 0 is the first CIR of shard 0, CIR 128 the first one of shard 1:
+	cdx_out.write_cir(vector<CDX::components_t>(1), { 0.0 }, 0);
+	cdx_out.write_cir(vector<CDX::components_t>(1), { 0.0 }, 128);
+
+	try {
+		cdx_out.write_cir(vector<CDX::components_t>(1), { 0.0 }, 5);
+		fail("CIR written out of order did not throw.");
+	} catch (logic_error &) {
+	}
+
+	try {
+		cdx_out.write_cir(vector<CDX::components_t>(1), { 0.0 }, 200);
+		fail("CIR outside the file did not throw.");
+	} catch (logic_error &) {
+	}
+
+	try {
+		cdx_out.finalize();
+		fail("incomplete shards did not throw.");
+	} catch (logic_error &) {
+	}
+
+	for (size_t k = 0; k < 2; k++)
+		remove(CDX::get_shard_file_name("cdx-test-shards-errors.cdx", k).c_str());
+	remove("cdx-test-shards-errors.cdx");
+
+	try {
+		CDX::split_into_shards(100, 0);
+		fail("zero shards did not throw.");
+	} catch (logic_error &) {
+	}
+}
+
+int main(void) {
+	cout << "cdx-test-shards start." << endl;
+
+	// shards of 128, 64, 64 and 44 CIRs:
+	check_sharded_file("cdx-test-shards.cdx", 300, 4);
+
+	// two blocks for eight shards, six shards are empty:
+	check_sharded_file("cdx-test-shards-empty.cdx", 100, 8);
+
+	check_discrete_master();
+	check_errors();
+
+	for (size_t k = 0; k < 8; k++) {
+		remove(CDX::get_shard_file_name("cdx-test-shards.cdx", k).c_str());
+		remove(CDX::get_shard_file_name("cdx-test-shards-empty.cdx", k).c_str());
+	}
+	remove("cdx-test-shards.cdx");
+	remove("cdx-test-shards-empty.cdx");
+
+	cout << "all done." << endl;
+}
@@ -0,0 +1,475 @@
+/**
+ * \file cdx-test-swmr.cpp
+ *
+ * \brief Writes CDX files in SWMR mode from a child process that is killed halfway, reads
+ * the CIRs the child flushed, resumes the files with the constructors that reopen files
+ * for appending and checks the complete files before and after compacting them: CIRs,
+ * reference delays, delay bounds via queries, the track index and the time axis of a
+ * discrete-delay file. Checks that a reader with H5F_ACC_SWMR_READ sees the CIRs while
+ * they are written.
+ */
+
+#include "../../cdx/WriteContinuousDelayFile.h"
+#include "../../cdx/ReadContinuousDelayFile.h"
+#include "../../cdx/WriteDiscreteDelayFile.h"
+#include "../../cdx/ReadDiscreteDelayFile.h"
+#include "../cdx-test-common.h"
+
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <sstream>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace std;
+using namespace fixture;
+
+const double cir_rate_Hz = 100.0;
+
+/// the CIRs are flushed in steps of this number of CIRs
+const size_t flush_interval_cirs = 16;
+
+static CDX::swmr_options_t get_swmr_options() {
+	CDX::swmr_options_t options;
+	options.flush_interval_cirs = flush_interval_cirs;
+	options.flush_interval_s = 0.0;
+	return options;
+}
+
+/**
+ * \brief Creates a file in SWMR mode and writes CIRs, the asynchronous writer is optional.
+ */
+static CDX::WriteContinuousDelayFile *create_file(const string &file_name,
+		bool async_writer) {
+	const vector<string> link_names = { "link0", "link1" };
+	CDX::links_to_component_types_t component_types;
+	for (const auto &link_name : link_names)
+		component_types[link_name] = { { 0, "LOS" }, { 1, "Scatterer" } };
+
+	CDX::WriteContinuousDelayFile *cdx_out = new CDX::WriteContinuousDelayFile(
+			file_name, 3e8, cir_rate_Hz, 1e9, link_names, component_types, true,
+			CDX::get_swmr_access_plist());
+	if (async_writer)
+		cdx_out->enable_async_writer(8);
+	cdx_out->enable_swmr_write(get_swmr_options());
+
+	return cdx_out;
+}
+
+/**
+ * \brief Runs a function in a child process that exits without closing any files.
+ */
+template<typename F>
+static void run_and_crash(F function) {
+	cout.flush();
+
+	const pid_t pid = fork();
+	if (pid < 0)
+		fail("fork failed.");
+
+	if (pid == 0) {
+		try {
+			function();
+		} catch (...) {
+			_exit(2);
+		}
+		_exit(0); // no destructors, no HDF5 cleanup, as after a crash
+	}
+
+	int status;
+	waitpid(pid, &status, 0);
+	if (not WIFEXITED(status) or WEXITSTATUS(status) != 0)
+		fail("the writing child process failed.");
+}
+
+/**
+ * \brief Checks all CIRs, a query with a delay window and a track of a continuous-delay file.
+ *
+ * Files of a writer that crashed in SWMR mode are opened with \c swmr_read, as HDF5
+ * refuses to open them otherwise.
+ */
+static void check_continuous_file(const string &file_name,
+		CDX::cir_number_t nof_cirs, bool lazy_open = false, bool swmr_read =
+				false) {
+	CDX::ReadContinuousDelayFile cdx_in(file_name,
+			swmr_read ?
+					CDX::get_swmr_access_plist() : H5::FileAccPropList::DEFAULT,
+			lazy_open,
+			swmr_read ? H5F_ACC_RDONLY | H5F_ACC_SWMR_READ : H5F_ACC_RDONLY);
+	if (cdx_in.get_nof_cirs() != nof_cirs) {
+		stringstream ss;
+		ss << file_name << " has " << cdx_in.get_nof_cirs() << " CIRs instead of "
+				<< nof_cirs << ".";
+		fail(ss.str());
+	}
+
+	for (size_t l = 0; l < cdx_in.get_nof_links(); l++) {
+		const size_t link_index = cdx_in.get_link_index(
+				"link" + to_string(l));
+
+		for (CDX::cir_number_t n = 0; n < nof_cirs; n++) {
+			const CDX::cir_t cir = cdx_in.get_cir(link_index, n);
+
+			bool ok = cir.ref_delay == reference_delay_of(l, n)
+					and cir.components.size() == nof_components_of(l, n);
+			for (size_t c = 0; ok and c < cir.components.size(); c++)
+				ok = equal(cir.components[c], component_of(l, n, c));
+
+			if (not ok) {
+				stringstream ss;
+				ss << "CIR " << n << " of link " << l << " does not match.";
+				fail(ss.str());
+			}
+		}
+
+		// the CIRs appended in SWMR mode are read at once, after the stored ones:
+		const CDX::cir_block_t block = cdx_in.read_cirs(link_index, 0,
+				nof_cirs);
+		for (CDX::cir_number_t n = 0; n < nof_cirs; n++) {
+			bool ok = block.ref_delays[n] == reference_delay_of(l, n)
+					and block.offsets[n + 1] - block.offsets[n]
+							== nof_components_of(l, n);
+			for (size_t i = block.offsets[n], c = 0;
+					ok and i < block.offsets[n + 1]; i++, c++)
+				ok = block.ids[i] == component_of(l, n, c).id
+						and block.delays[i] == component_of(l, n, c).delay;
+
+			if (not ok) {
+				stringstream ss;
+				ss << "CIR " << n << " of link " << l
+						<< " does not match in a block.";
+				fail(ss.str());
+			}
+		}
+
+		// the query skips blocks by their delay bounds, so it misses components if the
+		// bounds of a resumed block are too narrow:
+		CDX::query_t query;
+		query.min_delay_s = 10e-6;
+		query.max_delay_s = 11.5e-6;
+
+		size_t nof_expected = 0;
+		for (CDX::cir_number_t n = 0; n < nof_cirs; n++)
+			for (size_t c = 0; c < nof_components_of(l, n); c++) {
+				const double delay = component_of(l, n, c).delay;
+				if (delay >= query.min_delay_s and delay <= query.max_delay_s)
+					nof_expected++;
+			}
+
+		// the blocks from CIR 128 on lie completely beyond the delay window:
+		const CDX::query_result_t result = cdx_in.query(
+				"link" + to_string(l), query);
+		if (result.size() != nof_expected
+				or (nof_cirs > 128 and result.nof_cirs_skipped == 0))
+			fail("query returned a wrong result.");
+
+		vector<CDX::cir_number_t> expected;
+		for (CDX::cir_number_t n = 0; n < nof_cirs; n++)
+			if (3 < nof_components_of(l, n))
+				expected.push_back(n);
+
+		const CDX::track_t track = cdx_in.get_track("link" + to_string(l),
+				10 * l + 3);
+		if (track.cir_numbers != expected)
+			fail("track does not match.");
+	}
+}
+
+/**
+ * \brief Returns true if the CIRs of the links of a file are stored as datasets of their own.
+ */
+static bool is_compacted(const string &file_name) {
+	CDX::ReadContinuousDelayFile cdx_in(file_name);
+	for (size_t k = 0; k < cdx_in.get_nof_links(); k++)
+		if (cdx_in.get_nof_stored_cirs(k) != cdx_in.get_nof_cirs())
+			return false;
+	return true;
+}
+
+/**
+ * \brief Compacts a file that has been closed in SWMR mode and checks it.
+ */
+static void check_compaction(const string &file_name,
+		CDX::cir_number_t nof_cirs) {
+	if (is_compacted(file_name))
+		fail("closing in SWMR mode restructured the file.");
+
+	CDX::compact_continuous_delay_file(file_name, true);
+	if (not is_compacted(file_name))
+		fail("the compacted file has appended CIRs.");
+
+	check_continuous_file(file_name, nof_cirs);
+
+	H5::H5File h5file(file_name, H5F_ACC_RDONLY);
+	for (const string link_name : { "link0", "link1" })
+		if (H5Lexists(h5file.getId(),
+				("/links/" + link_name + "/track_index").c_str(), H5P_DEFAULT)
+				<= 0
+				or H5Lexists(h5file.getId(),
+						("/links/" + link_name + "/appended_cirs").c_str(),
+						H5P_DEFAULT) > 0)
+			fail("the compacted file has a wrong structure.");
+}
+
+/**
+ * \brief Crashes while writing in SWMR mode, reads the file, and resumes twice.
+ */
+static void check_continuous_resume(bool async_writer) {
+	cout << "checking resuming a continuous-delay file, asynchronous writer "
+			<< async_writer << "..." << endl;
+
+	const string file_name = "cdx-test-swmr-continuous.cdx";
+
+	// the child writes 100 CIRs, of which 96 are flushed by the synchronous writer and at
+	// least 84 by the asynchronous one, which flushes after whole batches:
+	run_and_crash([&] {
+		CDX::WriteContinuousDelayFile *cdx_out = create_file(file_name,
+				async_writer);
+		write_cirs(*cdx_out, 0, 100);
+		cdx_out->flush();
+	});
+
+	// the CIRs the child flushed are read from the datasets they were appended to:
+	CDX::cir_number_t nof_flushed_cirs;
+	{
+		CDX::ReadContinuousDelayFile cdx_in(file_name,
+				CDX::get_swmr_access_plist(), false,
+				H5F_ACC_RDONLY | H5F_ACC_SWMR_READ);
+		nof_flushed_cirs = cdx_in.get_nof_cirs();
+	}
+	if ((not async_writer and nof_flushed_cirs != 96) or nof_flushed_cirs < 84
+			or nof_flushed_cirs > 100) {
+		stringstream ss;
+		ss << "crashed file has " << nof_flushed_cirs << " CIRs.";
+		fail(ss.str());
+	}
+	check_continuous_file(file_name, nof_flushed_cirs, false, true);
+	check_continuous_file(file_name, nof_flushed_cirs, true, true);
+
+	{
+		CDX::WriteContinuousDelayFile cdx_out(file_name, true,
+				CDX::get_swmr_access_plist());
+		const CDX::cir_number_t nof_cirs = cdx_out.get_nof_written_cirs();
+		if (nof_cirs != nof_flushed_cirs) {
+			stringstream ss;
+			ss << "resumed file has " << nof_cirs << " CIRs.";
+			fail(ss.str());
+		}
+
+		if (async_writer)
+			cdx_out.enable_async_writer(8);
+		cdx_out.enable_swmr_write(get_swmr_options());
+		write_cirs(cdx_out, nof_cirs, 150);
+		cdx_out.close();
+	}
+	check_continuous_file(file_name, 150);
+	check_continuous_file(file_name, 150, true);
+	check_compaction(file_name, 150);
+
+	// a file that has been closed properly is resumed without SWMR mode:
+	{
+		CDX::WriteContinuousDelayFile cdx_out(file_name, true);
+		if (cdx_out.get_nof_written_cirs() != 150)
+			fail("resumed file has lost CIRs.");
+		write_cirs(cdx_out, 150, 200);
+	}
+	check_continuous_file(file_name, 200);
+
+	remove(file_name.c_str());
+}
+
+/**
+ * \brief Reads the number of published CIRs from a file open with H5F_ACC_SWMR_READ.
+ *
+ * The reader caches the metadata of open datasets, so the dataset is refreshed first.
+ */
+static hsize_t read_nof_published_cirs(H5::DataSet &dataset) {
+	if (H5Drefresh(dataset.getId()) < 0)
+		fail("refreshing the reference delays failed.");
+
+	hsize_t size;
+	dataset.getSpace().getSimpleExtentDims(&size);
+	return size;
+}
+
+/**
+ * \brief Reads a file with H5F_ACC_SWMR_READ while a child process writes it.
+ */
+static void check_concurrent_reader() {
+	cout << "checking a concurrent SWMR reader..." << endl;
+
+	const string file_name = "cdx-test-swmr-reader.cdx";
+	const CDX::cir_number_t nof_cirs = 160;
+
+	int to_reader[2], to_writer[2];
+	if (pipe(to_reader) != 0 or pipe(to_writer) != 0)
+		fail("pipe failed.");
+
+	cout.flush();
+	const pid_t pid = fork();
+	if (pid < 0)
+		fail("fork failed.");
+
+	if (pid == 0) {
+		char byte = 0;
+		try {
+			unique_ptr<CDX::WriteContinuousDelayFile> cdx_out(
+					create_file(file_name, false));
+			if (write(to_reader[1], &byte, 1) != 1)
+				_exit(2);
+
+			for (CDX::cir_number_t n = 0; n < nof_cirs; n++) {
+				write_cirs(*cdx_out, n, n + 1);
+				usleep(500);
+			}
+			cdx_out->sync();
+
+			// the file is closed after the reader is done:
+			if (write(to_reader[1], &byte, 1) != 1
+					or read(to_writer[0], &byte, 1) != 1)
+				_exit(2);
+		} catch (...) {
+			_exit(2);
+		}
+		_exit(0);
+	}
+
+	char byte;
+	if (read(to_reader[0], &byte, 1) != 1)
+		fail("the writer did not start.");
+
+	{
+		H5::H5File h5file(file_name, H5F_ACC_RDONLY | H5F_ACC_SWMR_READ,
+				H5::FileCreatPropList::DEFAULT, CDX::get_swmr_access_plist());
+		H5::DataSet dataset = h5file.openDataSet(
+				"/links/link0/reference_delays");
+
+		hsize_t nof_published = 0;
+		size_t nof_increments = 0;
+		while (nof_published < nof_cirs) {
+			const hsize_t size = read_nof_published_cirs(dataset);
+			if (size < nof_published or size % flush_interval_cirs != 0)
+				fail("reader saw a wrong number of CIRs.");
+			if (size > nof_published)
+				nof_increments++;
+			nof_published = size;
+			usleep(1000);
+		}
+
+		if (nof_increments < 2)
+			fail("reader did not see the CIRs while they were written.");
+
+		if (read(to_reader[0], &byte, 1) != 1)
+			fail("the writer did not finish.");
+	}
+
+	if (write(to_writer[1], &byte, 1) != 1)
+		fail("write to pipe failed.");
+
+	int status;
+	waitpid(pid, &status, 0);
+	if (not WIFEXITED(status) or WEXITSTATUS(status) != 0)
+		fail("the writing child process failed.");
+
+	check_continuous_file(file_name, nof_cirs);
+	check_compaction(file_name, nof_cirs);
+	remove(file_name.c_str());
+}
+
+static complex<double> sample_of(size_t link_index,
+		CDX::cir_number_t cir_number, size_t s) {
+	return complex<double>(cir_number + s, link_index);
+}
+
+/**
+ * \brief Appends snapshots first_cir to end_cir - 1 to both links of a discrete-delay file.
+ */
+static void append_snapshots(CDX::WriteDiscreteDelayFile &cdx_out,
+		size_t nof_samples, CDX::cir_number_t first_cir,
+		CDX::cir_number_t end_cir) {
+	vector<complex<double> > data(nof_samples);
+	for (CDX::cir_number_t n = first_cir; n < end_cir; n++)
+		for (size_t l = 0; l < 2; l++) {
+			for (size_t s = 0; s < nof_samples; s++)
+				data[s] = sample_of(l, n, s);
+			cdx_out.append_cir_snapshot(l, data, reference_delay_of(l, n));
+		}
+}
+
+static void check_discrete_resume() {
+	cout << "checking resuming a discrete-delay file..." << endl;
+
+	const string file_name = "cdx-test-swmr-discrete.cdx";
+	const size_t nof_samples = 10;
+
+	// the child appends 37 snapshots to each link, one flush covers 8 snapshots of each
+	// link, so 32 are flushed:
+	run_and_crash([&] {
+		CDX::WriteDiscreteDelayFile *cdx_out = new CDX::WriteDiscreteDelayFile(
+				file_name, 3e8, cir_rate_Hz, 1e9, { "link0", "link1" }, 1e8,
+				CDX::get_swmr_access_plist());
+		for (size_t l = 0; l < 2; l++)
+			cdx_out->setup_link(l, nof_samples, 1e-6);
+		cdx_out->enable_swmr_write(get_swmr_options());
+		append_snapshots(*cdx_out, nof_samples, 0, 37);
+	});
+
+	{
+		CDX::WriteDiscreteDelayFile cdx_out(file_name,
+				CDX::get_swmr_access_plist());
+		cdx_out.enable_swmr_write(get_swmr_options());
+		append_snapshots(cdx_out, nof_samples, 32, 50);
+
+		// close appends the snapshots held back for the next flush:
+		cdx_out.close();
+		cdx_out.close();
+		expect_logic_error([&] {
+			append_snapshots(cdx_out, nof_samples, 50, 51);
+		}, "appending to a closed discrete-delay file");
+	}
+
+	CDX::ReadDiscreteDelayFile cdx_in(file_name);
+	for (size_t l = 0; l < 2; l++) {
+		if (cdx_in.get_nof_cirs(l) != 50)
+			fail("resumed discrete-delay file has a wrong number of CIRs.");
+
+		const auto cirs = cdx_in.get_cirs(l);
+		const vector<double> reference_delays = cdx_in.get_reference_delays(l);
+		for (CDX::cir_number_t n = 0; n < 50; n++) {
+			bool ok = reference_delays.at(n) == reference_delay_of(l, n);
+			for (size_t s = 0; ok and s < nof_samples; s++)
+				ok = cirs.at(n).at(s) == sample_of(l, n, s);
+
+			if (not ok) {
+				stringstream ss;
+				ss << "snapshot " << n << " of link " << l << " does not match.";
+				fail(ss.str());
+			}
+		}
+	}
+
+	H5::H5File h5file(file_name, H5F_ACC_RDONLY);
+	H5::DataSet dataset = h5file.openDataSet("/links/link1/x_axis");
+	hsize_t dims[2];
+	dataset.getSpace().getSimpleExtentDims(dims);
+	vector<double> x_axis(dims[0]);
+	dataset.read(x_axis.data(), H5::PredType::NATIVE_DOUBLE);
+	if (x_axis.size() != 50 or x_axis[49] != 49 / cir_rate_Hz)
+		fail("time axis of the resumed file is wrong.");
+
+	remove(file_name.c_str());
+}
+
+int main(void) {
+	cout << "cdx-test-swmr start." << endl;
+
+	check_continuous_resume(false);
+	check_continuous_resume(true);
+	check_concurrent_reader();
+	check_discrete_resume();
+
+	cout << "all done." << endl;
+}
@@ -0,0 +1,125 @@
+/**
+ * \file cdx-test-track-index.cpp
+ *
+ * \brief Writes a continuous-delay CDX file with a track index and one without. Components
+ * appear and disappear over time. The tracks returned by ReadContinuousDelayFile::get_track
+ * for the indexed file, for the file indexed afterwards by build_track_index and for the
+ * unindexed file (full scan) are compared to the written data.
+ */
+
+#include "../../cdx/WriteContinuousDelayFile.h"
+#include "../../cdx/ReadContinuousDelayFile.h"
+#include "../../cdx/TrackIndex.h"
+
+#include <iostream>
+#include <stdexcept>
+#include <sstream>
+
+using namespace std;
+
+const size_t nof_cirs = 500;
+const uint64_t nof_ids = 20;
+
+/**
+ * \brief Component id is present in CIR cir_number if this returns true.
+ */
+static bool is_alive(uint64_t id, CDX::cir_number_t cir_number) {
+	return id < nof_ids and cir_number >= id * 10
+			and cir_number < id * 10 + 100 + id;
+}
+
+static double delay_of(uint64_t id, CDX::cir_number_t cir_number) {
+	return 1e-6 * id + 1e-9 * cir_number;
+}
+
+static void write_file(const string &file_name, bool write_track_index) {
+	CDX::component_types_t component_types = { { 0, "LOS" }, { 256,
+			"Scatterer" } };
+	CDX::links_to_component_types_t links_to_component_types = { { "link0",
+			component_types }, { "link1", component_types } };
+
+	CDX::WriteContinuousDelayFile cdx_out(file_name, 3e8, 100.0, 1e9, {
+			"link0", "link1" }, links_to_component_types, write_track_index);
+
+	for (CDX::cir_number_t cir_number = 0; cir_number < nof_cirs;
+			cir_number++) {
+		CDX::components_t components;
+		for (uint64_t id = 0; id < nof_ids; id++) {
+			if (not is_alive(id, cir_number))
+				continue;
+			CDX::impulse_t impulse;
+			impulse.type = id == 0 ? 0 : 256;
+			impulse.id = id;
+			impulse.delay = delay_of(id, cir_number);
+			impulse.amplitude = complex<double>(id, cir_number);
+			components.push_back(impulse);
+		}
+
+		// link1 holds the components in reverse order:
+		CDX::components_t reversed(components.rbegin(), components.rend());
+
+		cdx_out.write_cir( { { "link0", components }, { "link1", reversed } }, {
+				{ "link0", 0.0 }, { "link1", 0.0 } }, cir_number);
+	}
+}
+
+static void check_tracks(const string &file_name) {
+	CDX::ReadContinuousDelayFile cdx_in(file_name);
+
+	for (const string link : { "link0", "link1" }) {
+		// one more id than written, its track must be empty:
+		for (uint64_t id = 0; id <= nof_ids; id++) {
+			const CDX::track_t track = cdx_in.get_track(link, id);
+
+			size_t n = 0;
+			for (CDX::cir_number_t cir_number = 0; cir_number < nof_cirs;
+					cir_number++) {
+				if (not is_alive(id, cir_number))
+					continue;
+
+				if (n >= track.size() or track.cir_numbers.at(n) != cir_number
+						or track.delays.at(n) != delay_of(id, cir_number)
+						or track.reals.at(n) != id
+						or track.imags.at(n) != cir_number
+						or track.types.at(n) != (id == 0 ? 0 : 256)) {
+					stringstream ss;
+					ss << file_name << ": track of id " << id << " in " << link
+							<< " does not match input data at cir_number "
+							<< cir_number;
+					throw runtime_error(ss.str());
+				}
+				n++;
+			}
+
+			if (n != track.size()) {
+				stringstream ss;
+				ss << file_name << ": track of id " << id << " in " << link
+						<< " has " << track.size() << " entries instead of "
+						<< n;
+				throw runtime_error(ss.str());
+			}
+		}
+	}
+}
+
+int main(void) {
+	cout << "cdx-test-track-index start." << endl;
+
+	const string indexed_file_name = "cdx-test-track-index-indexed.cdx";
+	const string unindexed_file_name = "cdx-test-track-index-unindexed.cdx";
+
+	write_file(indexed_file_name, true);
+	write_file(unindexed_file_name, false);
+
+	cout << "checking tracks from index written with the CIRs..." << endl;
+	check_tracks(indexed_file_name);
+
+	cout << "checking tracks found by scanning all CIRs..." << endl;
+	check_tracks(unindexed_file_name);
+
+	cout << "checking tracks from index built afterwards..." << endl;
+	CDX::build_track_index(unindexed_file_name);
+	check_tracks(unindexed_file_name);
+
+	cout << "all done." << endl;
+}
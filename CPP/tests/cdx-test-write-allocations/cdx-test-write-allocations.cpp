@@ -0,0 +1,149 @@
+/**
+ * \file cdx-test-write-allocations.cpp
+ *
+ * \brief Counts the heap allocations done by WriteContinuousDelayFile::write_cir with
+ * link indices once all buffers have reached their final size. There must be none.
+ *
+ * Allocations are counted by replacing the global operator new. Memory allocated by the
+ * HDF5 library with malloc is not counted.
+ */
+
+#include "../../cdx/WriteContinuousDelayFile.h"
+#include "../../cdx/ReadContinuousDelayFile.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <stdexcept>
+#include <sstream>
+
+using namespace std;
+
+static atomic<size_t> nof_allocations(0);
+
+// GCC sees malloc and free inlined into new and delete expressions and warns that they do
+// not match, but the replaced operators below are the only ones used:
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpragmas" // GCC before 11 does not know the warning
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+
+void *operator new(size_t size) {
+	nof_allocations++;
+	void *p = malloc(size > 0 ? size : 1);
+	if (p == nullptr)
+		throw bad_alloc();
+	return p;
+}
+
+void *operator new[](size_t size) {
+	return operator new(size);
+}
+
+void *operator new(size_t size, const nothrow_t&) noexcept {
+	nof_allocations++;
+	return malloc(size > 0 ? size : 1);
+}
+
+void *operator new[](size_t size, const nothrow_t &tag) noexcept {
+	return operator new(size, tag);
+}
+
+void operator delete(void *p) noexcept {
+	free(p);
+}
+
+void operator delete[](void *p) noexcept {
+	free(p);
+}
+
+void operator delete(void *p, size_t) noexcept {
+	free(p);
+}
+
+void operator delete[](void *p, size_t) noexcept {
+	free(p);
+}
+
+#pragma GCC diagnostic pop
+
+const size_t nof_warm_up_cirs = 10;
+const size_t nof_cirs = 300;
+const size_t max_nof_components = 20;
+
+int main(void) {
+	cout << "cdx-test-write-allocations start." << endl;
+
+	const string file_name = "cdx-test-write-allocations.cdx";
+	const vector<string> link_names = { "link0", "link1" };
+
+	CDX::component_types_t component_types = { { 0, "LOS" },
+			{ 256, "Scatterer" } };
+	CDX::links_to_component_types_t links_to_component_types = { { "link0",
+			component_types }, { "link1", component_types } };
+
+	{
+		CDX::WriteContinuousDelayFile cdx_out(file_name, 3e8, 100.0, 1e9,
+				link_names, links_to_component_types);
+
+		vector<CDX::components_t> cirs(link_names.size(),
+				CDX::components_t(max_nof_components));
+		vector<double> reference_delays(link_names.size());
+
+		size_t nof_allocations_before = 0;
+
+		for (CDX::cir_number_t cir_number = 0;
+				cir_number < nof_warm_up_cirs + nof_cirs; cir_number++) {
+			// the largest CIR is written during warm-up:
+			const size_t nof_components =
+					cir_number < nof_warm_up_cirs ?
+							max_nof_components :
+							cir_number % max_nof_components;
+
+			for (size_t k = 0; k < link_names.size(); k++) {
+				for (size_t c = 0; c < max_nof_components; c++) {
+					cirs[k][c].type = c == 0 ? 0 : 256;
+					cirs[k][c].id = c;
+					cirs[k][c].delay = 1e-6 * c + 1e-9 * cir_number;
+					cirs[k][c].amplitude = complex<double>(k, cir_number);
+				}
+				reference_delays[k] = 1e-3 * cir_number;
+			}
+
+			// shrinking does not reallocate, the components are restored above:
+			for (auto &cir : cirs)
+				cir.resize(nof_components);
+
+			if (cir_number == nof_warm_up_cirs)
+				nof_allocations_before = nof_allocations;
+
+			cdx_out.write_cir(cirs, reference_delays, cir_number);
+
+			for (auto &cir : cirs)
+				cir.resize(max_nof_components);
+		}
+
+		const size_t nof_steady_state_allocations = nof_allocations
+				- nof_allocations_before;
+
+		cout << "allocations while writing " << nof_cirs << " CIRs: "
+				<< nof_steady_state_allocations << endl;
+
+		if (nof_steady_state_allocations != 0)
+			throw runtime_error("write_cir allocated memory in steady state.");
+	}
+
+	// check that the file is complete:
+	CDX::ReadContinuousDelayFile cdx_in(file_name);
+	if (cdx_in.get_nof_cirs() != nof_warm_up_cirs + nof_cirs)
+		throw runtime_error("number of CIRs does not match.");
+
+	const CDX::cir_t cir = cdx_in.get_cir("link1", nof_warm_up_cirs + 7);
+	if (cir.components.size() != 17 or cir.components[3].delay
+			!= 1e-6 * 3 + 1e-9 * (nof_warm_up_cirs + 7))
+		throw runtime_error("written CIR does not match input data.");
+
+	remove(file_name.c_str());
+
+	cout << "all done." << endl;
+}
@@ -0,0 +1,220 @@
+/**
+ * \file cdx-test-writer-options.cpp
+ *
+ * \brief Writes CDX files with different settings of writer_options_t, checks that the
+ * settings arrive in the HDF5 file, e.g. the file space strategy and the link storage of
+ * the CIR groups, and that the readers return the written CIRs, also with a page buffer.
+ */
+
+#include "../../cdx/WriteContinuousDelayFile.h"
+#include "../../cdx/ReadContinuousDelayFile.h"
+#include "../../cdx/WriteDiscreteDelayFile.h"
+#include "../../cdx/ReadDiscreteDelayFile.h"
+#include "../cdx-test-common.h"
+
+#include <cstdio>
+#include <iostream>
+#include <stdexcept>
+
+using namespace std;
+
+const vector<string> link_names = { "link0", "link1" };
+const CDX::cir_number_t nof_cirs = 200;
+
+static size_t nof_components_of(size_t link_index,
+		CDX::cir_number_t cir_number) {
+	return (cir_number + 3 * link_index) % 7;
+}
+
+static void write_continuous_file(const string &file_name,
+		const CDX::writer_options_t &options) {
+	CDX::links_to_component_types_t component_types;
+	for (const auto &link_name : link_names)
+		component_types[link_name] = { { 0, "LOS" } };
+
+	CDX::WriteContinuousDelayFile cdx_out(file_name, 3e8, 100.0, 1e9,
+			link_names, component_types, true, H5::FileAccPropList::DEFAULT,
+			options);
+
+	vector<CDX::components_t> cirs(link_names.size());
+	for (CDX::cir_number_t n = 0; n < nof_cirs; n++) {
+		for (size_t l = 0; l < cirs.size(); l++) {
+			cirs[l].resize(nof_components_of(l, n));
+			for (size_t c = 0; c < cirs[l].size(); c++) {
+				cirs[l][c].type = 0;
+				cirs[l][c].id = c;
+				cirs[l][c].delay = 1e-6 * c;
+				cirs[l][c].amplitude = complex<double>(n, c);
+			}
+		}
+		cdx_out.write_cir(cirs, { 1e-6 * n, 2e-6 * n }, n);
+	}
+}
+
+static void check_continuous_file(const string &file_name,
+		const CDX::reader_options_t &reader_options, const string &what) {
+	CDX::ReadContinuousDelayFile cdx_in(file_name,
+			CDX::get_reader_access_plist(reader_options));
+	if (cdx_in.get_nof_cirs() != nof_cirs)
+		fail(what + ": wrong number of CIRs.");
+
+	for (size_t l = 0; l < link_names.size(); l++) {
+		for (CDX::cir_number_t n = 0; n < nof_cirs; n++) {
+			const CDX::cir_t cir = cdx_in.get_cir(l, n);
+			if (cir.components.size() != nof_components_of(l, n)
+					or (not cir.components.empty()
+							and cir.components.back().amplitude
+									!= complex<double>(n,
+											cir.components.size() - 1)))
+				fail(what + ": wrong CIR.");
+		}
+
+		if (cdx_in.get_track(l, 0).cir_numbers.empty())
+			fail(what + ": wrong track.");
+	}
+}
+
+/**
+ * \brief Returns the link storage type of the CIR group of link0.
+ */
+static H5G_storage_type_t get_cirs_storage_type(const string &file_name) {
+	H5::H5File file(file_name, H5F_ACC_RDONLY);
+	H5G_info_t info;
+	H5Gget_info(file.openGroup("/links/link0/cirs").getId(), &info);
+	return info.storage_type;
+}
+
+static void test_continuous_delay(const string &file_name) {
+	const CDX::reader_options_t default_reader_options;
+
+	cout << "HDF5 defaults..." << endl;
+	write_continuous_file(file_name, CDX::writer_options_t());
+	check_continuous_file(file_name, default_reader_options, "defaults");
+	if (get_cirs_storage_type(file_name) != H5G_STORAGE_TYPE_SYMBOL_TABLE)
+		fail("defaults: CIR group is not a symbol table.");
+
+	cout << "paged aggregation..." << endl;
+	CDX::writer_options_t options;
+	options.paged_aggregation = true;
+	options.page_size = 16384;
+	write_continuous_file(file_name, options);
+	{
+		H5::H5File file(file_name, H5F_ACC_RDONLY);
+		H5F_fspace_strategy_t strategy;
+		hbool_t persist;
+		hsize_t threshold, page_size;
+		const hid_t create_plist = H5Fget_create_plist(file.getId());
+		H5Pget_file_space_strategy(create_plist, &strategy, &persist,
+				&threshold);
+		H5Pget_file_space_page_size(create_plist, &page_size);
+		H5Pclose(create_plist);
+		if (strategy != H5F_FSPACE_STRATEGY_PAGE or page_size != 16384)
+			fail("paged aggregation: wrong file space strategy.");
+	}
+	check_continuous_file(file_name, default_reader_options,
+			"paged aggregation");
+
+	CDX::reader_options_t reader_options;
+	reader_options.page_buffer_size = 1 << 20;
+	check_continuous_file(file_name, reader_options,
+			"paged aggregation with page buffer");
+
+	cout << "aggregation blocks..." << endl;
+	options = CDX::writer_options_t();
+	options.meta_block_size = 65536;
+	options.small_data_block_size = 65536;
+	write_continuous_file(file_name, options);
+	check_continuous_file(file_name, default_reader_options,
+			"aggregation blocks");
+
+	cout << "dense and compact groups..." << endl;
+	options = CDX::writer_options_t();
+	options.new_style_groups = true;
+	write_continuous_file(file_name, options);
+	check_continuous_file(file_name, default_reader_options, "dense groups");
+	if (get_cirs_storage_type(file_name) != H5G_STORAGE_TYPE_DENSE)
+		fail("dense groups: CIR group is not dense.");
+
+	options.max_compact_links = 1000;
+	options.min_dense_links = 800;
+	write_continuous_file(file_name, options);
+	check_continuous_file(file_name, default_reader_options,
+			"compact groups");
+	if (get_cirs_storage_type(file_name) != H5G_STORAGE_TYPE_COMPACT)
+		fail("compact groups: CIR group is not compact.");
+
+	cout << "creation order and times..." << endl;
+	options = CDX::writer_options_t();
+	options.track_creation_order = true;
+	options.track_times = false;
+	write_continuous_file(file_name, options);
+	check_continuous_file(file_name, default_reader_options,
+			"creation order");
+	{
+		H5::H5File file(file_name, H5F_ACC_RDONLY);
+		H5::Group cirs_group = file.openGroup("/links/link0/cirs");
+
+		const hid_t create_plist = H5Gget_create_plist(cirs_group.getId());
+		unsigned flags = 0;
+		H5Pget_link_creation_order(create_plist, &flags);
+		H5Pclose(create_plist);
+		if (not (flags & H5P_CRT_ORDER_TRACKED))
+			fail("creation order: not tracked.");
+
+		H5O_info_t info;
+		H5Oget_info_by_name2(cirs_group.getId(), "10", &info, H5O_INFO_TIME,
+				H5P_DEFAULT);
+		if (info.ctime != 0)
+			fail("times: change time of a CIR is stored.");
+	}
+
+	expect_logic_error([&]() {
+		CDX::writer_options_t options;
+		options.paged_aggregation = true;
+		options.page_size = 100;
+		write_continuous_file(file_name, options);
+	}, "page size below 512 bytes");
+}
+
+static void test_discrete_delay(const string &file_name) {
+	cout << "discrete-delay file with paged aggregation..." << endl;
+	CDX::writer_options_t options;
+	options.paged_aggregation = true;
+	options.new_style_groups = true;
+	{
+		CDX::WriteDiscreteDelayFile cdx_out(file_name, 3e8, 100.0, 1e9,
+				link_names, 1e8, H5::FileAccPropList::DEFAULT, options);
+		cdx_out.setup_link(0, 16, 0.0);
+		cdx_out.setup_link(1, 16, 0.0);
+
+		const vector<complex<double> > cir(16, complex<double>(1.0, 2.0));
+		for (size_t k = 0; k < nof_cirs; k++) {
+			cdx_out.append_cir_snapshot(0, cir, 0.0);
+			cdx_out.append_cir_snapshot(1, cir, 0.0);
+		}
+	}
+
+	CDX::reader_options_t reader_options;
+	reader_options.page_buffer_size = 1 << 20;
+	CDX::ReadDiscreteDelayFile cdx_in(file_name,
+			CDX::get_reader_access_plist(reader_options));
+	for (size_t l = 0; l < link_names.size(); l++) {
+		const auto cirs = cdx_in.get_cirs(l);
+		if (cirs.size() != nof_cirs
+				or cirs.back().back() != complex<double>(1.0, 2.0))
+			fail("wrong discrete-delay CIRs.");
+	}
+}
+
+int main(void) {
+	cout << "cdx-test-writer-options start." << endl;
+
+	const string file_name = "cdx-test-writer-options.cdx";
+
+	test_continuous_delay(file_name);
+	test_discrete_delay(file_name);
+
+	remove(file_name.c_str());
+
+	cout << "all done." << endl;
+}
@@ -18,14 +18,16 @@
 #include <omp.h>
 #endif
 
+#include <algorithm>
+
 #include <boost/timer.hpp>
 #include <boost/progress.hpp>
-#include <boost/math/special_functions/sinc.hpp>
 #include <boost/program_options.hpp> // for reading command line parameters
 namespace po = boost::program_options;
 
 #include <armadillo>
 
+#include "cdx/Convert.h"
 #include "cdx/WriteDiscreteDelayFile.h"
 #include "cdx/ReadContinuousDelayFile.h"
 
@@ -214,47 +216,35 @@ int main(int argc, char **argv) {
 		cout.flush();
 		boost::progress_display show_progress(nof_cirs);
 
-		const double interpolation_bandwidth = smpl_freq / 2.0;
-		const double Om = 2.0 * M_PI * (interpolation_bandwidth);
-
 		const arma::cx_rowvec window = fftshift(
 				arma::conv_to<arma::cx_vec>::from(hamming(nof_coeffs))).st();
 
 		if (window.size() != nof_coeffs)
 			throw std::runtime_error("window.size() != nof_coeffs");
 
-		size_t k, c;
-		size_t n;
-#pragma omp parallel for private (k, c, n)
+		// only the components of the type to process are interpolated:
+		if (filter_by_types == true)
+			for (size_t k = 0; k < nof_cirs; k++) {
+				CDX::components_t &components = cirs.at(k).components;
+				components.erase(
+						remove_if(components.begin(), components.end(),
+								[&](const CDX::impulse_t &component) {
+									return component.type != type_to_process;
+								}), components.end());
+			}
+
+		// sample k of a CIR is at delay_min - delay_before_min + k / smpl_freq:
+		const double first_delay = delay_min - delay_before_min;
+
+		size_t k;
+#pragma omp parallel for private (k)
 		// for all CIRs
 		for (k = 0; k < nof_cirs; k++) {
-			for (c = 0; c < cirs.at(k).components.size(); c++) { // for all components
-				if (filter_by_types == true
-						and type_to_process != cirs.at(k).components.at(c).type)
-					continue;
-
-				for (n = 0; n < nof_coeffs; n++) { // for all coefficients
-					const double fac = Om
-							* (static_cast<double>(n) / smpl_freq
-									- (cirs.at(k).components.at(c).delay
-											- delay_min + delay_before_min));
-					const double sin_term = boost::math::sinc_pi(fac);
-
-					interp_cirs(k, n) += cirs.at(k).components.at(c).amplitude
-							* sin_term;
-
-					/*
-					 const double fac = Om
-					 * (static_cast<double>(n) / smpl_freq
-					 - (cirs[k].components[c].delay
-					 + delay_before_min));
-					 const double sin_term = sin(fac) / fac;
-
-					 interp_cirs(k, n) += cirs[k].components[c].weight
-					 * sin_term;
-					 */
-				}
-			}
+			vector<complex<double> > samples(nof_coeffs);
+			CDX::sample_components(cirs.at(k).components, first_delay,
+					smpl_freq, samples);
+			for (size_t n = 0; n < nof_coeffs; n++)
+				interp_cirs(k, n) = samples[n];
 
 			if (filter_enabled == true) {
 				// filter the CIR:
@@ -290,6 +280,7 @@ int main(int argc, char **argv) {
 		}
 		cout << "done.\n";
 	}
+	cdx_out.close();
 	cout << "all done. exit.\n";
 	return 0;
 }
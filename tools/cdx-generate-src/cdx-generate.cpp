@@ -0,0 +1,138 @@
+/**
+ * \addtogroup cpp_tools
+ * @{
+ * \addtogroup cpp_tools_cdx_generate cdx-generate
+ * @{
+ *
+ * \file cdx-generate.cpp
+ *
+ * \brief This file contains the implementation of a tool which writes synthetic
+ * continuous-delay or discrete-delay CDX files for benchmarks and soak tests.
+ *
+ * The CIRs of a moving receiver and several satellites are computed with CDX::generate
+ * on several threads. The same seed gives the same file for any number of threads.
+ */
+
+#include <boost/program_options.hpp> // for reading command line parameters
+namespace po = boost::program_options;
+
+#include <chrono>
+#include <iostream>
+
+#include "cdx/Generate.h"
+
+using namespace std;
+
+int main(int argc, char **argv) {
+	cout << "\n==== Generate synthetic CDX file ====\n\n";
+
+	const CDX::generate_options_t defaults;
+
+	po::options_description desc("Allowed options");
+	desc.add_options()("help", "produce help message")("output-file,o",
+			po::value<string>(), "output CDX file")("satellites,n",
+			po::value<size_t>()->default_value(defaults.nof_satellites),
+			"number of satellites, one link each")("cirs,c",
+			po::value<CDX::cir_number_t>()->default_value(defaults.nof_cirs),
+			"number of CIRs of each link")("cir-rate,r",
+			po::value<double>()->default_value(defaults.cir_rate_Hz),
+			"CIR rate in Hz")("speed,v",
+			po::value<double>()->default_value(defaults.receiver_speed_m_s),
+			"speed of the receiver in m/s")("scatterers,S",
+			po::value<double>()->default_value(defaults.mean_nof_scatterers),
+			"mean number of scatterers of each link alive at a time")(
+			"lifetime,L",
+			po::value<double>()->default_value(
+					defaults.mean_scatterer_lifetime_s),
+			"mean lifetime of a scatterer in s")("scatterer-power,P",
+			po::value<double>()->default_value(
+					defaults.mean_scatterer_power_dB),
+			"mean power of a scatterer relative to the LOS component in dB")(
+			"seed,s", po::value<uint64_t>()->default_value(defaults.seed),
+			"seed of the model")("threads,j",
+			po::value<size_t>()->default_value(0),
+			"number of threads, all hardware threads if 0")("discrete-delay",
+			po::bool_switch(), "write a discrete-delay file")(
+			"sampling-frequency",
+			po::value<double>()->default_value(
+					defaults.delay_sampling_frequency_Hz),
+			"sampling frequency of the delay axis of a discrete-delay file in Hz")(
+			"delay-samples",
+			po::value<size_t>()->default_value(defaults.nof_delay_samples),
+			"delay samples of each CIR of a discrete-delay file")(
+			"track-index", po::bool_switch(),
+			"write a track index to a continuous-delay file")("shards",
+			po::value<size_t>()->default_value(0),
+			"write a continuous-delay file as this number of shards and a master file")(
+			"paged-aggregation", po::value<size_t>(),
+			"allocate file space in pages of this size in bytes")(
+			"meta-block-size", po::value<size_t>(),
+			"size of the blocks that aggregate metadata in bytes")(
+			"new-style-groups", po::bool_switch(),
+			"store the links of groups compact or dense")(
+			"no-times", po::bool_switch(),
+			"do not store the times of objects");
+
+	// parse command line options:
+	po::variables_map vm;
+	po::store(po::parse_command_line(argc, argv, desc), vm);
+	po::notify(vm);
+
+	if (vm.count("help")) {
+		cout << desc << endl;
+		exit(0);
+	}
+
+	if (vm.count("output-file") != 1)
+		throw std::runtime_error("no output file name given.");
+
+	const string output_file = vm["output-file"].as<string>();
+
+	CDX::generate_options_t options;
+	options.nof_satellites = vm["satellites"].as<size_t>();
+	options.nof_cirs = vm["cirs"].as<CDX::cir_number_t>();
+	options.cir_rate_Hz = vm["cir-rate"].as<double>();
+	options.receiver_speed_m_s = vm["speed"].as<double>();
+	options.mean_nof_scatterers = vm["scatterers"].as<double>();
+	options.mean_scatterer_lifetime_s = vm["lifetime"].as<double>();
+	options.mean_scatterer_power_dB = vm["scatterer-power"].as<double>();
+	options.seed = vm["seed"].as<uint64_t>();
+	options.nof_threads = vm["threads"].as<size_t>();
+	options.discrete_delay = vm["discrete-delay"].as<bool>();
+	options.delay_sampling_frequency_Hz =
+			vm["sampling-frequency"].as<double>();
+	options.nof_delay_samples = vm["delay-samples"].as<size_t>();
+	options.write_track_index = vm["track-index"].as<bool>();
+	options.nof_shards = vm["shards"].as<size_t>();
+
+	if (vm.count("paged-aggregation")) {
+		options.writer_options.paged_aggregation = true;
+		options.writer_options.page_size = vm["paged-aggregation"].as<size_t>();
+	}
+
+	if (vm.count("meta-block-size"))
+		options.writer_options.meta_block_size =
+				vm["meta-block-size"].as<size_t>();
+
+	options.writer_options.new_style_groups = vm["new-style-groups"].as<bool>();
+	options.writer_options.track_times = not vm["no-times"].as<bool>();
+
+	cout << "process: generating " << options.nof_cirs << " CIRs of "
+			<< options.nof_satellites << " satellites to " << output_file
+			<< "... ";
+	cout.flush();
+
+	const auto start = chrono::steady_clock::now();
+	const CDX::generate_stats_t stats = CDX::generate(output_file, options);
+	const double seconds = chrono::duration<double>(
+			chrono::steady_clock::now() - start).count();
+
+	cout << "done.\n";
+	cout << "info: " << stats.nof_components << " components of "
+			<< stats.nof_scatterers << " scatterers written in " << seconds
+			<< " s\n";
+	return 0;
+}
+
+/** @} */
+/** @} */
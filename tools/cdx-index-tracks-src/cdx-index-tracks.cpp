@@ -0,0 +1,59 @@
+/**
+ * \addtogroup cpp_tools
+ * @{
+ * \addtogroup cpp_tools_cdx_index_tracks cdx-index-tracks
+ * @{
+ *
+ * \file cdx-index-tracks.cpp
+ *
+ * \brief This file contains the implementation of a tool which adds a track index to an
+ * existing continuous-delay CDX file.
+ *
+ * The track index maps each component identifier to the CIRs the component appears in.
+ * With the index, CDX::ReadContinuousDelayFile::get_track reads the trajectory of a
+ * single component without scanning the whole file.
+ */
+
+#include <boost/program_options.hpp> // for reading command line parameters
+namespace po = boost::program_options;
+
+#include <iostream>
+
+#include "cdx/TrackIndex.h"
+
+using namespace std;
+
+int main(int argc, char **argv) {
+	cout << "\n==== Add track index to continuous-delay CDX file ====\n\n";
+
+	po::options_description desc("Allowed options");
+	desc.add_options()("help", "produce help message")("input-file,i",
+			po::value<string>(),
+			"continuous-delay CDX file, the index is added to this file");
+
+	// parse command line options:
+	po::variables_map vm;
+	po::store(po::parse_command_line(argc, argv, desc), vm);
+	po::notify(vm);
+
+	if (vm.count("help")) {
+		cout << desc << endl;
+		exit(0);
+	}
+
+	if (vm.count("input-file") != 1)
+		throw std::runtime_error("no input file name given.");
+
+	const string input_file = vm["input-file"].as<string>();
+
+	cout << "process: indexing " << input_file << "... ";
+	cout.flush();
+
+	CDX::build_track_index(input_file);
+
+	cout << "done.\n";
+	return 0;
+}
+
+/** @} */
+/** @} */
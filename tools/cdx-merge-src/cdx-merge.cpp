@@ -0,0 +1,90 @@
+/**
+ * \addtogroup cpp_tools
+ * @{
+ * \addtogroup cpp_tools_cdx_merge cdx-merge
+ * @{
+ *
+ * \file cdx-merge.cpp
+ *
+ * \brief This file contains the implementation of a tool which combines continuous-delay
+ * CDX files into a new file.
+ *
+ * By default, the input files are concatenated along time, e.g. the chunks of a long
+ * drive that were simulated in parallel. With --links, files with disjoint links are
+ * combined. The CIRs are copied with CDX::merge without decoding them, unless --decode is
+ * given.
+ */
+
+#include <boost/program_options.hpp> // for reading command line parameters
+namespace po = boost::program_options;
+
+#include <iostream>
+
+#include "cdx/Merge.h"
+
+using namespace std;
+
+int main(int argc, char **argv) {
+	cout << "\n==== Merge continuous-delay CDX files ====\n\n";
+
+	po::options_description desc("Allowed options");
+	desc.add_options()("help", "produce help message")("input-file,i",
+			po::value<vector<string> >(),
+			"input continuous-delay CDX file, can be given several times, in order of time")(
+			"output-file,o", po::value<string>(),
+			"output continuous-delay CDX file")("links", po::bool_switch(),
+			"combine files with disjoint links instead of concatenating them along time")(
+			"decode", po::bool_switch(),
+			"read and write every CIR instead of copying the datasets")(
+			"batch-size,b", po::value<size_t>()->default_value(256),
+			"number of CIRs of a link read in one batch with --decode")(
+			"track-index", po::bool_switch(),
+			"write a track index to the output file");
+
+	po::positional_options_description positional;
+	positional.add("input-file", -1);
+
+	// parse command line options:
+	po::variables_map vm;
+	po::store(
+			po::command_line_parser(argc, argv).options(desc).positional(
+					positional).run(), vm);
+	po::notify(vm);
+
+	if (vm.count("help")) {
+		cout << desc << endl;
+		exit(0);
+	}
+
+	if (vm.count("input-file") == 0)
+		throw std::runtime_error("no input file names given.");
+
+	if (vm.count("output-file") != 1)
+		throw std::runtime_error("no output file name given.");
+
+	const vector<string> input_files = vm["input-file"].as<vector<string> >();
+	const string output_file = vm["output-file"].as<string>();
+
+	CDX::merge_options_t options;
+	options.mode = vm["links"].as<bool>() ? CDX::merge_links : CDX::merge_time;
+	options.bulk_copy = not vm["decode"].as<bool>();
+	options.batch_size = vm["batch-size"].as<size_t>();
+	options.write_track_index = vm["track-index"].as<bool>();
+
+	cout << "process: merging " << input_files.size() << " files into "
+			<< output_file << "... ";
+	cout.flush();
+
+	const CDX::merge_stats_t stats = CDX::merge(input_files, output_file,
+			options);
+
+	cout << "done.\n";
+	cout << "info: " << stats.nof_links << " links of " << stats.nof_cirs
+			<< " CIRs written\n";
+	cout << "info: " << stats.nof_copied_cirs << " CIRs copied, "
+			<< stats.nof_decoded_cirs << " CIRs decoded\n";
+	return 0;
+}
+
+/** @} */
+/** @} */
@@ -0,0 +1,99 @@
+/**
+ * \addtogroup cpp_tools
+ * @{
+ * \addtogroup cpp_tools_cdx_resample cdx-resample
+ * @{
+ *
+ * \file cdx-resample.cpp
+ *
+ * \brief This file contains the implementation of a tool which decimates, crops and
+ * filters a continuous-delay CDX file into a new file.
+ *
+ * The CIRs are streamed through CDX::resample, so files of any number of CIRs are
+ * processed in bounded memory.
+ */
+
+#include <boost/program_options.hpp> // for reading command line parameters
+namespace po = boost::program_options;
+
+#include <iostream>
+
+#include "cdx/Resample.h"
+
+using namespace std;
+
+int main(int argc, char **argv) {
+	cout << "\n==== Resample continuous-delay CDX file ====\n\n";
+
+	po::options_description desc("Allowed options");
+	desc.add_options()("help", "produce help message")("input-file,i",
+			po::value<string>(), "input continuous-delay CDX file")(
+			"output-file,o", po::value<string>(),
+			"output continuous-delay CDX file")("decimation,d",
+			po::value<size_t>()->default_value(1),
+			"keep only every d-th CIR, the CIR rate is divided by d")(
+			"start-time,s", po::value<double>(),
+			"drop CIRs before this time in s")("end-time,e",
+			po::value<double>(), "drop CIRs at or after this time in s")(
+			"link,l", po::value<vector<string> >(),
+			"copy only this link, can be given several times")("type,t",
+			po::value<vector<unsigned> >(),
+			"copy only components of this type, can be given several times")(
+			"batch-size,b", po::value<size_t>()->default_value(256),
+			"number of CIRs of a link read in one batch")("track-index",
+			po::bool_switch(), "write a track index to the output file");
+
+	// parse command line options:
+	po::variables_map vm;
+	po::store(po::parse_command_line(argc, argv, desc), vm);
+	po::notify(vm);
+
+	if (vm.count("help")) {
+		cout << desc << endl;
+		exit(0);
+	}
+
+	if (vm.count("input-file") != 1)
+		throw std::runtime_error("no input file name given.");
+
+	if (vm.count("output-file") != 1)
+		throw std::runtime_error("no output file name given.");
+
+	const string input_file = vm["input-file"].as<string>();
+	const string output_file = vm["output-file"].as<string>();
+
+	CDX::resample_options_t options;
+	options.decimation = vm["decimation"].as<size_t>();
+	options.batch_size = vm["batch-size"].as<size_t>();
+	options.write_track_index = vm["track-index"].as<bool>();
+
+	if (vm.count("start-time"))
+		options.start_time_s = vm["start-time"].as<double>();
+
+	if (vm.count("end-time"))
+		options.end_time_s = vm["end-time"].as<double>();
+
+	if (vm.count("link"))
+		options.links = vm["link"].as<vector<string> >();
+
+	if (vm.count("type"))
+		for (unsigned type : vm["type"].as<vector<unsigned> >())
+			options.types.push_back(type);
+
+	cout << "process: resampling " << input_file << " to " << output_file
+			<< "... ";
+	cout.flush();
+
+	const CDX::resample_stats_t stats = CDX::resample(input_file, output_file,
+			options);
+
+	cout << "done.\n";
+	cout << "info: " << stats.nof_read_cirs << " CIRs read, "
+			<< stats.nof_written_cirs << " CIRs written per link\n";
+	cout << "info: " << stats.nof_read_components << " components read, "
+			<< stats.nof_written_components << " components written\n";
+	return 0;
+}
+
+/** @} */
+/** @} */